@@ -0,0 +1,1020 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+/*
+
+times the functions in nom.h, nom_bitmap.h, nom_lz.h and nom_scan.h and the macros in nom_extras.h over a sweep of element counts, buffer and caller-side
+alignments and cache-resident or dram-sized footprints, printing one csv row per measurement. given a baseline in the
+same format, each row is compared against it and the program exits with 1 if anything got slower than the threshold
+
+	nom_bench [--filter substring] [--time ms] [--dram mib] [--cpu mask] [--baseline file] [--threshold percent]
+
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../nom.h"
+#include "../nom_bitmap.h"
+#include "../nom_extras.h"
+#include "../nom_lz.h"
+#include "../nom_scan.h"
+
+/* what the count of a benchmark means */
+#define BENCH_ARRAY 0 /* count elements at an offset, swept over counts and alignments */
+#define BENCH_SINGLE 1 /* one operation, so the count is always 1 */
+#define BENCH_WHOLE 2 /* an operation over count bytes */
+
+/* keeps the compiler from moving memory accesses across a benchmark's iterations */
+#if defined(__GNUC__) || defined(__clang__)
+#define BENCH_CLOBBER() __asm__ volatile("" ::: "memory")
+#else
+#define BENCH_CLOBBER()
+#endif
+
+/* the state a benchmark runs against */
+typedef struct BenchCtx {
+	struct NomBuffer b;
+	uint8_t *host; /* the caller-side array, offset by the host alignment */
+	int64_t off; /* the offset into the buffer, which is the buffer alignment */
+	int64_t n;
+} BenchCtx;
+
+typedef struct Bench {
+	const char *name;
+	void (*run)(struct BenchCtx *c, int64_t iters);
+	void (*prepare)(struct BenchCtx *c); /* fills the buffer in before timing, or NULL */
+	int kind;
+	int elem; /* bytes per element on the caller's side */
+	int bits; /* bits per element in the buffer */
+} Bench;
+
+static volatile uint64_t bench_sink;
+
+/* benchmarks for the array functions, which all share an argument order per family */
+#define BENCH_WRITE(fn, type)                                                  \
+	static void run_##fn(struct BenchCtx *c, int64_t iters) {              \
+		int64_t i;                                                     \
+		for (i = 0; i < iters; i++) {                                  \
+			fn(&c->b, c->off, c->n, (type *)(void *)(c->host));    \
+			BENCH_CLOBBER();                                       \
+		}                                                              \
+	}
+#define BENCH_WRITENEXT(fn, type)                                              \
+	static void run_##fn(struct BenchCtx *c, int64_t iters) {              \
+		int64_t i;                                                     \
+		for (i = 0; i < iters; i++) {                                  \
+			c->b.off = c->off;                                     \
+			fn(&c->b, c->n, (type *)(void *)(c->host));            \
+			BENCH_CLOBBER();                                       \
+		}                                                              \
+	}
+#define BENCH_READ(fn, type)                                                   \
+	static void run_##fn(struct BenchCtx *c, int64_t iters) {              \
+		int64_t i;                                                     \
+		for (i = 0; i < iters; i++) {                                  \
+			fn(&c->b, (type *)(void *)(c->host), c->off, c->n);    \
+			BENCH_CLOBBER();                                       \
+		}                                                              \
+	}
+#define BENCH_READNEXT(fn, type)                                               \
+	static void run_##fn(struct BenchCtx *c, int64_t iters) {              \
+		int64_t i;                                                     \
+		for (i = 0; i < iters; i++) {                                  \
+			c->b.off = c->off;                                     \
+			fn(&c->b, (type *)(void *)(c->host), c->n);            \
+			BENCH_CLOBBER();                                       \
+		}                                                              \
+	}
+
+/* the scaled i16 functions take a scale after the usual arguments */
+#define BENCH_SCALE (1.0f / 256)
+#define BENCH_SCALEDWRITE(fn)                                                  \
+	static void run_##fn(struct BenchCtx *c, int64_t iters) {              \
+		int64_t i;                                                     \
+		for (i = 0; i < iters; i++) {                                  \
+			fn(&c->b, c->off, c->n, (float *)(void *)(c->host),    \
+			   BENCH_SCALE);                                       \
+			BENCH_CLOBBER();                                       \
+		}                                                              \
+	}
+#define BENCH_SCALEDWRITENEXT(fn)                                              \
+	static void run_##fn(struct BenchCtx *c, int64_t iters) {              \
+		int64_t i;                                                     \
+		for (i = 0; i < iters; i++) {                                  \
+			c->b.off = c->off;                                     \
+			fn(&c->b, c->n, (float *)(void *)(c->host),            \
+			   BENCH_SCALE);                                       \
+			BENCH_CLOBBER();                                       \
+		}                                                              \
+	}
+#define BENCH_SCALEDREAD(fn)                                                   \
+	static void run_##fn(struct BenchCtx *c, int64_t iters) {              \
+		int64_t i;                                                     \
+		for (i = 0; i < iters; i++) {                                  \
+			fn(&c->b, (float *)(void *)(c->host), c->off, c->n,    \
+			   BENCH_SCALE);                                       \
+			BENCH_CLOBBER();                                       \
+		}                                                              \
+	}
+#define BENCH_SCALEDREADNEXT(fn)                                               \
+	static void run_##fn(struct BenchCtx *c, int64_t iters) {              \
+		int64_t i;                                                     \
+		for (i = 0; i < iters; i++) {                                  \
+			c->b.off = c->off;                                     \
+			fn(&c->b, (float *)(void *)(c->host), c->n,            \
+			   BENCH_SCALE);                                       \
+			BENCH_CLOBBER();                                       \
+		}                                                              \
+	}
+
+BENCH_WRITE(nom_buffer_writebytes, uint8_t)
+BENCH_WRITENEXT(nom_buffer_writebytesnext, uint8_t)
+BENCH_WRITE(nom_buffer_writeu16le, uint16_t)
+BENCH_WRITENEXT(nom_buffer_writeu16lenext, uint16_t)
+BENCH_WRITE(nom_buffer_writeu16be, uint16_t)
+BENCH_WRITENEXT(nom_buffer_writeu16benext, uint16_t)
+BENCH_WRITE(nom_buffer_writeu32le, uint32_t)
+BENCH_WRITENEXT(nom_buffer_writeu32lenext, uint32_t)
+BENCH_WRITE(nom_buffer_writeu32be, uint32_t)
+BENCH_WRITENEXT(nom_buffer_writeu32benext, uint32_t)
+BENCH_WRITE(nom_buffer_writeu64le, uint64_t)
+BENCH_WRITENEXT(nom_buffer_writeu64lenext, uint64_t)
+BENCH_WRITE(nom_buffer_writeu64be, uint64_t)
+BENCH_WRITENEXT(nom_buffer_writeu64benext, uint64_t)
+BENCH_READ(nom_buffer_readbytes, uint8_t)
+BENCH_READNEXT(nom_buffer_readbytesnext, uint8_t)
+BENCH_READ(nom_buffer_readu16le, uint16_t)
+BENCH_READNEXT(nom_buffer_readu16lenext, uint16_t)
+BENCH_READ(nom_buffer_readu16be, uint16_t)
+BENCH_READNEXT(nom_buffer_readu16benext, uint16_t)
+BENCH_READ(nom_buffer_readu32le, uint32_t)
+BENCH_READNEXT(nom_buffer_readu32lenext, uint32_t)
+BENCH_READ(nom_buffer_readu32be, uint32_t)
+BENCH_READNEXT(nom_buffer_readu32benext, uint32_t)
+BENCH_READ(nom_buffer_readu64le, uint64_t)
+BENCH_READNEXT(nom_buffer_readu64lenext, uint64_t)
+BENCH_READ(nom_buffer_readu64be, uint64_t)
+BENCH_READNEXT(nom_buffer_readu64benext, uint64_t)
+BENCH_WRITENEXT(nom_buffer_appendbytes, uint8_t)
+BENCH_WRITENEXT(nom_buffer_appendu16le, uint16_t)
+BENCH_WRITENEXT(nom_buffer_appendu16be, uint16_t)
+BENCH_WRITENEXT(nom_buffer_appendu32le, uint32_t)
+BENCH_WRITENEXT(nom_buffer_appendu32be, uint32_t)
+BENCH_WRITENEXT(nom_buffer_appendu64le, uint64_t)
+BENCH_WRITENEXT(nom_buffer_appendu64be, uint64_t)
+BENCH_WRITE(nom_buffer_writei16le, int16_t)
+BENCH_WRITENEXT(nom_buffer_writei16lenext, int16_t)
+BENCH_WRITE(nom_buffer_writei16be, int16_t)
+BENCH_WRITENEXT(nom_buffer_writei16benext, int16_t)
+BENCH_WRITE(nom_buffer_writei32le, int32_t)
+BENCH_WRITENEXT(nom_buffer_writei32lenext, int32_t)
+BENCH_WRITE(nom_buffer_writei32be, int32_t)
+BENCH_WRITENEXT(nom_buffer_writei32benext, int32_t)
+BENCH_WRITE(nom_buffer_writei64le, int64_t)
+BENCH_WRITENEXT(nom_buffer_writei64lenext, int64_t)
+BENCH_WRITE(nom_buffer_writei64be, int64_t)
+BENCH_WRITENEXT(nom_buffer_writei64benext, int64_t)
+BENCH_WRITE(nom_buffer_writef32le, float)
+BENCH_WRITENEXT(nom_buffer_writef32lenext, float)
+BENCH_WRITE(nom_buffer_writef32be, float)
+BENCH_WRITENEXT(nom_buffer_writef32benext, float)
+BENCH_WRITE(nom_buffer_writef64le, double)
+BENCH_WRITENEXT(nom_buffer_writef64lenext, double)
+BENCH_WRITE(nom_buffer_writef64be, double)
+BENCH_WRITENEXT(nom_buffer_writef64benext, double)
+BENCH_READ(nom_buffer_readi16le, int16_t)
+BENCH_READNEXT(nom_buffer_readi16lenext, int16_t)
+BENCH_READ(nom_buffer_readi16be, int16_t)
+BENCH_READNEXT(nom_buffer_readi16benext, int16_t)
+BENCH_READ(nom_buffer_readi32le, int32_t)
+BENCH_READNEXT(nom_buffer_readi32lenext, int32_t)
+BENCH_READ(nom_buffer_readi32be, int32_t)
+BENCH_READNEXT(nom_buffer_readi32benext, int32_t)
+BENCH_READ(nom_buffer_readi64le, int64_t)
+BENCH_READNEXT(nom_buffer_readi64lenext, int64_t)
+BENCH_READ(nom_buffer_readi64be, int64_t)
+BENCH_READNEXT(nom_buffer_readi64benext, int64_t)
+BENCH_READ(nom_buffer_readf32le, float)
+BENCH_READNEXT(nom_buffer_readf32lenext, float)
+BENCH_READ(nom_buffer_readf32be, float)
+BENCH_READNEXT(nom_buffer_readf32benext, float)
+BENCH_READ(nom_buffer_readf64le, double)
+BENCH_READNEXT(nom_buffer_readf64lenext, double)
+BENCH_READ(nom_buffer_readf64be, double)
+BENCH_READNEXT(nom_buffer_readf64benext, double)
+BENCH_WRITENEXT(nom_buffer_appendi16le, int16_t)
+BENCH_WRITENEXT(nom_buffer_appendi16be, int16_t)
+BENCH_WRITENEXT(nom_buffer_appendi32le, int32_t)
+BENCH_WRITENEXT(nom_buffer_appendi32be, int32_t)
+BENCH_WRITENEXT(nom_buffer_appendi64le, int64_t)
+BENCH_WRITENEXT(nom_buffer_appendi64be, int64_t)
+BENCH_WRITENEXT(nom_buffer_appendf32le, float)
+BENCH_WRITENEXT(nom_buffer_appendf32be, float)
+BENCH_WRITENEXT(nom_buffer_appendf64le, double)
+BENCH_WRITENEXT(nom_buffer_appendf64be, double)
+BENCH_WRITE(nom_buffer_writef16le, float)
+BENCH_WRITENEXT(nom_buffer_writef16lenext, float)
+BENCH_WRITENEXT(nom_buffer_appendf16le, float)
+BENCH_READ(nom_buffer_readf16le, float)
+BENCH_READNEXT(nom_buffer_readf16lenext, float)
+BENCH_WRITE(nom_buffer_writef16be, float)
+BENCH_WRITENEXT(nom_buffer_writef16benext, float)
+BENCH_WRITENEXT(nom_buffer_appendf16be, float)
+BENCH_READ(nom_buffer_readf16be, float)
+BENCH_READNEXT(nom_buffer_readf16benext, float)
+BENCH_SCALEDWRITE(nom_buffer_writescaledi16le)
+BENCH_SCALEDWRITENEXT(nom_buffer_writescaledi16lenext)
+BENCH_SCALEDWRITENEXT(nom_buffer_appendscaledi16le)
+BENCH_SCALEDREAD(nom_buffer_readscaledi16le)
+BENCH_SCALEDREADNEXT(nom_buffer_readscaledi16lenext)
+BENCH_SCALEDWRITE(nom_buffer_writescaledi16be)
+BENCH_SCALEDWRITENEXT(nom_buffer_writescaledi16benext)
+BENCH_SCALEDWRITENEXT(nom_buffer_appendscaledi16be)
+BENCH_SCALEDREAD(nom_buffer_readscaledi16be)
+BENCH_SCALEDREADNEXT(nom_buffer_readscaledi16benext)
+BENCH_WRITE(nom_buffer_writevaru32, uint32_t)
+BENCH_WRITENEXT(nom_buffer_writevaru32next, uint32_t)
+BENCH_WRITENEXT(nom_buffer_appendvaru32, uint32_t)
+BENCH_READ(nom_buffer_readvaru32, uint32_t)
+BENCH_READNEXT(nom_buffer_readvaru32next, uint32_t)
+BENCH_WRITE(nom_buffer_writevaru64, uint64_t)
+BENCH_WRITENEXT(nom_buffer_writevaru64next, uint64_t)
+BENCH_WRITENEXT(nom_buffer_appendvaru64, uint64_t)
+BENCH_READ(nom_buffer_readvaru64, uint64_t)
+BENCH_READNEXT(nom_buffer_readvaru64next, uint64_t)
+BENCH_WRITE(nom_buffer_writevari32, int32_t)
+BENCH_WRITENEXT(nom_buffer_writevari32next, int32_t)
+BENCH_WRITENEXT(nom_buffer_appendvari32, int32_t)
+BENCH_READ(nom_buffer_readvari32, int32_t)
+BENCH_READNEXT(nom_buffer_readvari32next, int32_t)
+BENCH_WRITE(nom_buffer_writevari64, int64_t)
+BENCH_WRITENEXT(nom_buffer_writevari64next, int64_t)
+BENCH_WRITENEXT(nom_buffer_appendvari64, int64_t)
+BENCH_READ(nom_buffer_readvari64, int64_t)
+BENCH_READNEXT(nom_buffer_readvari64next, int64_t)
+
+/* the nom_extras.h macros, which dispatch on the type of their data argument */
+BENCH_WRITE(nom_buffer_writecomplexle, uint32_t)
+BENCH_WRITENEXT(nom_buffer_writecomplexlenext, uint32_t)
+BENCH_WRITE(nom_buffer_writecomplexbe, uint32_t)
+BENCH_WRITENEXT(nom_buffer_writecomplexbenext, uint32_t)
+BENCH_WRITENEXT(nom_buffer_appendcomplexle, uint32_t)
+BENCH_WRITENEXT(nom_buffer_appendcomplexbe, uint32_t)
+BENCH_READ(nom_buffer_readcomplexle, uint32_t)
+BENCH_READNEXT(nom_buffer_readcomplexlenext, uint32_t)
+BENCH_READ(nom_buffer_readcomplexbe, uint32_t)
+BENCH_READNEXT(nom_buffer_readcomplexbenext, uint32_t)
+BENCH_WRITE(nom_buffer_writevar, uint32_t)
+BENCH_WRITENEXT(nom_buffer_writevarnext, uint32_t)
+BENCH_WRITENEXT(nom_buffer_appendvar, uint32_t)
+BENCH_READ(nom_buffer_readvar, uint32_t)
+BENCH_READNEXT(nom_buffer_readvarnext, uint32_t)
+
+/* the bit packing functions, at a width that doesn't line up with bytes */
+#define BENCH_PACK_WIDTH 13
+
+static void run_nom_buffer_packbits(struct BenchCtx *c, int64_t iters) {
+	int64_t i;
+
+	for (i = 0; i < iters; i++) {
+		nom_buffer_packbits(&c->b, c->off * 8, BENCH_PACK_WIDTH, c->n,
+				    (uint32_t *)(void *)(c->host));
+		BENCH_CLOBBER();
+	}
+}
+
+static void run_nom_buffer_packbitsnext(struct BenchCtx *c, int64_t iters) {
+	int64_t i;
+
+	for (i = 0; i < iters; i++) {
+		c->b.boff = c->off * 8;
+		nom_buffer_packbitsnext(&c->b, BENCH_PACK_WIDTH, c->n,
+					(uint32_t *)(void *)(c->host));
+		BENCH_CLOBBER();
+	}
+}
+
+static void run_nom_buffer_unpackbits(struct BenchCtx *c, int64_t iters) {
+	int64_t i;
+
+	for (i = 0; i < iters; i++) {
+		nom_buffer_unpackbits(&c->b, (uint32_t *)(void *)(c->host),
+				      c->off * 8, BENCH_PACK_WIDTH, c->n);
+		BENCH_CLOBBER();
+	}
+}
+
+static void run_nom_buffer_unpackbitsnext(struct BenchCtx *c, int64_t iters) {
+	int64_t i;
+
+	for (i = 0; i < iters; i++) {
+		c->b.boff = c->off * 8;
+		nom_buffer_unpackbitsnext(&c->b, (uint32_t *)(void *)(c->host),
+					  BENCH_PACK_WIDTH, c->n);
+		BENCH_CLOBBER();
+	}
+}
+
+static void run_nom_bitreader_read(struct BenchCtx *c, int64_t iters) {
+	struct NomBitReader r;
+	uint64_t sum = 0;
+	int64_t i, j;
+
+	for (i = 0; i < iters; i++) {
+		nom_bitreader_new(&r, &c->b, c->off * 8);
+		for (j = 0; j < c->n; j++) {
+			sum += nom_bitreader_read(&r, BENCH_PACK_WIDTH);
+		}
+	}
+	bench_sink = sum;
+}
+
+static void run_nom_bitwriter_write(struct BenchCtx *c, int64_t iters) {
+	struct NomBitWriter w;
+	int64_t i, j;
+
+	for (i = 0; i < iters; i++) {
+		if (nom_bitwriter_new(&w, &c->b, c->off * 8) != 0) {
+			return;
+		}
+		for (j = 0; j < c->n; j++) {
+			nom_bitwriter_write(&w, (uint64_t)(j),
+					    BENCH_PACK_WIDTH);
+		}
+		nom_bitwriter_flush(&w);
+		BENCH_CLOBBER();
+	}
+}
+
+/* single bit and offset operations, which walk over the first kilobit so they don't all hit the same byte */
+#define BENCH_BIT(fn, call)                                                    \
+	static void run_##fn(struct BenchCtx *c, int64_t iters) {              \
+		uint8_t bit = 0;                                               \
+		uint64_t bits = 0;                                             \
+		int64_t i, at = 0;                                             \
+		for (i = 0; i < iters; i++) {                                  \
+			c->b.boff = i & 1023;                                  \
+			c->b.off = i & 127;                                    \
+			call;                                                  \
+			BENCH_CLOBBER();                                       \
+		}                                                              \
+		bench_sink = bit + bits + (uint64_t)(at);                      \
+	}
+
+BENCH_BIT(nom_buffer_readbit, nom_buffer_readbit(&c->b, &bit, i & 1023))
+BENCH_BIT(nom_buffer_readbitnext, nom_buffer_readbitnext(&c->b, &bit))
+BENCH_BIT(nom_buffer_readbits, nom_buffer_readbits(&c->b, &bits, i & 1023, 13))
+BENCH_BIT(nom_buffer_readbitsnext, nom_buffer_readbitsnext(&c->b, &bits, 13))
+BENCH_BIT(nom_buffer_setbit, nom_buffer_setbit(&c->b, i & 1023))
+BENCH_BIT(nom_buffer_setbitnext, nom_buffer_setbitnext(&c->b))
+BENCH_BIT(nom_buffer_clearbit, nom_buffer_clearbit(&c->b, i & 1023))
+BENCH_BIT(nom_buffer_clearbitnext, nom_buffer_clearbitnext(&c->b))
+BENCH_BIT(nom_buffer_flipbit, nom_buffer_flipbit(&c->b, i & 1023))
+BENCH_BIT(nom_buffer_flipbitnext, nom_buffer_flipbitnext(&c->b))
+BENCH_BIT(nom_buffer_setbits,
+	  nom_buffer_setbits(&c->b, i & 1023, (uint64_t)(i), 13))
+BENCH_BIT(nom_buffer_setbitsnext,
+	  nom_buffer_setbitsnext(&c->b, (uint64_t)(i), 13))
+BENCH_BIT(nom_buffer_seekbit, nom_buffer_seekbit(&c->b, 3, 1))
+BENCH_BIT(nom_buffer_afterbit, nom_buffer_afterbit(&c->b, &at, 5))
+BENCH_BIT(nom_buffer_alignbit, nom_buffer_alignbit(&c->b))
+BENCH_BIT(nom_buffer_seekbyte, nom_buffer_seekbyte(&c->b, 3, 1))
+BENCH_BIT(nom_buffer_afterbyte, nom_buffer_afterbyte(&c->b, &at, 5))
+BENCH_BIT(nom_buffer_alignbyte, nom_buffer_alignbyte(&c->b))
+
+/* whole-buffer operations, run over the first n bytes of the buffer */
+#define BENCH_ALL(fn)                                                          \
+	static void run_##fn(struct BenchCtx *c, int64_t iters) {              \
+		int64_t i, cap = c->b.cap, bcap = c->b.bcap;                   \
+		c->b.cap = c->n;                                               \
+		c->b.bcap = c->n * 8;                                          \
+		for (i = 0; i < iters; i++) {                                  \
+			fn(&c->b);                                             \
+			BENCH_CLOBBER();                                       \
+		}                                                              \
+		c->b.cap = cap;                                                \
+		c->b.bcap = bcap;                                              \
+	}
+
+BENCH_ALL(nom_buffer_clearallbits)
+BENCH_ALL(nom_buffer_setallbits)
+BENCH_ALL(nom_buffer_flipallbits)
+
+/* bitmap operations over the first n bytes, starting a few bits in so the partial bytes at the ends are covered */
+#define BENCH_BITMAP(fn, call)                                                 \
+	static void run_##fn(struct BenchCtx *c, int64_t iters) {              \
+		int64_t i, r = 0;                                              \
+		for (i = 0; i < iters; i++) {                                  \
+			call;                                                  \
+			BENCH_CLOBBER();                                       \
+		}                                                              \
+		bench_sink = (uint64_t)(r);                                    \
+	}
+
+BENCH_BITMAP(nom_buffer_setbitrange,
+	     nom_buffer_setbitrange(&c->b, 3, c->n * 8 - 6))
+BENCH_BITMAP(nom_buffer_clearbitrange,
+	     nom_buffer_clearbitrange(&c->b, 3, c->n * 8 - 6))
+BENCH_BITMAP(nom_buffer_flipbitrange,
+	     nom_buffer_flipbitrange(&c->b, 3, c->n * 8 - 6))
+BENCH_BITMAP(nom_buffer_popcount,
+	     r += nom_buffer_popcount(&c->b, 3, c->n * 8 - 6))
+BENCH_BITMAP(nom_buffer_findset, r += nom_buffer_findset(&c->b, 3))
+BENCH_BITMAP(nom_buffer_findclear, r += nom_buffer_findclear(&c->b, 3))
+BENCH_BITMAP(nom_crc32c, r += nom_crc32c(0, c->b.buf, c->n))
+BENCH_BITMAP(nom_xxh64, r += (int64_t)(nom_xxh64(c->b.buf, c->n, 0)))
+
+/* run_writebytesnext_crc32c is nom_buffer_writebytesnext with a crc32c attached to the buffer, to compare against the plain one */
+static void run_writebytesnext_crc32c(struct BenchCtx *c, int64_t iters) {
+	struct NomChecksum k;
+	int64_t i;
+
+	nom_checksum_new(&k, NOM_CHECKSUM_CRC32C, 0);
+	nom_buffer_setchecksum(&c->b, &k);
+	for (i = 0; i < iters; i++) {
+		c->b.off = c->off;
+		nom_buffer_writebytesnext(&c->b, c->n, c->host);
+		BENCH_CLOBBER();
+	}
+	nom_buffer_setchecksum(&c->b, NULL);
+	bench_sink = k.crc;
+}
+
+/* the size of the block prepare_lz left after the data */
+static int64_t bench_lz_size;
+
+/* prepare_lz fills the first n bytes with text made of a few words, which compresses about as well as the structured data nom usually holds, and compresses it into the bytes after them for nom_lz_decompress */
+static void prepare_lz(struct BenchCtx *c) {
+	static const char *words[] = {
+		"nom ",    "crunch ", "but ",  "the ",   "letter ", "c ",
+		"buffer ", "offset ", "read ", "write ", "next ",   "u32 ",
+		"bits ",   "varint ", "frame ", "\n"};
+	uint32_t r = 1;
+	int64_t i = 0;
+	const char *w;
+
+	while (i < c->n) {
+		r = r * 1103515245u + 12345u;
+		for (w = words[(r >> 16) % 16]; *w != '\0' && i < c->n; w++) {
+			c->b.buf[i++] = (uint8_t)(*w);
+		}
+		if ((r >> 8) % 4 == 0 && i < c->n) {
+			c->b.buf[i++] = (uint8_t)('0' + (r >> 20) % 10);
+		}
+	}
+	bench_lz_size = nom_lz_compress(c->b.buf + c->n, nom_lz_bound(c->n),
+					c->b.buf, c->n);
+}
+
+BENCH_BITMAP(nom_lz_compress,
+	     r += nom_lz_compress(c->host, c->n + 64, c->b.buf, c->n))
+BENCH_BITMAP(nom_lz_decompress,
+	     r += nom_lz_decompress(c->host, c->n, c->b.buf + c->n,
+				    bench_lz_size))
+
+/* prepare_scan fills the first n bytes with lowercase letters ending in a blank line, so the scans have to look through all of them */
+static void prepare_scan(struct BenchCtx *c) {
+	int64_t i;
+
+	for (i = 0; i < c->n; i++) {
+		c->b.buf[i] = (uint8_t)('a' + i % 26);
+	}
+	memcpy(c->b.buf + c->n - 4, "\r\n\r\n", 4);
+}
+
+BENCH_BITMAP(nom_buffer_findbyte, r += nom_buffer_findbyte(&c->b, 0, '\n'))
+BENCH_BITMAP(nom_buffer_findany,
+	     r += nom_buffer_findany(&c->b, 0, 4,
+				     (const uint8_t *)("\r\n;\"")))
+BENCH_BITMAP(nom_buffer_findpattern,
+	     r += nom_buffer_findpattern(&c->b, 0, 4,
+					 (const uint8_t *)("\r\n\r\n")))
+BENCH_BITMAP(nom_buffer_findall,
+	     r += nom_buffer_findall(&c->b, (int64_t *)(void *)(c->host), 0,
+				     c->n, '\n', c->n / 8))
+
+/* prepare_findset clears the first n bytes except for the last bit, so nom_buffer_findset has to scan all of them */
+static void prepare_findset(struct BenchCtx *c) {
+	memset(c->b.buf, 0x00, c->n);
+	c->b.buf[c->n - 1] = 0x01;
+}
+
+/* prepare_findclear does the opposite for nom_buffer_findclear */
+static void prepare_findclear(struct BenchCtx *c) {
+	memset(c->b.buf, 0xff, c->n);
+	c->b.buf[c->n - 1] = 0xfe;
+}
+
+/* run_nom_buffer_slice takes a slice of the first n bytes, reads its last one and releases it, which should cost the same at every n, to compare against copying them out with nom_buffer_readbytes */
+static void run_nom_buffer_slice(struct BenchCtx *c, int64_t iters) {
+	NomSlice s;
+	int64_t i;
+
+	for (i = 0; i < iters; i++) {
+		nom_buffer_slice(&s, &c->b, 0, c->n);
+		bench_sink += s.buf[s.cap - 1];
+		nom_buffer_release(&s);
+		BENCH_CLOBBER();
+	}
+}
+
+/* growth, from a fresh 16 byte buffer each time, so the allocation is part of what is measured */
+#define BENCH_GROW(fn, call)                                                   \
+	static void run_##fn(struct BenchCtx *c, int64_t iters) {              \
+		struct NomBuffer t;                                            \
+		int64_t i;                                                     \
+		for (i = 0; i < iters; i++) {                                  \
+			nom_buffer_newwith(&t, 16, NULL);                      \
+			call;                                                  \
+			bench_sink += t.cap;                                   \
+			free(t.buf);                                           \
+		}                                                              \
+	}
+
+BENCH_GROW(nom_buffer_grow, nom_buffer_grow(&t, c->n))
+BENCH_GROW(nom_buffer_ensure, nom_buffer_ensure(&t, c->n))
+BENCH_GROW(nom_buffer_reserve, nom_buffer_reserve(&t, c->n))
+
+/* prepare_varint fills the buffer with n varints of mixed lengths at the offset for the varint readers */
+static void prepare_varint(struct BenchCtx *c) {
+	uint32_t v;
+	int64_t i;
+
+	for (i = 0; i < c->n; i++) {
+		v = (uint32_t)(i * 2654435761u) >> (i % 29);
+		memcpy(c->host + i * 4, &v, 4);
+	}
+	nom_buffer_writevaru32(&c->b, c->off, c->n,
+			       (uint32_t *)(void *)(c->host));
+}
+
+#define ARRAY(fn, elem) {#fn, run_##fn, NULL, BENCH_ARRAY, elem, (elem) * 8}
+#define VARINT(fn, elem)                                                       \
+	{#fn, run_##fn, prepare_varint, BENCH_ARRAY, elem, (elem) * 8}
+#define PACK(fn) {#fn, run_##fn, NULL, BENCH_ARRAY, 4, BENCH_PACK_WIDTH}
+#define HALF(fn) {#fn, run_##fn, NULL, BENCH_ARRAY, 4, 16}
+#define SINGLE(fn) {#fn, run_##fn, NULL, BENCH_SINGLE, 1, 8}
+#define WHOLE(fn) {#fn, run_##fn, NULL, BENCH_WHOLE, 1, 8}
+
+static const struct Bench benches[] = {
+	ARRAY(nom_buffer_writebytes, 1),
+	ARRAY(nom_buffer_writebytesnext, 1),
+	{"nom_buffer_writebytesnext+crc32c", run_writebytesnext_crc32c, NULL,
+	 BENCH_ARRAY, 1, 8},
+	ARRAY(nom_buffer_writeu16le, 2),
+	ARRAY(nom_buffer_writeu16lenext, 2),
+	ARRAY(nom_buffer_writeu16be, 2),
+	ARRAY(nom_buffer_writeu16benext, 2),
+	ARRAY(nom_buffer_writeu32le, 4),
+	ARRAY(nom_buffer_writeu32lenext, 4),
+	ARRAY(nom_buffer_writeu32be, 4),
+	ARRAY(nom_buffer_writeu32benext, 4),
+	ARRAY(nom_buffer_writeu64le, 8),
+	ARRAY(nom_buffer_writeu64lenext, 8),
+	ARRAY(nom_buffer_writeu64be, 8),
+	ARRAY(nom_buffer_writeu64benext, 8),
+	ARRAY(nom_buffer_readbytes, 1),
+	ARRAY(nom_buffer_readbytesnext, 1),
+	ARRAY(nom_buffer_readu16le, 2),
+	ARRAY(nom_buffer_readu16lenext, 2),
+	ARRAY(nom_buffer_readu16be, 2),
+	ARRAY(nom_buffer_readu16benext, 2),
+	ARRAY(nom_buffer_readu32le, 4),
+	ARRAY(nom_buffer_readu32lenext, 4),
+	ARRAY(nom_buffer_readu32be, 4),
+	ARRAY(nom_buffer_readu32benext, 4),
+	ARRAY(nom_buffer_readu64le, 8),
+	ARRAY(nom_buffer_readu64lenext, 8),
+	ARRAY(nom_buffer_readu64be, 8),
+	ARRAY(nom_buffer_readu64benext, 8),
+	ARRAY(nom_buffer_appendbytes, 1),
+	ARRAY(nom_buffer_appendu16le, 2),
+	ARRAY(nom_buffer_appendu16be, 2),
+	ARRAY(nom_buffer_appendu32le, 4),
+	ARRAY(nom_buffer_appendu32be, 4),
+	ARRAY(nom_buffer_appendu64le, 8),
+	ARRAY(nom_buffer_appendu64be, 8),
+	ARRAY(nom_buffer_writei16le, 2),
+	ARRAY(nom_buffer_writei16lenext, 2),
+	ARRAY(nom_buffer_writei16be, 2),
+	ARRAY(nom_buffer_writei16benext, 2),
+	ARRAY(nom_buffer_writei32le, 4),
+	ARRAY(nom_buffer_writei32lenext, 4),
+	ARRAY(nom_buffer_writei32be, 4),
+	ARRAY(nom_buffer_writei32benext, 4),
+	ARRAY(nom_buffer_writei64le, 8),
+	ARRAY(nom_buffer_writei64lenext, 8),
+	ARRAY(nom_buffer_writei64be, 8),
+	ARRAY(nom_buffer_writei64benext, 8),
+	ARRAY(nom_buffer_writef32le, 4),
+	ARRAY(nom_buffer_writef32lenext, 4),
+	ARRAY(nom_buffer_writef32be, 4),
+	ARRAY(nom_buffer_writef32benext, 4),
+	ARRAY(nom_buffer_writef64le, 8),
+	ARRAY(nom_buffer_writef64lenext, 8),
+	ARRAY(nom_buffer_writef64be, 8),
+	ARRAY(nom_buffer_writef64benext, 8),
+	ARRAY(nom_buffer_readi16le, 2),
+	ARRAY(nom_buffer_readi16lenext, 2),
+	ARRAY(nom_buffer_readi16be, 2),
+	ARRAY(nom_buffer_readi16benext, 2),
+	ARRAY(nom_buffer_readi32le, 4),
+	ARRAY(nom_buffer_readi32lenext, 4),
+	ARRAY(nom_buffer_readi32be, 4),
+	ARRAY(nom_buffer_readi32benext, 4),
+	ARRAY(nom_buffer_readi64le, 8),
+	ARRAY(nom_buffer_readi64lenext, 8),
+	ARRAY(nom_buffer_readi64be, 8),
+	ARRAY(nom_buffer_readi64benext, 8),
+	ARRAY(nom_buffer_readf32le, 4),
+	ARRAY(nom_buffer_readf32lenext, 4),
+	ARRAY(nom_buffer_readf32be, 4),
+	ARRAY(nom_buffer_readf32benext, 4),
+	ARRAY(nom_buffer_readf64le, 8),
+	ARRAY(nom_buffer_readf64lenext, 8),
+	ARRAY(nom_buffer_readf64be, 8),
+	ARRAY(nom_buffer_readf64benext, 8),
+	ARRAY(nom_buffer_appendi16le, 2),
+	ARRAY(nom_buffer_appendi16be, 2),
+	ARRAY(nom_buffer_appendi32le, 4),
+	ARRAY(nom_buffer_appendi32be, 4),
+	ARRAY(nom_buffer_appendi64le, 8),
+	ARRAY(nom_buffer_appendi64be, 8),
+	ARRAY(nom_buffer_appendf32le, 4),
+	ARRAY(nom_buffer_appendf32be, 4),
+	ARRAY(nom_buffer_appendf64le, 8),
+	ARRAY(nom_buffer_appendf64be, 8),
+	HALF(nom_buffer_writef16le),
+	HALF(nom_buffer_writef16lenext),
+	HALF(nom_buffer_appendf16le),
+	HALF(nom_buffer_readf16le),
+	HALF(nom_buffer_readf16lenext),
+	HALF(nom_buffer_writef16be),
+	HALF(nom_buffer_writef16benext),
+	HALF(nom_buffer_appendf16be),
+	HALF(nom_buffer_readf16be),
+	HALF(nom_buffer_readf16benext),
+	HALF(nom_buffer_writescaledi16le),
+	HALF(nom_buffer_writescaledi16lenext),
+	HALF(nom_buffer_appendscaledi16le),
+	HALF(nom_buffer_readscaledi16le),
+	HALF(nom_buffer_readscaledi16lenext),
+	HALF(nom_buffer_writescaledi16be),
+	HALF(nom_buffer_writescaledi16benext),
+	HALF(nom_buffer_appendscaledi16be),
+	HALF(nom_buffer_readscaledi16be),
+	HALF(nom_buffer_readscaledi16benext),
+	VARINT(nom_buffer_writevaru32, 4),
+	VARINT(nom_buffer_writevaru32next, 4),
+	VARINT(nom_buffer_appendvaru32, 4),
+	VARINT(nom_buffer_readvaru32, 4),
+	VARINT(nom_buffer_readvaru32next, 4),
+	VARINT(nom_buffer_writevaru64, 8),
+	VARINT(nom_buffer_writevaru64next, 8),
+	VARINT(nom_buffer_appendvaru64, 8),
+	VARINT(nom_buffer_readvaru64, 8),
+	VARINT(nom_buffer_readvaru64next, 8),
+	VARINT(nom_buffer_writevari32, 4),
+	VARINT(nom_buffer_writevari32next, 4),
+	VARINT(nom_buffer_appendvari32, 4),
+	VARINT(nom_buffer_readvari32, 4),
+	VARINT(nom_buffer_readvari32next, 4),
+	VARINT(nom_buffer_writevari64, 8),
+	VARINT(nom_buffer_writevari64next, 8),
+	VARINT(nom_buffer_appendvari64, 8),
+	VARINT(nom_buffer_readvari64, 8),
+	VARINT(nom_buffer_readvari64next, 8),
+	ARRAY(nom_buffer_writecomplexle, 4),
+	ARRAY(nom_buffer_writecomplexlenext, 4),
+	ARRAY(nom_buffer_writecomplexbe, 4),
+	ARRAY(nom_buffer_writecomplexbenext, 4),
+	ARRAY(nom_buffer_appendcomplexle, 4),
+	ARRAY(nom_buffer_appendcomplexbe, 4),
+	ARRAY(nom_buffer_readcomplexle, 4),
+	ARRAY(nom_buffer_readcomplexlenext, 4),
+	ARRAY(nom_buffer_readcomplexbe, 4),
+	ARRAY(nom_buffer_readcomplexbenext, 4),
+	VARINT(nom_buffer_writevar, 4),
+	VARINT(nom_buffer_writevarnext, 4),
+	VARINT(nom_buffer_appendvar, 4),
+	VARINT(nom_buffer_readvar, 4),
+	VARINT(nom_buffer_readvarnext, 4),
+	PACK(nom_buffer_packbits),
+	PACK(nom_buffer_packbitsnext),
+	PACK(nom_buffer_unpackbits),
+	PACK(nom_buffer_unpackbitsnext),
+	PACK(nom_bitreader_read),
+	PACK(nom_bitwriter_write),
+	SINGLE(nom_buffer_readbit),
+	SINGLE(nom_buffer_readbitnext),
+	SINGLE(nom_buffer_readbits),
+	SINGLE(nom_buffer_readbitsnext),
+	SINGLE(nom_buffer_setbit),
+	SINGLE(nom_buffer_setbitnext),
+	SINGLE(nom_buffer_clearbit),
+	SINGLE(nom_buffer_clearbitnext),
+	SINGLE(nom_buffer_flipbit),
+	SINGLE(nom_buffer_flipbitnext),
+	SINGLE(nom_buffer_setbits),
+	SINGLE(nom_buffer_setbitsnext),
+	SINGLE(nom_buffer_seekbit),
+	SINGLE(nom_buffer_afterbit),
+	SINGLE(nom_buffer_alignbit),
+	SINGLE(nom_buffer_seekbyte),
+	SINGLE(nom_buffer_afterbyte),
+	SINGLE(nom_buffer_alignbyte),
+	WHOLE(nom_buffer_clearallbits),
+	WHOLE(nom_buffer_setallbits),
+	WHOLE(nom_buffer_flipallbits),
+	WHOLE(nom_buffer_setbitrange),
+	WHOLE(nom_buffer_clearbitrange),
+	WHOLE(nom_buffer_flipbitrange),
+	WHOLE(nom_buffer_popcount),
+	{"nom_buffer_findset", run_nom_buffer_findset, prepare_findset,
+	 BENCH_WHOLE, 1, 8},
+	{"nom_buffer_findclear", run_nom_buffer_findclear, prepare_findclear,
+	 BENCH_WHOLE, 1, 8},
+	WHOLE(nom_crc32c),
+	WHOLE(nom_xxh64),
+	{"nom_lz_compress", run_nom_lz_compress, prepare_lz, BENCH_WHOLE, 1, 8},
+	{"nom_lz_decompress", run_nom_lz_decompress, prepare_lz, BENCH_WHOLE, 1,
+	 8},
+	{"nom_buffer_findbyte", run_nom_buffer_findbyte, prepare_scan,
+	 BENCH_WHOLE, 1, 8},
+	{"nom_buffer_findany", run_nom_buffer_findany, prepare_scan,
+	 BENCH_WHOLE, 1, 8},
+	{"nom_buffer_findpattern", run_nom_buffer_findpattern, prepare_scan,
+	 BENCH_WHOLE, 1, 8},
+	{"nom_buffer_findall", run_nom_buffer_findall, prepare_lz,
+	 BENCH_WHOLE, 1, 8},
+	WHOLE(nom_buffer_slice),
+	WHOLE(nom_buffer_grow),
+	WHOLE(nom_buffer_ensure),
+	WHOLE(nom_buffer_reserve),
+};
+
+/* the counts swept for arrays, after which comes one that makes the footprint dram-sized */
+static const int64_t array_counts[] = {1, 16, 256, 4096};
+
+/* the byte counts swept for whole-buffer operations, before the dram-sized one */
+static const int64_t whole_counts[] = {64, 4096, 262144};
+
+/* the buffer and caller-side alignments swept for cache-resident arrays, dram-sized ones only use the first */
+static const int64_t aligns[][2] = {{0, 0}, {1, 0}, {0, 3}, {1, 3}};
+
+/* a row of a baseline */
+typedef struct BenchRow {
+	char name[64];
+	int64_t count;
+	int64_t buf_align;
+	int64_t host_align;
+	double ns;
+} BenchRow;
+
+static struct BenchRow *baseline;
+static int64_t baseline_rows;
+
+/* bench_now returns a monotonic time in nanoseconds */
+static double bench_now(void) {
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (double)(t.tv_sec) * 1e9 + (double)(t.tv_nsec);
+}
+
+/* bench_measure returns the fastest time per iteration out of several runs that each take at least min_ns */
+static double bench_measure(const struct Bench *bn, struct BenchCtx *c,
+			    double min_ns) {
+	double t, best = 0;
+	int64_t iters = 1;
+	int r;
+
+	for (;;) {
+		t = bench_now();
+		bn->run(c, iters);
+		t = bench_now() - t;
+		if (t >= min_ns) {
+			break;
+		}
+		iters = t < min_ns / 16 ? iters * 16 : iters * 2;
+	}
+	best = t / (double)(iters);
+	for (r = 0; r < 4; r++) {
+		t = bench_now();
+		bn->run(c, iters);
+		t = (bench_now() - t) / (double)(iters);
+		best = t < best ? t : best;
+	}
+	return best;
+}
+
+/* bench_load reads a baseline written by an earlier run, returning -1 if it can't be opened */
+static int bench_load(const char *path) {
+	char line[256];
+	struct BenchRow row;
+	int64_t cap = 0;
+	FILE *f = fopen(path, "r");
+
+	if (f == NULL) {
+		return -1;
+	}
+	while (fgets(line, sizeof(line), f) != NULL) {
+		if (sscanf(line, "%63[^,],%" SCNd64 ",%" SCNd64 ",%" SCNd64
+			   ",%*[^,],%*[^,],%lf",
+			   row.name, &row.count, &row.buf_align,
+			   &row.host_align, &row.ns) != 5) {
+			continue;
+		}
+		if (baseline_rows == cap) {
+			cap = cap == 0 ? 256 : cap * 2;
+			baseline = (struct BenchRow *)(realloc(
+				baseline, cap * sizeof(struct BenchRow)));
+			if (baseline == NULL) {
+				fclose(f);
+				return -1;
+			}
+		}
+		baseline[baseline_rows++] = row;
+	}
+	fclose(f);
+	return 0;
+}
+
+/* bench_find returns the baseline's time for a measurement, or 0 if it has none */
+static double bench_find(const char *name, int64_t count, int64_t buf_align,
+			 int64_t host_align) {
+	int64_t i;
+
+	for (i = 0; i < baseline_rows; i++) {
+		if (baseline[i].count == count &&
+		    baseline[i].buf_align == buf_align &&
+		    baseline[i].host_align == host_align &&
+		    strcmp(baseline[i].name, name) == 0) {
+			return baseline[i].ns;
+		}
+	}
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	const char *filter = NULL, *baseline_path = NULL, *footprint, *status;
+	double min_ns = 20e6, threshold = 10, ns, base;
+	int64_t dram = (int64_t)(256) << 20, counts[8], ncounts, i, j, k, slow;
+	int64_t bytes, host_size, buf_size, regressions = 0;
+	uint8_t *host;
+	struct BenchCtx c;
+	const struct Bench *bn;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+			filter = argv[++i];
+
+		} else if (strcmp(argv[i], "--time") == 0 && i + 1 < argc) {
+			min_ns = atof(argv[++i]) * 1e6;
+
+		} else if (strcmp(argv[i], "--dram") == 0 && i + 1 < argc) {
+			dram = (int64_t)(atol(argv[++i])) << 20;
+
+		} else if (strcmp(argv[i], "--cpu") == 0 && i + 1 < argc) {
+			nom_cpu_restrict((int)(strtol(argv[++i], NULL, 0)));
+
+		} else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+			baseline_path = argv[++i];
+
+		} else if (strcmp(argv[i], "--threshold") == 0 &&
+			   i + 1 < argc) {
+			threshold = atof(argv[++i]);
+
+		} else {
+			fprintf(stderr,
+				"usage: %s [--filter substring] [--time ms] "
+				"[--dram mib] [--cpu mask] [--baseline file] "
+				"[--threshold percent]\n",
+				argv[0]);
+			return 2;
+		}
+	}
+	if (baseline_path != NULL && bench_load(baseline_path) != 0) {
+		fprintf(stderr, "%s: can't read baseline %s\n", argv[0],
+			baseline_path);
+		return 2;
+	}
+
+	/* varints of u32s take up to 5 bytes where the caller has 4, and prepare_lz puts a block of up to nom_lz_bound bytes after the data, so the buffer gets the footprint plus that */
+	host_size = dram + 64;
+	buf_size = dram + nom_lz_bound(dram) + 64;
+	host = (uint8_t *)(malloc(host_size));
+	nom_buffer_new(&c.b, buf_size);
+	if (host == NULL || c.b.buf == NULL) {
+		fprintf(stderr, "%s: can't allocate %" PRId64 " bytes\n",
+			argv[0], host_size + buf_size);
+		return 2;
+	}
+	memset(host, 0x5a, host_size);
+	memset(c.b.buf, 0xa5, c.b.cap);
+
+	printf("name,count,buf_align,host_align,footprint,bytes,ns_per_op,"
+	       "gb_per_s%s\n",
+	       baseline_path != NULL ? ",baseline_ns,change_pct,status" : "");
+	for (i = 0; i < (int64_t)(sizeof(benches) / sizeof(benches[0]));
+	     i++) {
+		bn = &benches[i];
+		if (filter != NULL && strstr(bn->name, filter) == NULL) {
+			continue;
+		}
+		ncounts = 0;
+		if (bn->kind == BENCH_ARRAY) {
+			for (j = 0; j < 4; j++) {
+				counts[ncounts++] = array_counts[j];
+			}
+			counts[ncounts++] = dram / bn->elem;
+
+		} else if (bn->kind == BENCH_WHOLE) {
+			for (j = 0; j < 3; j++) {
+				counts[ncounts++] = whole_counts[j];
+			}
+			counts[ncounts++] = dram;
+
+		} else {
+			counts[ncounts++] = 1;
+		}
+		for (j = 0; j < ncounts; j++) {
+			for (k = 0; k < 4; k++) {
+				if (k > 0 && (bn->kind != BENCH_ARRAY ||
+					      j == ncounts - 1)) {
+					break;
+				}
+				c.off = aligns[k][0];
+				c.host = host + aligns[k][1];
+				c.n = counts[j];
+				c.b.off = c.off;
+				c.b.boff = c.off * 8;
+				if (bn->prepare != NULL) {
+					bn->prepare(&c);
+				}
+				ns = bench_measure(bn, &c, min_ns);
+				bytes = 1;
+				if (bn->kind == BENCH_ARRAY) {
+					bytes = (c.n * bn->bits + 7) / 8;
+
+				} else if (bn->kind == BENCH_WHOLE) {
+					bytes = c.n;
+				}
+				footprint = "cache";
+				if (j == ncounts - 1 &&
+				    bn->kind != BENCH_SINGLE) {
+					footprint = "dram";
+				}
+				printf("%s,%" PRId64 ",%" PRId64 ",%" PRId64
+				       ",%s,%" PRId64 ",%.3f,%.3f",
+				       bn->name, c.n, aligns[k][0],
+				       aligns[k][1], footprint, bytes, ns,
+				       (double)(bytes) / ns);
+				if (baseline_path == NULL) {
+					printf("\n");
+					fflush(stdout);
+					continue;
+				}
+				base = bench_find(bn->name, c.n, aligns[k][0],
+						  aligns[k][1]);
+				slow = base > 0 &&
+				       ns > base * (1 + threshold / 100);
+				regressions += slow;
+				status = slow ? "regressed" : "ok";
+				if (base <= 0) {
+					status = "new";
+				}
+				printf(",%.3f,%.1f,%s\n", base,
+				       base > 0 ? (ns / base - 1) * 100 : 0,
+				       status);
+				fflush(stdout);
+			}
+		}
+	}
+	free(host);
+	nom_buffer_release(&c.b);
+	free(baseline);
+	if (regressions > 0) {
+		fprintf(stderr,
+			"%" PRId64 " measurements regressed by more than "
+			"%.1f%%\n",
+			regressions, threshold);
+		return 1;
+	}
+	return 0;
+}
@@ -10,7 +10,6 @@ file, You can obtain one at https://mozilla.org/MPL/2.0/.
 */
 
 //TODO(superwhiskers): consider making the iterator `i` variables use a int64_t
-//TODO(superwhiskers): add in support for signed integers and floating point numbers
 
 #ifndef NOM_NOM_H
 #define NOM_NOM_H
@@ -21,6 +20,421 @@ file, You can obtain one at https://mozilla.org/MPL/2.0/.
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__unix__) || defined(__APPLE__)
+#define NOM_POSIX 1
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define NOM_BIG_ENDIAN 1
+#else
+#define NOM_BIG_ENDIAN 0
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) &&                              \
+	(defined(__x86_64__) || defined(__i386__))
+#define NOM_X86 1
+#include <immintrin.h>
+#endif
+
+/* every function is static inline unless NOM_EXTERN is defined, in which case
+   they use the c99 inline model and exactly one c translation unit defines
+   NOM_IMPLEMENTATION before including nom to emit the out-of-line copies and
+   the shared state (cpu features, stats, trace hooks and the crc tables).
+   the state is shared without NOM_EXTERN too: each translation unit defines
+   it weakly (or as an inline variable in c++17) and the linker keeps one
+   copy, except where neither is available (windows, and compilers other than
+   gcc and clang), where it falls back to a copy per translation unit */
+#if !defined(NOM_EXTERN)
+#define NOM_API static inline
+#define NOM_INIT(...) = __VA_ARGS__
+#if !(defined(__GNUC__) || defined(__clang__)) || defined(_WIN32)
+#define NOM_DATA static
+#elif defined(__cplusplus) && __cplusplus >= 201703L
+#define NOM_DATA inline
+#elif defined(__cplusplus)
+#define NOM_DATA static
+#else
+#define NOM_DATA __attribute__((weak))
+#endif
+#elif defined(__cplusplus)
+#define NOM_API inline
+#define NOM_DATA extern "C"
+#elif defined(NOM_IMPLEMENTATION)
+#define NOM_API extern inline
+#define NOM_DATA
+#else
+#define NOM_API inline
+#define NOM_DATA extern
+#endif
+
+#if defined(NOM_EXTERN) && !defined(NOM_INIT)
+#if defined(NOM_IMPLEMENTATION)
+#define NOM_INIT(...) = __VA_ARGS__
+#else
+#define NOM_INIT(...)
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define NOM_ALWAYS_INLINE __attribute__((always_inline))
+#else
+#define NOM_ALWAYS_INLINE
+#endif
+
+#if defined(__cplusplus)
+#define NOM_THREAD_LOCAL thread_local
+#elif defined(_MSC_VER)
+#define NOM_THREAD_LOCAL __declspec(thread)
+#else
+#define NOM_THREAD_LOCAL _Thread_local
+#endif
+
+/* NOM_LOAD, NOM_STORE and NOM_CAS access state that any thread can fill in, with the given __ATOMIC_ order on compilers that have the builtins. NOM_CAS stores v if *p is *expected and returns 1, or loads *p into *expected and returns 0 */
+#if defined(__GNUC__) || defined(__clang__)
+#define NOM_LOAD(p, order) __atomic_load_n(p, __ATOMIC_##order)
+#define NOM_STORE(p, v, order) __atomic_store_n(p, v, __ATOMIC_##order)
+#define NOM_CAS(p, expected, v, order)                                         \
+	__atomic_compare_exchange_n(p, expected, v, 0, __ATOMIC_##order,       \
+				    __ATOMIC_RELAXED)
+#else
+#define NOM_LOAD(p, order) (*(p))
+#define NOM_STORE(p, v, order) (void)(*(p) = (v))
+#define NOM_CAS(p, expected, v, order)                                         \
+	(*(p) == *(expected) ? (*(p) = (v), 1) : (*(expected) = *(p), 0))
+#endif
+
+/* instruction set extensions nom knows how to use, as returned by nom_cpu_features */
+#define NOM_CPU_SSSE3 0x01
+#define NOM_CPU_AVX2 0x02
+#define NOM_CPU_AVX512BW 0x04
+#define NOM_CPU_POPCNT 0x08
+#define NOM_CPU_F16C 0x10
+#define NOM_CPU_SSE42 0x20
+#define NOM_CPU_PCLMUL 0x40
+
+/* the detected extensions, masked by nom_cpu_restrict (-1 means not yet detected), which threads detecting them at the same time all store the same value to */
+NOM_DATA int nom_cpu_detected NOM_INIT(-1);
+NOM_DATA int nom_cpu_allowed NOM_INIT(-1);
+
+/* nom_cpu_features returns the simd extensions nom is allowed to use on this machine */
+NOM_API int nom_cpu_features(void) {
+	int f = NOM_LOAD(&nom_cpu_detected, RELAXED);
+
+	if (f < 0) {
+		f = 0;
+#ifdef NOM_X86
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("ssse3"))
+			f |= NOM_CPU_SSSE3;
+		if (__builtin_cpu_supports("avx2"))
+			f |= NOM_CPU_AVX2;
+		if (__builtin_cpu_supports("avx512bw"))
+			f |= NOM_CPU_AVX512BW;
+		if (__builtin_cpu_supports("popcnt"))
+			f |= NOM_CPU_POPCNT;
+		if (__builtin_cpu_supports("f16c"))
+			f |= NOM_CPU_F16C;
+		if (__builtin_cpu_supports("sse4.2"))
+			f |= NOM_CPU_SSE42;
+		if (__builtin_cpu_supports("pclmul"))
+			f |= NOM_CPU_PCLMUL;
+#endif
+		NOM_STORE(&nom_cpu_detected, f, RELAXED);
+	}
+	return f & NOM_LOAD(&nom_cpu_allowed, RELAXED);
+}
+
+/* the byte swapping kernel picked by nom_byteorder, reset by nom_cpu_restrict */
+typedef void (*NomSwapKernel)(uint8_t *dst, const uint8_t *src, int64_t len,
+			      int size);
+NOM_DATA NomSwapKernel nom_swap_kernel NOM_INIT(NULL);
+
+/* nom_cpu_restrict limits the simd extensions nom will use to the ones in mask, which calls already under way in other threads can miss */
+NOM_API void nom_cpu_restrict(int mask) {
+	NOM_STORE(&nom_cpu_allowed, mask, RELAXED);
+	NOM_STORE(&nom_swap_kernel, (NomSwapKernel)(NULL), RELAXED);
+}
+
+/* nom_bswap16 reverses the byte order of a u16 */
+NOM_API NOM_ALWAYS_INLINE uint16_t nom_bswap16(uint16_t v) {
+	return (uint16_t)((v >> 8) | (v << 8));
+}
+
+/* nom_bswap32 reverses the byte order of a u32 */
+NOM_API NOM_ALWAYS_INLINE uint32_t nom_bswap32(uint32_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_bswap32(v);
+#else
+	return (v >> 24) | ((v >> 8) & 0xff00) | ((v << 8) & 0xff0000) |
+	       (v << 24);
+#endif
+}
+
+/* nom_bswap64 reverses the byte order of a u64 */
+NOM_API NOM_ALWAYS_INLINE uint64_t nom_bswap64(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_bswap64(v);
+#else
+	return ((uint64_t)(nom_bswap32((uint32_t)(v))) << 32) |
+	       nom_bswap32((uint32_t)(v >> 32));
+#endif
+}
+
+/* nom_load64be loads a big endian u64 from p, which doesn't have to be aligned */
+NOM_API NOM_ALWAYS_INLINE uint64_t nom_load64be(const uint8_t *p) {
+	uint64_t v;
+
+	memcpy(&v, p, 8);
+#if !NOM_BIG_ENDIAN
+	v = nom_bswap64(v);
+#endif
+	return v;
+}
+
+/* nom_load64le loads a little endian u64 from p, which doesn't have to be aligned */
+NOM_API NOM_ALWAYS_INLINE uint64_t nom_load64le(const uint8_t *p) {
+	uint64_t v;
+
+	memcpy(&v, p, 8);
+#if NOM_BIG_ENDIAN
+	v = nom_bswap64(v);
+#endif
+	return v;
+}
+
+/* nom_store32be stores v to p in big endian, which doesn't have to be aligned */
+NOM_API NOM_ALWAYS_INLINE void nom_store32be(uint8_t *p, uint32_t v) {
+#if !NOM_BIG_ENDIAN
+	v = nom_bswap32(v);
+#endif
+	memcpy(p, &v, 4);
+}
+
+/* nom_swap_scalar reverses the byte order of each size byte element in src into dst */
+NOM_API void nom_swap_scalar(uint8_t *dst, const uint8_t *src, int64_t len,
+			     int size) {
+	int64_t i;
+	uint16_t v16;
+	uint32_t v32;
+	uint64_t v64;
+
+	switch (size) {
+	case 2:
+		for (i = 0; i + 2 <= len; i += 2) {
+			memcpy(&v16, src + i, 2);
+			v16 = nom_bswap16(v16);
+			memcpy(dst + i, &v16, 2);
+		}
+		break;
+
+	case 4:
+		for (i = 0; i + 4 <= len; i += 4) {
+			memcpy(&v32, src + i, 4);
+			v32 = nom_bswap32(v32);
+			memcpy(dst + i, &v32, 4);
+		}
+		break;
+
+	case 8:
+		for (i = 0; i + 8 <= len; i += 8) {
+			memcpy(&v64, src + i, 8);
+			v64 = nom_bswap64(v64);
+			memcpy(dst + i, &v64, 8);
+		}
+		break;
+	}
+}
+
+#ifdef NOM_X86
+/* nom_swap_mask returns the pshufb control that reverses each size byte lane of a 16 byte block */
+__attribute__((target("ssse3"))) NOM_API __m128i nom_swap_mask(int size) {
+	switch (size) {
+	case 2:
+		return _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13,
+				     12, 15, 14);
+	case 4:
+		return _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15,
+				     14, 13, 12);
+	default:
+		return _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12,
+				     11, 10, 9, 8);
+	}
+}
+
+/* nom_swap_ssse3 is nom_swap_scalar for 16 bytes at a time */
+__attribute__((target("ssse3"))) NOM_API void
+nom_swap_ssse3(uint8_t *dst, const uint8_t *src, int64_t len, int size) {
+	__m128i mask = nom_swap_mask(size);
+	int64_t i = 0;
+
+	for (; i + 16 <= len; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+		_mm_storeu_si128((__m128i *)(dst + i),
+				 _mm_shuffle_epi8(v, mask));
+	}
+	nom_swap_scalar(dst + i, src + i, len - i, size);
+}
+
+/* the vector kernels wider than ssse3 cost about 200ns to get going on some cpus when the wide units have been idle, so they only take arrays of at least this many bytes. once running they save about 200ns over ssse3 at 8KiB and 300 to 500ns at 16KiB, so this is the smallest power of two whose saving clearly pays for the warm-up */
+#define NOM_SWAP_WIDE 16384
+
+/* nom_swap_avx2 is nom_swap_scalar for 64 bytes at a time */
+__attribute__((target("avx2"))) NOM_API void
+nom_swap_avx2(uint8_t *dst, const uint8_t *src, int64_t len, int size) {
+	__m256i mask;
+	int64_t i = 0;
+
+	if (len < NOM_SWAP_WIDE) {
+		nom_swap_ssse3(dst, src, len, size);
+		return;
+	}
+	mask = _mm256_broadcastsi128_si256(nom_swap_mask(size));
+	for (; i + 64 <= len; i += 64) {
+		__m256i v0 = _mm256_loadu_si256((const __m256i *)(src + i));
+		__m256i v1 =
+			_mm256_loadu_si256((const __m256i *)(src + i + 32));
+		_mm256_storeu_si256((__m256i *)(dst + i),
+				    _mm256_shuffle_epi8(v0, mask));
+		_mm256_storeu_si256((__m256i *)(dst + i + 32),
+				    _mm256_shuffle_epi8(v1, mask));
+	}
+	nom_swap_ssse3(dst + i, src + i, len - i, size);
+}
+
+/* nom_swap_avx512 is nom_swap_scalar for 128 bytes at a time */
+__attribute__((target("avx512f,avx512bw"))) NOM_API void
+nom_swap_avx512(uint8_t *dst, const uint8_t *src, int64_t len, int size) {
+	__m512i mask;
+	int64_t i = 0;
+
+	if (len < NOM_SWAP_WIDE) {
+		nom_swap_avx2(dst, src, len, size);
+		return;
+	}
+	mask = _mm512_broadcast_i32x4(nom_swap_mask(size));
+	for (; i + 128 <= len; i += 128) {
+		__m512i v0 = _mm512_loadu_si512((const void *)(src + i));
+		__m512i v1 = _mm512_loadu_si512((const void *)(src + i + 64));
+		_mm512_storeu_si512((void *)(dst + i),
+				    _mm512_shuffle_epi8(v0, mask));
+		_mm512_storeu_si512((void *)(dst + i + 64),
+				    _mm512_shuffle_epi8(v1, mask));
+	}
+	nom_swap_avx2(dst + i, src + i, len - i, size);
+}
+#endif
+
+/* nom_ctz64 returns the amount of trailing zero bits in v, which must not be 0 */
+NOM_API int nom_ctz64(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(v);
+#else
+	int n = 0;
+	while (!(v & 1)) {
+		v >>= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+/* nom_clz64 returns the amount of leading zero bits in v, which must not be 0 */
+NOM_API int nom_clz64(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_clzll(v);
+#else
+	int n = 0;
+	while (!(v & (UINT64_C(1) << 63))) {
+		v <<= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+/* nom_byteorder copies n size byte elements from src to dst, converting host order to or from big (1) or little (0) endian */
+NOM_API void nom_byteorder(void *dst, const void *src, int64_t n, int size,
+			   int big) {
+	NomSwapKernel k;
+
+	if (n <= 0) {
+		return;
+	}
+	if (big == NOM_BIG_ENDIAN) {
+		memcpy(dst, src, n * size);
+		return;
+	}
+	k = NOM_LOAD(&nom_swap_kernel, RELAXED);
+	if (k == NULL) {
+		int f = nom_cpu_features();
+		k = nom_swap_scalar;
+#ifdef NOM_X86
+		if (f & NOM_CPU_AVX512BW) {
+			k = nom_swap_avx512;
+
+		} else if (f & NOM_CPU_AVX2) {
+			k = nom_swap_avx2;
+
+		} else if (f & NOM_CPU_SSSE3) {
+			k = nom_swap_ssse3;
+		}
+#else
+		(void)f;
+#endif
+		NOM_STORE(&nom_swap_kernel, k, RELAXED);
+	}
+
+	/* a vector kernel would only set up its mask to reach its scalar tail, which costs more than swapping a few elements */
+	if (n * size < 16) {
+		nom_swap_scalar((uint8_t *)dst, (const uint8_t *)src, n * size,
+				size);
+		return;
+	}
+	k((uint8_t *)dst, (const uint8_t *)src, n * size, size);
+}
+
+/* a growth policy returns the new allocation size for a buffer that has alloc bytes allocated and needs at least needed */
+typedef int64_t (*NomGrowthPolicy)(int64_t alloc, int64_t needed);
+
+/* hooks nom allocates memory through, each given back the size of the block it hands out or takes back */
+typedef struct NomAllocator {
+	void *(*allocate)(void *ctx, size_t n);
+	void *(*reallocate)(void *ctx, void *p, size_t old_size, size_t n);
+	void (*deallocate)(void *ctx, void *p, size_t n);
+	void *ctx;
+} NomAllocator;
+
+/* nom_alloc allocates n bytes with a, or with malloc if a is NULL */
+NOM_API void *nom_alloc(const struct NomAllocator *a, size_t n) {
+	return a == NULL ? malloc(n) : a->allocate(a->ctx, n);
+}
+
+/* nom_realloc resizes a block of old_size bytes allocated with a to n bytes */
+NOM_API void *nom_realloc(const struct NomAllocator *a, void *p,
+			  size_t old_size, size_t n) {
+	return a == NULL ? realloc(p, n)
+			 : a->reallocate(a->ctx, p, old_size, n);
+}
+
+/* nom_free releases a block of n bytes allocated with a */
+NOM_API void nom_free(const struct NomAllocator *a, void *p, size_t n) {
+	if (a == NULL) {
+		free(p);
+
+	} else {
+		a->deallocate(a->ctx, p, n);
+	}
+}
+
+struct NomStream;
+struct NomChecksum;
+struct NomShared;
+
 /* a high-performance buffer type */
 typedef struct NomBuffer {
 	/* you shouldn't modify any of these directly, but you *can* */
@@ -29,428 +443,3762 @@ typedef struct NomBuffer {
 	int64_t cap;
 	int64_t boff;
 	int64_t bcap;
+	int64_t alloc; /* the amount of bytes allocated for buf, at least cap */
+	NomGrowthPolicy growth; /* how to grow the allocation, NULL means nom_growth_geometric */
+	int flags; /* where buf came from, see the NOM_BUFFER_ constants */
+	struct NomStream *stream; /* the stream buf is a window into, or NULL */
+	struct NomChecksum *checksum; /* fed every byte the *next functions move, or NULL */
+	const struct NomAllocator *allocator; /* where buf and the buffer itself came from, NULL means malloc */
+	struct NomShared *shared; /* the storage buf points into while slices share it, or NULL */
 } NomBuffer;
 
-/* nom_buffer_new creates a new buffer */
-void nom_buffer_new(struct NomBuffer *out, int64_t initial_size) {
-	out->off = 0x00;
-	out->cap = initial_size;
-	out->boff = 0x00;
-	out->bcap = initial_size * 8;
+/* a slice is a buffer over part of another buffer's storage, which it shares instead of copying */
+typedef struct NomBuffer NomSlice;
+
+/* buf is a file mapping created by nom_buffer_mapfile, and can't be resized */
+#define NOM_BUFFER_MAPPED 0x01
+
+/* buf is a file mapping made with NOM_MAP_WRITE, whose writes have to reach the file and so can't be moved to a private copy */
+#define NOM_BUFFER_MAPWRITE 0x02
+
+/* what went through nom on one thread, counted when nom is built with NOM_STATS defined and always zero otherwise */
+typedef struct NomStats {
+	int64_t reads; /* calls to the byte, integer and varint read functions */
+	int64_t read_bytes;
+	int64_t writes; /* calls to the byte, integer and varint write functions */
+	int64_t write_bytes;
+	int64_t bit_ops; /* calls to the bit functions */
+	int64_t bits; /* the amount of bits they read or wrote */
+	int64_t misaligned; /* integer reads and writes that didn't start on a multiple of the integer's size */
+	int64_t grows; /* times a buffer's storage was reallocated to make it bigger */
+	int64_t grow_bytes_copied; /* bytes moved by the reallocations that couldn't extend in place */
+	int64_t peak_capacity; /* the biggest allocation a buffer was created with or grew to */
+} NomStats;
+
+/* the events passed to a trace hook */
+#define NOM_TRACE_READ 0 /* off and n are the byte offset and length of a read */
+#define NOM_TRACE_WRITE 1 /* off and n are the byte offset and length of a write */
+#define NOM_TRACE_BITS 2 /* off and n are the bit offset and length of a bit operation */
+#define NOM_TRACE_GROW 3 /* off and n are the old and new allocation sizes */
+
+/* a trace hook, called on the thread that caused every event counted in NomStats */
+typedef void (*NomTraceFn)(void *ctx, int event, const struct NomBuffer *b,
+			   int64_t off, int64_t n);
+
+/* a trace hook along with its context, which are swapped in together so no thread ever calls one hook with another's context */
+typedef struct NomTrace {
+	NomTraceFn fn;
+	void *ctx;
+	struct NomTrace *next; /* the hook made before this one */
+} NomTrace;
+
+#ifdef NOM_STATS
+NOM_DATA NOM_THREAD_LOCAL struct NomStats nom_stats_local;
+
+/* the installed hook, and every hook made so far, which are kept since threads can still be calling them after they are swapped out */
+NOM_DATA struct NomTrace *nom_trace NOM_INIT(NULL);
+NOM_DATA struct NomTrace *nom_trace_hooks NOM_INIT(NULL);
+
+/* nom_stats_trace calls the installed trace hook, if there is one */
+NOM_API NOM_ALWAYS_INLINE void nom_stats_trace(int event,
+					       const struct NomBuffer *b,
+					       int64_t off, int64_t n) {
+	struct NomTrace *t = NOM_LOAD(&nom_trace, ACQUIRE);
+
+	if (t != NULL) {
+		t->fn(t->ctx, event, b, off, n);
+	}
+}
+
+/* nom_stats_access counts a read, write or bit operation of n bytes (or bits) at off, whose elements are size bytes */
+NOM_API NOM_ALWAYS_INLINE void nom_stats_access(int event,
+						const struct NomBuffer *b,
+						int64_t off, int64_t n,
+						int size) {
+	struct NomStats *s = &nom_stats_local;
+
+	if (event == NOM_TRACE_READ) {
+		s->reads++;
+		s->read_bytes += n;
+	} else if (event == NOM_TRACE_WRITE) {
+		s->writes++;
+		s->write_bytes += n;
+	} else {
+		s->bit_ops++;
+		s->bits += n;
+	}
+	if (size > 1 && ((uintptr_t)(b->buf + off) & (uintptr_t)(size - 1))) {
+		s->misaligned++;
+	}
+	nom_stats_trace(event, b, off, n);
+}
+
+/* nom_stats_alloc counts a buffer's allocation going from old to n bytes, which moved says had to be copied */
+NOM_API void nom_stats_alloc(const struct NomBuffer *b, int64_t old, int64_t n,
+			     int moved) {
+	struct NomStats *s = &nom_stats_local;
+
+	if (old > 0) {
+		s->grows++;
+		s->grow_bytes_copied += moved ? old : 0;
+		nom_stats_trace(NOM_TRACE_GROW, b, old, n);
+	}
+	if (n > s->peak_capacity) {
+		s->peak_capacity = n;
+	}
+}
+
+#define NOM_STAT_ACCESS(event, b, off, n, size)                                \
+	nom_stats_access(event, b, off, n, size)
+#define NOM_STAT_ALLOC(b, old, n, moved) nom_stats_alloc(b, old, n, moved)
+#else
+#define NOM_STAT_ACCESS(event, b, off, n, size) ((void)0)
+#define NOM_STAT_ALLOC(b, old, n, moved) ((void)0)
+#endif
+
+/* nom_stats_snapshot copies the calling thread's counters into out */
+NOM_API void nom_stats_snapshot(struct NomStats *out) {
+#ifdef NOM_STATS
+	*out = nom_stats_local;
+#else
+	memset(out, 0, sizeof(struct NomStats));
+#endif
+}
+
+/* nom_stats_reset zeroes the calling thread's counters */
+NOM_API void nom_stats_reset(void) {
+#ifdef NOM_STATS
+	memset(&nom_stats_local, 0, sizeof(struct NomStats));
+#endif
+}
+
+/* nom_stats_settrace makes every thread call fn for each counted event, or stops that if fn is NULL, returning -1 if the hook can't be allocated. it can be called while other threads are counting events, which may still call the old hook for an event that was already under way */
+NOM_API int nom_stats_settrace(NomTraceFn fn, void *ctx) {
+#ifdef NOM_STATS
+	struct NomTrace *t = NULL;
+
+	/* a hook is made once for each fn and ctx and reused after that, so swapping between a few of them doesn't keep allocating */
+	if (fn != NULL) {
+		t = NOM_LOAD(&nom_trace_hooks, ACQUIRE);
+		while (t != NULL && (t->fn != fn || t->ctx != ctx)) {
+			t = t->next;
+		}
+	}
+	if (fn != NULL && t == NULL) {
+		t = (struct NomTrace *)(malloc(sizeof(NomTrace)));
+		if (t == NULL) {
+			return -1;
+		}
+		t->fn = fn;
+		t->ctx = ctx;
+		t->next = NOM_LOAD(&nom_trace_hooks, RELAXED);
+		while (!NOM_CAS(&nom_trace_hooks, &t->next, t, RELEASE)) {
+		}
+	}
+	NOM_STORE(&nom_trace, t, RELEASE);
+#else
+	(void)fn;
+	(void)ctx;
+#endif
+	return 0;
+}
+
+/* nom_stats_freetrace stops tracing and frees every hook nom_stats_settrace made, which no other thread can be counting events or setting a hook during */
+NOM_API void nom_stats_freetrace(void) {
+#ifdef NOM_STATS
+	struct NomTrace *t = nom_trace_hooks, *next;
+
+	nom_trace = NULL;
+	nom_trace_hooks = NULL;
+	for (; t != NULL; t = next) {
+		next = t->next;
+		free(t);
+	}
+#endif
+}
+
+/* the algorithms a NomChecksum can run */
+#define NOM_CHECKSUM_CRC32C 0 /* crc32c (castagnoli), as used by iscsi, ext4 and sctp */
+#define NOM_CHECKSUM_XXH64 1 /* the 64 bit xxhash */
+
+/* a running checksum, which a buffer's *next functions update with every byte they move when it is attached with nom_buffer_setchecksum */
+typedef struct NomChecksum {
+	int kind;
+	uint32_t crc;
+	uint64_t acc[4]; /* the xxhash lanes */
+	uint64_t seed;
+	uint64_t total; /* the amount of bytes hashed */
+	uint8_t mem[32]; /* bytes waiting for a full xxhash stripe */
+	int memsize;
+} NomChecksum;
+
+/* the crc32c polynomial, bit reversed */
+#define NOM_CRC32C_POLY UINT32_C(0x82f63b78)
+
+/* the slice-by-8 tables for crc32c without sse4.2, where table 0 is the crc of each byte and table j + 1 moves table j's crcs over one more byte. they are constants rather than filled in on first use so threads can share them without locking */
+NOM_DATA const uint32_t nom_crc32c_table[8][256] NOM_INIT({
+	{0x00000000, 0xf26b8303, 0xe13b70f7, 0x1350f3f4, 0xc79a971f, 0x35f1141c,
+	 0x26a1e7e8, 0xd4ca64eb, 0x8ad958cf, 0x78b2dbcc, 0x6be22838, 0x9989ab3b,
+	 0x4d43cfd0, 0xbf284cd3, 0xac78bf27, 0x5e133c24, 0x105ec76f, 0xe235446c,
+	 0xf165b798, 0x030e349b, 0xd7c45070, 0x25afd373, 0x36ff2087, 0xc494a384,
+	 0x9a879fa0, 0x68ec1ca3, 0x7bbcef57, 0x89d76c54, 0x5d1d08bf, 0xaf768bbc,
+	 0xbc267848, 0x4e4dfb4b, 0x20bd8ede, 0xd2d60ddd, 0xc186fe29, 0x33ed7d2a,
+	 0xe72719c1, 0x154c9ac2, 0x061c6936, 0xf477ea35, 0xaa64d611, 0x580f5512,
+	 0x4b5fa6e6, 0xb93425e5, 0x6dfe410e, 0x9f95c20d, 0x8cc531f9, 0x7eaeb2fa,
+	 0x30e349b1, 0xc288cab2, 0xd1d83946, 0x23b3ba45, 0xf779deae, 0x05125dad,
+	 0x1642ae59, 0xe4292d5a, 0xba3a117e, 0x4851927d, 0x5b016189, 0xa96ae28a,
+	 0x7da08661, 0x8fcb0562, 0x9c9bf696, 0x6ef07595, 0x417b1dbc, 0xb3109ebf,
+	 0xa0406d4b, 0x522bee48, 0x86e18aa3, 0x748a09a0, 0x67dafa54, 0x95b17957,
+	 0xcba24573, 0x39c9c670, 0x2a993584, 0xd8f2b687, 0x0c38d26c, 0xfe53516f,
+	 0xed03a29b, 0x1f682198, 0x5125dad3, 0xa34e59d0, 0xb01eaa24, 0x42752927,
+	 0x96bf4dcc, 0x64d4cecf, 0x77843d3b, 0x85efbe38, 0xdbfc821c, 0x2997011f,
+	 0x3ac7f2eb, 0xc8ac71e8, 0x1c661503, 0xee0d9600, 0xfd5d65f4, 0x0f36e6f7,
+	 0x61c69362, 0x93ad1061, 0x80fde395, 0x72966096, 0xa65c047d, 0x5437877e,
+	 0x4767748a, 0xb50cf789, 0xeb1fcbad, 0x197448ae, 0x0a24bb5a, 0xf84f3859,
+	 0x2c855cb2, 0xdeeedfb1, 0xcdbe2c45, 0x3fd5af46, 0x7198540d, 0x83f3d70e,
+	 0x90a324fa, 0x62c8a7f9, 0xb602c312, 0x44694011, 0x5739b3e5, 0xa55230e6,
+	 0xfb410cc2, 0x092a8fc1, 0x1a7a7c35, 0xe811ff36, 0x3cdb9bdd, 0xceb018de,
+	 0xdde0eb2a, 0x2f8b6829, 0x82f63b78, 0x709db87b, 0x63cd4b8f, 0x91a6c88c,
+	 0x456cac67, 0xb7072f64, 0xa457dc90, 0x563c5f93, 0x082f63b7, 0xfa44e0b4,
+	 0xe9141340, 0x1b7f9043, 0xcfb5f4a8, 0x3dde77ab, 0x2e8e845f, 0xdce5075c,
+	 0x92a8fc17, 0x60c37f14, 0x73938ce0, 0x81f80fe3, 0x55326b08, 0xa759e80b,
+	 0xb4091bff, 0x466298fc, 0x1871a4d8, 0xea1a27db, 0xf94ad42f, 0x0b21572c,
+	 0xdfeb33c7, 0x2d80b0c4, 0x3ed04330, 0xccbbc033, 0xa24bb5a6, 0x502036a5,
+	 0x4370c551, 0xb11b4652, 0x65d122b9, 0x97baa1ba, 0x84ea524e, 0x7681d14d,
+	 0x2892ed69, 0xdaf96e6a, 0xc9a99d9e, 0x3bc21e9d, 0xef087a76, 0x1d63f975,
+	 0x0e330a81, 0xfc588982, 0xb21572c9, 0x407ef1ca, 0x532e023e, 0xa145813d,
+	 0x758fe5d6, 0x87e466d5, 0x94b49521, 0x66df1622, 0x38cc2a06, 0xcaa7a905,
+	 0xd9f75af1, 0x2b9cd9f2, 0xff56bd19, 0x0d3d3e1a, 0x1e6dcdee, 0xec064eed,
+	 0xc38d26c4, 0x31e6a5c7, 0x22b65633, 0xd0ddd530, 0x0417b1db, 0xf67c32d8,
+	 0xe52cc12c, 0x1747422f, 0x49547e0b, 0xbb3ffd08, 0xa86f0efc, 0x5a048dff,
+	 0x8ecee914, 0x7ca56a17, 0x6ff599e3, 0x9d9e1ae0, 0xd3d3e1ab, 0x21b862a8,
+	 0x32e8915c, 0xc083125f, 0x144976b4, 0xe622f5b7, 0xf5720643, 0x07198540,
+	 0x590ab964, 0xab613a67, 0xb831c993, 0x4a5a4a90, 0x9e902e7b, 0x6cfbad78,
+	 0x7fab5e8c, 0x8dc0dd8f, 0xe330a81a, 0x115b2b19, 0x020bd8ed, 0xf0605bee,
+	 0x24aa3f05, 0xd6c1bc06, 0xc5914ff2, 0x37faccf1, 0x69e9f0d5, 0x9b8273d6,
+	 0x88d28022, 0x7ab90321, 0xae7367ca, 0x5c18e4c9, 0x4f48173d, 0xbd23943e,
+	 0xf36e6f75, 0x0105ec76, 0x12551f82, 0xe03e9c81, 0x34f4f86a, 0xc69f7b69,
+	 0xd5cf889d, 0x27a40b9e, 0x79b737ba, 0x8bdcb4b9, 0x988c474d, 0x6ae7c44e,
+	 0xbe2da0a5, 0x4c4623a6, 0x5f16d052, 0xad7d5351},
+	{0x00000000, 0x13a29877, 0x274530ee, 0x34e7a899, 0x4e8a61dc, 0x5d28f9ab,
+	 0x69cf5132, 0x7a6dc945, 0x9d14c3b8, 0x8eb65bcf, 0xba51f356, 0xa9f36b21,
+	 0xd39ea264, 0xc03c3a13, 0xf4db928a, 0xe7790afd, 0x3fc5f181, 0x2c6769f6,
+	 0x1880c16f, 0x0b225918, 0x714f905d, 0x62ed082a, 0x560aa0b3, 0x45a838c4,
+	 0xa2d13239, 0xb173aa4e, 0x859402d7, 0x96369aa0, 0xec5b53e5, 0xfff9cb92,
+	 0xcb1e630b, 0xd8bcfb7c, 0x7f8be302, 0x6c297b75, 0x58ced3ec, 0x4b6c4b9b,
+	 0x310182de, 0x22a31aa9, 0x1644b230, 0x05e62a47, 0xe29f20ba, 0xf13db8cd,
+	 0xc5da1054, 0xd6788823, 0xac154166, 0xbfb7d911, 0x8b507188, 0x98f2e9ff,
+	 0x404e1283, 0x53ec8af4, 0x670b226d, 0x74a9ba1a, 0x0ec4735f, 0x1d66eb28,
+	 0x298143b1, 0x3a23dbc6, 0xdd5ad13b, 0xcef8494c, 0xfa1fe1d5, 0xe9bd79a2,
+	 0x93d0b0e7, 0x80722890, 0xb4958009, 0xa737187e, 0xff17c604, 0xecb55e73,
+	 0xd852f6ea, 0xcbf06e9d, 0xb19da7d8, 0xa23f3faf, 0x96d89736, 0x857a0f41,
+	 0x620305bc, 0x71a19dcb, 0x45463552, 0x56e4ad25, 0x2c896460, 0x3f2bfc17,
+	 0x0bcc548e, 0x186eccf9, 0xc0d23785, 0xd370aff2, 0xe797076b, 0xf4359f1c,
+	 0x8e585659, 0x9dface2e, 0xa91d66b7, 0xbabffec0, 0x5dc6f43d, 0x4e646c4a,
+	 0x7a83c4d3, 0x69215ca4, 0x134c95e1, 0x00ee0d96, 0x3409a50f, 0x27ab3d78,
+	 0x809c2506, 0x933ebd71, 0xa7d915e8, 0xb47b8d9f, 0xce1644da, 0xddb4dcad,
+	 0xe9537434, 0xfaf1ec43, 0x1d88e6be, 0x0e2a7ec9, 0x3acdd650, 0x296f4e27,
+	 0x53028762, 0x40a01f15, 0x7447b78c, 0x67e52ffb, 0xbf59d487, 0xacfb4cf0,
+	 0x981ce469, 0x8bbe7c1e, 0xf1d3b55b, 0xe2712d2c, 0xd69685b5, 0xc5341dc2,
+	 0x224d173f, 0x31ef8f48, 0x050827d1, 0x16aabfa6, 0x6cc776e3, 0x7f65ee94,
+	 0x4b82460d, 0x5820de7a, 0xfbc3faf9, 0xe861628e, 0xdc86ca17, 0xcf245260,
+	 0xb5499b25, 0xa6eb0352, 0x920cabcb, 0x81ae33bc, 0x66d73941, 0x7575a136,
+	 0x419209af, 0x523091d8, 0x285d589d, 0x3bffc0ea, 0x0f186873, 0x1cbaf004,
+	 0xc4060b78, 0xd7a4930f, 0xe3433b96, 0xf0e1a3e1, 0x8a8c6aa4, 0x992ef2d3,
+	 0xadc95a4a, 0xbe6bc23d, 0x5912c8c0, 0x4ab050b7, 0x7e57f82e, 0x6df56059,
+	 0x1798a91c, 0x043a316b, 0x30dd99f2, 0x237f0185, 0x844819fb, 0x97ea818c,
+	 0xa30d2915, 0xb0afb162, 0xcac27827, 0xd960e050, 0xed8748c9, 0xfe25d0be,
+	 0x195cda43, 0x0afe4234, 0x3e19eaad, 0x2dbb72da, 0x57d6bb9f, 0x447423e8,
+	 0x70938b71, 0x63311306, 0xbb8de87a, 0xa82f700d, 0x9cc8d894, 0x8f6a40e3,
+	 0xf50789a6, 0xe6a511d1, 0xd242b948, 0xc1e0213f, 0x26992bc2, 0x353bb3b5,
+	 0x01dc1b2c, 0x127e835b, 0x68134a1e, 0x7bb1d269, 0x4f567af0, 0x5cf4e287,
+	 0x04d43cfd, 0x1776a48a, 0x23910c13, 0x30339464, 0x4a5e5d21, 0x59fcc556,
+	 0x6d1b6dcf, 0x7eb9f5b8, 0x99c0ff45, 0x8a626732, 0xbe85cfab, 0xad2757dc,
+	 0xd74a9e99, 0xc4e806ee, 0xf00fae77, 0xe3ad3600, 0x3b11cd7c, 0x28b3550b,
+	 0x1c54fd92, 0x0ff665e5, 0x759baca0, 0x663934d7, 0x52de9c4e, 0x417c0439,
+	 0xa6050ec4, 0xb5a796b3, 0x81403e2a, 0x92e2a65d, 0xe88f6f18, 0xfb2df76f,
+	 0xcfca5ff6, 0xdc68c781, 0x7b5fdfff, 0x68fd4788, 0x5c1aef11, 0x4fb87766,
+	 0x35d5be23, 0x26772654, 0x12908ecd, 0x013216ba, 0xe64b1c47, 0xf5e98430,
+	 0xc10e2ca9, 0xd2acb4de, 0xa8c17d9b, 0xbb63e5ec, 0x8f844d75, 0x9c26d502,
+	 0x449a2e7e, 0x5738b609, 0x63df1e90, 0x707d86e7, 0x0a104fa2, 0x19b2d7d5,
+	 0x2d557f4c, 0x3ef7e73b, 0xd98eedc6, 0xca2c75b1, 0xfecbdd28, 0xed69455f,
+	 0x97048c1a, 0x84a6146d, 0xb041bcf4, 0xa3e32483},
+	{0x00000000, 0xa541927e, 0x4f6f520d, 0xea2ec073, 0x9edea41a, 0x3b9f3664,
+	 0xd1b1f617, 0x74f06469, 0x38513ec5, 0x9d10acbb, 0x773e6cc8, 0xd27ffeb6,
+	 0xa68f9adf, 0x03ce08a1, 0xe9e0c8d2, 0x4ca15aac, 0x70a27d8a, 0xd5e3eff4,
+	 0x3fcd2f87, 0x9a8cbdf9, 0xee7cd990, 0x4b3d4bee, 0xa1138b9d, 0x045219e3,
+	 0x48f3434f, 0xedb2d131, 0x079c1142, 0xa2dd833c, 0xd62de755, 0x736c752b,
+	 0x9942b558, 0x3c032726, 0xe144fb14, 0x4405696a, 0xae2ba919, 0x0b6a3b67,
+	 0x7f9a5f0e, 0xdadbcd70, 0x30f50d03, 0x95b49f7d, 0xd915c5d1, 0x7c5457af,
+	 0x967a97dc, 0x333b05a2, 0x47cb61cb, 0xe28af3b5, 0x08a433c6, 0xade5a1b8,
+	 0x91e6869e, 0x34a714e0, 0xde89d493, 0x7bc846ed, 0x0f382284, 0xaa79b0fa,
+	 0x40577089, 0xe516e2f7, 0xa9b7b85b, 0x0cf62a25, 0xe6d8ea56, 0x43997828,
+	 0x37691c41, 0x92288e3f, 0x78064e4c, 0xdd47dc32, 0xc76580d9, 0x622412a7,
+	 0x880ad2d4, 0x2d4b40aa, 0x59bb24c3, 0xfcfab6bd, 0x16d476ce, 0xb395e4b0,
+	 0xff34be1c, 0x5a752c62, 0xb05bec11, 0x151a7e6f, 0x61ea1a06, 0xc4ab8878,
+	 0x2e85480b, 0x8bc4da75, 0xb7c7fd53, 0x12866f2d, 0xf8a8af5e, 0x5de93d20,
+	 0x29195949, 0x8c58cb37, 0x66760b44, 0xc337993a, 0x8f96c396, 0x2ad751e8,
+	 0xc0f9919b, 0x65b803e5, 0x1148678c, 0xb409f5f2, 0x5e273581, 0xfb66a7ff,
+	 0x26217bcd, 0x8360e9b3, 0x694e29c0, 0xcc0fbbbe, 0xb8ffdfd7, 0x1dbe4da9,
+	 0xf7908dda, 0x52d11fa4, 0x1e704508, 0xbb31d776, 0x511f1705, 0xf45e857b,
+	 0x80aee112, 0x25ef736c, 0xcfc1b31f, 0x6a802161, 0x56830647, 0xf3c29439,
+	 0x19ec544a, 0xbcadc634, 0xc85da25d, 0x6d1c3023, 0x8732f050, 0x2273622e,
+	 0x6ed23882, 0xcb93aafc, 0x21bd6a8f, 0x84fcf8f1, 0xf00c9c98, 0x554d0ee6,
+	 0xbf63ce95, 0x1a225ceb, 0x8b277743, 0x2e66e53d, 0xc448254e, 0x6109b730,
+	 0x15f9d359, 0xb0b84127, 0x5a968154, 0xffd7132a, 0xb3764986, 0x1637dbf8,
+	 0xfc191b8b, 0x595889f5, 0x2da8ed9c, 0x88e97fe2, 0x62c7bf91, 0xc7862def,
+	 0xfb850ac9, 0x5ec498b7, 0xb4ea58c4, 0x11abcaba, 0x655baed3, 0xc01a3cad,
+	 0x2a34fcde, 0x8f756ea0, 0xc3d4340c, 0x6695a672, 0x8cbb6601, 0x29faf47f,
+	 0x5d0a9016, 0xf84b0268, 0x1265c21b, 0xb7245065, 0x6a638c57, 0xcf221e29,
+	 0x250cde5a, 0x804d4c24, 0xf4bd284d, 0x51fcba33, 0xbbd27a40, 0x1e93e83e,
+	 0x5232b292, 0xf77320ec, 0x1d5de09f, 0xb81c72e1, 0xccec1688, 0x69ad84f6,
+	 0x83834485, 0x26c2d6fb, 0x1ac1f1dd, 0xbf8063a3, 0x55aea3d0, 0xf0ef31ae,
+	 0x841f55c7, 0x215ec7b9, 0xcb7007ca, 0x6e3195b4, 0x2290cf18, 0x87d15d66,
+	 0x6dff9d15, 0xc8be0f6b, 0xbc4e6b02, 0x190ff97c, 0xf321390f, 0x5660ab71,
+	 0x4c42f79a, 0xe90365e4, 0x032da597, 0xa66c37e9, 0xd29c5380, 0x77ddc1fe,
+	 0x9df3018d, 0x38b293f3, 0x7413c95f, 0xd1525b21, 0x3b7c9b52, 0x9e3d092c,
+	 0xeacd6d45, 0x4f8cff3b, 0xa5a23f48, 0x00e3ad36, 0x3ce08a10, 0x99a1186e,
+	 0x738fd81d, 0xd6ce4a63, 0xa23e2e0a, 0x077fbc74, 0xed517c07, 0x4810ee79,
+	 0x04b1b4d5, 0xa1f026ab, 0x4bdee6d8, 0xee9f74a6, 0x9a6f10cf, 0x3f2e82b1,
+	 0xd50042c2, 0x7041d0bc, 0xad060c8e, 0x08479ef0, 0xe2695e83, 0x4728ccfd,
+	 0x33d8a894, 0x96993aea, 0x7cb7fa99, 0xd9f668e7, 0x9557324b, 0x3016a035,
+	 0xda386046, 0x7f79f238, 0x0b899651, 0xaec8042f, 0x44e6c45c, 0xe1a75622,
+	 0xdda47104, 0x78e5e37a, 0x92cb2309, 0x378ab177, 0x437ad51e, 0xe63b4760,
+	 0x0c158713, 0xa954156d, 0xe5f54fc1, 0x40b4ddbf, 0xaa9a1dcc, 0x0fdb8fb2,
+	 0x7b2bebdb, 0xde6a79a5, 0x3444b9d6, 0x91052ba8},
+	{0x00000000, 0xdd45aab8, 0xbf672381, 0x62228939, 0x7b2231f3, 0xa6679b4b,
+	 0xc4451272, 0x1900b8ca, 0xf64463e6, 0x2b01c95e, 0x49234067, 0x9466eadf,
+	 0x8d665215, 0x5023f8ad, 0x32017194, 0xef44db2c, 0xe964b13d, 0x34211b85,
+	 0x560392bc, 0x8b463804, 0x924680ce, 0x4f032a76, 0x2d21a34f, 0xf06409f7,
+	 0x1f20d2db, 0xc2657863, 0xa047f15a, 0x7d025be2, 0x6402e328, 0xb9474990,
+	 0xdb65c0a9, 0x06206a11, 0xd725148b, 0x0a60be33, 0x6842370a, 0xb5079db2,
+	 0xac072578, 0x71428fc0, 0x136006f9, 0xce25ac41, 0x2161776d, 0xfc24ddd5,
+	 0x9e0654ec, 0x4343fe54, 0x5a43469e, 0x8706ec26, 0xe524651f, 0x3861cfa7,
+	 0x3e41a5b6, 0xe3040f0e, 0x81268637, 0x5c632c8f, 0x45639445, 0x98263efd,
+	 0xfa04b7c4, 0x27411d7c, 0xc805c650, 0x15406ce8, 0x7762e5d1, 0xaa274f69,
+	 0xb327f7a3, 0x6e625d1b, 0x0c40d422, 0xd1057e9a, 0xaba65fe7, 0x76e3f55f,
+	 0x14c17c66, 0xc984d6de, 0xd0846e14, 0x0dc1c4ac, 0x6fe34d95, 0xb2a6e72d,
+	 0x5de23c01, 0x80a796b9, 0xe2851f80, 0x3fc0b538, 0x26c00df2, 0xfb85a74a,
+	 0x99a72e73, 0x44e284cb, 0x42c2eeda, 0x9f874462, 0xfda5cd5b, 0x20e067e3,
+	 0x39e0df29, 0xe4a57591, 0x8687fca8, 0x5bc25610, 0xb4868d3c, 0x69c32784,
+	 0x0be1aebd, 0xd6a40405, 0xcfa4bccf, 0x12e11677, 0x70c39f4e, 0xad8635f6,
+	 0x7c834b6c, 0xa1c6e1d4, 0xc3e468ed, 0x1ea1c255, 0x07a17a9f, 0xdae4d027,
+	 0xb8c6591e, 0x6583f3a6, 0x8ac7288a, 0x57828232, 0x35a00b0b, 0xe8e5a1b3,
+	 0xf1e51979, 0x2ca0b3c1, 0x4e823af8, 0x93c79040, 0x95e7fa51, 0x48a250e9,
+	 0x2a80d9d0, 0xf7c57368, 0xeec5cba2, 0x3380611a, 0x51a2e823, 0x8ce7429b,
+	 0x63a399b7, 0xbee6330f, 0xdcc4ba36, 0x0181108e, 0x1881a844, 0xc5c402fc,
+	 0xa7e68bc5, 0x7aa3217d, 0x52a0c93f, 0x8fe56387, 0xedc7eabe, 0x30824006,
+	 0x2982f8cc, 0xf4c75274, 0x96e5db4d, 0x4ba071f5, 0xa4e4aad9, 0x79a10061,
+	 0x1b838958, 0xc6c623e0, 0xdfc69b2a, 0x02833192, 0x60a1b8ab, 0xbde41213,
+	 0xbbc47802, 0x6681d2ba, 0x04a35b83, 0xd9e6f13b, 0xc0e649f1, 0x1da3e349,
+	 0x7f816a70, 0xa2c4c0c8, 0x4d801be4, 0x90c5b15c, 0xf2e73865, 0x2fa292dd,
+	 0x36a22a17, 0xebe780af, 0x89c50996, 0x5480a32e, 0x8585ddb4, 0x58c0770c,
+	 0x3ae2fe35, 0xe7a7548d, 0xfea7ec47, 0x23e246ff, 0x41c0cfc6, 0x9c85657e,
+	 0x73c1be52, 0xae8414ea, 0xcca69dd3, 0x11e3376b, 0x08e38fa1, 0xd5a62519,
+	 0xb784ac20, 0x6ac10698, 0x6ce16c89, 0xb1a4c631, 0xd3864f08, 0x0ec3e5b0,
+	 0x17c35d7a, 0xca86f7c2, 0xa8a47efb, 0x75e1d443, 0x9aa50f6f, 0x47e0a5d7,
+	 0x25c22cee, 0xf8878656, 0xe1873e9c, 0x3cc29424, 0x5ee01d1d, 0x83a5b7a5,
+	 0xf90696d8, 0x24433c60, 0x4661b559, 0x9b241fe1, 0x8224a72b, 0x5f610d93,
+	 0x3d4384aa, 0xe0062e12, 0x0f42f53e, 0xd2075f86, 0xb025d6bf, 0x6d607c07,
+	 0x7460c4cd, 0xa9256e75, 0xcb07e74c, 0x16424df4, 0x106227e5, 0xcd278d5d,
+	 0xaf050464, 0x7240aedc, 0x6b401616, 0xb605bcae, 0xd4273597, 0x09629f2f,
+	 0xe6264403, 0x3b63eebb, 0x59416782, 0x8404cd3a, 0x9d0475f0, 0x4041df48,
+	 0x22635671, 0xff26fcc9, 0x2e238253, 0xf36628eb, 0x9144a1d2, 0x4c010b6a,
+	 0x5501b3a0, 0x88441918, 0xea669021, 0x37233a99, 0xd867e1b5, 0x05224b0d,
+	 0x6700c234, 0xba45688c, 0xa345d046, 0x7e007afe, 0x1c22f3c7, 0xc167597f,
+	 0xc747336e, 0x1a0299d6, 0x782010ef, 0xa565ba57, 0xbc65029d, 0x6120a825,
+	 0x0302211c, 0xde478ba4, 0x31035088, 0xec46fa30, 0x8e647309, 0x5321d9b1,
+	 0x4a21617b, 0x9764cbc3, 0xf54642fa, 0x2803e842},
+	{0x00000000, 0x38116fac, 0x7022df58, 0x4833b0f4, 0xe045beb0, 0xd854d11c,
+	 0x906761e8, 0xa8760e44, 0xc5670b91, 0xfd76643d, 0xb545d4c9, 0x8d54bb65,
+	 0x2522b521, 0x1d33da8d, 0x55006a79, 0x6d1105d5, 0x8f2261d3, 0xb7330e7f,
+	 0xff00be8b, 0xc711d127, 0x6f67df63, 0x5776b0cf, 0x1f45003b, 0x27546f97,
+	 0x4a456a42, 0x725405ee, 0x3a67b51a, 0x0276dab6, 0xaa00d4f2, 0x9211bb5e,
+	 0xda220baa, 0xe2336406, 0x1ba8b557, 0x23b9dafb, 0x6b8a6a0f, 0x539b05a3,
+	 0xfbed0be7, 0xc3fc644b, 0x8bcfd4bf, 0xb3debb13, 0xdecfbec6, 0xe6ded16a,
+	 0xaeed619e, 0x96fc0e32, 0x3e8a0076, 0x069b6fda, 0x4ea8df2e, 0x76b9b082,
+	 0x948ad484, 0xac9bbb28, 0xe4a80bdc, 0xdcb96470, 0x74cf6a34, 0x4cde0598,
+	 0x04edb56c, 0x3cfcdac0, 0x51eddf15, 0x69fcb0b9, 0x21cf004d, 0x19de6fe1,
+	 0xb1a861a5, 0x89b90e09, 0xc18abefd, 0xf99bd151, 0x37516aae, 0x0f400502,
+	 0x4773b5f6, 0x7f62da5a, 0xd714d41e, 0xef05bbb2, 0xa7360b46, 0x9f2764ea,
+	 0xf236613f, 0xca270e93, 0x8214be67, 0xba05d1cb, 0x1273df8f, 0x2a62b023,
+	 0x625100d7, 0x5a406f7b, 0xb8730b7d, 0x806264d1, 0xc851d425, 0xf040bb89,
+	 0x5836b5cd, 0x6027da61, 0x28146a95, 0x10050539, 0x7d1400ec, 0x45056f40,
+	 0x0d36dfb4, 0x3527b018, 0x9d51be5c, 0xa540d1f0, 0xed736104, 0xd5620ea8,
+	 0x2cf9dff9, 0x14e8b055, 0x5cdb00a1, 0x64ca6f0d, 0xccbc6149, 0xf4ad0ee5,
+	 0xbc9ebe11, 0x848fd1bd, 0xe99ed468, 0xd18fbbc4, 0x99bc0b30, 0xa1ad649c,
+	 0x09db6ad8, 0x31ca0574, 0x79f9b580, 0x41e8da2c, 0xa3dbbe2a, 0x9bcad186,
+	 0xd3f96172, 0xebe80ede, 0x439e009a, 0x7b8f6f36, 0x33bcdfc2, 0x0badb06e,
+	 0x66bcb5bb, 0x5eadda17, 0x169e6ae3, 0x2e8f054f, 0x86f90b0b, 0xbee864a7,
+	 0xf6dbd453, 0xcecabbff, 0x6ea2d55c, 0x56b3baf0, 0x1e800a04, 0x269165a8,
+	 0x8ee76bec, 0xb6f60440, 0xfec5b4b4, 0xc6d4db18, 0xabc5decd, 0x93d4b161,
+	 0xdbe70195, 0xe3f66e39, 0x4b80607d, 0x73910fd1, 0x3ba2bf25, 0x03b3d089,
+	 0xe180b48f, 0xd991db23, 0x91a26bd7, 0xa9b3047b, 0x01c50a3f, 0x39d46593,
+	 0x71e7d567, 0x49f6bacb, 0x24e7bf1e, 0x1cf6d0b2, 0x54c56046, 0x6cd40fea,
+	 0xc4a201ae, 0xfcb36e02, 0xb480def6, 0x8c91b15a, 0x750a600b, 0x4d1b0fa7,
+	 0x0528bf53, 0x3d39d0ff, 0x954fdebb, 0xad5eb117, 0xe56d01e3, 0xdd7c6e4f,
+	 0xb06d6b9a, 0x887c0436, 0xc04fb4c2, 0xf85edb6e, 0x5028d52a, 0x6839ba86,
+	 0x200a0a72, 0x181b65de, 0xfa2801d8, 0xc2396e74, 0x8a0ade80, 0xb21bb12c,
+	 0x1a6dbf68, 0x227cd0c4, 0x6a4f6030, 0x525e0f9c, 0x3f4f0a49, 0x075e65e5,
+	 0x4f6dd511, 0x777cbabd, 0xdf0ab4f9, 0xe71bdb55, 0xaf286ba1, 0x9739040d,
+	 0x59f3bff2, 0x61e2d05e, 0x29d160aa, 0x11c00f06, 0xb9b60142, 0x81a76eee,
+	 0xc994de1a, 0xf185b1b6, 0x9c94b463, 0xa485dbcf, 0xecb66b3b, 0xd4a70497,
+	 0x7cd10ad3, 0x44c0657f, 0x0cf3d58b, 0x34e2ba27, 0xd6d1de21, 0xeec0b18d,
+	 0xa6f30179, 0x9ee26ed5, 0x36946091, 0x0e850f3d, 0x46b6bfc9, 0x7ea7d065,
+	 0x13b6d5b0, 0x2ba7ba1c, 0x63940ae8, 0x5b856544, 0xf3f36b00, 0xcbe204ac,
+	 0x83d1b458, 0xbbc0dbf4, 0x425b0aa5, 0x7a4a6509, 0x3279d5fd, 0x0a68ba51,
+	 0xa21eb415, 0x9a0fdbb9, 0xd23c6b4d, 0xea2d04e1, 0x873c0134, 0xbf2d6e98,
+	 0xf71ede6c, 0xcf0fb1c0, 0x6779bf84, 0x5f68d028, 0x175b60dc, 0x2f4a0f70,
+	 0xcd796b76, 0xf56804da, 0xbd5bb42e, 0x854adb82, 0x2d3cd5c6, 0x152dba6a,
+	 0x5d1e0a9e, 0x650f6532, 0x081e60e7, 0x300f0f4b, 0x783cbfbf, 0x402dd013,
+	 0xe85bde57, 0xd04ab1fb, 0x9879010f, 0xa0686ea3},
+	{0x00000000, 0xef306b19, 0xdb8ca0c3, 0x34bccbda, 0xb2f53777, 0x5dc55c6e,
+	 0x697997b4, 0x8649fcad, 0x6006181f, 0x8f367306, 0xbb8ab8dc, 0x54bad3c5,
+	 0xd2f32f68, 0x3dc34471, 0x097f8fab, 0xe64fe4b2, 0xc00c303e, 0x2f3c5b27,
+	 0x1b8090fd, 0xf4b0fbe4, 0x72f90749, 0x9dc96c50, 0xa975a78a, 0x4645cc93,
+	 0xa00a2821, 0x4f3a4338, 0x7b8688e2, 0x94b6e3fb, 0x12ff1f56, 0xfdcf744f,
+	 0xc973bf95, 0x2643d48c, 0x85f4168d, 0x6ac47d94, 0x5e78b64e, 0xb148dd57,
+	 0x370121fa, 0xd8314ae3, 0xec8d8139, 0x03bdea20, 0xe5f20e92, 0x0ac2658b,
+	 0x3e7eae51, 0xd14ec548, 0x570739e5, 0xb83752fc, 0x8c8b9926, 0x63bbf23f,
+	 0x45f826b3, 0xaac84daa, 0x9e748670, 0x7144ed69, 0xf70d11c4, 0x183d7add,
+	 0x2c81b107, 0xc3b1da1e, 0x25fe3eac, 0xcace55b5, 0xfe729e6f, 0x1142f576,
+	 0x970b09db, 0x783b62c2, 0x4c87a918, 0xa3b7c201, 0x0e045beb, 0xe13430f2,
+	 0xd588fb28, 0x3ab89031, 0xbcf16c9c, 0x53c10785, 0x677dcc5f, 0x884da746,
+	 0x6e0243f4, 0x813228ed, 0xb58ee337, 0x5abe882e, 0xdcf77483, 0x33c71f9a,
+	 0x077bd440, 0xe84bbf59, 0xce086bd5, 0x213800cc, 0x1584cb16, 0xfab4a00f,
+	 0x7cfd5ca2, 0x93cd37bb, 0xa771fc61, 0x48419778, 0xae0e73ca, 0x413e18d3,
+	 0x7582d309, 0x9ab2b810, 0x1cfb44bd, 0xf3cb2fa4, 0xc777e47e, 0x28478f67,
+	 0x8bf04d66, 0x64c0267f, 0x507ceda5, 0xbf4c86bc, 0x39057a11, 0xd6351108,
+	 0xe289dad2, 0x0db9b1cb, 0xebf65579, 0x04c63e60, 0x307af5ba, 0xdf4a9ea3,
+	 0x5903620e, 0xb6330917, 0x828fc2cd, 0x6dbfa9d4, 0x4bfc7d58, 0xa4cc1641,
+	 0x9070dd9b, 0x7f40b682, 0xf9094a2f, 0x16392136, 0x2285eaec, 0xcdb581f5,
+	 0x2bfa6547, 0xc4ca0e5e, 0xf076c584, 0x1f46ae9d, 0x990f5230, 0x763f3929,
+	 0x4283f2f3, 0xadb399ea, 0x1c08b7d6, 0xf338dccf, 0xc7841715, 0x28b47c0c,
+	 0xaefd80a1, 0x41cdebb8, 0x75712062, 0x9a414b7b, 0x7c0eafc9, 0x933ec4d0,
+	 0xa7820f0a, 0x48b26413, 0xcefb98be, 0x21cbf3a7, 0x1577387d, 0xfa475364,
+	 0xdc0487e8, 0x3334ecf1, 0x0788272b, 0xe8b84c32, 0x6ef1b09f, 0x81c1db86,
+	 0xb57d105c, 0x5a4d7b45, 0xbc029ff7, 0x5332f4ee, 0x678e3f34, 0x88be542d,
+	 0x0ef7a880, 0xe1c7c399, 0xd57b0843, 0x3a4b635a, 0x99fca15b, 0x76ccca42,
+	 0x42700198, 0xad406a81, 0x2b09962c, 0xc439fd35, 0xf08536ef, 0x1fb55df6,
+	 0xf9fab944, 0x16cad25d, 0x22761987, 0xcd46729e, 0x4b0f8e33, 0xa43fe52a,
+	 0x90832ef0, 0x7fb345e9, 0x59f09165, 0xb6c0fa7c, 0x827c31a6, 0x6d4c5abf,
+	 0xeb05a612, 0x0435cd0b, 0x308906d1, 0xdfb96dc8, 0x39f6897a, 0xd6c6e263,
+	 0xe27a29b9, 0x0d4a42a0, 0x8b03be0d, 0x6433d514, 0x508f1ece, 0xbfbf75d7,
+	 0x120cec3d, 0xfd3c8724, 0xc9804cfe, 0x26b027e7, 0xa0f9db4a, 0x4fc9b053,
+	 0x7b757b89, 0x94451090, 0x720af422, 0x9d3a9f3b, 0xa98654e1, 0x46b63ff8,
+	 0xc0ffc355, 0x2fcfa84c, 0x1b736396, 0xf443088f, 0xd200dc03, 0x3d30b71a,
+	 0x098c7cc0, 0xe6bc17d9, 0x60f5eb74, 0x8fc5806d, 0xbb794bb7, 0x544920ae,
+	 0xb206c41c, 0x5d36af05, 0x698a64df, 0x86ba0fc6, 0x00f3f36b, 0xefc39872,
+	 0xdb7f53a8, 0x344f38b1, 0x97f8fab0, 0x78c891a9, 0x4c745a73, 0xa344316a,
+	 0x250dcdc7, 0xca3da6de, 0xfe816d04, 0x11b1061d, 0xf7fee2af, 0x18ce89b6,
+	 0x2c72426c, 0xc3422975, 0x450bd5d8, 0xaa3bbec1, 0x9e87751b, 0x71b71e02,
+	 0x57f4ca8e, 0xb8c4a197, 0x8c786a4d, 0x63480154, 0xe501fdf9, 0x0a3196e0,
+	 0x3e8d5d3a, 0xd1bd3623, 0x37f2d291, 0xd8c2b988, 0xec7e7252, 0x034e194b,
+	 0x8507e5e6, 0x6a378eff, 0x5e8b4525, 0xb1bb2e3c},
+	{0x00000000, 0x68032cc8, 0xd0065990, 0xb8057558, 0xa5e0c5d1, 0xcde3e919,
+	 0x75e69c41, 0x1de5b089, 0x4e2dfd53, 0x262ed19b, 0x9e2ba4c3, 0xf628880b,
+	 0xebcd3882, 0x83ce144a, 0x3bcb6112, 0x53c84dda, 0x9c5bfaa6, 0xf458d66e,
+	 0x4c5da336, 0x245e8ffe, 0x39bb3f77, 0x51b813bf, 0xe9bd66e7, 0x81be4a2f,
+	 0xd27607f5, 0xba752b3d, 0x02705e65, 0x6a7372ad, 0x7796c224, 0x1f95eeec,
+	 0xa7909bb4, 0xcf93b77c, 0x3d5b83bd, 0x5558af75, 0xed5dda2d, 0x855ef6e5,
+	 0x98bb466c, 0xf0b86aa4, 0x48bd1ffc, 0x20be3334, 0x73767eee, 0x1b755226,
+	 0xa370277e, 0xcb730bb6, 0xd696bb3f, 0xbe9597f7, 0x0690e2af, 0x6e93ce67,
+	 0xa100791b, 0xc90355d3, 0x7106208b, 0x19050c43, 0x04e0bcca, 0x6ce39002,
+	 0xd4e6e55a, 0xbce5c992, 0xef2d8448, 0x872ea880, 0x3f2bddd8, 0x5728f110,
+	 0x4acd4199, 0x22ce6d51, 0x9acb1809, 0xf2c834c1, 0x7ab7077a, 0x12b42bb2,
+	 0xaab15eea, 0xc2b27222, 0xdf57c2ab, 0xb754ee63, 0x0f519b3b, 0x6752b7f3,
+	 0x349afa29, 0x5c99d6e1, 0xe49ca3b9, 0x8c9f8f71, 0x917a3ff8, 0xf9791330,
+	 0x417c6668, 0x297f4aa0, 0xe6ecfddc, 0x8eefd114, 0x36eaa44c, 0x5ee98884,
+	 0x430c380d, 0x2b0f14c5, 0x930a619d, 0xfb094d55, 0xa8c1008f, 0xc0c22c47,
+	 0x78c7591f, 0x10c475d7, 0x0d21c55e, 0x6522e996, 0xdd279cce, 0xb524b006,
+	 0x47ec84c7, 0x2fefa80f, 0x97eadd57, 0xffe9f19f, 0xe20c4116, 0x8a0f6dde,
+	 0x320a1886, 0x5a09344e, 0x09c17994, 0x61c2555c, 0xd9c72004, 0xb1c40ccc,
+	 0xac21bc45, 0xc422908d, 0x7c27e5d5, 0x1424c91d, 0xdbb77e61, 0xb3b452a9,
+	 0x0bb127f1, 0x63b20b39, 0x7e57bbb0, 0x16549778, 0xae51e220, 0xc652cee8,
+	 0x959a8332, 0xfd99affa, 0x459cdaa2, 0x2d9ff66a, 0x307a46e3, 0x58796a2b,
+	 0xe07c1f73, 0x887f33bb, 0xf56e0ef4, 0x9d6d223c, 0x25685764, 0x4d6b7bac,
+	 0x508ecb25, 0x388de7ed, 0x808892b5, 0xe88bbe7d, 0xbb43f3a7, 0xd340df6f,
+	 0x6b45aa37, 0x034686ff, 0x1ea33676, 0x76a01abe, 0xcea56fe6, 0xa6a6432e,
+	 0x6935f452, 0x0136d89a, 0xb933adc2, 0xd130810a, 0xccd53183, 0xa4d61d4b,
+	 0x1cd36813, 0x74d044db, 0x27180901, 0x4f1b25c9, 0xf71e5091, 0x9f1d7c59,
+	 0x82f8ccd0, 0xeafbe018, 0x52fe9540, 0x3afdb988, 0xc8358d49, 0xa036a181,
+	 0x1833d4d9, 0x7030f811, 0x6dd54898, 0x05d66450, 0xbdd31108, 0xd5d03dc0,
+	 0x8618701a, 0xee1b5cd2, 0x561e298a, 0x3e1d0542, 0x23f8b5cb, 0x4bfb9903,
+	 0xf3feec5b, 0x9bfdc093, 0x546e77ef, 0x3c6d5b27, 0x84682e7f, 0xec6b02b7,
+	 0xf18eb23e, 0x998d9ef6, 0x2188ebae, 0x498bc766, 0x1a438abc, 0x7240a674,
+	 0xca45d32c, 0xa246ffe4, 0xbfa34f6d, 0xd7a063a5, 0x6fa516fd, 0x07a63a35,
+	 0x8fd9098e, 0xe7da2546, 0x5fdf501e, 0x37dc7cd6, 0x2a39cc5f, 0x423ae097,
+	 0xfa3f95cf, 0x923cb907, 0xc1f4f4dd, 0xa9f7d815, 0x11f2ad4d, 0x79f18185,
+	 0x6414310c, 0x0c171dc4, 0xb412689c, 0xdc114454, 0x1382f328, 0x7b81dfe0,
+	 0xc384aab8, 0xab878670, 0xb66236f9, 0xde611a31, 0x66646f69, 0x0e6743a1,
+	 0x5daf0e7b, 0x35ac22b3, 0x8da957eb, 0xe5aa7b23, 0xf84fcbaa, 0x904ce762,
+	 0x2849923a, 0x404abef2, 0xb2828a33, 0xda81a6fb, 0x6284d3a3, 0x0a87ff6b,
+	 0x17624fe2, 0x7f61632a, 0xc7641672, 0xaf673aba, 0xfcaf7760, 0x94ac5ba8,
+	 0x2ca92ef0, 0x44aa0238, 0x594fb2b1, 0x314c9e79, 0x8949eb21, 0xe14ac7e9,
+	 0x2ed97095, 0x46da5c5d, 0xfedf2905, 0x96dc05cd, 0x8b39b544, 0xe33a998c,
+	 0x5b3fecd4, 0x333cc01c, 0x60f48dc6, 0x08f7a10e, 0xb0f2d456, 0xd8f1f89e,
+	 0xc5144817, 0xad1764df, 0x15121187, 0x7d113d4f},
+	{0x00000000, 0x493c7d27, 0x9278fa4e, 0xdb448769, 0x211d826d, 0x6821ff4a,
+	 0xb3657823, 0xfa590504, 0x423b04da, 0x0b0779fd, 0xd043fe94, 0x997f83b3,
+	 0x632686b7, 0x2a1afb90, 0xf15e7cf9, 0xb86201de, 0x847609b4, 0xcd4a7493,
+	 0x160ef3fa, 0x5f328edd, 0xa56b8bd9, 0xec57f6fe, 0x37137197, 0x7e2f0cb0,
+	 0xc64d0d6e, 0x8f717049, 0x5435f720, 0x1d098a07, 0xe7508f03, 0xae6cf224,
+	 0x7528754d, 0x3c14086a, 0x0d006599, 0x443c18be, 0x9f789fd7, 0xd644e2f0,
+	 0x2c1de7f4, 0x65219ad3, 0xbe651dba, 0xf759609d, 0x4f3b6143, 0x06071c64,
+	 0xdd439b0d, 0x947fe62a, 0x6e26e32e, 0x271a9e09, 0xfc5e1960, 0xb5626447,
+	 0x89766c2d, 0xc04a110a, 0x1b0e9663, 0x5232eb44, 0xa86bee40, 0xe1579367,
+	 0x3a13140e, 0x732f6929, 0xcb4d68f7, 0x827115d0, 0x593592b9, 0x1009ef9e,
+	 0xea50ea9a, 0xa36c97bd, 0x782810d4, 0x31146df3, 0x1a00cb32, 0x533cb615,
+	 0x8878317c, 0xc1444c5b, 0x3b1d495f, 0x72213478, 0xa965b311, 0xe059ce36,
+	 0x583bcfe8, 0x1107b2cf, 0xca4335a6, 0x837f4881, 0x79264d85, 0x301a30a2,
+	 0xeb5eb7cb, 0xa262caec, 0x9e76c286, 0xd74abfa1, 0x0c0e38c8, 0x453245ef,
+	 0xbf6b40eb, 0xf6573dcc, 0x2d13baa5, 0x642fc782, 0xdc4dc65c, 0x9571bb7b,
+	 0x4e353c12, 0x07094135, 0xfd504431, 0xb46c3916, 0x6f28be7f, 0x2614c358,
+	 0x1700aeab, 0x5e3cd38c, 0x857854e5, 0xcc4429c2, 0x361d2cc6, 0x7f2151e1,
+	 0xa465d688, 0xed59abaf, 0x553baa71, 0x1c07d756, 0xc743503f, 0x8e7f2d18,
+	 0x7426281c, 0x3d1a553b, 0xe65ed252, 0xaf62af75, 0x9376a71f, 0xda4ada38,
+	 0x010e5d51, 0x48322076, 0xb26b2572, 0xfb575855, 0x2013df3c, 0x692fa21b,
+	 0xd14da3c5, 0x9871dee2, 0x4335598b, 0x0a0924ac, 0xf05021a8, 0xb96c5c8f,
+	 0x6228dbe6, 0x2b14a6c1, 0x34019664, 0x7d3deb43, 0xa6796c2a, 0xef45110d,
+	 0x151c1409, 0x5c20692e, 0x8764ee47, 0xce589360, 0x763a92be, 0x3f06ef99,
+	 0xe44268f0, 0xad7e15d7, 0x572710d3, 0x1e1b6df4, 0xc55fea9d, 0x8c6397ba,
+	 0xb0779fd0, 0xf94be2f7, 0x220f659e, 0x6b3318b9, 0x916a1dbd, 0xd856609a,
+	 0x0312e7f3, 0x4a2e9ad4, 0xf24c9b0a, 0xbb70e62d, 0x60346144, 0x29081c63,
+	 0xd3511967, 0x9a6d6440, 0x4129e329, 0x08159e0e, 0x3901f3fd, 0x703d8eda,
+	 0xab7909b3, 0xe2457494, 0x181c7190, 0x51200cb7, 0x8a648bde, 0xc358f6f9,
+	 0x7b3af727, 0x32068a00, 0xe9420d69, 0xa07e704e, 0x5a27754a, 0x131b086d,
+	 0xc85f8f04, 0x8163f223, 0xbd77fa49, 0xf44b876e, 0x2f0f0007, 0x66337d20,
+	 0x9c6a7824, 0xd5560503, 0x0e12826a, 0x472eff4d, 0xff4cfe93, 0xb67083b4,
+	 0x6d3404dd, 0x240879fa, 0xde517cfe, 0x976d01d9, 0x4c2986b0, 0x0515fb97,
+	 0x2e015d56, 0x673d2071, 0xbc79a718, 0xf545da3f, 0x0f1cdf3b, 0x4620a21c,
+	 0x9d642575, 0xd4585852, 0x6c3a598c, 0x250624ab, 0xfe42a3c2, 0xb77edee5,
+	 0x4d27dbe1, 0x041ba6c6, 0xdf5f21af, 0x96635c88, 0xaa7754e2, 0xe34b29c5,
+	 0x380faeac, 0x7133d38b, 0x8b6ad68f, 0xc256aba8, 0x19122cc1, 0x502e51e6,
+	 0xe84c5038, 0xa1702d1f, 0x7a34aa76, 0x3308d751, 0xc951d255, 0x806daf72,
+	 0x5b29281b, 0x1215553c, 0x230138cf, 0x6a3d45e8, 0xb179c281, 0xf845bfa6,
+	 0x021cbaa2, 0x4b20c785, 0x906440ec, 0xd9583dcb, 0x613a3c15, 0x28064132,
+	 0xf342c65b, 0xba7ebb7c, 0x4027be78, 0x091bc35f, 0xd25f4436, 0x9b633911,
+	 0xa777317b, 0xee4b4c5c, 0x350fcb35, 0x7c33b612, 0x866ab316, 0xcf56ce31,
+	 0x14124958, 0x5d2e347f, 0xe54c35a1, 0xac704886, 0x7734cfef, 0x3e08b2c8,
+	 0xc451b7cc, 0x8d6dcaeb, 0x56294d82, 0x1f1530a5}
+});
+
+/* nom_crc32c_multmodp multiplies a and b modulo the crc32c polynomial, in the crc's bit reversed order */
+NOM_API uint32_t nom_crc32c_multmodp(uint32_t a, uint32_t b) {
+	uint32_t m = UINT32_C(1) << 31, p = 0;
+
+	for (;;) {
+		if (a & m) {
+			p ^= b;
+			if ((a & (m - 1)) == 0) {
+				break;
+			}
+		}
+		m >>= 1;
+		b = b & 1 ? (b >> 1) ^ NOM_CRC32C_POLY : b >> 1;
+	}
+	return p;
+}
+
+/* nom_crc32c_xpow returns x^n modulo the crc32c polynomial */
+NOM_API uint32_t nom_crc32c_xpow(int64_t n) {
+	uint32_t p = UINT32_C(1) << 31, sq = UINT32_C(1) << 30;
+
+	while (n > 0) {
+		if (n & 1) {
+			p = nom_crc32c_multmodp(sq, p);
+		}
+		sq = nom_crc32c_multmodp(sq, sq);
+		n >>= 1;
+	}
+	return p;
+}
+
+/* nom_crc32c_slice8 continues an uninverted crc32c over n bytes at p, 8 bytes at a time through lookup tables */
+NOM_API uint32_t nom_crc32c_slice8(uint32_t crc, const uint8_t *p, int64_t n) {
+	const uint32_t(*t)[256] = nom_crc32c_table;
+	uint64_t w;
+
+	for (; n >= 8; p += 8, n -= 8) {
+		w = nom_load64le(p) ^ crc;
+		crc = t[7][w & 0xff] ^ t[6][(w >> 8) & 0xff] ^
+		      t[5][(w >> 16) & 0xff] ^ t[4][(w >> 24) & 0xff] ^
+		      t[3][(w >> 32) & 0xff] ^ t[2][(w >> 40) & 0xff] ^
+		      t[1][(w >> 48) & 0xff] ^ t[0][w >> 56];
+	}
+	for (; n > 0; p++, n--) {
+		crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xff];
+	}
+	return crc;
+}
+
+#if defined(NOM_X86) && defined(__x86_64__)
+/* the strides of the three crc32 streams nom_crc32c_sse42 runs side by side, long ones for big inputs so they need joining less often and short ones for the rest */
+#define NOM_CRC32C_LONG 4096
+#define NOM_CRC32C_SHORT 256
+
+/* nom_crc32c_xpow(8 * stride - 33) and nom_crc32c_xpow(16 * stride - 33) for the long and short strides, as constants so threads can share them without locking */
+NOM_DATA const uint32_t nom_crc32c_shifts[4] NOM_INIT({0x82f89c77, 0x54a86326,
+						       0xb9e02b86, 0xdd7e3b0c});
+
+/* nom_crc32c_shift moves an uninverted crc over the bytes k stands for with a carry-less multiply, which crc32 then reduces */
+__attribute__((target("sse4.2,pclmul"))) NOM_API NOM_ALWAYS_INLINE uint64_t
+nom_crc32c_shift(uint64_t crc, uint32_t k) {
+	__m128i r = _mm_clmulepi64_si128(_mm_cvtsi64_si128((int64_t)(crc)),
+					 _mm_cvtsi32_si128((int)(k)), 0);
+	return _mm_crc32_u64(0, (uint64_t)(_mm_cvtsi128_si64(r)));
+}
+
+/* nom_crc32c_3way continues crc over every 3 * stride bytes at *p as three streams, then moves *p and *n past them */
+__attribute__((target("sse4.2,pclmul"))) NOM_API NOM_ALWAYS_INLINE uint64_t
+nom_crc32c_3way(uint64_t c0, const uint8_t **p, int64_t *n, int64_t stride,
+		uint32_t k1, uint32_t k2) {
+	const uint8_t *q = *p;
+	uint64_t c1, c2, w0, w1, w2;
+	int64_t i, left = *n;
+
+	/* crc32 takes 3 cycles but can start every cycle, so three independent streams keep it busy, and the first two are shifted over the bytes after them to join them back up */
+	for (; left >= 3 * stride; q += 3 * stride, left -= 3 * stride) {
+		c1 = 0;
+		c2 = 0;
+		for (i = 0; i < stride; i += 8) {
+			memcpy(&w0, q + i, 8);
+			memcpy(&w1, q + stride + i, 8);
+			memcpy(&w2, q + 2 * stride + i, 8);
+			c0 = _mm_crc32_u64(c0, w0);
+			c1 = _mm_crc32_u64(c1, w1);
+			c2 = _mm_crc32_u64(c2, w2);
+		}
+		c0 = nom_crc32c_shift(c0, k2) ^ nom_crc32c_shift(c1, k1) ^ c2;
+	}
+	*p = q;
+	*n = left;
+	return c0;
+}
+
+/* nom_crc32c_sse42 is nom_crc32c_slice8 with the crc32 and pclmulqdq instructions */
+__attribute__((target("sse4.2,pclmul"))) NOM_API uint32_t
+nom_crc32c_sse42(uint32_t crc, const uint8_t *p, int64_t n) {
+	const uint32_t *k = nom_crc32c_shifts;
+	uint64_t c = crc, w;
+
+	c = nom_crc32c_3way(c, &p, &n, NOM_CRC32C_LONG, k[0], k[1]);
+	c = nom_crc32c_3way(c, &p, &n, NOM_CRC32C_SHORT, k[2], k[3]);
+	for (; n >= 8; p += 8, n -= 8) {
+		memcpy(&w, p, 8);
+		c = _mm_crc32_u64(c, w);
+	}
+	for (; n > 0; p++, n--) {
+		c = _mm_crc32_u8((uint32_t)(c), *p);
+	}
+	return (uint32_t)(c);
+}
+#endif
+
+/* nom_crc32c continues the crc32c crc (0 to start one) over n bytes at p */
+NOM_API uint32_t nom_crc32c(uint32_t crc, const uint8_t *p, int64_t n) {
+	crc = ~crc;
+#if defined(NOM_X86) && defined(__x86_64__)
+	if ((nom_cpu_features() & (NOM_CPU_SSE42 | NOM_CPU_PCLMUL)) ==
+	    (NOM_CPU_SSE42 | NOM_CPU_PCLMUL)) {
+		return ~nom_crc32c_sse42(crc, p, n);
+	}
+#endif
+	return ~nom_crc32c_slice8(crc, p, n);
+}
+
+/* the xxhash64 primes */
+#define NOM_XXH_PRIME1 UINT64_C(0x9e3779b185ebca87)
+#define NOM_XXH_PRIME2 UINT64_C(0xc2b2ae3d27d4eb4f)
+#define NOM_XXH_PRIME3 UINT64_C(0x165667b19e3779f9)
+#define NOM_XXH_PRIME4 UINT64_C(0x85ebca77c2b2ae63)
+#define NOM_XXH_PRIME5 UINT64_C(0x27d4eb2f165667c5)
+
+/* nom_rotl64 rotates v left by r bits */
+NOM_API NOM_ALWAYS_INLINE uint64_t nom_rotl64(uint64_t v, int r) {
+	return (v << r) | (v >> (64 - r));
+}
+
+/* nom_xxh64_round mixes 8 bytes of input into an xxhash lane */
+NOM_API NOM_ALWAYS_INLINE uint64_t nom_xxh64_round(uint64_t acc,
+						   uint64_t input) {
+	return nom_rotl64(acc + input * NOM_XXH_PRIME2, 31) * NOM_XXH_PRIME1;
+}
+
+/* nom_xxh64_merge folds an xxhash lane into the hash */
+NOM_API NOM_ALWAYS_INLINE uint64_t nom_xxh64_merge(uint64_t h, uint64_t acc) {
+	h ^= nom_xxh64_round(0, acc);
+	return h * NOM_XXH_PRIME1 + NOM_XXH_PRIME4;
+}
+
+/* nom_xxh64_stripes mixes every whole 32 byte stripe of n bytes at p into the four lanes, returning the amount of bytes it used */
+NOM_API int64_t nom_xxh64_stripes(uint64_t *acc, const uint8_t *p, int64_t n) {
+	uint64_t a0 = acc[0], a1 = acc[1], a2 = acc[2], a3 = acc[3];
+	int64_t i;
+
+	for (i = 0; i + 32 <= n; i += 32) {
+		a0 = nom_xxh64_round(a0, nom_load64le(p + i));
+		a1 = nom_xxh64_round(a1, nom_load64le(p + i + 8));
+		a2 = nom_xxh64_round(a2, nom_load64le(p + i + 16));
+		a3 = nom_xxh64_round(a3, nom_load64le(p + i + 24));
+	}
+	acc[0] = a0;
+	acc[1] = a1;
+	acc[2] = a2;
+	acc[3] = a3;
+	return i;
+}
+
+/* nom_xxh64_finish hashes the last n (under 32) bytes at p into h and mixes it up */
+NOM_API uint64_t nom_xxh64_finish(uint64_t h, const uint8_t *p, int64_t n) {
+	uint32_t w;
+
+	for (; n >= 8; p += 8, n -= 8) {
+		h ^= nom_xxh64_round(0, nom_load64le(p));
+		h = nom_rotl64(h, 27) * NOM_XXH_PRIME1 + NOM_XXH_PRIME4;
+	}
+	if (n >= 4) {
+		memcpy(&w, p, 4);
+#if NOM_BIG_ENDIAN
+		w = nom_bswap32(w);
+#endif
+		h ^= (uint64_t)(w)*NOM_XXH_PRIME1;
+		h = nom_rotl64(h, 23) * NOM_XXH_PRIME2 + NOM_XXH_PRIME3;
+		p += 4;
+		n -= 4;
+	}
+	for (; n > 0; p++, n--) {
+		h ^= *p * NOM_XXH_PRIME5;
+		h = nom_rotl64(h, 11) * NOM_XXH_PRIME1;
+	}
+	h ^= h >> 33;
+	h *= NOM_XXH_PRIME2;
+	h ^= h >> 29;
+	h *= NOM_XXH_PRIME3;
+	h ^= h >> 32;
+	return h;
+}
+
+/* nom_checksum_new starts a checksum of the given kind, seeded with seed (a crc32c to continue from, or an xxhash seed) */
+NOM_API void nom_checksum_new(struct NomChecksum *out, int kind,
+			      uint64_t seed) {
+	out->kind = kind;
+	out->crc = (uint32_t)(seed);
+	out->seed = seed;
+	out->acc[0] = seed + NOM_XXH_PRIME1 + NOM_XXH_PRIME2;
+	out->acc[1] = seed + NOM_XXH_PRIME2;
+	out->acc[2] = seed;
+	out->acc[3] = seed - NOM_XXH_PRIME1;
+	out->total = 0;
+	out->memsize = 0;
+}
+
+/* nom_checksum_update feeds n bytes at p to a checksum */
+NOM_API void nom_checksum_update(struct NomChecksum *c, const uint8_t *p,
+				 int64_t n) {
+	int64_t k;
+
+	if (n <= 0) {
+		return;
+	}
+	if (c->kind == NOM_CHECKSUM_CRC32C) {
+		c->crc = nom_crc32c(c->crc, p, n);
+		return;
+	}
+	c->total += (uint64_t)(n);
+	if (c->memsize > 0) {
+		k = 32 - c->memsize < n ? 32 - c->memsize : n;
+		memcpy(c->mem + c->memsize, p, k);
+		c->memsize += (int)(k);
+		p += k;
+		n -= k;
+		if (c->memsize < 32) {
+			return;
+		}
+		nom_xxh64_stripes(c->acc, c->mem, 32);
+		c->memsize = 0;
+	}
+	k = nom_xxh64_stripes(c->acc, p, n);
+	memcpy(c->mem, p + k, n - k);
+	c->memsize = (int)(n - k);
+}
+
+/* nom_checksum_digest returns the checksum of everything fed to c so far, which can keep being updated afterwards */
+NOM_API uint64_t nom_checksum_digest(const struct NomChecksum *c) {
+	uint64_t h;
+
+	if (c->kind == NOM_CHECKSUM_CRC32C) {
+		return c->crc;
+	}
+	if (c->total >= 32) {
+		h = nom_rotl64(c->acc[0], 1) + nom_rotl64(c->acc[1], 7) +
+		    nom_rotl64(c->acc[2], 12) + nom_rotl64(c->acc[3], 18);
+		h = nom_xxh64_merge(h, c->acc[0]);
+		h = nom_xxh64_merge(h, c->acc[1]);
+		h = nom_xxh64_merge(h, c->acc[2]);
+		h = nom_xxh64_merge(h, c->acc[3]);
+
+	} else {
+		h = c->seed + NOM_XXH_PRIME5;
+	}
+	return nom_xxh64_finish(h + c->total, c->mem, c->memsize);
+}
+
+/* nom_xxh64 returns the 64 bit xxhash of n bytes at p */
+NOM_API uint64_t nom_xxh64(const uint8_t *p, int64_t n, uint64_t seed) {
+	struct NomChecksum c;
+
+	nom_checksum_new(&c, NOM_CHECKSUM_XXH64, seed);
+	nom_checksum_update(&c, p, n);
+	return nom_checksum_digest(&c);
+}
+
+/* nom_buffer_setchecksum makes the buffer's *next functions feed every byte they read or write to c, or stops that if c is NULL */
+NOM_API void nom_buffer_setchecksum(struct NomBuffer *b,
+				    struct NomChecksum *c) {
+	b->checksum = c;
+}
+
+/* nom_buffer_checksum returns the checksum of the given kind of n bytes at off */
+NOM_API uint64_t nom_buffer_checksum(struct NomBuffer *b, int kind, int64_t off,
+				     int64_t n) {
+	struct NomChecksum c;
+
+	nom_checksum_new(&c, kind, 0);
+	nom_checksum_update(&c, b->buf + off, n);
+	return nom_checksum_digest(&c);
+}
+
+/* nom_buffer_verify checks n bytes at off against a checksum of the given kind, returning -1 if they don't match */
+NOM_API int nom_buffer_verify(struct NomBuffer *b, int kind, int64_t off,
+			      int64_t n, uint64_t expected) {
+	return nom_buffer_checksum(b, kind, off, n) == expected ? 0 : -1;
+}
+
+/* nom_growth_geometric grows an allocation by half of its size at a time, which makes appending amortized O(1) */
+NOM_API int64_t nom_growth_geometric(int64_t alloc, int64_t needed) {
+	int64_t n = alloc < 64 ? 64 : alloc + alloc / 2;
+	return n < needed ? needed : n;
+}
+
+/* nom_growth_exact grows an allocation to exactly what is needed */
+NOM_API int64_t nom_growth_exact(int64_t alloc, int64_t needed) {
+	(void)alloc;
+	return needed;
+}
+
+/* nom_buffer_newwith creates a new buffer whose storage comes from a, which nom_buffer_destroy also releases the buffer itself to */
+NOM_API void nom_buffer_newwith(struct NomBuffer *out, int64_t initial_size,
+				const struct NomAllocator *a) {
+	out->off = 0x00;
+	out->cap = initial_size;
+	out->boff = 0x00;
+	out->bcap = initial_size * 8;
+	out->alloc = initial_size;
+	out->growth = NULL;
+	out->flags = 0;
+	out->stream = NULL;
+	out->checksum = NULL;
+	out->allocator = a;
+	out->shared = NULL;
+
+	out->buf =
+		(uint8_t *)(nom_alloc(a, initial_size * sizeof(uint8_t)));
+	NOM_STAT_ALLOC(out, 0, initial_size, 0);
+}
+
+/* nom_buffer_new creates a new buffer */
+NOM_API void nom_buffer_new(struct NomBuffer *out, int64_t initial_size) {
+	nom_buffer_newwith(out, initial_size, NULL);
+}
+
+/* nom_buffer_create allocates a buffer and its storage from a, returning NULL if that fails */
+NOM_API struct NomBuffer *nom_buffer_create(const struct NomAllocator *a,
+					    int64_t initial_size) {
+	struct NomBuffer *b =
+		(struct NomBuffer *)(nom_alloc(a, sizeof(struct NomBuffer)));
+
+	if (b == NULL) {
+		return NULL;
+	}
+	nom_buffer_newwith(b, initial_size, a);
+	if (b->buf == NULL && initial_size > 0) {
+		nom_free(a, b, sizeof(struct NomBuffer));
+		return NULL;
+	}
+	return b;
+}
+
+/* storage that a buffer and the slices taken of it point into, released when the last of them lets go of it */
+typedef struct NomShared {
+	int64_t refs; /* how many buffers point into buf */
+	uint8_t *buf;
+	int64_t alloc;
+	int flags; /* NOM_BUFFER_MAPPED and NOM_BUFFER_MAPWRITE if buf is a file mapping */
+	const struct NomAllocator *allocator; /* where buf and this came from */
+} NomShared;
+
+/* nom_shared_refs returns how many buffers point into s */
+NOM_API int64_t nom_shared_refs(struct NomShared *s) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __atomic_load_n(&s->refs, __ATOMIC_ACQUIRE);
+#else
+	return s->refs;
+#endif
+}
+
+/* nom_shared_retain adds a buffer pointing into s */
+NOM_API void nom_shared_retain(struct NomShared *s) {
+#if defined(__GNUC__) || defined(__clang__)
+	__atomic_add_fetch(&s->refs, 1, __ATOMIC_RELAXED);
+#else
+	s->refs++;
+#endif
+}
+
+/* nom_shared_release drops a buffer pointing into s, freeing the storage once none are left */
+NOM_API void nom_shared_release(struct NomShared *s) {
+#if defined(__GNUC__) || defined(__clang__)
+	if (__atomic_sub_fetch(&s->refs, 1, __ATOMIC_ACQ_REL) != 0) {
+		return;
+	}
+#else
+	if (--s->refs != 0) {
+		return;
+	}
+#endif
+#ifdef NOM_POSIX
+	if (s->flags & NOM_BUFFER_MAPPED) {
+		if (s->alloc > 0) {
+			munmap(s->buf, s->alloc);
+		}
+
+	} else {
+		nom_free(s->allocator, s->buf, s->alloc);
+	}
+#else
+	nom_free(s->allocator, s->buf, s->alloc);
+#endif
+	nom_free(s->allocator, s, sizeof(struct NomShared));
+}
+
+/* nom_buffer_slice makes out a buffer over the n bytes at off without copying them, sharing the storage with b until either of them is written to or released, returning -1 if the bytes aren't in b or that fails. writes that can't copy the storage, because it is a NOM_MAP_WRITE mapping or allocating fails, leave it unchanged */
+NOM_API int nom_buffer_slice(NomSlice *out, struct NomBuffer *b, int64_t off,
+			     int64_t n) {
+	struct NomShared *s = b->shared;
+
+	if (off < 0 || n < 0 || off > b->cap - n) {
+		return -1;
+	}
+
+	/* the storage only gets a reference count the first time it is sliced */
+	if (s == NULL) {
+		s = (struct NomShared *)(nom_alloc(b->allocator,
+						   sizeof(struct NomShared)));
+		if (s == NULL) {
+			return -1;
+		}
+		s->refs = 1;
+		s->buf = b->buf;
+		s->alloc = b->alloc;
+		s->flags = b->flags & (NOM_BUFFER_MAPPED | NOM_BUFFER_MAPWRITE);
+		s->allocator = b->allocator;
+		b->shared = s;
+	}
+	nom_shared_retain(s);
+
+	out->buf = b->buf + off;
+	out->off = 0x00;
+	out->cap = n;
+	out->boff = 0x00;
+	out->bcap = n * 8;
+	out->alloc = n;
+	out->growth = b->growth;
+	out->flags = 0;
+	out->stream = NULL;
+	out->checksum = NULL;
+	out->allocator = b->allocator;
+	out->shared = s;
+	return 0;
+}
+
+/* nom_buffer_detach moves the buffer's contents into private storage of n bytes and lets go of the shared storage, returning -1 if that fails or the storage is a writable file mapping, whose writes would then miss the file */
+NOM_API int nom_buffer_detach(struct NomBuffer *b, int64_t n) {
+	uint8_t *buf;
+
+	if (b->shared->flags & NOM_BUFFER_MAPWRITE) {
+		return -1;
+	}
+	buf = (uint8_t *)(nom_alloc(b->allocator, n * sizeof(uint8_t)));
+	if (buf == NULL) {
+		return -1;
+	}
+	memcpy(buf, b->buf, b->cap);
+	NOM_STAT_ALLOC(b, b->alloc, n, 1);
+	nom_shared_release(b->shared);
+	b->buf = buf;
+	b->alloc = n;
+	b->flags = 0;
+	b->shared = NULL;
+	return 0;
+}
+
+/* nom_buffer_reclaim takes shared storage back once every other buffer has let go of it and b still starts at its front, returning -1 if it can't */
+NOM_API int nom_buffer_reclaim(struct NomBuffer *b) {
+	struct NomShared *s = b->shared;
+
+	if (nom_shared_refs(s) != 1 || b->buf != s->buf) {
+		return -1;
+	}
+	b->alloc = s->alloc;
+	b->flags = s->flags;
+	b->shared = NULL;
+	nom_free(s->allocator, s, sizeof(struct NomShared));
+	return 0;
+}
+
+/* nom_buffer_unshare gives the buffer its own copy of storage it shares with slices or a parent, so writing to it doesn't show through them, returning -1 if that fails */
+NOM_API int nom_buffer_unshare(struct NomBuffer *b) {
+	if (b->shared == NULL) {
+		return 0;
+	}
+
+	/* once every other buffer has let go, the storage is written in place, and taken back outright if b starts at its front */
+	if (nom_shared_refs(b->shared) == 1) {
+		nom_buffer_reclaim(b);
+		return 0;
+	}
+	return nom_buffer_detach(b, b->alloc);
+}
+
+/* NOM_COW copies shared storage before a write changes it, and is -1 if that fails, in which case the write functions leave the buffer and the storage as they were (the ones returning nothing drop the write, which nom_buffer_unshare can check for beforehand) */
+#define NOM_COW(b) ((b)->shared != NULL ? nom_buffer_unshare(b) : 0)
+
+/* nom_buffer_reserve makes sure at least n bytes are allocated for the buffer without changing its capacity, returning -1 if that fails */
+NOM_API int nom_buffer_reserve(struct NomBuffer *b, int64_t n) {
+	uint8_t *buf;
+
+	if (n <= b->alloc) {
+		return 0;
+	}
+
+	/* shared storage can't be resized under the other buffers pointing into it, so it is copied unless they are all gone */
+	if (b->shared != NULL && nom_buffer_reclaim(b) != 0) {
+		return nom_buffer_detach(b, n);
+	}
+	if (n <= b->alloc) {
+		return 0;
+	}
+	if (b->flags & NOM_BUFFER_MAPPED) {
+		return -1;
+	}
+
+	/* realloc can extend in place, and glibc moves large blocks with mremap instead of copying them */
+	buf = (uint8_t *)(nom_realloc(b->allocator, b->buf, b->alloc,
+				      n * sizeof(uint8_t)));
+	if (buf == NULL) {
+		return -1;
+	}
+	NOM_STAT_ALLOC(b, b->alloc, n, buf != b->buf);
+	b->buf = buf;
+	b->alloc = n;
+	return 0;
+}
+
+/* a stream callback reads up to n bytes into buf or writes n bytes from buf, returning the amount of bytes transferred, 0 at the end of the stream or -1 on errors */
+typedef int64_t (*NomStreamFn)(void *ctx, uint8_t *buf, int64_t n);
+
+/* an unbounded source or sink that a buffer can be a window into */
+typedef struct NomStream {
+	NomStreamFn read; /* set for streams that are read from */
+	NomStreamFn write; /* set for streams that are written to */
+	void *ctx;
+	int64_t pos; /* the stream offset of the first byte in the window */
+	int eof; /* read returned 0 */
+	int err; /* a callback returned -1 */
+} NomStream;
+
+/* nom_stream_new creates a stream around a pair of callbacks, one of which should be NULL */
+NOM_API void nom_stream_new(struct NomStream *out, NomStreamFn read,
+			    NomStreamFn write, void *ctx) {
+	out->read = read;
+	out->write = write;
+	out->ctx = ctx;
+	out->pos = 0;
+	out->eof = 0;
+	out->err = 0;
+}
+
+#ifdef NOM_POSIX
+/* nom_stream_fdread is a stream callback that reads from the file descriptor stored in ctx */
+NOM_API int64_t nom_stream_fdread(void *ctx, uint8_t *buf, int64_t n) {
+	ssize_t r;
+
+	do {
+		r = read((int)(intptr_t)(ctx), buf, (size_t)(n));
+	} while (r < 0 && errno == EINTR);
+	return r;
+}
+
+/* nom_stream_fdwrite is a stream callback that writes to the file descriptor stored in ctx */
+NOM_API int64_t nom_stream_fdwrite(void *ctx, uint8_t *buf, int64_t n) {
+	ssize_t r;
+
+	do {
+		r = write((int)(intptr_t)(ctx), buf, (size_t)(n));
+	} while (r < 0 && errno == EINTR);
+	return r;
+}
+
+/* nom_stream_fd creates a stream that reads from or, if writing is set, writes to a file descriptor */
+NOM_API void nom_stream_fd(struct NomStream *out, int fd, int writing) {
+	nom_stream_new(out, writing ? NULL : nom_stream_fdread,
+		       writing ? nom_stream_fdwrite : NULL,
+		       (void *)(intptr_t)(fd));
+}
+#endif
+
+/* nom_buffer_openstream creates a new buffer that is a window of window_size bytes into a stream, returning -1 if that fails */
+NOM_API int nom_buffer_openstream(struct NomBuffer *out, struct NomStream *s,
+				  int64_t window_size) {
+	nom_buffer_new(out, window_size);
+	if (out->buf == NULL) {
+		return -1;
+	}
+
+	/* a read window starts out empty, a write window starts out with all of its room free */
+	out->cap = s->write != NULL ? window_size : 0;
+	out->bcap = out->cap * 8;
+	out->stream = s;
+	return 0;
+}
+
+/* nom_buffer_flush writes everything before the current offset of a write stream's window out and rewinds the window, returning -1 if that fails */
+NOM_API int nom_buffer_flush(struct NomBuffer *b) {
+	struct NomStream *s = b->stream;
+	int64_t done = 0, r;
+
+	if (s == NULL || s->write == NULL) {
+		return 0;
+	}
+	while (done < b->off) {
+		r = s->write(s->ctx, b->buf + done, b->off - done);
+		if (r <= 0) {
+			s->err = 1;
+			if (NOM_COW(b) != 0) {
+				return -1;
+			}
+			memmove(b->buf, b->buf + done, b->off - done);
+			s->pos += done;
+			b->off -= done;
+			return -1;
+		}
+		done += r;
+	}
+	s->pos += done;
+	b->off = 0x00;
+	b->boff = 0x00;
+	return 0;
+}
+
+/* nom_buffer_refill moves the unread part of a read stream's window to its front and reads until at least n bytes are unread, returning -1 if the stream ended or failed first */
+NOM_API int nom_buffer_refill(struct NomBuffer *b, int64_t n) {
+	struct NomStream *s = b->stream;
+	int64_t r;
+
+	if (s == NULL || s->read == NULL) {
+		return 0;
+	}
+	if (b->off > 0) {
+		if (NOM_COW(b) != 0) {
+			return -1;
+		}
+		memmove(b->buf, b->buf + b->off, b->cap - b->off);
+		s->pos += b->off;
+		b->cap -= b->off;
+		b->off = 0x00;
+	}
+
+	/* a window smaller than n is grown first, since a read into no room would come back 0 and look like the end of the stream */
+	if (n > b->alloc && nom_buffer_reserve(b, n) != 0) {
+		return -1;
+	}
+
+	/* every read asks for all of the free room, so the callback sees as few and as large requests as possible */
+	while (b->cap < n && !s->eof && !s->err) {
+		r = s->read(s->ctx, b->buf + b->cap, b->alloc - b->cap);
+		if (r == 0) {
+			s->eof = 1;
+
+		} else if (r < 0) {
+			s->err = 1;
+
+		} else {
+			b->cap += r;
+		}
+	}
+	b->bcap = b->cap * 8;
+	b->boff = 0x00;
+	return b->cap < n ? -1 : 0;
+}
+
+/* nom_buffer_window returns how many of the next n elements of size bytes can be accessed at the current offset, refilling or flushing a stream's window when none can */
+NOM_API int64_t nom_buffer_window(struct NomBuffer *b, int64_t n,
+				  int64_t size) {
+	int64_t k;
+
+	if (b->stream == NULL || n <= 0) {
+		return n;
+	}
+	k = (b->cap - b->off) / size;
+	if (k == 0) {
+		if (b->stream->write != NULL) {
+			/* a window smaller than an element is grown to fit one once it is empty */
+			if (nom_buffer_flush(b) == 0 && size > b->alloc &&
+			    nom_buffer_reserve(b, size) == 0) {
+				b->cap = b->alloc;
+				b->bcap = b->cap * 8;
+			}
+
+		} else {
+			nom_buffer_refill(b, size);
+		}
+		k = (b->cap - b->off) / size;
+	}
+	return k < n ? k : n;
+}
+
+/* nom_buffer_release releases a buffer's storage and leaves it empty without freeing the buffer itself, which is how slices and buffers not made by nom_buffer_create are torn down */
+NOM_API void nom_buffer_release(struct NomBuffer *b) {
+	nom_buffer_flush(b);
+	if (b->shared != NULL) {
+		nom_shared_release(b->shared);
+
+#ifdef NOM_POSIX
+	} else if (b->flags & NOM_BUFFER_MAPPED) {
+		if (b->alloc > 0) {
+			munmap(b->buf, b->alloc);
+		}
+#endif
+
+	} else {
+		nom_free(b->allocator, b->buf, b->alloc);
+	}
+	b->buf = NULL;
+	b->off = 0x00;
+	b->cap = 0x00;
+	b->boff = 0x00;
+	b->bcap = 0x00;
+	b->alloc = 0x00;
+	b->flags = 0;
+	b->shared = NULL;
+}
+
+/* nom_buffer_destroy destroys an existing buffer, whose storage lives on until the slices taken of it are released */
+NOM_API void nom_buffer_destroy(struct NomBuffer *b) {
+	nom_buffer_release(b);
+	nom_free(b->allocator, b, sizeof(struct NomBuffer));
+}
+
+/* nom_buffer_shrinktofit releases the memory allocated past the buffer's capacity, returning -1 if that fails */
+NOM_API int nom_buffer_shrinktofit(struct NomBuffer *b) {
+	uint8_t *buf;
+
+	if (b->shared != NULL && nom_buffer_reclaim(b) != 0) {
+		return 0;
+	}
+	if (b->alloc == b->cap || b->cap == 0 ||
+	    (b->flags & NOM_BUFFER_MAPPED)) {
+		return 0;
+	}
+	buf = (uint8_t *)(nom_realloc(b->allocator, b->buf, b->alloc,
+				      b->cap * sizeof(uint8_t)));
+	if (buf == NULL) {
+		return -1;
+	}
+	b->buf = buf;
+	b->alloc = b->cap;
+	return 0;
+}
+
+/* nom_buffer_ensure makes the buffer's capacity at least n bytes, growing the allocation with the buffer's growth policy */
+NOM_API int nom_buffer_ensure(struct NomBuffer *b, int64_t n) {
+	NomGrowthPolicy growth =
+		b->growth == NULL ? nom_growth_geometric : b->growth;
+
+	/* stream windows make room by flushing instead */
+	if (n <= b->cap || b->stream != NULL) {
+		return 0;
+	}
+	if (n > b->alloc && nom_buffer_reserve(b, growth(b->alloc, n)) != 0) {
+		return -1;
+	}
+	b->cap = n;
+	b->bcap = n * 8;
+	return 0;
+}
+
+#ifdef NOM_POSIX
+/* flags for nom_buffer_mapfile */
+#define NOM_MAP_WRITE 0x01 /* map the file shared and writable, so writes to the buffer reach the file, which means that while it is sliced writes to it or its slices fail instead of going to a copy */
+#define NOM_MAP_PRIVATE 0x02 /* map the file copy-on-write, so the buffer is writable but the file isn't changed */
+#define NOM_MAP_SEQUENTIAL 0x04 /* the buffer will be read from front to back */
+#define NOM_MAP_RANDOM 0x08 /* the buffer will be read in no particular order */
+#define NOM_MAP_WILLNEED 0x10 /* start reading the whole file in ahead of time */
+#define NOM_MAP_HUGEPAGES 0x20 /* back the mapping with huge pages where the kernel allows it */
+#define NOM_MAP_POPULATE 0x40 /* fault in every page before returning */
+
+/* nom_buffer_mapfd creates a new buffer backed by a mapping of the whole file fd refers to, returning -1 if that fails */
+NOM_API int nom_buffer_mapfd(struct NomBuffer *out, int fd, int flags) {
+	struct stat st;
+	int prot = PROT_READ;
+	int mflags = MAP_SHARED;
+	void *p = NULL;
+
+	if (fstat(fd, &st) != 0) {
+		return -1;
+	}
+	if (flags & (NOM_MAP_WRITE | NOM_MAP_PRIVATE)) {
+		prot |= PROT_WRITE;
+	}
+	if (flags & NOM_MAP_PRIVATE) {
+		mflags = MAP_PRIVATE;
+	}
+#ifdef MAP_POPULATE
+	if (flags & NOM_MAP_POPULATE) {
+		mflags |= MAP_POPULATE;
+	}
+#endif
+
+	/* mmap rejects empty mappings, so empty files get an empty buffer */
+	if (st.st_size > 0) {
+		p = mmap(NULL, (size_t)(st.st_size), prot, mflags, fd, 0);
+		if (p == MAP_FAILED) {
+			return -1;
+		}
+
+		/* the hints are only advice, so failures and missing support are ignored */
+#ifdef MADV_SEQUENTIAL
+		if (flags & NOM_MAP_SEQUENTIAL) {
+			madvise(p, (size_t)(st.st_size), MADV_SEQUENTIAL);
+		}
+		if (flags & NOM_MAP_RANDOM) {
+			madvise(p, (size_t)(st.st_size), MADV_RANDOM);
+		}
+		if (flags & NOM_MAP_WILLNEED) {
+			madvise(p, (size_t)(st.st_size), MADV_WILLNEED);
+		}
+#endif
+#ifdef MADV_HUGEPAGE
+		if (flags & NOM_MAP_HUGEPAGES) {
+			madvise(p, (size_t)(st.st_size), MADV_HUGEPAGE);
+		}
+#endif
+	}
+
+	out->buf = (uint8_t *)(p);
+	out->off = 0x00;
+	out->cap = st.st_size;
+	out->boff = 0x00;
+	out->bcap = st.st_size * 8;
+	out->alloc = st.st_size;
+	out->growth = NULL;
+	out->flags = NOM_BUFFER_MAPPED;
+	if ((flags & NOM_MAP_WRITE) && !(flags & NOM_MAP_PRIVATE)) {
+		out->flags |= NOM_BUFFER_MAPWRITE;
+	}
+	out->stream = NULL;
+	out->checksum = NULL;
+	out->allocator = NULL;
+	out->shared = NULL;
+	return 0;
+}
+
+/* nom_buffer_mapfile creates a new buffer backed by a mapping of the file at path, returning -1 if that fails */
+NOM_API int nom_buffer_mapfile(struct NomBuffer *out, const char *path,
+			       int flags) {
+	int fd, r;
+
+	fd = open(path, (flags & NOM_MAP_WRITE) ? O_RDWR : O_RDONLY);
+	if (fd < 0) {
+		return -1;
+	}
+
+	/* the mapping stays valid after the descriptor is closed */
+	r = nom_buffer_mapfd(out, fd, flags);
+	close(fd);
+	return r;
+}
+
+/* nom_buffer_unmap releases a buffer's file mapping and leaves the buffer empty, changes to a shared mapping stay in the file and slices of it keep it mapped until they are released */
+NOM_API int nom_buffer_unmap(struct NomBuffer *b) {
+	int r = 0;
+
+	if (b->shared != NULL) {
+		if (!(b->shared->flags & NOM_BUFFER_MAPPED)) {
+			return -1;
+		}
+		nom_shared_release(b->shared);
+
+	} else if (!(b->flags & NOM_BUFFER_MAPPED)) {
+		return -1;
+
+	} else if (b->alloc > 0) {
+		r = munmap(b->buf, b->alloc);
+	}
+	b->buf = NULL;
+	b->off = 0x00;
+	b->cap = 0x00;
+	b->boff = 0x00;
+	b->bcap = 0x00;
+	b->alloc = 0x00;
+	b->flags = 0;
+	b->shared = NULL;
+	return r;
+}
+#endif
+
+/* nom_buffer_seekbit seeks to bit position off of buffer relative to the current position or exact */
+NOM_API void nom_buffer_seekbit(struct NomBuffer *b, int64_t off,
+				uint8_t relative) {
+	if (relative < 0) {
+		b->boff = off;
+
+	} else if (relative >= 0) {
+		b->boff += off;
+	}
+}
+
+/* a cursor that reads bits from a buffer a word at a time */
+typedef struct NomBitReader {
+	struct NomBuffer *b;
+	uint64_t acc; /* bits that have been loaded but not consumed, most significant first */
+	int64_t cnt; /* the amount of bits in acc */
+	int64_t pos; /* bit offset of the first bit that hasn't been loaded into acc */
+} NomBitReader;
+
+/* a cursor that writes bits to a buffer a word at a time */
+typedef struct NomBitWriter {
+	struct NomBuffer *b;
+	uint64_t acc; /* bits that haven't been stored yet, most significant first */
+	int64_t cnt; /* the amount of bits in acc */
+	int64_t pos; /* bit offset acc gets stored at, always a multiple of 8 */
+} NomBitWriter;
+
+/* nom_bitreader_new creates a bit reader over b starting at bit offset off */
+NOM_API void nom_bitreader_new(struct NomBitReader *out, struct NomBuffer *b,
+			       int64_t off) {
+	out->b = b;
+	out->acc = 0;
+	out->cnt = 0;
+	out->pos = off;
+}
+
+/* nom_bitreader_refill loads bits into the reader until it holds more than 56 of them or the buffer runs out */
+NOM_API void nom_bitreader_refill(struct NomBitReader *r) {
+	uint64_t w;
+	int64_t byte, k;
+
+	if (r->cnt > 56) {
+		return;
+	}
+	if (r->pos % 8 != 0 && r->pos < r->b->bcap) {
+		k = 8 - (r->pos % 8);
+		w = r->b->buf[r->pos / 8] & ((1u << k) - 1);
+		r->acc |= w << (64 - r->cnt - k);
+		r->cnt += k;
+		r->pos += k;
+	}
+
+	/* the fast path may also load part of the following byte, which is harmless as those bits get or'd in again later */
+	byte = r->pos / 8;
+	if (r->cnt <= 56 && byte + 8 <= r->b->cap) {
+		w = nom_load64be(r->b->buf + byte);
+		r->acc |= w >> r->cnt;
+		r->pos += ((63 - r->cnt) >> 3) * 8;
+		r->cnt |= 56;
+		return;
+	}
+	while (r->cnt <= 56 && byte < r->b->cap) {
+		r->acc |= (uint64_t)(r->b->buf[byte]) << (56 - r->cnt);
+		r->cnt += 8;
+		r->pos += 8;
+		byte++;
+	}
+}
+
+/* nom_bitreader_peek returns the next n (up to 64) bits without consuming them, reading zeroes past the end of the buffer */
+NOM_API uint64_t nom_bitreader_peek(struct NomBitReader *r, int64_t n) {
+	uint64_t v;
+	int64_t i;
+
+	if (n <= 0) {
+		return 0;
+	}
+	nom_bitreader_refill(r);
+	if (n <= r->cnt) {
+		return r->acc >> (64 - n);
+	}
+
+	/* only reached for n > 56, or at the end of the buffer */
+	v = r->cnt == 0 ? 0 : r->acc >> (64 - r->cnt);
+	for (i = 0; i < n - r->cnt; i++) {
+		v <<= 1;
+		if (r->pos + i < r->b->bcap) {
+			v |= (r->b->buf[(r->pos + i) / 8] >>
+			      (7 - ((r->pos + i) % 8))) &
+			     1;
+		}
+	}
+	return v;
+}
+
+/* nom_bitreader_consume skips the next n (up to 64) bits */
+NOM_API void nom_bitreader_consume(struct NomBitReader *r, int64_t n) {
+	if (n <= 0) {
+		return;
+	}
+	if (n < r->cnt) {
+		r->acc <<= n;
+		r->cnt -= n;
+
+	} else {
+		r->pos += n - r->cnt;
+		r->acc = 0;
+		r->cnt = 0;
+	}
+}
+
+/* nom_bitreader_read reads the next n (up to 64) bits */
+NOM_API uint64_t nom_bitreader_read(struct NomBitReader *r, int64_t n) {
+	uint64_t v = nom_bitreader_peek(r, n);
+	nom_bitreader_consume(r, n);
+	return v;
+}
+
+/* nom_bitreader_tell returns the bit offset of the next bit the reader will return */
+NOM_API int64_t nom_bitreader_tell(struct NomBitReader *r) {
+	return r->pos - r->cnt;
+}
+
+/* nom_bitreader_align skips ahead to the next byte boundary */
+NOM_API void nom_bitreader_align(struct NomBitReader *r) {
+	nom_bitreader_consume(r, (8 - (nom_bitreader_tell(r) % 8)) % 8);
+}
+
+/* nom_bitreader_sync stores the reader's position in the buffer's bit offset, so nom_buffer_alignbyte can pick it up */
+NOM_API void nom_bitreader_sync(struct NomBitReader *r) {
+	r->b->boff = nom_bitreader_tell(r);
+}
+
+/* nom_bitwriter_new creates a bit writer over b starting at bit offset off, returning -1 if b shares storage that can't be copied, in which case the writer can't be used */
+NOM_API int nom_bitwriter_new(struct NomBitWriter *out, struct NomBuffer *b,
+			      int64_t off) {
+	int64_t s = off % 8;
+
+	if (NOM_COW(b) != 0) {
+		return -1;
+	}
+	out->b = b;
+	out->cnt = s;
+	out->pos = off - s;
+
+	/* the bits before off in its byte are kept, so flushing can store whole bytes */
+	out->acc = s == 0 ? 0
+			  : (uint64_t)(b->buf[out->pos / 8] >> (8 - s))
+				    << (64 - s);
+	return 0;
+}
+
+/* nom_bitwriter_write writes the low n (up to 64) bits of v */
+NOM_API void nom_bitwriter_write(struct NomBitWriter *w, uint64_t v,
+				 int64_t n) {
+	if (n <= 0) {
+		return;
+	}
+	if (n > 32) {
+		nom_bitwriter_write(w, v >> 32, n - 32);
+		n = 32;
+	}
+	v &= (UINT64_C(1) << n) - 1;
+
+	/* cnt is below 32 here, so everything fits */
+	w->acc |= v << (64 - w->cnt - n);
+	w->cnt += n;
+	if (w->cnt >= 32) {
+		nom_store32be(w->b->buf + w->pos / 8, (uint32_t)(w->acc >> 32));
+		w->acc <<= 32;
+		w->cnt -= 32;
+		w->pos += 32;
+	}
+}
+
+/* nom_bitwriter_flush stores every pending bit, leaving the bits after them in their byte untouched */
+NOM_API void nom_bitwriter_flush(struct NomBitWriter *w) {
+	uint8_t mask;
+
+	while (w->cnt >= 8) {
+		w->b->buf[w->pos / 8] = (uint8_t)(w->acc >> 56);
+		w->acc <<= 8;
+		w->cnt -= 8;
+		w->pos += 8;
+	}
+	if (w->cnt > 0) {
+		mask = (uint8_t)(0xff << (8 - w->cnt));
+		w->b->buf[w->pos / 8] = (w->b->buf[w->pos / 8] & ~mask) |
+					((uint8_t)(w->acc >> 56) & mask);
+	}
+}
+
+/* nom_bitwriter_tell returns the bit offset the next written bit will go to */
+NOM_API int64_t nom_bitwriter_tell(struct NomBitWriter *w) {
+	return w->pos + w->cnt;
+}
+
+/* nom_bitwriter_align writes zeroes up to the next byte boundary */
+NOM_API void nom_bitwriter_align(struct NomBitWriter *w) {
+	nom_bitwriter_write(w, 0, (8 - (w->cnt % 8)) % 8);
+}
+
+/* nom_bitwriter_sync flushes the writer and stores its position in the buffer's bit offset, so nom_buffer_alignbyte can pick it up */
+NOM_API void nom_bitwriter_sync(struct NomBitWriter *w) {
+	nom_bitwriter_flush(w);
+	w->b->boff = nom_bitwriter_tell(w);
+}
+
+/* nom_buffer_readbit reads a bit from the buffer at the specified offset */
+NOM_API void nom_buffer_readbit(struct NomBuffer *b, uint8_t *out,
+				int64_t off) {
+	NOM_STAT_ACCESS(NOM_TRACE_BITS, b, off, 1, 0);
+	*out = (b->buf[off / 8] >> (7 - (off % 8))) & 1;
+}
+
+/* nom_buffer_readbitnext reads the next bit from the buffer at the current offset and moves the offset forward a bit */
+NOM_API void nom_buffer_readbitnext(struct NomBuffer *b, uint8_t *out) {
+	nom_buffer_readbit(b, out, b->boff);
+	nom_buffer_seekbit(b, 1, 1);
+}
+
+/* nom_buffer_readbits reads n bits from the buffer at the specified offset */
+NOM_API void nom_buffer_readbits(struct NomBuffer *b, uint64_t *out,
+				 int64_t off, int64_t n) {
+	struct NomBitReader r;
+	uint64_t v;
+
+	if (n <= 0) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_BITS, b, off, n, 0);
+	nom_bitreader_new(&r, b, off);
+	v = nom_bitreader_read(&r, n);
+	*out = n >= 64 ? v : (*out << n) | v;
+}
+
+/* nom_buffer_readbitsnext reads the next n bits from the buffer at the current offset and moves the offset forward the amount of bits read */
+NOM_API void nom_buffer_readbitsnext(struct NomBuffer *b, uint64_t *out,
+				     int64_t n) {
+	nom_buffer_readbits(b, out, b->boff, n);
+	nom_buffer_seekbit(b, n, 1);
+}
+
+/* nom_buffer_setbit sets the bit located at the specified offset */
+NOM_API void nom_buffer_setbit(struct NomBuffer *b, int64_t off) {
+	if (NOM_COW(b) != 0) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_BITS, b, off, 1, 0);
+	b->buf[off / 8] |= (1 << (7 - (off % 8)));
+}
+
+/* nom_buffer_setbitnext sets the next bit from the current offset and moves the offset forward a bit */
+NOM_API void nom_buffer_setbitnext(struct NomBuffer *b) {
+	nom_buffer_setbit(b, b->boff);
+	nom_buffer_seekbit(b, 1, 1);
+}
+
+/* nom_buffer_clearbit clears the bit located at the specified offset */
+NOM_API void nom_buffer_clearbit(struct NomBuffer *b, int64_t off) {
+	if (NOM_COW(b) != 0) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_BITS, b, off, 1, 0);
+	b->buf[off / 8] &= ~(1 << (7 - (off % 8)));
+}
+
+/* nom_buffer_clearbitnext clears the next bit from the current offset and moves the offset forward a bit */
+NOM_API void nom_buffer_clearbitnext(struct NomBuffer *b) {
+	nom_buffer_clearbit(b, b->boff);
+	nom_buffer_seekbit(b, 1, 1);
+}
+
+/* nom_buffer_setbits sets the next n bits from the specified offset value */
+NOM_API void nom_buffer_setbits(struct NomBuffer *b, int64_t off, uint64_t data,
+				int64_t n) {
+	struct NomBitWriter w;
+
+	if (nom_bitwriter_new(&w, b, off) != 0) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_BITS, b, off, n, 0);
+	nom_bitwriter_write(&w, data, n);
+	nom_bitwriter_flush(&w);
+}
+
+/* nom_buffer_setbitsnext sets the next n bits from the current offset and moves the offset forward the amount of bits set */
+NOM_API void nom_buffer_setbitsnext(struct NomBuffer *b, uint64_t data,
+				    int64_t n) {
+	nom_buffer_setbits(b, b->boff, data, n);
+	nom_buffer_seekbit(b, n, 1);
+}
+
+/* NOM_EACH_WIDTH expands X once for every width the bit packing kernels are specialized for */
+#define NOM_EACH_WIDTH(X)                                                      \
+	X(1) X(2) X(3) X(4) X(5) X(6) X(7) X(8) X(9) X(10) X(11) X(12) X(13)   \
+	X(14) X(15) X(16) X(17) X(18) X(19) X(20) X(21) X(22) X(23) X(24)      \
+	X(25) X(26) X(27) X(28) X(29) X(30) X(31) X(32)
+
+/* nom_pack_kernel appends count values of width bits to a bit writer, and is inlined with a constant width by nom_buffer_packbits */
+NOM_API NOM_ALWAYS_INLINE void nom_pack_kernel(struct NomBitWriter *wr,
+					       const uint32_t *values,
+					       int64_t count, const int width) {
+	const uint64_t mask = (UINT64_C(1) << width) - 1;
+	uint64_t acc = wr->acc;
+	int64_t cnt = wr->cnt;
+	uint8_t *p = wr->b->buf + wr->pos / 8;
+	int64_t i;
+	uint32_t v;
+
+	/* cnt stays below 32 between values, so a value always fits */
+	for (i = 0; i < count; i++) {
+		memcpy(&v, values + i, 4);
+		acc |= (v & mask) << (64 - cnt - width);
+		cnt += width;
+		if (cnt >= 32) {
+			nom_store32be(p, (uint32_t)(acc >> 32));
+			p += 4;
+			acc <<= 32;
+			cnt -= 32;
+		}
+	}
+	wr->pos = (p - wr->b->buf) * 8;
+	wr->acc = acc;
+	wr->cnt = cnt;
+}
+
+/* nom_unpack_kernel extracts count values of width bits starting at bit offset off with one unaligned load each, 8 at a time, and is inlined with a constant width by nom_buffer_unpackbits */
+NOM_API NOM_ALWAYS_INLINE void nom_unpack_kernel(const uint8_t *buf,
+						 uint32_t *out, int64_t off,
+						 int64_t count,
+						 const int width) {
+	const uint8_t *p;
+	unsigned int j, bit, s = (unsigned int)(off % 8);
+	uint32_t v;
+	int64_t i;
+
+	for (i = 0; i + 8 <= count; i += 8) {
+		/* 8 values take up exactly width bytes, so only the position within the group varies */
+		p = buf + off / 8 + i / 8 * width;
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC unroll 8
+#endif
+		for (j = 0; j < 8; j++) {
+			bit = s + j * width;
+			v = (uint32_t)((nom_load64be(p + bit / 8) << (bit % 8)) >>
+				       (64 - width));
+			memcpy(out + i + j, &v, 4);
+		}
+	}
+	for (; i < count; i++) {
+		v = (uint32_t)((nom_load64be(buf + (off + i * width) / 8)
+				<< ((off + i * width) % 8)) >>
+			       (64 - width));
+		memcpy(out + i, &v, 4);
+	}
+}
+
+/* nom_buffer_packbits writes count values of width (1 to 32) bits each to the buffer starting at the specified bit offset, in the same order as nom_buffer_setbits */
+NOM_API void nom_buffer_packbits(struct NomBuffer *b, int64_t off, int width,
+				 int64_t count, uint32_t *values) {
+	struct NomBitWriter w;
+
+	if (count <= 0 || width <= 0 || width > 32) {
+		return;
+	}
+	if (nom_bitwriter_new(&w, b, off) != 0) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_BITS, b, off, width * count, 0);
+	switch (width) {
+#define NOM_PACK_CASE(n)                                                       \
+	case n:                                                                \
+		nom_pack_kernel(&w, values, count, n);                         \
+		break;
+		NOM_EACH_WIDTH(NOM_PACK_CASE)
+#undef NOM_PACK_CASE
+	}
+	nom_bitwriter_flush(&w);
+}
+
+/* nom_buffer_packbitsnext writes count values of width bits each to the buffer at the current bit offset and moves the bit offset forward the amount of bits written */
+NOM_API void nom_buffer_packbitsnext(struct NomBuffer *b, int width,
+				     int64_t count, uint32_t *values) {
+	nom_buffer_packbits(b, b->boff, width, count, values);
+	nom_buffer_seekbit(b, width * count, 1);
+}
+
+/* nom_buffer_unpackbits reads count values of width (1 to 32) bits each from the buffer starting at the specified bit offset */
+NOM_API void nom_buffer_unpackbits(struct NomBuffer *b, uint32_t *out,
+				   int64_t off, int width, int64_t count) {
+	struct NomBitReader r;
+	int64_t fast = 0, i;
+
+	if (count <= 0 || width <= 0 || width > 32) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_BITS, b, off, width * count, 0);
+
+	/* the kernels load 8 bytes per value, so the values near the end of the buffer are read with a bit reader instead */
+	if ((b->cap - 8) * 8 - off >= 0) {
+		fast = ((b->cap - 8) * 8 - off) / width + 1;
+		fast = fast > count ? count : fast;
+	}
+	switch (width) {
+#define NOM_UNPACK_CASE(n)                                                     \
+	case n:                                                                \
+		nom_unpack_kernel(b->buf, out, off, fast, n);                  \
+		break;
+		NOM_EACH_WIDTH(NOM_UNPACK_CASE)
+#undef NOM_UNPACK_CASE
+	}
+	if (fast < count) {
+		nom_bitreader_new(&r, b, off + fast * width);
+		for (i = fast; i < count; i++) {
+			out[i] = (uint32_t)(nom_bitreader_read(&r, width));
+		}
+	}
+}
+
+/* nom_buffer_unpackbitsnext reads count values of width bits each from the buffer at the current bit offset and moves the bit offset forward the amount of bits read */
+NOM_API void nom_buffer_unpackbitsnext(struct NomBuffer *b, uint32_t *out,
+				       int width, int64_t count) {
+	nom_buffer_unpackbits(b, out, b->boff, width, count);
+	nom_buffer_seekbit(b, width * count, 1);
+}
+
+/* nom_buffer_flipbit flips the bit located at the specified offset */
+NOM_API void nom_buffer_flipbit(struct NomBuffer *b, int64_t off) {
+	if (NOM_COW(b) != 0) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_BITS, b, off, 1, 0);
+	b->buf[off / 8] ^= (1 << (7 - (off % 8)));
+}
+
+/* nom_buffer_flipbitnext flips the bit located at the current offset and moves the offset forwards a bit */
+NOM_API void nom_buffer_flipbitnext(struct NomBuffer *b) {
+	nom_buffer_flipbit(b, b->boff);
+	nom_buffer_seekbit(b, 1, 1);
+}
+
+/* nom_flipbytes inverts n bytes at p a word at a time */
+NOM_API void nom_flipbytes(uint8_t *p, int64_t n) {
+	uint64_t w;
+	int64_t i = 0;
+
+#if defined(NOM_X86) && defined(__SSE2__)
+	__m128i ones = _mm_set1_epi8(-1);
+
+	for (; i + 32 <= n; i += 32) {
+		__m128i v0 = _mm_loadu_si128((const __m128i *)(p + i));
+		__m128i v1 = _mm_loadu_si128((const __m128i *)(p + i + 16));
+		_mm_storeu_si128((__m128i *)(p + i), _mm_xor_si128(v0, ones));
+		_mm_storeu_si128((__m128i *)(p + i + 16),
+				 _mm_xor_si128(v1, ones));
+	}
+#endif
+	for (; i + 8 <= n; i += 8) {
+		memcpy(&w, p + i, 8);
+		w = ~w;
+		memcpy(p + i, &w, 8);
+	}
+	for (; i < n; i++) {
+		p[i] = (uint8_t)(~p[i]);
+	}
+}
+
+/* nom_buffer_clearallbits clears all of the bits in the buffer */
+NOM_API void nom_buffer_clearallbits(struct NomBuffer *b) {
+	if (NOM_COW(b) != 0) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_BITS, b, 0, b->cap * 8, 0);
+	memset(b->buf, 0x00, b->cap);
+}
+
+/* nom_buffer_setallbits sets all of the bits in the buffer */
+NOM_API void nom_buffer_setallbits(struct NomBuffer *b) {
+	if (NOM_COW(b) != 0) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_BITS, b, 0, b->cap * 8, 0);
+	memset(b->buf, 0xff, b->cap);
+}
+
+/* nom_buffer_flipallbits flips all of the bits in the buffer */
+NOM_API void nom_buffer_flipallbits(struct NomBuffer *b) {
+	if (NOM_COW(b) != 0) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_BITS, b, 0, b->cap * 8, 0);
+	nom_flipbytes(b->buf, b->cap);
+}
+
+/* nom_buffer_afterbit stores the amount of bits located after the current position or the specified one in out */
+NOM_API void nom_buffer_afterbit(struct NomBuffer *b, int64_t *out,
+				 int64_t off) {
+	if (off < 0) {
+		*out = b->bcap - b->boff - 1;
+
+	} else if (off >= 0) {
+		*out = b->bcap - off - 1;
+	}
+}
+
+/* nom_buffer_alignbit aligns the bit offset to the byte offset */
+NOM_API void nom_buffer_alignbit(struct NomBuffer *b) {
+	b->boff = b->off * 8;
+}
+
+/* nom_buffer_seekbytes seeks to position off of the buffer relative to the current position or exact */
+NOM_API void nom_buffer_seekbyte(struct NomBuffer *b, int64_t off,
+				 uint8_t relative) {
+	if (relative < 0) {
+		b->off = off;
+
+	} else if (relative >= 0) {
+		b->off += off;
+	}
+}
+
+/* nom_buffer_advance moves the offset forward past n bytes that were just read or written at it, feeding them to the buffer's checksum */
+NOM_API NOM_ALWAYS_INLINE void nom_buffer_advance(struct NomBuffer *b,
+						  int64_t n) {
+	if (b->checksum != NULL) {
+		nom_checksum_update(b->checksum, b->buf + b->off, n);
+	}
+	b->off += n;
+}
+
+/* nom_buffer_writebytes writes a byte array to the buffer at the specified offset */
+NOM_API void nom_buffer_writebytes(struct NomBuffer *b, int64_t off,
+				   int64_t data_length, uint8_t *data) {
+	if (NOM_COW(b) != 0) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, b, off, data_length, 1);
+	memcpy(b->buf + off, data, data_length * sizeof(uint8_t));
+}
+
+/* nom_buffer_writebytesnext writes a byte array to the buffer at the current offset and moves the offset forward the amount of bytes written */
+NOM_API void nom_buffer_writebytesnext(struct NomBuffer *b, int64_t data_length,
+				       uint8_t *data) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, data_length, 1)) > 0) {
+		nom_buffer_writebytes(b, b->off, k, data);
+		nom_buffer_advance(b, k);
+		data += k;
+		data_length -= k;
+	}
+}
+
+/* nom_buffer_writeu16le writes an array of u16s to the buffer in little endian at the specified offset */
+NOM_API void nom_buffer_writeu16le(struct NomBuffer *b, int64_t off,
+				   int64_t data_length, uint16_t *data) {
+	if (NOM_COW(b) != 0) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, b, off, data_length * 2, 2);
+	nom_byteorder(b->buf + off, data, data_length, 2, 0);
+}
+
+/* nom_buffer_writeu16lenext writes an array of u16s to the buffer in little endian at the current offset and moves the offset forward the amount of bytes written */
+NOM_API void nom_buffer_writeu16lenext(struct NomBuffer *b, int64_t data_length,
+				       uint16_t *data) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, data_length, 2)) > 0) {
+		nom_buffer_writeu16le(b, b->off, k, data);
+		nom_buffer_advance(b, k * 2);
+		data += k;
+		data_length -= k;
+	}
+}
+
+/* nom_buffer_writeu16be writes an array of u16s to the buffer in big endian at the specified offset */
+NOM_API void nom_buffer_writeu16be(struct NomBuffer *b, int64_t off,
+				   int64_t data_length, uint16_t *data) {
+	if (NOM_COW(b) != 0) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, b, off, data_length * 2, 2);
+	nom_byteorder(b->buf + off, data, data_length, 2, 1);
+}
+
+/* nom_buffer_writeu16benext writes an array of u16s to the buffer in big endian at the current offset and moves the offset forward the amount of bytes written */
+NOM_API void nom_buffer_writeu16benext(struct NomBuffer *b, int64_t data_length,
+				       uint16_t *data) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, data_length, 2)) > 0) {
+		nom_buffer_writeu16be(b, b->off, k, data);
+		nom_buffer_advance(b, k * 2);
+		data += k;
+		data_length -= k;
+	}
+}
+
+/* nom_buffer_writeu32le writes an array of u32s to the buffer in little endian at the specified offset */
+NOM_API void nom_buffer_writeu32le(struct NomBuffer *b, int64_t off,
+				   int64_t data_length, uint32_t *data) {
+	if (NOM_COW(b) != 0) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, b, off, data_length * 4, 4);
+	nom_byteorder(b->buf + off, data, data_length, 4, 0);
+}
+
+/* nom_buffer_writeu32lenext writes an array of u32s to the buffer in little endian at the current offset and moves the offset forward the amount of bytes written */
+NOM_API void nom_buffer_writeu32lenext(struct NomBuffer *b, int64_t data_length,
+				       uint32_t *data) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, data_length, 4)) > 0) {
+		nom_buffer_writeu32le(b, b->off, k, data);
+		nom_buffer_advance(b, k * 4);
+		data += k;
+		data_length -= k;
+	}
+}
+
+/* nom_buffer_writeu32be writes an array of u32s to the buffer in big endian at the specified offset */
+NOM_API void nom_buffer_writeu32be(struct NomBuffer *b, int64_t off,
+				   int64_t data_length, uint32_t *data) {
+	if (NOM_COW(b) != 0) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, b, off, data_length * 4, 4);
+	nom_byteorder(b->buf + off, data, data_length, 4, 1);
+}
+
+/* nom_buffer_writeu32benext writes an array of u32s to the buffer in big endian at the current offset and moves the offset forward the amount of bytes written */
+NOM_API void nom_buffer_writeu32benext(struct NomBuffer *b, int64_t data_length,
+				       uint32_t *data) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, data_length, 4)) > 0) {
+		nom_buffer_writeu32be(b, b->off, k, data);
+		nom_buffer_advance(b, k * 4);
+		data += k;
+		data_length -= k;
+	}
+}
+
+/* nom_buffer_writeu64le writes an array of u64s to the buffer in little endian at the specified offset */
+NOM_API void nom_buffer_writeu64le(struct NomBuffer *b, int64_t off,
+				   int64_t data_length, uint64_t *data) {
+	if (NOM_COW(b) != 0) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, b, off, data_length * 8, 8);
+	nom_byteorder(b->buf + off, data, data_length, 8, 0);
+}
+
+/* nom_buffer_writeu64lenext writes an array of u64s to the buffer in little endian at the current offset and moves the offset forward the amount of bytes written */
+NOM_API void nom_buffer_writeu64lenext(struct NomBuffer *b, int64_t data_length,
+				       uint64_t *data) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, data_length, 8)) > 0) {
+		nom_buffer_writeu64le(b, b->off, k, data);
+		nom_buffer_advance(b, k * 8);
+		data += k;
+		data_length -= k;
+	}
+}
+
+/* nom_buffer_writeu64be writes an array of u64s to the buffer in big endian at the specified offset */
+NOM_API void nom_buffer_writeu64be(struct NomBuffer *b, int64_t off,
+				   int64_t data_length, uint64_t *data) {
+	if (NOM_COW(b) != 0) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, b, off, data_length * 8, 8);
+	nom_byteorder(b->buf + off, data, data_length, 8, 1);
+}
+
+/* nom_buffer_writeu64benext writes an array of u64s to the buffer in big endian at the current offset and moves the offset forward the amount of bytes written */
+NOM_API void nom_buffer_writeu64benext(struct NomBuffer *b, int64_t data_length,
+				       uint64_t *data) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, data_length, 8)) > 0) {
+		nom_buffer_writeu64be(b, b->off, k, data);
+		nom_buffer_advance(b, k * 8);
+		data += k;
+		data_length -= k;
+	}
+}
+
+/* nom_buffer_writei16le writes an array of i16s to the buffer in little endian at the specified offset */
+NOM_API void nom_buffer_writei16le(struct NomBuffer *b, int64_t off,
+				   int64_t data_length, int16_t *data) {
+	if (NOM_COW(b) != 0) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, b, off, data_length * 2, 2);
+	nom_byteorder(b->buf + off, data, data_length, 2, 0);
+}
+
+/* nom_buffer_writei16lenext writes an array of i16s to the buffer in little endian at the current offset and moves the offset forward the amount of bytes written */
+NOM_API void nom_buffer_writei16lenext(struct NomBuffer *b, int64_t data_length,
+				       int16_t *data) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, data_length, 2)) > 0) {
+		nom_buffer_writei16le(b, b->off, k, data);
+		nom_buffer_advance(b, k * 2);
+		data += k;
+		data_length -= k;
+	}
+}
+
+/* nom_buffer_writei16be writes an array of i16s to the buffer in big endian at the specified offset */
+NOM_API void nom_buffer_writei16be(struct NomBuffer *b, int64_t off,
+				   int64_t data_length, int16_t *data) {
+	if (NOM_COW(b) != 0) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, b, off, data_length * 2, 2);
+	nom_byteorder(b->buf + off, data, data_length, 2, 1);
+}
+
+/* nom_buffer_writei16benext writes an array of i16s to the buffer in big endian at the current offset and moves the offset forward the amount of bytes written */
+NOM_API void nom_buffer_writei16benext(struct NomBuffer *b, int64_t data_length,
+				       int16_t *data) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, data_length, 2)) > 0) {
+		nom_buffer_writei16be(b, b->off, k, data);
+		nom_buffer_advance(b, k * 2);
+		data += k;
+		data_length -= k;
+	}
+}
+
+/* nom_buffer_writei32le writes an array of i32s to the buffer in little endian at the specified offset */
+NOM_API void nom_buffer_writei32le(struct NomBuffer *b, int64_t off,
+				   int64_t data_length, int32_t *data) {
+	if (NOM_COW(b) != 0) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, b, off, data_length * 4, 4);
+	nom_byteorder(b->buf + off, data, data_length, 4, 0);
+}
+
+/* nom_buffer_writei32lenext writes an array of i32s to the buffer in little endian at the current offset and moves the offset forward the amount of bytes written */
+NOM_API void nom_buffer_writei32lenext(struct NomBuffer *b, int64_t data_length,
+				       int32_t *data) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, data_length, 4)) > 0) {
+		nom_buffer_writei32le(b, b->off, k, data);
+		nom_buffer_advance(b, k * 4);
+		data += k;
+		data_length -= k;
+	}
+}
+
+/* nom_buffer_writei32be writes an array of i32s to the buffer in big endian at the specified offset */
+NOM_API void nom_buffer_writei32be(struct NomBuffer *b, int64_t off,
+				   int64_t data_length, int32_t *data) {
+	if (NOM_COW(b) != 0) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, b, off, data_length * 4, 4);
+	nom_byteorder(b->buf + off, data, data_length, 4, 1);
+}
+
+/* nom_buffer_writei32benext writes an array of i32s to the buffer in big endian at the current offset and moves the offset forward the amount of bytes written */
+NOM_API void nom_buffer_writei32benext(struct NomBuffer *b, int64_t data_length,
+				       int32_t *data) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, data_length, 4)) > 0) {
+		nom_buffer_writei32be(b, b->off, k, data);
+		nom_buffer_advance(b, k * 4);
+		data += k;
+		data_length -= k;
+	}
+}
+
+/* nom_buffer_writei64le writes an array of i64s to the buffer in little endian at the specified offset */
+NOM_API void nom_buffer_writei64le(struct NomBuffer *b, int64_t off,
+				   int64_t data_length, int64_t *data) {
+	if (NOM_COW(b) != 0) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, b, off, data_length * 8, 8);
+	nom_byteorder(b->buf + off, data, data_length, 8, 0);
+}
+
+/* nom_buffer_writei64lenext writes an array of i64s to the buffer in little endian at the current offset and moves the offset forward the amount of bytes written */
+NOM_API void nom_buffer_writei64lenext(struct NomBuffer *b, int64_t data_length,
+				       int64_t *data) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, data_length, 8)) > 0) {
+		nom_buffer_writei64le(b, b->off, k, data);
+		nom_buffer_advance(b, k * 8);
+		data += k;
+		data_length -= k;
+	}
+}
+
+/* nom_buffer_writei64be writes an array of i64s to the buffer in big endian at the specified offset */
+NOM_API void nom_buffer_writei64be(struct NomBuffer *b, int64_t off,
+				   int64_t data_length, int64_t *data) {
+	if (NOM_COW(b) != 0) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, b, off, data_length * 8, 8);
+	nom_byteorder(b->buf + off, data, data_length, 8, 1);
+}
+
+/* nom_buffer_writei64benext writes an array of i64s to the buffer in big endian at the current offset and moves the offset forward the amount of bytes written */
+NOM_API void nom_buffer_writei64benext(struct NomBuffer *b, int64_t data_length,
+				       int64_t *data) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, data_length, 8)) > 0) {
+		nom_buffer_writei64be(b, b->off, k, data);
+		nom_buffer_advance(b, k * 8);
+		data += k;
+		data_length -= k;
+	}
+}
+
+/* nom_buffer_writef32le writes an array of f32s to the buffer in little endian at the specified offset */
+NOM_API void nom_buffer_writef32le(struct NomBuffer *b, int64_t off,
+				   int64_t data_length, float *data) {
+	if (NOM_COW(b) != 0) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, b, off, data_length * 4, 4);
+	nom_byteorder(b->buf + off, data, data_length, 4, 0);
+}
+
+/* nom_buffer_writef32lenext writes an array of f32s to the buffer in little endian at the current offset and moves the offset forward the amount of bytes written */
+NOM_API void nom_buffer_writef32lenext(struct NomBuffer *b, int64_t data_length,
+				       float *data) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, data_length, 4)) > 0) {
+		nom_buffer_writef32le(b, b->off, k, data);
+		nom_buffer_advance(b, k * 4);
+		data += k;
+		data_length -= k;
+	}
+}
+
+/* nom_buffer_writef32be writes an array of f32s to the buffer in big endian at the specified offset */
+NOM_API void nom_buffer_writef32be(struct NomBuffer *b, int64_t off,
+				   int64_t data_length, float *data) {
+	if (NOM_COW(b) != 0) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, b, off, data_length * 4, 4);
+	nom_byteorder(b->buf + off, data, data_length, 4, 1);
+}
+
+/* nom_buffer_writef32benext writes an array of f32s to the buffer in big endian at the current offset and moves the offset forward the amount of bytes written */
+NOM_API void nom_buffer_writef32benext(struct NomBuffer *b, int64_t data_length,
+				       float *data) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, data_length, 4)) > 0) {
+		nom_buffer_writef32be(b, b->off, k, data);
+		nom_buffer_advance(b, k * 4);
+		data += k;
+		data_length -= k;
+	}
+}
+
+/* nom_buffer_writef64le writes an array of f64s to the buffer in little endian at the specified offset */
+NOM_API void nom_buffer_writef64le(struct NomBuffer *b, int64_t off,
+				   int64_t data_length, double *data) {
+	if (NOM_COW(b) != 0) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, b, off, data_length * 8, 8);
+	nom_byteorder(b->buf + off, data, data_length, 8, 0);
+}
+
+/* nom_buffer_writef64lenext writes an array of f64s to the buffer in little endian at the current offset and moves the offset forward the amount of bytes written */
+NOM_API void nom_buffer_writef64lenext(struct NomBuffer *b, int64_t data_length,
+				       double *data) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, data_length, 8)) > 0) {
+		nom_buffer_writef64le(b, b->off, k, data);
+		nom_buffer_advance(b, k * 8);
+		data += k;
+		data_length -= k;
+	}
+}
+
+/* nom_buffer_writef64be writes an array of f64s to the buffer in big endian at the specified offset */
+NOM_API void nom_buffer_writef64be(struct NomBuffer *b, int64_t off,
+				   int64_t data_length, double *data) {
+	if (NOM_COW(b) != 0) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, b, off, data_length * 8, 8);
+	nom_byteorder(b->buf + off, data, data_length, 8, 1);
+}
+
+/* nom_buffer_writef64benext writes an array of f64s to the buffer in big endian at the current offset and moves the offset forward the amount of bytes written */
+NOM_API void nom_buffer_writef64benext(struct NomBuffer *b, int64_t data_length,
+				       double *data) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, data_length, 8)) > 0) {
+		nom_buffer_writef64be(b, b->off, k, data);
+		nom_buffer_advance(b, k * 8);
+		data += k;
+		data_length -= k;
+	}
+}
+
+/* nom_buffer_readbytes reads n bytes from the buffer at the specified offset */
+NOM_API void nom_buffer_readbytes(struct NomBuffer *b, uint8_t *out,
+				  int64_t off, int64_t n) {
+	NOM_STAT_ACCESS(NOM_TRACE_READ, b, off, n, 1);
+	memcpy(out, b->buf + off, n * sizeof(uint8_t));
+}
+
+/* nom_buffer_readbytesnext reads n bytes from the buffer at the current offset and moves the offset forward the amount of bytes read */
+NOM_API void nom_buffer_readbytesnext(struct NomBuffer *b, uint8_t *out,
+				      int64_t n) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, n, 1)) > 0) {
+		nom_buffer_readbytes(b, out, b->off, k);
+		nom_buffer_advance(b, k);
+		out += k;
+		n -= k;
+	}
+}
+
+/* nom_buffer_readu16le reads n u16s from the buffer in little endian at the specified offset */
+NOM_API void nom_buffer_readu16le(struct NomBuffer *b, uint16_t *out,
+				  int64_t off, int64_t n) {
+	NOM_STAT_ACCESS(NOM_TRACE_READ, b, off, n * 2, 2);
+	nom_byteorder(out, b->buf + off, n, 2, 0);
+}
+
+/* nom_buffer_readu16lenext reads n u16s from the buffer in little endian at the current offset and moves the offset forward the amount of bytes read */
+NOM_API void nom_buffer_readu16lenext(struct NomBuffer *b, uint16_t *out,
+				      int64_t n) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, n, 2)) > 0) {
+		nom_buffer_readu16le(b, out, b->off, k);
+		nom_buffer_advance(b, k * 2);
+		out += k;
+		n -= k;
+	}
+}
+
+/* nom_buffer_readu16be reads n u16s from the buffer in big endian at the specified offset */
+NOM_API void nom_buffer_readu16be(struct NomBuffer *b, uint16_t *out,
+				  int64_t off, int64_t n) {
+	NOM_STAT_ACCESS(NOM_TRACE_READ, b, off, n * 2, 2);
+	nom_byteorder(out, b->buf + off, n, 2, 1);
+}
+
+/* nom_buffer_readu16benext reads n u16s from the buffer in big endian at the current offset and moves the offset forward the amount of bytes read */
+NOM_API void nom_buffer_readu16benext(struct NomBuffer *b, uint16_t *out,
+				      int64_t n) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, n, 2)) > 0) {
+		nom_buffer_readu16be(b, out, b->off, k);
+		nom_buffer_advance(b, k * 2);
+		out += k;
+		n -= k;
+	}
+}
+
+/* nom_buffer_readu32le reads n u32s from the buffer in little endian at the specified offset */
+NOM_API void nom_buffer_readu32le(struct NomBuffer *b, uint32_t *out,
+				  int64_t off, int64_t n) {
+	NOM_STAT_ACCESS(NOM_TRACE_READ, b, off, n * 4, 4);
+	nom_byteorder(out, b->buf + off, n, 4, 0);
+}
+
+/* nom_buffer_readu32lenext reads n u32s from the buffer in little endian at the current offset and moves the offset forward the amount of bytes read */
+NOM_API void nom_buffer_readu32lenext(struct NomBuffer *b, uint32_t *out,
+				      int64_t n) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, n, 4)) > 0) {
+		nom_buffer_readu32le(b, out, b->off, k);
+		nom_buffer_advance(b, k * 4);
+		out += k;
+		n -= k;
+	}
+}
+
+/* nom_buffer_readu32be reads n u32s from the buffer in big endian at the specified offset */
+NOM_API void nom_buffer_readu32be(struct NomBuffer *b, uint32_t *out,
+				  int64_t off, int64_t n) {
+	NOM_STAT_ACCESS(NOM_TRACE_READ, b, off, n * 4, 4);
+	nom_byteorder(out, b->buf + off, n, 4, 1);
+}
+
+/* nom_buffer_readu32benext reads n u32s from the buffer in big endian at the current offset and moves the offset forward the amount of bytes read */
+NOM_API void nom_buffer_readu32benext(struct NomBuffer *b, uint32_t *out,
+				      int64_t n) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, n, 4)) > 0) {
+		nom_buffer_readu32be(b, out, b->off, k);
+		nom_buffer_advance(b, k * 4);
+		out += k;
+		n -= k;
+	}
+}
+
+/* nom_buffer_readu64le reads n u64s from the buffer in little endian at the specified offset */
+NOM_API void nom_buffer_readu64le(struct NomBuffer *b, uint64_t *out,
+				  int64_t off, int64_t n) {
+	NOM_STAT_ACCESS(NOM_TRACE_READ, b, off, n * 8, 8);
+	nom_byteorder(out, b->buf + off, n, 8, 0);
+}
+
+/* nom_buffer_readu64lenext reads n u64s from the buffer in little endian at the current offset and moves the offset forward the amount of bytes read */
+NOM_API void nom_buffer_readu64lenext(struct NomBuffer *b, uint64_t *out,
+				      int64_t n) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, n, 8)) > 0) {
+		nom_buffer_readu64le(b, out, b->off, k);
+		nom_buffer_advance(b, k * 8);
+		out += k;
+		n -= k;
+	}
+}
+
+/* nom_buffer_readu64be reads n u64s from the buffer in big endian at the specified offset */
+NOM_API void nom_buffer_readu64be(struct NomBuffer *b, uint64_t *out,
+				  int64_t off, int64_t n) {
+	NOM_STAT_ACCESS(NOM_TRACE_READ, b, off, n * 8, 8);
+	nom_byteorder(out, b->buf + off, n, 8, 1);
+}
+
+/* nom_buffer_readu64benext reads n u64s from the buffer in big endian at the current offset and moves the offset forward the amount of bytes read */
+NOM_API void nom_buffer_readu64benext(struct NomBuffer *b, uint64_t *out,
+				      int64_t n) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, n, 8)) > 0) {
+		nom_buffer_readu64be(b, out, b->off, k);
+		nom_buffer_advance(b, k * 8);
+		out += k;
+		n -= k;
+	}
+}
+
+/* nom_buffer_readi16le reads n i16s from the buffer in little endian at the specified offset */
+NOM_API void nom_buffer_readi16le(struct NomBuffer *b, int16_t *out,
+				  int64_t off, int64_t n) {
+	NOM_STAT_ACCESS(NOM_TRACE_READ, b, off, n * 2, 2);
+	nom_byteorder(out, b->buf + off, n, 2, 0);
+}
+
+/* nom_buffer_readi16lenext reads n i16s from the buffer in little endian at the current offset and moves the offset forward the amount of bytes read */
+NOM_API void nom_buffer_readi16lenext(struct NomBuffer *b, int16_t *out,
+				      int64_t n) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, n, 2)) > 0) {
+		nom_buffer_readi16le(b, out, b->off, k);
+		nom_buffer_advance(b, k * 2);
+		out += k;
+		n -= k;
+	}
+}
+
+/* nom_buffer_readi16be reads n i16s from the buffer in big endian at the specified offset */
+NOM_API void nom_buffer_readi16be(struct NomBuffer *b, int16_t *out,
+				  int64_t off, int64_t n) {
+	NOM_STAT_ACCESS(NOM_TRACE_READ, b, off, n * 2, 2);
+	nom_byteorder(out, b->buf + off, n, 2, 1);
+}
+
+/* nom_buffer_readi16benext reads n i16s from the buffer in big endian at the current offset and moves the offset forward the amount of bytes read */
+NOM_API void nom_buffer_readi16benext(struct NomBuffer *b, int16_t *out,
+				      int64_t n) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, n, 2)) > 0) {
+		nom_buffer_readi16be(b, out, b->off, k);
+		nom_buffer_advance(b, k * 2);
+		out += k;
+		n -= k;
+	}
+}
+
+/* nom_buffer_readi32le reads n i32s from the buffer in little endian at the specified offset */
+NOM_API void nom_buffer_readi32le(struct NomBuffer *b, int32_t *out,
+				  int64_t off, int64_t n) {
+	NOM_STAT_ACCESS(NOM_TRACE_READ, b, off, n * 4, 4);
+	nom_byteorder(out, b->buf + off, n, 4, 0);
+}
+
+/* nom_buffer_readi32lenext reads n i32s from the buffer in little endian at the current offset and moves the offset forward the amount of bytes read */
+NOM_API void nom_buffer_readi32lenext(struct NomBuffer *b, int32_t *out,
+				      int64_t n) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, n, 4)) > 0) {
+		nom_buffer_readi32le(b, out, b->off, k);
+		nom_buffer_advance(b, k * 4);
+		out += k;
+		n -= k;
+	}
+}
+
+/* nom_buffer_readi32be reads n i32s from the buffer in big endian at the specified offset */
+NOM_API void nom_buffer_readi32be(struct NomBuffer *b, int32_t *out,
+				  int64_t off, int64_t n) {
+	NOM_STAT_ACCESS(NOM_TRACE_READ, b, off, n * 4, 4);
+	nom_byteorder(out, b->buf + off, n, 4, 1);
+}
+
+/* nom_buffer_readi32benext reads n i32s from the buffer in big endian at the current offset and moves the offset forward the amount of bytes read */
+NOM_API void nom_buffer_readi32benext(struct NomBuffer *b, int32_t *out,
+				      int64_t n) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, n, 4)) > 0) {
+		nom_buffer_readi32be(b, out, b->off, k);
+		nom_buffer_advance(b, k * 4);
+		out += k;
+		n -= k;
+	}
+}
+
+/* nom_buffer_readi64le reads n i64s from the buffer in little endian at the specified offset */
+NOM_API void nom_buffer_readi64le(struct NomBuffer *b, int64_t *out,
+				  int64_t off, int64_t n) {
+	NOM_STAT_ACCESS(NOM_TRACE_READ, b, off, n * 8, 8);
+	nom_byteorder(out, b->buf + off, n, 8, 0);
+}
+
+/* nom_buffer_readi64lenext reads n i64s from the buffer in little endian at the current offset and moves the offset forward the amount of bytes read */
+NOM_API void nom_buffer_readi64lenext(struct NomBuffer *b, int64_t *out,
+				      int64_t n) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, n, 8)) > 0) {
+		nom_buffer_readi64le(b, out, b->off, k);
+		nom_buffer_advance(b, k * 8);
+		out += k;
+		n -= k;
+	}
+}
+
+/* nom_buffer_readi64be reads n i64s from the buffer in big endian at the specified offset */
+NOM_API void nom_buffer_readi64be(struct NomBuffer *b, int64_t *out,
+				  int64_t off, int64_t n) {
+	NOM_STAT_ACCESS(NOM_TRACE_READ, b, off, n * 8, 8);
+	nom_byteorder(out, b->buf + off, n, 8, 1);
+}
+
+/* nom_buffer_readi64benext reads n i64s from the buffer in big endian at the current offset and moves the offset forward the amount of bytes read */
+NOM_API void nom_buffer_readi64benext(struct NomBuffer *b, int64_t *out,
+				      int64_t n) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, n, 8)) > 0) {
+		nom_buffer_readi64be(b, out, b->off, k);
+		nom_buffer_advance(b, k * 8);
+		out += k;
+		n -= k;
+	}
+}
+
+/* nom_buffer_readf32le reads n f32s from the buffer in little endian at the specified offset */
+NOM_API void nom_buffer_readf32le(struct NomBuffer *b, float *out, int64_t off,
+				  int64_t n) {
+	NOM_STAT_ACCESS(NOM_TRACE_READ, b, off, n * 4, 4);
+	nom_byteorder(out, b->buf + off, n, 4, 0);
+}
+
+/* nom_buffer_readf32lenext reads n f32s from the buffer in little endian at the current offset and moves the offset forward the amount of bytes read */
+NOM_API void nom_buffer_readf32lenext(struct NomBuffer *b, float *out,
+				      int64_t n) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, n, 4)) > 0) {
+		nom_buffer_readf32le(b, out, b->off, k);
+		nom_buffer_advance(b, k * 4);
+		out += k;
+		n -= k;
+	}
+}
+
+/* nom_buffer_readf32be reads n f32s from the buffer in big endian at the specified offset */
+NOM_API void nom_buffer_readf32be(struct NomBuffer *b, float *out, int64_t off,
+				  int64_t n) {
+	NOM_STAT_ACCESS(NOM_TRACE_READ, b, off, n * 4, 4);
+	nom_byteorder(out, b->buf + off, n, 4, 1);
+}
+
+/* nom_buffer_readf32benext reads n f32s from the buffer in big endian at the current offset and moves the offset forward the amount of bytes read */
+NOM_API void nom_buffer_readf32benext(struct NomBuffer *b, float *out,
+				      int64_t n) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, n, 4)) > 0) {
+		nom_buffer_readf32be(b, out, b->off, k);
+		nom_buffer_advance(b, k * 4);
+		out += k;
+		n -= k;
+	}
+}
+
+/* nom_buffer_readf64le reads n f64s from the buffer in little endian at the specified offset */
+NOM_API void nom_buffer_readf64le(struct NomBuffer *b, double *out, int64_t off,
+				  int64_t n) {
+	NOM_STAT_ACCESS(NOM_TRACE_READ, b, off, n * 8, 8);
+	nom_byteorder(out, b->buf + off, n, 8, 0);
+}
+
+/* nom_buffer_readf64lenext reads n f64s from the buffer in little endian at the current offset and moves the offset forward the amount of bytes read */
+NOM_API void nom_buffer_readf64lenext(struct NomBuffer *b, double *out,
+				      int64_t n) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, n, 8)) > 0) {
+		nom_buffer_readf64le(b, out, b->off, k);
+		nom_buffer_advance(b, k * 8);
+		out += k;
+		n -= k;
+	}
+}
+
+/* nom_buffer_readf64be reads n f64s from the buffer in big endian at the specified offset */
+NOM_API void nom_buffer_readf64be(struct NomBuffer *b, double *out, int64_t off,
+				  int64_t n) {
+	NOM_STAT_ACCESS(NOM_TRACE_READ, b, off, n * 8, 8);
+	nom_byteorder(out, b->buf + off, n, 8, 1);
+}
+
+/* nom_buffer_readf64benext reads n f64s from the buffer in big endian at the current offset and moves the offset forward the amount of bytes read */
+NOM_API void nom_buffer_readf64benext(struct NomBuffer *b, double *out,
+				      int64_t n) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, n, 8)) > 0) {
+		nom_buffer_readf64be(b, out, b->off, k);
+		nom_buffer_advance(b, k * 8);
+		out += k;
+		n -= k;
+	}
+}
+
+/* nom_buffer_afterbyte stores the amount of bytes located after the current position or the specified one in out */
+NOM_API void nom_buffer_afterbyte(struct NomBuffer *b, int64_t *out,
+				  int64_t off) {
+	if (off < 0) {
+		*out = b->cap - b->off - 1;
+
+	} else if (off >= 0) {
+		*out = b->cap - off - 1;
+	}
+}
+
+/* nom_buffer_alignbyte aligns the byte offset to the bit offset */
+NOM_API void nom_buffer_alignbyte(struct NomBuffer *b) {
+	b->off = b->boff / 8;
+}
+
+/* nom_buffer_grow makes the buffer's capacity bigger by n bytes, returning -1 if that fails */
+NOM_API int nom_buffer_grow(struct NomBuffer *b, int64_t n) {
+	return nom_buffer_ensure(b, b->cap + n);
+}
+
+/* nom_buffer_appendbytes writes a byte array to the buffer at the current offset, growing the buffer if it doesn't fit, and moves the offset forward the amount of bytes written */
+NOM_API int nom_buffer_appendbytes(struct NomBuffer *b, int64_t data_length,
+				   uint8_t *data) {
+	if (nom_buffer_ensure(b, b->off + data_length) != 0) {
+		return -1;
+	}
+	nom_buffer_writebytesnext(b, data_length, data);
+	return 0;
+}
 
-	out->buf = (uint8_t *)(malloc(initial_size * sizeof(uint8_t)));
+/* nom_buffer_appendu16le writes an array of u16s to the buffer in little endian at the current offset, growing the buffer if it doesn't fit, and moves the offset forward the amount of bytes written */
+NOM_API int nom_buffer_appendu16le(struct NomBuffer *b, int64_t data_length,
+				   uint16_t *data) {
+	if (nom_buffer_ensure(b, b->off + data_length * 2) != 0) {
+		return -1;
+	}
+	nom_buffer_writeu16lenext(b, data_length, data);
+	return 0;
 }
 
-/* nom_buffer_destroy destroys an existing buffer */
-void nom_buffer_destroy(struct NomBuffer *b) {
-	free(b->buf);
-	free(b);
+/* nom_buffer_appendu16be writes an array of u16s to the buffer in big endian at the current offset, growing the buffer if it doesn't fit, and moves the offset forward the amount of bytes written */
+NOM_API int nom_buffer_appendu16be(struct NomBuffer *b, int64_t data_length,
+				   uint16_t *data) {
+	if (nom_buffer_ensure(b, b->off + data_length * 2) != 0) {
+		return -1;
+	}
+	nom_buffer_writeu16benext(b, data_length, data);
+	return 0;
 }
 
-/* nom_buffer_seekbit seeks to bit position off of buffer relative to the current position or exact */
-void nom_buffer_seekbit(struct NomBuffer *b, int64_t off, uint8_t relative) {
-	if (relative < 0) {
-		b->boff = off;
+/* nom_buffer_appendu32le writes an array of u32s to the buffer in little endian at the current offset, growing the buffer if it doesn't fit, and moves the offset forward the amount of bytes written */
+NOM_API int nom_buffer_appendu32le(struct NomBuffer *b, int64_t data_length,
+				   uint32_t *data) {
+	if (nom_buffer_ensure(b, b->off + data_length * 4) != 0) {
+		return -1;
+	}
+	nom_buffer_writeu32lenext(b, data_length, data);
+	return 0;
+}
 
-	} else if (relative >= 0) {
-		b->boff += off;
+/* nom_buffer_appendu32be writes an array of u32s to the buffer in big endian at the current offset, growing the buffer if it doesn't fit, and moves the offset forward the amount of bytes written */
+NOM_API int nom_buffer_appendu32be(struct NomBuffer *b, int64_t data_length,
+				   uint32_t *data) {
+	if (nom_buffer_ensure(b, b->off + data_length * 4) != 0) {
+		return -1;
 	}
+	nom_buffer_writeu32benext(b, data_length, data);
+	return 0;
 }
 
-/* nom_buffer_readbit reads a bit from the buffer at the specified offset */
-void nom_buffer_readbit(struct NomBuffer *b, uint8_t *out, int64_t off) {
-	*out = (b->buf[off / 8] >> (7 - (off % 8))) & 1;
+/* nom_buffer_appendu64le writes an array of u64s to the buffer in little endian at the current offset, growing the buffer if it doesn't fit, and moves the offset forward the amount of bytes written */
+NOM_API int nom_buffer_appendu64le(struct NomBuffer *b, int64_t data_length,
+				   uint64_t *data) {
+	if (nom_buffer_ensure(b, b->off + data_length * 8) != 0) {
+		return -1;
+	}
+	nom_buffer_writeu64lenext(b, data_length, data);
+	return 0;
 }
 
-/* nom_buffer_readbitnext reads the next bit from the buffer at the current offset and moves the offset forward a bit */
-void nom_buffer_readbitnext(struct NomBuffer *b, uint8_t *out) {
-	nom_buffer_readbit(b, out, b->boff);
-	nom_buffer_seekbit(b, 1, 1);
+/* nom_buffer_appendu64be writes an array of u64s to the buffer in big endian at the current offset, growing the buffer if it doesn't fit, and moves the offset forward the amount of bytes written */
+NOM_API int nom_buffer_appendu64be(struct NomBuffer *b, int64_t data_length,
+				   uint64_t *data) {
+	if (nom_buffer_ensure(b, b->off + data_length * 8) != 0) {
+		return -1;
+	}
+	nom_buffer_writeu64benext(b, data_length, data);
+	return 0;
 }
 
-/* nom_buffer_readbits reads n bits from the buffer at the specified offset */
-void nom_buffer_readbits(struct NomBuffer *b, uint64_t *out, int64_t off,
-			 int64_t n) {
-	uint8_t bout;
-	for (int i = 0; i < n; i++) {
-		nom_buffer_readbit(b, &bout, off + i);
-		*out = (*out << 1) | bout;
+/* nom_buffer_appendi16le writes an array of i16s to the buffer in little endian at the current offset, growing the buffer if it doesn't fit, and moves the offset forward the amount of bytes written */
+NOM_API int nom_buffer_appendi16le(struct NomBuffer *b, int64_t data_length,
+				   int16_t *data) {
+	if (nom_buffer_ensure(b, b->off + data_length * 2) != 0) {
+		return -1;
 	}
+	nom_buffer_writei16lenext(b, data_length, data);
+	return 0;
 }
 
-/* nom_buffer_readbitsnext reads the next n bits from the buffer at the current offset and moves the offset forward the amount of bits read */
-void nom_buffer_readbitsnext(struct NomBuffer *b, uint64_t *out, int64_t n) {
-	nom_buffer_readbits(b, out, b->boff, n);
-	nom_buffer_seekbit(b, n, 1);
+/* nom_buffer_appendi16be writes an array of i16s to the buffer in big endian at the current offset, growing the buffer if it doesn't fit, and moves the offset forward the amount of bytes written */
+NOM_API int nom_buffer_appendi16be(struct NomBuffer *b, int64_t data_length,
+				   int16_t *data) {
+	if (nom_buffer_ensure(b, b->off + data_length * 2) != 0) {
+		return -1;
+	}
+	nom_buffer_writei16benext(b, data_length, data);
+	return 0;
 }
 
-/* nom_buffer_setbit sets the bit located at the specified offset */
-void nom_buffer_setbit(struct NomBuffer *b, int64_t off) {
-	b->buf[off / 8] |= (1 << (7 - (off % 8)));
+/* nom_buffer_appendi32le writes an array of i32s to the buffer in little endian at the current offset, growing the buffer if it doesn't fit, and moves the offset forward the amount of bytes written */
+NOM_API int nom_buffer_appendi32le(struct NomBuffer *b, int64_t data_length,
+				   int32_t *data) {
+	if (nom_buffer_ensure(b, b->off + data_length * 4) != 0) {
+		return -1;
+	}
+	nom_buffer_writei32lenext(b, data_length, data);
+	return 0;
 }
 
-/* nom_buffer_setbitnext sets the next bit from the current offset and moves the offset forward a bit */
-void nom_buffer_setbitnext(struct NomBuffer *b) {
-	nom_buffer_setbit(b, b->boff);
-	nom_buffer_seekbit(b, 1, 1);
+/* nom_buffer_appendi32be writes an array of i32s to the buffer in big endian at the current offset, growing the buffer if it doesn't fit, and moves the offset forward the amount of bytes written */
+NOM_API int nom_buffer_appendi32be(struct NomBuffer *b, int64_t data_length,
+				   int32_t *data) {
+	if (nom_buffer_ensure(b, b->off + data_length * 4) != 0) {
+		return -1;
+	}
+	nom_buffer_writei32benext(b, data_length, data);
+	return 0;
 }
 
-/* nom_buffer_clearbit clears the bit located at the specified offset */
-void nom_buffer_clearbit(struct NomBuffer *b, int64_t off) {
-	b->buf[off / 8] &= ~(1 << (7 - (off % 8)));
+/* nom_buffer_appendi64le writes an array of i64s to the buffer in little endian at the current offset, growing the buffer if it doesn't fit, and moves the offset forward the amount of bytes written */
+NOM_API int nom_buffer_appendi64le(struct NomBuffer *b, int64_t data_length,
+				   int64_t *data) {
+	if (nom_buffer_ensure(b, b->off + data_length * 8) != 0) {
+		return -1;
+	}
+	nom_buffer_writei64lenext(b, data_length, data);
+	return 0;
 }
 
-/* nom_buffer_clearbitnext clears the next bit from the current offset and moves the offset forward a bit */
-void nom_buffer_clearbitnext(struct NomBuffer *b) {
-	nom_buffer_clearbit(b, b->boff);
-	nom_buffer_seekbit(b, 1, 1);
+/* nom_buffer_appendi64be writes an array of i64s to the buffer in big endian at the current offset, growing the buffer if it doesn't fit, and moves the offset forward the amount of bytes written */
+NOM_API int nom_buffer_appendi64be(struct NomBuffer *b, int64_t data_length,
+				   int64_t *data) {
+	if (nom_buffer_ensure(b, b->off + data_length * 8) != 0) {
+		return -1;
+	}
+	nom_buffer_writei64benext(b, data_length, data);
+	return 0;
 }
 
-/* nom_buffer_setbits sets the next n bits from the specified offset value */
-void nom_buffer_setbits(struct NomBuffer *b, int64_t off, uint64_t data,
-			int64_t n) {
-	for (int i = 0; i < n; i++) {
-		if (((data >> (n - i - 1)) & 1) == 0) {
-			nom_buffer_clearbit(b, off + i);
+/* nom_buffer_appendf32le writes an array of f32s to the buffer in little endian at the current offset, growing the buffer if it doesn't fit, and moves the offset forward the amount of bytes written */
+NOM_API int nom_buffer_appendf32le(struct NomBuffer *b, int64_t data_length,
+				   float *data) {
+	if (nom_buffer_ensure(b, b->off + data_length * 4) != 0) {
+		return -1;
+	}
+	nom_buffer_writef32lenext(b, data_length, data);
+	return 0;
+}
 
-		} else {
-			nom_buffer_setbit(b, off + i);
+/* nom_buffer_appendf32be writes an array of f32s to the buffer in big endian at the current offset, growing the buffer if it doesn't fit, and moves the offset forward the amount of bytes written */
+NOM_API int nom_buffer_appendf32be(struct NomBuffer *b, int64_t data_length,
+				   float *data) {
+	if (nom_buffer_ensure(b, b->off + data_length * 4) != 0) {
+		return -1;
+	}
+	nom_buffer_writef32benext(b, data_length, data);
+	return 0;
+}
+
+/* nom_buffer_appendf64le writes an array of f64s to the buffer in little endian at the current offset, growing the buffer if it doesn't fit, and moves the offset forward the amount of bytes written */
+NOM_API int nom_buffer_appendf64le(struct NomBuffer *b, int64_t data_length,
+				   double *data) {
+	if (nom_buffer_ensure(b, b->off + data_length * 8) != 0) {
+		return -1;
+	}
+	nom_buffer_writef64lenext(b, data_length, data);
+	return 0;
+}
+
+/* nom_buffer_appendf64be writes an array of f64s to the buffer in big endian at the current offset, growing the buffer if it doesn't fit, and moves the offset forward the amount of bytes written */
+NOM_API int nom_buffer_appendf64be(struct NomBuffer *b, int64_t data_length,
+				   double *data) {
+	if (nom_buffer_ensure(b, b->off + data_length * 8) != 0) {
+		return -1;
+	}
+	nom_buffer_writef64benext(b, data_length, data);
+	return 0;
+}
+
+/* nom_half_to_float widens an ieee 754 half to a float */
+NOM_API NOM_ALWAYS_INLINE float nom_half_to_float(uint16_t h) {
+	uint32_t sign = (uint32_t)(h & 0x8000) << 16, exp = (h >> 10) & 0x1f,
+		 man = h & 0x3ff, x;
+	float f;
+
+	if (exp == 0x1f) {
+		/* nans come out quiet, as they do from f16c */
+		x = sign | 0x7f800000 | (man << 13) | (man != 0 ? 0x400000 : 0);
+
+	} else if (exp != 0) {
+		x = sign | ((exp + 112) << 23) | (man << 13);
+
+	} else {
+		/* subnormals are exact as a float, and man * 2^-24 renormalizes them */
+		f = (float)(man) / 16777216.0f;
+		memcpy(&x, &f, 4);
+		x |= sign;
+	}
+	memcpy(&f, &x, 4);
+	return f;
+}
+
+/* nom_float_to_half narrows a float to an ieee 754 half, rounding to nearest even like f16c does */
+NOM_API NOM_ALWAYS_INLINE uint16_t nom_float_to_half(float f) {
+	uint32_t x, sign;
+	float t;
+
+	memcpy(&x, &f, 4);
+	sign = (x >> 16) & 0x8000;
+	x &= 0x7fffffff;
+	if (x > 0x7f800000) {
+		return (uint16_t)(sign | 0x7e00 | ((x >> 13) & 0x3ff));
+	}
+	if (x >= 0x47800000) {
+		return (uint16_t)(sign | 0x7c00);
+	}
+
+	/* below the smallest normal half, adding 0.5 lines the half's subnormal mantissa up with the bottom of the float's and lets the fpu round it */
+	if (x < 0x38800000) {
+		memcpy(&t, &x, 4);
+		t += 0.5f;
+		memcpy(&x, &t, 4);
+		return (uint16_t)(sign | (x - 0x3f000000));
+	}
+	x += ((uint32_t)(15 - 127) << 23) + 0xfff + ((x >> 13) & 1);
+	return (uint16_t)(sign | (x >> 13));
+}
+
+/* nom_float_to_i16 rounds v to the nearest i16 (ties to even, like cvtps2dq), saturating values out of range and nans */
+NOM_API NOM_ALWAYS_INLINE int16_t nom_float_to_i16(float v) {
+	/* the comparisons are ordered so a nan saturates the same way minps and maxps make it */
+	v = v < 32767.0f ? v : 32767.0f;
+	v = v > -32768.0f ? v : -32768.0f;
+
+	/* adding and removing 1.5 * 2^23 leaves no fraction bits, so the fpu rounds v in the current rounding mode */
+	v = (v + 12582912.0f) - 12582912.0f;
+	return (int16_t)(v);
+}
+
+/* nom_load16 loads a u16 in big (1) or little (0) endian from p */
+NOM_API NOM_ALWAYS_INLINE uint16_t nom_load16(const uint8_t *p, int big) {
+	uint16_t v;
+
+	memcpy(&v, p, 2);
+	return big != NOM_BIG_ENDIAN ? nom_bswap16(v) : v;
+}
+
+/* nom_store16 stores a u16 in big (1) or little (0) endian to p */
+NOM_API NOM_ALWAYS_INLINE void nom_store16(uint8_t *p, uint16_t v, int big) {
+	v = big != NOM_BIG_ENDIAN ? nom_bswap16(v) : v;
+	memcpy(p, &v, 2);
+}
+
+#ifdef NOM_X86
+/* nom_half_decode_f16c converts halves to floats 8 at a time, returning how many it converted. it sticks to xmm registers so it doesn't pay for waking up the wide units on small arrays */
+__attribute__((target("avx,f16c"))) NOM_API int64_t
+nom_half_decode_f16c(float *dst, const uint8_t *src, int64_t n, int big) {
+	__m128i mask = nom_swap_mask(2);
+	int64_t i = 0;
+
+	for (; i + 8 <= n; i += 8) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + i * 2));
+		if (big) {
+			v = _mm_shuffle_epi8(v, mask);
 		}
+		_mm_storeu_ps(dst + i, _mm_cvtph_ps(v));
+		_mm_storeu_ps(dst + i + 4, _mm_cvtph_ps(_mm_srli_si128(v, 8)));
 	}
+	return i;
 }
 
-/* nom_buffer_setbitsnext sets the next n bits from the current offset and moves the offset forward the amount of bits set */
-void nom_buffer_setbitsnext(struct NomBuffer *b, uint64_t data, int64_t n) {
-	nom_buffer_setbits(b, b->boff, data, n);
-	nom_buffer_seekbit(b, n, 1);
+/* nom_half_encode_f16c converts floats to halves 8 at a time, returning how many it converted */
+__attribute__((target("avx,f16c"))) NOM_API int64_t
+nom_half_encode_f16c(uint8_t *dst, const float *src, int64_t n, int big) {
+	__m128i mask = nom_swap_mask(2);
+	int64_t i = 0;
+
+	for (; i + 8 <= n; i += 8) {
+		__m128i lo = _mm_cvtps_ph(_mm_loadu_ps(src + i),
+					  _MM_FROUND_TO_NEAREST_INT);
+		__m128i hi = _mm_cvtps_ph(_mm_loadu_ps(src + i + 4),
+					  _MM_FROUND_TO_NEAREST_INT);
+		__m128i v = _mm_unpacklo_epi64(lo, hi);
+		if (big) {
+			v = _mm_shuffle_epi8(v, mask);
+		}
+		_mm_storeu_si128((__m128i *)(dst + i * 2), v);
+	}
+	return i;
 }
+#endif
 
-/* nom_buffer_flipbit flips the bit located at the specified offset */
-void nom_buffer_flipbit(struct NomBuffer *b, int64_t off) {
-	b->buf[off / 8] ^= (1 << (7 - (off % 8)));
+#if defined(NOM_X86) && defined(__SSE2__)
+/* nom_swap16_sse2 reverses the bytes of each u16 lane of v */
+NOM_API NOM_ALWAYS_INLINE __m128i nom_swap16_sse2(__m128i v) {
+	return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
 }
+#endif
 
-/* nom_buffer_flipbitnext flips the bit located at the current offset and moves the offset forwards a bit */
-void nom_buffer_flipbitnext(struct NomBuffer *b) {
-	nom_buffer_flipbit(b, b->boff);
-	nom_buffer_seekbit(b, 1, 1);
+/* nom_half_decode converts n halves in big (1) or little (0) endian at src to floats */
+NOM_API void nom_half_decode(float *dst, const uint8_t *src, int64_t n,
+			     int big) {
+	int64_t i = 0;
+
+#ifdef NOM_X86
+	if (nom_cpu_features() & NOM_CPU_F16C) {
+		i = nom_half_decode_f16c(dst, src, n, big);
+	}
+#endif
+	for (; i < n; i++) {
+		dst[i] = nom_half_to_float(nom_load16(src + i * 2, big));
+	}
 }
 
-/* nom_buffer_clearallbits clears all of the bits in the buffer */
-void nom_buffer_clearallbits(struct NomBuffer *b) {
-	for (int i = 0; i < b->cap; i++) {
-		b->buf[i] = 0x00;
+/* nom_half_encode converts n floats at src to halves in big (1) or little (0) endian */
+NOM_API void nom_half_encode(uint8_t *dst, const float *src, int64_t n,
+			     int big) {
+	int64_t i = 0;
+
+#ifdef NOM_X86
+	if (nom_cpu_features() & NOM_CPU_F16C) {
+		i = nom_half_encode_f16c(dst, src, n, big);
+	}
+#endif
+	for (; i < n; i++) {
+		nom_store16(dst + i * 2, nom_float_to_half(src[i]), big);
 	}
 }
 
-/* nom_buffer_setallbits sets all of the bits in the buffer */
-void nom_buffer_setallbits(struct NomBuffer *b) {
-	for (int i = 0; i < b->cap; i++) {
-		b->buf[i] = 0xff;
+/* nom_scaled_decode converts n i16s in big (1) or little (0) endian at src to floats, multiplying them by scale */
+NOM_API void nom_scaled_decode(float *dst, const uint8_t *src, int64_t n,
+			       int big, float scale) {
+	int64_t i = 0;
+
+#if defined(NOM_X86) && defined(__SSE2__)
+	__m128 s = _mm_set1_ps(scale);
+
+	for (; i + 8 <= n; i += 8) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + i * 2));
+		if (big) {
+			v = nom_swap16_sse2(v);
+		}
+
+		/* unpacking a lane with itself and shifting it back down sign extends it */
+		_mm_storeu_ps(dst + i,
+			      _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(
+						 _mm_unpacklo_epi16(v, v), 16)),
+					 s));
+		_mm_storeu_ps(dst + i + 4,
+			      _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(
+						 _mm_unpackhi_epi16(v, v), 16)),
+					 s));
+	}
+#endif
+	for (; i < n; i++) {
+		dst[i] = (float)((int16_t)(nom_load16(src + i * 2, big))) *
+			 scale;
 	}
 }
 
-/* nom_buffer_flipallbits flips all of the bits in the buffer */
-void nom_buffer_flipallbits(struct NomBuffer *b) {
-	for (int i = 0; i < b->cap; i++) {
-		b->buf[i] = ~b->buf[i];
+/* nom_scaled_encode converts n floats at src to i16s in big (1) or little (0) endian, dividing them by scale and rounding them */
+NOM_API void nom_scaled_encode(uint8_t *dst, const float *src, int64_t n,
+			       int big, float scale) {
+	float inv = 1.0f / scale;
+	int64_t i = 0;
+
+#if defined(NOM_X86) && defined(__SSE2__)
+	__m128 s = _mm_set1_ps(inv), hi = _mm_set1_ps(32767.0f),
+	       lo = _mm_set1_ps(-32768.0f);
+
+	for (; i + 8 <= n; i += 8) {
+		__m128 f0 = _mm_mul_ps(_mm_loadu_ps(src + i), s);
+		__m128 f1 = _mm_mul_ps(_mm_loadu_ps(src + i + 4), s);
+		__m128i v;
+
+		/* cvtps2dq turns values out of range into INT32_MIN, so clamp first */
+		f0 = _mm_max_ps(_mm_min_ps(f0, hi), lo);
+		f1 = _mm_max_ps(_mm_min_ps(f1, hi), lo);
+		v = _mm_packs_epi32(_mm_cvtps_epi32(f0), _mm_cvtps_epi32(f1));
+		if (big) {
+			v = nom_swap16_sse2(v);
+		}
+		_mm_storeu_si128((__m128i *)(dst + i * 2), v);
+	}
+#endif
+	for (; i < n; i++) {
+		nom_store16(dst + i * 2,
+			    (uint16_t)(nom_float_to_i16(src[i] * inv)), big);
 	}
 }
 
-/* nom_buffer_afterbit stores the amount of bits located after the current position or the specified one in out */
-void nom_buffer_afterbit(struct NomBuffer *b, int64_t *out, int64_t off) {
-	if (off < 0) {
-		*out = b->bcap - b->boff - 1;
+/* nom_buffer_readf16le reads n ieee 754 halves from the buffer in little endian at the specified offset, widening them to floats */
+NOM_API void nom_buffer_readf16le(struct NomBuffer *b, float *out, int64_t off,
+				  int64_t n) {
+	NOM_STAT_ACCESS(NOM_TRACE_READ, b, off, n * 2, 2);
+	nom_half_decode(out, b->buf + off, n, 0);
+}
 
-	} else if (off >= 0) {
-		*out = b->bcap - off - 1;
+/* nom_buffer_readf16lenext reads n ieee 754 halves from the buffer in little endian at the current offset, widening them to floats, and moves the offset forward the amount of bytes read */
+NOM_API void nom_buffer_readf16lenext(struct NomBuffer *b, float *out,
+				      int64_t n) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, n, 2)) > 0) {
+		nom_buffer_readf16le(b, out, b->off, k);
+		nom_buffer_advance(b, k * 2);
+		out += k;
+		n -= k;
 	}
 }
 
-/* nom_buffer_alignbit aligns the bit offset to the byte offset */
-void nom_buffer_alignbit(struct NomBuffer *b) {
-	b->boff = b->off * 8;
+/* nom_buffer_writef16le writes an array of floats to the buffer as ieee 754 halves in little endian at the specified offset, rounding them to nearest even */
+NOM_API void nom_buffer_writef16le(struct NomBuffer *b, int64_t off,
+				   int64_t data_length, float *data) {
+	if (NOM_COW(b) != 0) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, b, off, data_length * 2, 2);
+	nom_half_encode(b->buf + off, data, data_length, 0);
 }
 
-/* nom_buffer_seekbytes seeks to position off of the buffer relative to the current position or exact */
-void nom_buffer_seekbyte(struct NomBuffer *b, int64_t off, uint8_t relative) {
-	if (relative < 0) {
-		b->off = off;
+/* nom_buffer_writef16lenext writes an array of floats to the buffer as ieee 754 halves in little endian at the current offset and moves the offset forward the amount of bytes written */
+NOM_API void nom_buffer_writef16lenext(struct NomBuffer *b, int64_t data_length,
+				       float *data) {
+	int64_t k;
 
-	} else if (relative >= 0) {
-		b->off += off;
+	while ((k = nom_buffer_window(b, data_length, 2)) > 0) {
+		nom_buffer_writef16le(b, b->off, k, data);
+		nom_buffer_advance(b, k * 2);
+		data += k;
+		data_length -= k;
 	}
 }
 
-/* nom_buffer_writebytes writes a byte array to the buffer at the specified offset */
-void nom_buffer_writebytes(struct NomBuffer *b, int64_t off,
-			   int64_t data_length, uint8_t *data) {
-	memcpy(b->buf + off, data, data_length * sizeof(uint8_t));
+/* nom_buffer_appendf16le writes an array of floats to the buffer as ieee 754 halves in little endian at the current offset, growing the buffer if they don't fit, and moves the offset forward the amount of bytes written */
+NOM_API int nom_buffer_appendf16le(struct NomBuffer *b, int64_t data_length,
+				   float *data) {
+	if (nom_buffer_ensure(b, b->off + data_length * 2) != 0) {
+		return -1;
+	}
+	nom_buffer_writef16lenext(b, data_length, data);
+	return 0;
 }
 
-/* nom_buffer_writebytesnext writes a byte array to the buffer at the current offset and moves the offset forward the amount of bytes written */
-void nom_buffer_writebytesnext(struct NomBuffer *b, int64_t data_length,
-			       uint8_t *data) {
-	nom_buffer_writebytes(b, b->off, data_length, data);
-	nom_buffer_seekbyte(b, data_length, 1);
+/* nom_buffer_readf16be reads n ieee 754 halves from the buffer in big endian at the specified offset, widening them to floats */
+NOM_API void nom_buffer_readf16be(struct NomBuffer *b, float *out, int64_t off,
+				  int64_t n) {
+	NOM_STAT_ACCESS(NOM_TRACE_READ, b, off, n * 2, 2);
+	nom_half_decode(out, b->buf + off, n, 1);
 }
 
-/* nom_buffer_writeu16le writes an array of u16s to the buffer in little endian at the specified offset */
-void nom_buffer_writeu16le(struct NomBuffer *b, int64_t off,
-			   int64_t data_length, uint16_t *data) {
-	for (int i = 0; i < data_length; i++) {
-		b->buf[off + (i * 2)] = (uint8_t)(data[i]);
-		b->buf[off + (1 + (i * 2))] = (uint8_t)(data[i] >> 8);
+/* nom_buffer_readf16benext reads n ieee 754 halves from the buffer in big endian at the current offset, widening them to floats, and moves the offset forward the amount of bytes read */
+NOM_API void nom_buffer_readf16benext(struct NomBuffer *b, float *out,
+				      int64_t n) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, n, 2)) > 0) {
+		nom_buffer_readf16be(b, out, b->off, k);
+		nom_buffer_advance(b, k * 2);
+		out += k;
+		n -= k;
 	}
 }
 
-/* nom_buffer_writeu16lenext writes an array of u16s to the buffer in little endian at the current offset and moves the offset forward the amount of bytes written */
-void nom_buffer_writeu16lenext(struct NomBuffer *b, int64_t data_length,
-			       uint16_t *data) {
-	nom_buffer_writeu16le(b, b->off, data_length, data);
-	nom_buffer_seekbyte(b, data_length * 2, 1);
+/* nom_buffer_writef16be writes an array of floats to the buffer as ieee 754 halves in big endian at the specified offset, rounding them to nearest even */
+NOM_API void nom_buffer_writef16be(struct NomBuffer *b, int64_t off,
+				   int64_t data_length, float *data) {
+	if (NOM_COW(b) != 0) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, b, off, data_length * 2, 2);
+	nom_half_encode(b->buf + off, data, data_length, 1);
 }
 
-/* nom_buffer_writeu16be writes an array of u16s to the buffer in big endian at the specified offset */
-void nom_buffer_writeu16be(struct NomBuffer *b, int64_t off,
-			   int64_t data_length, uint16_t *data) {
-	for (int i = 0; i < data_length; i++) {
-		b->buf[off + (i * 2)] = (uint8_t)(data[i] >> 8);
-		b->buf[off + (1 + (i * 2))] = (uint8_t)(data[i]);
+/* nom_buffer_writef16benext writes an array of floats to the buffer as ieee 754 halves in big endian at the current offset and moves the offset forward the amount of bytes written */
+NOM_API void nom_buffer_writef16benext(struct NomBuffer *b, int64_t data_length,
+				       float *data) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, data_length, 2)) > 0) {
+		nom_buffer_writef16be(b, b->off, k, data);
+		nom_buffer_advance(b, k * 2);
+		data += k;
+		data_length -= k;
 	}
 }
 
-/* nom_buffer_writeu16benext writes an array of u16s to the buffer in big endian at the current offset and moves the offset forward the amount of bytes written */
-void nom_buffer_writeu16benext(struct NomBuffer *b, int64_t data_length,
-			       uint16_t *data) {
-	nom_buffer_writeu16be(b, b->off, data_length, data);
-	nom_buffer_seekbyte(b, data_length * 2, 1);
+/* nom_buffer_appendf16be writes an array of floats to the buffer as ieee 754 halves in big endian at the current offset, growing the buffer if they don't fit, and moves the offset forward the amount of bytes written */
+NOM_API int nom_buffer_appendf16be(struct NomBuffer *b, int64_t data_length,
+				   float *data) {
+	if (nom_buffer_ensure(b, b->off + data_length * 2) != 0) {
+		return -1;
+	}
+	nom_buffer_writef16benext(b, data_length, data);
+	return 0;
 }
 
-/* nom_buffer_writeu32le writes an array of u32s to the buffer in little endian at the specified offset */
-void nom_buffer_writeu32le(struct NomBuffer *b, int64_t off,
-			   int64_t data_length, uint32_t *data) {
-	for (int i = 0; i < data_length; i++) {
-		b->buf[off + (i * 4)] = (uint8_t)(data[i]);
-		b->buf[off + (1 + (i * 4))] = (uint8_t)(data[i] >> 8);
-		b->buf[off + (2 + (i * 4))] = (uint8_t)(data[i] >> 16);
-		b->buf[off + (3 + (i * 4))] = (uint8_t)(data[i] >> 24);
+/* nom_buffer_readscaledi16le reads n i16s from the buffer in little endian at the specified offset as floats, multiplying them by scale */
+NOM_API void nom_buffer_readscaledi16le(struct NomBuffer *b, float *out,
+					int64_t off, int64_t n, float scale) {
+	NOM_STAT_ACCESS(NOM_TRACE_READ, b, off, n * 2, 2);
+	nom_scaled_decode(out, b->buf + off, n, 0, scale);
+}
+
+/* nom_buffer_readscaledi16lenext reads n i16s from the buffer in little endian at the current offset as floats, multiplying them by scale, and moves the offset forward the amount of bytes read */
+NOM_API void nom_buffer_readscaledi16lenext(struct NomBuffer *b, float *out,
+					    int64_t n, float scale) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, n, 2)) > 0) {
+		nom_buffer_readscaledi16le(b, out, b->off, k, scale);
+		nom_buffer_advance(b, k * 2);
+		out += k;
+		n -= k;
 	}
 }
 
-/* nom_buffer_writeu32lenext writes an array of u32s to the buffer in little endian at the current offset and moves the offset forward the amount of bytes written */
-void nom_bufferwriteu32lenext(struct NomBuffer *b, int64_t data_length,
-			      uint32_t *data) {
-	nom_buffer_writeu32le(b, b->off, data_length, data);
-	nom_buffer_seekbyte(b, data_length * 4, 1);
+/* nom_buffer_writescaledi16le writes an array of floats to the buffer as i16s in little endian at the specified offset, dividing them by scale and rounding them to nearest even, and saturating the ones out of range */
+NOM_API void nom_buffer_writescaledi16le(struct NomBuffer *b, int64_t off,
+					 int64_t data_length, float *data,
+					 float scale) {
+	if (NOM_COW(b) != 0) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, b, off, data_length * 2, 2);
+	nom_scaled_encode(b->buf + off, data, data_length, 0, scale);
 }
 
-/* nom_buffer_writeu32be writes an array of u32s to the buffer in big endian at the specified offset */
-void nom_buffer_writeu32be(struct NomBuffer *b, int64_t off,
-			   int64_t data_length, uint32_t *data) {
-	for (int i = 0; i < data_length; i++) {
-		b->buf[off + (i * 4)] = (uint8_t)(data[i] >> 24);
-		b->buf[off + (1 + (i * 4))] = (uint8_t)(data[i] >> 16);
-		b->buf[off + (2 + (i * 4))] = (uint8_t)(data[i] >> 8);
-		b->buf[off + (3 + (i * 4))] = (uint8_t)(data[i]);
+/* nom_buffer_writescaledi16lenext writes an array of floats to the buffer as i16s in little endian at the current offset, dividing them by scale, and moves the offset forward the amount of bytes written */
+NOM_API void nom_buffer_writescaledi16lenext(struct NomBuffer *b,
+					     int64_t data_length, float *data,
+					     float scale) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, data_length, 2)) > 0) {
+		nom_buffer_writescaledi16le(b, b->off, k, data, scale);
+		nom_buffer_advance(b, k * 2);
+		data += k;
+		data_length -= k;
 	}
 }
 
-/* nom_buffer_writeu32benext writes an array of u32s to the buffer in big endian at the current offset and moves the offset forward the amount of bytes written */
-void nom_buffer_writeu32benext(struct NomBuffer *b, int64_t data_length,
-			       uint32_t *data) {
-	nom_buffer_writeu32be(b, b->off, data_length, data);
-	nom_buffer_seekbyte(b, data_length * 4, 1);
+/* nom_buffer_appendscaledi16le writes an array of floats to the buffer as i16s in little endian at the current offset, dividing them by scale, growing the buffer if they don't fit, and moves the offset forward the amount of bytes written */
+NOM_API int nom_buffer_appendscaledi16le(struct NomBuffer *b,
+					 int64_t data_length, float *data,
+					 float scale) {
+	if (nom_buffer_ensure(b, b->off + data_length * 2) != 0) {
+		return -1;
+	}
+	nom_buffer_writescaledi16lenext(b, data_length, data, scale);
+	return 0;
 }
 
-/* nom_buffer_writeu64le writes an array of u64s to the buffer in little endian at the specified offset */
-void nom_buffer_writeu64le(struct NomBuffer *b, int64_t off,
-			   int64_t data_length, uint64_t *data) {
-	for (int i = 0; i < data_length; i++) {
-		b->buf[off + (i * 8)] = (uint8_t)(data[i]);
-		b->buf[off + (1 + (i * 8))] = (uint8_t)(data[i] >> 8);
-		b->buf[off + (2 + (i * 8))] = (uint8_t)(data[i] >> 16);
-		b->buf[off + (3 + (i * 8))] = (uint8_t)(data[i] >> 24);
-		b->buf[off + (4 + (i * 8))] = (uint8_t)(data[i] >> 32);
-		b->buf[off + (5 + (i * 8))] = (uint8_t)(data[i] >> 40);
-		b->buf[off + (6 + (i * 8))] = (uint8_t)(data[i] >> 48);
-		b->buf[off + (7 + (i * 8))] = (uint8_t)(data[i] >> 56);
+/* nom_buffer_readscaledi16be reads n i16s from the buffer in big endian at the specified offset as floats, multiplying them by scale */
+NOM_API void nom_buffer_readscaledi16be(struct NomBuffer *b, float *out,
+					int64_t off, int64_t n, float scale) {
+	NOM_STAT_ACCESS(NOM_TRACE_READ, b, off, n * 2, 2);
+	nom_scaled_decode(out, b->buf + off, n, 1, scale);
+}
+
+/* nom_buffer_readscaledi16benext reads n i16s from the buffer in big endian at the current offset as floats, multiplying them by scale, and moves the offset forward the amount of bytes read */
+NOM_API void nom_buffer_readscaledi16benext(struct NomBuffer *b, float *out,
+					    int64_t n, float scale) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, n, 2)) > 0) {
+		nom_buffer_readscaledi16be(b, out, b->off, k, scale);
+		nom_buffer_advance(b, k * 2);
+		out += k;
+		n -= k;
 	}
 }
 
-/* nom_buffer_writeu64lenext writes an array of u64s to the buffer in little endian at the current offset and moves the offset forward the amount of bytes written */
-void nom_buffer_writeu64lenext(struct NomBuffer *b, int64_t data_length,
-			       uint64_t *data) {
-	nom_buffer_writeu64le(b, b->off, data_length, data);
-	nom_buffer_seekbyte(b, data_length * 8, 1);
+/* nom_buffer_writescaledi16be writes an array of floats to the buffer as i16s in big endian at the specified offset, dividing them by scale and rounding them to nearest even, and saturating the ones out of range */
+NOM_API void nom_buffer_writescaledi16be(struct NomBuffer *b, int64_t off,
+					 int64_t data_length, float *data,
+					 float scale) {
+	if (NOM_COW(b) != 0) {
+		return;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, b, off, data_length * 2, 2);
+	nom_scaled_encode(b->buf + off, data, data_length, 1, scale);
 }
 
-/* nom_buffer_writeu64be writes an array of u64s to the buffer in big endian at the specified offset */
-void nom_buffer_writeu64be(struct NomBuffer *b, int64_t off,
-			   int64_t data_length, uint64_t *data) {
-	for (int i = 0; i < data_length; i++) {
-		b->buf[off + (i * 8)] = (uint8_t)(data[i] >> 56);
-		b->buf[off + (1 + (i * 8))] = (uint8_t)(data[i] >> 48);
-		b->buf[off + (2 + (i * 8))] = (uint8_t)(data[i] >> 40);
-		b->buf[off + (3 + (i * 8))] = (uint8_t)(data[i] >> 32);
-		b->buf[off + (4 + (i * 8))] = (uint8_t)(data[i] >> 24);
-		b->buf[off + (5 + (i * 8))] = (uint8_t)(data[i] >> 16);
-		b->buf[off + (6 + (i * 8))] = (uint8_t)(data[i] >> 8);
-		b->buf[off + (7 + (i * 8))] = (uint8_t)(data[i]);
+/* nom_buffer_writescaledi16benext writes an array of floats to the buffer as i16s in big endian at the current offset, dividing them by scale, and moves the offset forward the amount of bytes written */
+NOM_API void nom_buffer_writescaledi16benext(struct NomBuffer *b,
+					     int64_t data_length, float *data,
+					     float scale) {
+	int64_t k;
+
+	while ((k = nom_buffer_window(b, data_length, 2)) > 0) {
+		nom_buffer_writescaledi16be(b, b->off, k, data, scale);
+		nom_buffer_advance(b, k * 2);
+		data += k;
+		data_length -= k;
 	}
 }
 
-/* nom_buffer_writeu64benext writes an array of u64s to the buffer in big endian at the current offset and moves the offset forward the amount of bytes written */
-void nom_buffer_writeu64benext(struct NomBuffer *b, int64_t data_length,
-			       uint64_t *data) {
-	nom_buffer_writeu64be(b, b->off, data_length, data);
-	nom_buffer_seekbyte(b, data_length * 8, 1);
+/* nom_buffer_appendscaledi16be writes an array of floats to the buffer as i16s in big endian at the current offset, dividing them by scale, growing the buffer if they don't fit, and moves the offset forward the amount of bytes written */
+NOM_API int nom_buffer_appendscaledi16be(struct NomBuffer *b,
+					 int64_t data_length, float *data,
+					 float scale) {
+	if (nom_buffer_ensure(b, b->off + data_length * 2) != 0) {
+		return -1;
+	}
+	nom_buffer_writescaledi16benext(b, data_length, data, scale);
+	return 0;
 }
 
-/* nom_buffer_readbytes reads n bytes from the buffer at the specified offset */
-void nom_buffer_readbytes(struct NomBuffer *b, uint8_t *out, int64_t off,
-			  int64_t n) {
-	memcpy(out, b->buf + off, n * sizeof(uint8_t));
+/* the integer types the varint functions convert to and from */
+#define NOM_VARINT_U32 0
+#define NOM_VARINT_U64 1
+#define NOM_VARINT_I32 2
+#define NOM_VARINT_I64 3
+
+/* nom_varint_size returns the amount of bytes v takes up as a varint */
+NOM_API int64_t nom_varint_size(uint64_t v) {
+	return (64 - nom_clz64(v | 1) + 6) / 7;
 }
 
-/* nom_buffer_readbytesnext reads n bytes from the buffer at the current offset and moves the offset forward the amount of bytes read */
-void nom_buffer_readbytesnext(struct NomBuffer *b, uint8_t *out, int64_t n) {
-	nom_buffer_readbytes(b, out, b->off, n);
-	nom_buffer_seekbyte(b, n, 1);
+/* nom_varint_decode decodes up to n leb128 varints from [p, end) into out, stopping early at a truncated or overlong one, and returns how many it decoded along with the amount of bytes they took up in used */
+NOM_API int64_t nom_varint_decode(const uint8_t *p, const uint8_t *end,
+				  uint64_t *out, int64_t n, int64_t *used) {
+	const uint8_t *start = p;
+	uint64_t w, stop, x;
+	int64_t i = 0, len;
+	int shift;
+
+	while (i < n) {
+#if defined(NOM_X86) && defined(__SSE2__)
+		/* 16 bytes without continuation bits are 16 single byte varints, which only need widening */
+		if (end - p >= 16 && n - i >= 16 &&
+		    _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(p))) ==
+			    0) {
+			for (len = 0; len < 16; len++) {
+				x = p[len];
+				memcpy(out + i + len, &x, 8);
+			}
+			i += 16;
+			p += 16;
+			continue;
+		}
+#endif
+
+		/* varints of up to 8 bytes are decoded from a single load by squeezing the 7 bit groups together */
+		if (end - p >= 8) {
+			w = nom_load64le(p);
+			stop = ~w & UINT64_C(0x8080808080808080);
+			if (stop != 0) {
+				len = nom_ctz64(stop) / 8 + 1;
+				x = w & UINT64_C(0x7f7f7f7f7f7f7f7f);
+				if (len < 8) {
+					x &= (UINT64_C(1) << (len * 8)) - 1;
+				}
+				x = (x & UINT64_C(0x007f007f007f007f)) |
+				    ((x & UINT64_C(0x7f007f007f007f00)) >> 1);
+				x = (x & UINT64_C(0x00003fff00003fff)) |
+				    ((x & UINT64_C(0x3fff00003fff0000)) >> 2);
+				x = (x & UINT64_C(0x000000000fffffff)) |
+				    ((x & UINT64_C(0x0fffffff00000000)) >> 4);
+				memcpy(out + i++, &x, 8);
+				p += len;
+				continue;
+			}
+		}
+
+		/* everything else, including the ends of buffers, goes a byte at a time */
+		x = 0;
+		for (shift = 0, len = 0;; shift += 7, len++) {
+			if (p + len >= end || len == 10 ||
+			    (len == 9 && p[len] > 1)) {
+				*used = p - start;
+				return i;
+			}
+			x |= (uint64_t)(p[len] & 0x7f) << shift;
+			if (!(p[len] & 0x80)) {
+				break;
+			}
+		}
+		memcpy(out + i++, &x, 8);
+		p += len + 1;
+	}
+	*used = p - start;
+	return i;
 }
 
-/* nom_buffer_readu16le reads n u16s from the buffer in little endian at the specified offset */
-void nom_buffer_readu16le(struct NomBuffer *b, uint16_t *out, int64_t off,
-			  int64_t n) {
-	for (int i = 0; i < n; i++) {
-		out[i] = (uint16_t)(b->buf[off + (i * 2)]) |
-			 (uint16_t)(b->buf[off + (1 + (i * 2))]) << 8;
+/* nom_varint_encode encodes n values as leb128 varints into p and returns the amount of bytes written */
+NOM_API int64_t nom_varint_encode(uint8_t *p, const uint64_t *v, int64_t n) {
+	uint8_t *start = p;
+	uint64_t x;
+	int64_t i;
+
+	for (i = 0; i < n; i++) {
+		memcpy(&x, v + i, 8);
+		while (x >= 0x80) {
+			*p++ = (uint8_t)(x | 0x80);
+			x >>= 7;
+		}
+		*p++ = (uint8_t)(x);
 	}
+	return p - start;
 }
 
-/* nom_buffer_readu16lenext reads n u16s from the buffer in little endian at the current offset and moves the offset forward the amount of bytes read */
-void nom_buffer_readu16lenext(struct NomBuffer *b, uint16_t *out, int64_t n) {
-	nom_buffer_readu16le(b, out, b->off, n);
-	nom_buffer_seekbyte(b, n * 2, 1);
+/* nom_varint_widen converts n integers of the given varint type to the u64s that get encoded, zigzag encoding signed ones */
+NOM_API void nom_varint_widen(uint64_t *out, const void *data, int64_t n,
+			      int type) {
+	const uint8_t *d = (const uint8_t *)(data);
+	uint32_t u;
+	uint64_t v;
+	int64_t i;
+
+	/* data comes from the caller and doesn't have to be aligned */
+	for (i = 0; i < n; i++) {
+		switch (type) {
+		case NOM_VARINT_U32:
+			memcpy(&u, d + i * 4, 4);
+			out[i] = u;
+			break;
+		case NOM_VARINT_U64:
+			memcpy(&out[i], d + i * 8, 8);
+			break;
+		case NOM_VARINT_I32:
+			memcpy(&u, d + i * 4, 4);
+			out[i] = (uint32_t)((u << 1) ^ (0u - (u >> 31)));
+			break;
+		default:
+			memcpy(&v, d + i * 8, 8);
+			out[i] = (v << 1) ^ (0 - (v >> 63));
+		}
+	}
 }
 
-/* nom_buffer_readu16be reads n u16s from the buffer in big endian at the specified offset */
-void nom_buffer_readu16be(struct NomBuffer *b, uint16_t *out, int64_t off,
-			  int64_t n) {
-	for (int i = 0; i < n; i++) {
-		out[i] = (uint16_t)(b->buf[off + (1 + (i * 2))]) |
-			 (uint16_t)(b->buf[off + (i * 2)]) << 8;
+/* nom_varint_narrow converts n decoded u64s to the given varint type, zigzag decoding signed ones */
+NOM_API void nom_varint_narrow(void *out, const uint64_t *v, int64_t n,
+			       int type) {
+	uint8_t *o = (uint8_t *)(out);
+	uint32_t u;
+	uint64_t w;
+	int64_t i;
+
+	/* out comes from the caller and doesn't have to be aligned */
+	for (i = 0; i < n; i++) {
+		switch (type) {
+		case NOM_VARINT_U32:
+			u = (uint32_t)(v[i]);
+			memcpy(o + i * 4, &u, 4);
+			break;
+		case NOM_VARINT_U64:
+			memcpy(o + i * 8, &v[i], 8);
+			break;
+		case NOM_VARINT_I32:
+			u = (uint32_t)(v[i]);
+			u = (u >> 1) ^ (0u - (u & 1));
+			memcpy(o + i * 4, &u, 4);
+			break;
+		default:
+			w = (v[i] >> 1) ^ (0 - (v[i] & 1));
+			memcpy(o + i * 8, &w, 8);
+		}
 	}
 }
 
-/* nom_buffer_readu16benext reads n u16s from the buffer in big endian at the current offset and moves the offset forward the amount of bytes read */
-void nom_buffer_readu16benext(struct NomBuffer *b, uint16_t *out, int64_t n) {
-	nom_buffer_readu16be(b, out, b->off, n);
-	nom_buffer_seekbyte(b, n * 2, 1);
+/* nom_varint_read reads up to n varints of the given type from [p, end), stopping early at one that is truncated, overlong or too big for the type, and returns how many were read along with the amount of bytes they took up in used */
+NOM_API int64_t nom_varint_read(const uint8_t *p, const uint8_t *end, void *out,
+				int64_t n, int type, int64_t *used) {
+	uint64_t tmp[64];
+	int64_t total = 0, done = 0, k, m, chunk, i;
+	int size = (type == NOM_VARINT_U32 || type == NOM_VARINT_I32) ? 4 : 8;
+
+	if (type == NOM_VARINT_U64) {
+		return nom_varint_decode(p, end, (uint64_t *)(out), n, used);
+	}
+	while (done < n) {
+		chunk = n - done < 64 ? n - done : 64;
+		k = nom_varint_decode(p + total, end, tmp, chunk, &m);
+
+		/* a 32 bit value can't take more than 32 bits, so one that does is treated like a corrupt varint and the ones before it are decoded again to find where it starts */
+		if (size == 4) {
+			for (i = 0; i < k && tmp[i] <= UINT32_MAX; i++) {
+			}
+			if (i < k) {
+				k = nom_varint_decode(p + total, end, tmp, i,
+						      &m);
+			}
+		}
+		nom_varint_narrow((uint8_t *)(out) + done * size, tmp, k, type);
+		done += k;
+		total += m;
+		if (k < chunk) {
+			break;
+		}
+	}
+	*used = total;
+	return done;
 }
 
-/* nom_buffer_readu32le reads n u32s from the buffer in little endian at the specified offset */
-void nom_buffer_readu32le(struct NomBuffer *b, uint32_t *out, int64_t off,
-			  int64_t n) {
-	for (int i = 0; i < n; i++) {
-		out[i] = (uint32_t)(b->buf[off + (i * 4)]) |
-			 (uint32_t)(b->buf[off + (1 + (i * 4))]) << 8 |
-			 (uint32_t)(b->buf[off + (2 + (i * 4))]) << 16 |
-			 (uint32_t)(b->buf[off + (3 + (i * 4))]) << 24;
+/* nom_varint_readnext reads n varints of the given type at the current offset, refilling stream windows as needed, and moves the offset forward past the ones read */
+NOM_API int nom_varint_readnext(struct NomBuffer *b, void *out, int64_t n,
+				int type) {
+	int size = (type == NOM_VARINT_U32 || type == NOM_VARINT_I32) ? 4 : 8;
+	int64_t k, used, avail;
+
+	for (;;) {
+		k = nom_varint_read(b->buf + b->off, b->buf + b->cap, out, n,
+				    type, &used);
+		NOM_STAT_ACCESS(NOM_TRACE_READ, b, b->off, used, 1);
+		nom_buffer_advance(b, used);
+		out = (uint8_t *)(out) + k * size;
+		n -= k;
+		if (n == 0) {
+			return 0;
+		}
+
+		/* a varint was cut off by the end of a stream's window, so get more of it */
+		avail = b->cap - b->off;
+		if (b->stream == NULL || avail >= 10 ||
+		    nom_buffer_refill(b, avail + 1) != 0) {
+			return -1;
+		}
 	}
 }
 
-/* nom_buffer_readu32lenext reads n u32s from the buffer in little endian at the current offset and moves the offset forward the amount of bytes read */
-void nom_buffer_readu32lenext(struct NomBuffer *b, uint32_t *out, int64_t n) {
-	nom_buffer_readu32le(b, out, b->off, n);
-	nom_buffer_seekbyte(b, n * 4, 1);
+/* nom_varint_write writes n integers of the given type as varints to p, returning the amount of bytes written */
+NOM_API int64_t nom_varint_write(uint8_t *p, const void *data, int64_t n,
+				 int type) {
+	uint64_t tmp[64];
+	int64_t total = 0, done = 0, chunk;
+	int size = (type == NOM_VARINT_U32 || type == NOM_VARINT_I32) ? 4 : 8;
+
+	if (type == NOM_VARINT_U64) {
+		return nom_varint_encode(p, (const uint64_t *)(data), n);
+	}
+	while (done < n) {
+		chunk = n - done < 64 ? n - done : 64;
+		nom_varint_widen(tmp, (const uint8_t *)(data) + done * size,
+				 chunk, type);
+		total += nom_varint_encode(p + total, tmp, chunk);
+		done += chunk;
+	}
+	return total;
 }
 
-/* nom_buffer_readu32be reads n u32s from the buffer in big endian at the specified offset */
-void nom_buffer_readu32be(struct NomBuffer *b, uint32_t *out, int64_t off,
-			  int64_t n) {
-	for (int i = 0; i < n; i++) {
-		out[i] = (uint32_t)(b->buf[off + (3 + (i * 4))]) |
-			 (uint32_t)(b->buf[off + (2 + (i * 4))]) << 8 |
-			 (uint32_t)(b->buf[off + (1 + (i * 4))]) << 16 |
-			 (uint32_t)(b->buf[off + (i * 4)]) << 24;
+/* nom_varint_writenext writes n integers of the given type as varints at the current offset, flushing stream windows as needed, and moves the offset forward the amount of bytes written */
+NOM_API void nom_varint_writenext(struct NomBuffer *b, const void *data,
+				  int64_t n, int type) {
+	int size = (type == NOM_VARINT_U32 || type == NOM_VARINT_I32) ? 4 : 8;
+	int64_t k, used;
+
+	if (NOM_COW(b) != 0) {
+		return;
+	}
+
+	/* a varint is at most 10 bytes, so a stream's window always has room for this many */
+	while ((k = nom_buffer_window(b, n, 10)) > 0) {
+		used = nom_varint_write(b->buf + b->off, data, k, type);
+		NOM_STAT_ACCESS(NOM_TRACE_WRITE, b, b->off, used, 1);
+		nom_buffer_advance(b, used);
+		data = (const uint8_t *)(data) + k * size;
+		n -= k;
 	}
 }
 
-/* nom_buffer_readu32benext reads n u32s from the buffer in big endian at the current offset and moves the offset forward the amount of bytes read */
-void nom_buffer_readu32benext(struct NomBuffer *b, uint32_t *out, int64_t n) {
-	nom_buffer_readu32le(b, out, b->off, n);
-	nom_buffer_seekbyte(b, n * 4, 1);
+/* nom_varint_append writes n integers of the given type as varints at the current offset, growing the buffer if they don't fit, and moves the offset forward the amount of bytes written */
+NOM_API int nom_varint_append(struct NomBuffer *b, const void *data, int64_t n,
+			      int type) {
+	uint64_t tmp[64];
+	int64_t done = 0, chunk, size = 0, i;
+	int esize = (type == NOM_VARINT_U32 || type == NOM_VARINT_I32) ? 4 : 8;
+
+	if (b->stream != NULL) {
+		nom_varint_writenext(b, data, n, type);
+		return 0;
+	}
+	while (done < n) {
+		chunk = n - done < 64 ? n - done : 64;
+		nom_varint_widen(tmp, (const uint8_t *)(data) + done * esize,
+				 chunk, type);
+		for (i = 0; i < chunk; i++) {
+			size += nom_varint_size(tmp[i]);
+		}
+		done += chunk;
+	}
+	if (nom_buffer_ensure(b, b->off + size) != 0) {
+		return -1;
+	}
+	if (NOM_COW(b) != 0) {
+		return -1;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, b, b->off, size, 1);
+	nom_buffer_advance(b, nom_varint_write(b->buf + b->off, data, n, type));
+	return 0;
 }
 
-/* nom_buffer_readu64le reads n u64s from the buffer in little endian at the specified offset */
-void nom_buffer_readu64le(struct NomBuffer *b, uint64_t *out, int64_t off,
-			  int64_t n) {
-	for (int i = 0; i < n; i++) {
-		out[i] = (uint64_t)(b->buf[off + (i * 8)]) |
-			 (uint64_t)(b->buf[off + (1 + (i * 8))]) << 8 |
-			 (uint64_t)(b->buf[off + (2 + (i * 8))]) << 16 |
-			 (uint64_t)(b->buf[off + (3 + (i * 8))]) << 24 |
-			 (uint64_t)(b->buf[off + (4 + (i * 8))]) << 32 |
-			 (uint64_t)(b->buf[off + (5 + (i * 8))]) << 40 |
-			 (uint64_t)(b->buf[off + (6 + (i * 8))]) << 48 |
-			 (uint64_t)(b->buf[off + (7 + (i * 8))]) << 56;
+/* nom_buffer_readvaru32 reads n u32s from the buffer as leb128 varints at the specified offset, returning the amount of bytes read or -1 if one of them is truncated, overlong or doesn't fit in a u32 */
+NOM_API int64_t nom_buffer_readvaru32(struct NomBuffer *b, uint32_t *out,
+				      int64_t off, int64_t n) {
+	int64_t used, k;
+
+	k = nom_varint_read(b->buf + off, b->buf + b->cap, out, n,
+			    NOM_VARINT_U32, &used);
+
+	NOM_STAT_ACCESS(NOM_TRACE_READ, b, off, used, 1);
+	return k < n ? -1 : used;
+}
+
+/* nom_buffer_readvaru32next reads n u32s from the buffer as leb128 varints at the current offset and moves the offset forward the amount of bytes read, returning -1 if one of them is truncated, overlong or doesn't fit in a u32 */
+NOM_API int nom_buffer_readvaru32next(struct NomBuffer *b, uint32_t *out,
+				      int64_t n) {
+	return nom_varint_readnext(b, out, n, NOM_VARINT_U32);
+}
+
+/* nom_buffer_writevaru32 writes an array of u32s to the buffer as leb128 varints at the specified offset, returning the amount of bytes written or -1 if the buffer shares storage that can't be copied */
+NOM_API int64_t nom_buffer_writevaru32(struct NomBuffer *b, int64_t off,
+				       int64_t data_length, uint32_t *data) {
+	int64_t used;
+
+	if (NOM_COW(b) != 0) {
+		return -1;
 	}
+	used = nom_varint_write(b->buf + off, data, data_length,
+				NOM_VARINT_U32);
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, b, off, used, 1);
+	return used;
 }
 
-/* nom_buffer_readu64lenext reads n u64s from the buffer in little endian at the current offset and moves the offset forward the amount of bytes read */
-void nom_buffer_readu64lenext(struct NomBuffer *b, uint64_t *out, int64_t n) {
-	nom_buffer_readu64le(b, out, b->off, n);
-	nom_buffer_seekbyte(b, n * 8, 1);
+/* nom_buffer_writevaru32next writes an array of u32s to the buffer as leb128 varints at the current offset and moves the offset forward the amount of bytes written */
+NOM_API void nom_buffer_writevaru32next(struct NomBuffer *b,
+					int64_t data_length, uint32_t *data) {
+	nom_varint_writenext(b, data, data_length, NOM_VARINT_U32);
 }
 
-/* nom_buffer_readu64be reads n u64s from the buffer in big endian at the specified offset */
-void nom_buffer_readu64be(struct NomBuffer *b, uint64_t *out, int64_t off,
-			  int64_t n) {
-	for (int i = 0; i < n; i++) {
-		out[i] = (uint64_t)(b->buf[off + (7 + (i * 8))]) |
-			 (uint64_t)(b->buf[off + (6 + (i * 8))]) << 8 |
-			 (uint64_t)(b->buf[off + (5 + (i * 8))]) << 16 |
-			 (uint64_t)(b->buf[off + (4 + (i * 8))]) << 24 |
-			 (uint64_t)(b->buf[off + (3 + (i * 8))]) << 32 |
-			 (uint64_t)(b->buf[off + (2 + (i * 8))]) << 40 |
-			 (uint64_t)(b->buf[off + (1 + (i * 8))]) << 48 |
-			 (uint64_t)(b->buf[off + (i * 8)]) << 54;
+/* nom_buffer_appendvaru32 writes an array of u32s to the buffer as leb128 varints at the current offset, growing the buffer if they don't fit, and moves the offset forward the amount of bytes written */
+NOM_API int nom_buffer_appendvaru32(struct NomBuffer *b, int64_t data_length,
+				    uint32_t *data) {
+	return nom_varint_append(b, data, data_length, NOM_VARINT_U32);
+}
+
+/* nom_buffer_readvaru64 reads n u64s from the buffer as leb128 varints at the specified offset, returning the amount of bytes read or -1 if one of them is truncated or overlong */
+NOM_API int64_t nom_buffer_readvaru64(struct NomBuffer *b, uint64_t *out,
+				      int64_t off, int64_t n) {
+	int64_t used, k;
+
+	k = nom_varint_read(b->buf + off, b->buf + b->cap, out, n,
+			    NOM_VARINT_U64, &used);
+
+	NOM_STAT_ACCESS(NOM_TRACE_READ, b, off, used, 1);
+	return k < n ? -1 : used;
+}
+
+/* nom_buffer_readvaru64next reads n u64s from the buffer as leb128 varints at the current offset and moves the offset forward the amount of bytes read, returning -1 if one of them is truncated or overlong */
+NOM_API int nom_buffer_readvaru64next(struct NomBuffer *b, uint64_t *out,
+				      int64_t n) {
+	return nom_varint_readnext(b, out, n, NOM_VARINT_U64);
+}
+
+/* nom_buffer_writevaru64 writes an array of u64s to the buffer as leb128 varints at the specified offset, returning the amount of bytes written or -1 if the buffer shares storage that can't be copied */
+NOM_API int64_t nom_buffer_writevaru64(struct NomBuffer *b, int64_t off,
+				       int64_t data_length, uint64_t *data) {
+	int64_t used;
+
+	if (NOM_COW(b) != 0) {
+		return -1;
 	}
+	used = nom_varint_write(b->buf + off, data, data_length,
+				NOM_VARINT_U64);
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, b, off, used, 1);
+	return used;
 }
 
-/* nom_buffer_readu64benext reads n u64s from the buffer in big endian at the current offset and moves the offset forward the amount of bytes read */
-void nom_buffer_readu64benext(struct NomBuffer *b, uint64_t *out, int64_t n) {
-	nom_buffer_readu64be(b, out, b->off, n);
-	nom_buffer_seekbyte(b, n * 8, 1);
+/* nom_buffer_writevaru64next writes an array of u64s to the buffer as leb128 varints at the current offset and moves the offset forward the amount of bytes written */
+NOM_API void nom_buffer_writevaru64next(struct NomBuffer *b,
+					int64_t data_length, uint64_t *data) {
+	nom_varint_writenext(b, data, data_length, NOM_VARINT_U64);
 }
 
-/* nom_buffer_afterbyte stores the amount of bytes located after the current position or the specified one in out */
-void nom_buffer_afterbyte(struct NomBuffer *b, int64_t *out, int64_t off) {
-	if (off < 0) {
-		*out = b->cap - b->off - 1;
+/* nom_buffer_appendvaru64 writes an array of u64s to the buffer as leb128 varints at the current offset, growing the buffer if they don't fit, and moves the offset forward the amount of bytes written */
+NOM_API int nom_buffer_appendvaru64(struct NomBuffer *b, int64_t data_length,
+				    uint64_t *data) {
+	return nom_varint_append(b, data, data_length, NOM_VARINT_U64);
+}
 
-	} else if (off >= 0) {
-		*out = b->cap - off - 1;
+/* nom_buffer_readvari32 reads n zigzag encoded i32s from the buffer as leb128 varints at the specified offset, returning the amount of bytes read or -1 if one of them is truncated, overlong or doesn't fit in an i32 */
+NOM_API int64_t nom_buffer_readvari32(struct NomBuffer *b, int32_t *out,
+				      int64_t off, int64_t n) {
+	int64_t used, k;
+
+	k = nom_varint_read(b->buf + off, b->buf + b->cap, out, n,
+			    NOM_VARINT_I32, &used);
+
+	NOM_STAT_ACCESS(NOM_TRACE_READ, b, off, used, 1);
+	return k < n ? -1 : used;
+}
+
+/* nom_buffer_readvari32next reads n zigzag encoded i32s from the buffer as leb128 varints at the current offset and moves the offset forward the amount of bytes read, returning -1 if one of them is truncated, overlong or doesn't fit in an i32 */
+NOM_API int nom_buffer_readvari32next(struct NomBuffer *b, int32_t *out,
+				      int64_t n) {
+	return nom_varint_readnext(b, out, n, NOM_VARINT_I32);
+}
+
+/* nom_buffer_writevari32 writes an array of zigzag encoded i32s to the buffer as leb128 varints at the specified offset, returning the amount of bytes written or -1 if the buffer shares storage that can't be copied */
+NOM_API int64_t nom_buffer_writevari32(struct NomBuffer *b, int64_t off,
+				       int64_t data_length, int32_t *data) {
+	int64_t used;
+
+	if (NOM_COW(b) != 0) {
+		return -1;
 	}
+	used = nom_varint_write(b->buf + off, data, data_length,
+				NOM_VARINT_I32);
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, b, off, used, 1);
+	return used;
 }
 
-/* nom_buffer_alignbyte aligns the byte offset to the bit offset */
-void nom_buffer_alignbyte(struct NomBuffer *b) {
-	b->off = b->boff / 8;
+/* nom_buffer_writevari32next writes an array of zigzag encoded i32s to the buffer as leb128 varints at the current offset and moves the offset forward the amount of bytes written */
+NOM_API void nom_buffer_writevari32next(struct NomBuffer *b,
+					int64_t data_length, int32_t *data) {
+	nom_varint_writenext(b, data, data_length, NOM_VARINT_I32);
 }
 
-/* nom_buffer_grow makes the buffer's capacity bigger by n bytes */
-void nom_buffer_grow(struct NomBuffer *b, int64_t n) {
-	uint8_t *old = b->buf;
+/* nom_buffer_appendvari32 writes an array of zigzag encoded i32s to the buffer as leb128 varints at the current offset, growing the buffer if they don't fit, and moves the offset forward the amount of bytes written */
+NOM_API int nom_buffer_appendvari32(struct NomBuffer *b, int64_t data_length,
+				    int32_t *data) {
+	return nom_varint_append(b, data, data_length, NOM_VARINT_I32);
+}
 
-	b->buf = (uint8_t *)(malloc(sizeof(*old) + n));
-	memcpy(b->buf, old, sizeof(*old));
+/* nom_buffer_readvari64 reads n zigzag encoded i64s from the buffer as leb128 varints at the specified offset, returning the amount of bytes read or -1 if one of them is truncated or overlong */
+NOM_API int64_t nom_buffer_readvari64(struct NomBuffer *b, int64_t *out,
+				      int64_t off, int64_t n) {
+	int64_t used, k;
 
-	b->cap += n;
-	b->bcap = b->cap * 8;
+	k = nom_varint_read(b->buf + off, b->buf + b->cap, out, n,
+			    NOM_VARINT_I64, &used);
+
+	NOM_STAT_ACCESS(NOM_TRACE_READ, b, off, used, 1);
+	return k < n ? -1 : used;
+}
+
+/* nom_buffer_readvari64next reads n zigzag encoded i64s from the buffer as leb128 varints at the current offset and moves the offset forward the amount of bytes read, returning -1 if one of them is truncated or overlong */
+NOM_API int nom_buffer_readvari64next(struct NomBuffer *b, int64_t *out,
+				      int64_t n) {
+	return nom_varint_readnext(b, out, n, NOM_VARINT_I64);
+}
+
+/* nom_buffer_writevari64 writes an array of zigzag encoded i64s to the buffer as leb128 varints at the specified offset, returning the amount of bytes written or -1 if the buffer shares storage that can't be copied */
+NOM_API int64_t nom_buffer_writevari64(struct NomBuffer *b, int64_t off,
+				       int64_t data_length, int64_t *data) {
+	int64_t used;
+
+	if (NOM_COW(b) != 0) {
+		return -1;
+	}
+	used = nom_varint_write(b->buf + off, data, data_length,
+				NOM_VARINT_I64);
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, b, off, used, 1);
+	return used;
+}
+
+/* nom_buffer_writevari64next writes an array of zigzag encoded i64s to the buffer as leb128 varints at the current offset and moves the offset forward the amount of bytes written */
+NOM_API void nom_buffer_writevari64next(struct NomBuffer *b,
+					int64_t data_length, int64_t *data) {
+	nom_varint_writenext(b, data, data_length, NOM_VARINT_I64);
+}
 
-	free(old);
+/* nom_buffer_appendvari64 writes an array of zigzag encoded i64s to the buffer as leb128 varints at the current offset, growing the buffer if they don't fit, and moves the offset forward the amount of bytes written */
+NOM_API int nom_buffer_appendvari64(struct NomBuffer *b, int64_t data_length,
+				    int64_t *data) {
+	return nom_varint_append(b, data, data_length, NOM_VARINT_I64);
 }
 
 #endif
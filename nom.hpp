@@ -0,0 +1,333 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+#ifndef NOM_NOM_HPP
+#define NOM_NOM_HPP
+
+#include <bit>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include "nom.h"
+
+/* a c++20 front-end to nom whose reads and writes pick their width and byte order at compile time, so a single integer costs a load or store and at most a bswap instead of a call into nom_byteorder */
+
+namespace nom {
+
+/* the types a buffer can read and write, which are the integers and floats the c functions have variants for */
+template <class T>
+concept element = (std::is_integral_v<T> || std::is_floating_point_v<T>) &&
+		  !std::is_same_v<T, bool> &&
+		  (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 ||
+		   sizeof(T) == 8);
+
+/* the unsigned integer of the same width as T, which floats are swapped as */
+template <std::size_t N> struct bits_of;
+template <> struct bits_of<1> { using type = uint8_t; };
+template <> struct bits_of<2> { using type = uint16_t; };
+template <> struct bits_of<4> { using type = uint32_t; };
+template <> struct bits_of<8> { using type = uint64_t; };
+
+/* byteswap reverses the byte order of an unsigned integer */
+template <class U> constexpr U byteswap(U v) noexcept {
+	if constexpr (sizeof(U) == 1) {
+		return v;
+
+	} else if constexpr (sizeof(U) == 2) {
+		return nom_bswap16(v);
+
+	} else if constexpr (sizeof(U) == 4) {
+		return nom_bswap32(v);
+
+	} else {
+		return nom_bswap64(v);
+	}
+}
+
+/* load reads a T stored in byte order E at p */
+template <element T, std::endian E>
+inline T load(const uint8_t *p) noexcept {
+	static_assert(E == std::endian::little || E == std::endian::big);
+	using U = typename bits_of<sizeof(T)>::type;
+	U v;
+
+	std::memcpy(&v, p, sizeof(U));
+	if constexpr (E != std::endian::native) {
+		v = byteswap(v);
+	}
+	return std::bit_cast<T>(v);
+}
+
+/* store writes v at p in byte order E */
+template <element T, std::endian E>
+inline void store(uint8_t *p, T v) noexcept {
+	static_assert(E == std::endian::little || E == std::endian::big);
+	using U = typename bits_of<sizeof(T)>::type;
+	U u = std::bit_cast<U>(v);
+
+	if constexpr (E != std::endian::native) {
+		u = byteswap(u);
+	}
+	std::memcpy(p, &u, sizeof(U));
+}
+
+/* allocator_ref lets a buffer's storage come from a standard allocator, which has to outlive every buffer made with it */
+template <class A> class allocator_ref {
+	using bytes = typename std::allocator_traits<
+		A>::template rebind_alloc<uint8_t>;
+	using traits = std::allocator_traits<bytes>;
+
+	bytes a;
+	NomAllocator na;
+
+	static void *allocate(void *ctx, size_t n) {
+		try {
+			return traits::allocate(*static_cast<bytes *>(ctx), n);
+
+		} catch (...) {
+			return nullptr;
+		}
+	}
+
+	static void *reallocate(void *ctx, void *p, size_t old_size, size_t n) {
+		void *q = allocate(ctx, n);
+
+		if (q != nullptr && p != nullptr) {
+			std::memcpy(q, p, old_size < n ? old_size : n);
+			deallocate(ctx, p, old_size);
+		}
+		return q;
+	}
+
+	static void deallocate(void *ctx, void *p, size_t n) {
+		if (p != nullptr) {
+			traits::deallocate(*static_cast<bytes *>(ctx),
+					   static_cast<uint8_t *>(p), n);
+		}
+	}
+
+public:
+	explicit allocator_ref(const A &alloc = A())
+		: a(alloc), na{allocate, reallocate, deallocate, &a} {}
+
+	allocator_ref(const allocator_ref &) = delete;
+	allocator_ref &operator=(const allocator_ref &) = delete;
+
+	/* get returns the allocator to hand to nom */
+	const NomAllocator *get() const noexcept { return &na; }
+};
+
+/* buffer owns a NomBuffer, releasing its storage when it goes out of scope, and can be moved but not copied (use slice to share the bytes) */
+class buffer {
+	NomBuffer b;
+
+	/* empty leaves b owning nothing, which is what a moved-from buffer looks like */
+	void empty() noexcept { std::memset(&b, 0, sizeof(b)); }
+
+	/* big is what nom_byteorder is told about E, with bytes never swapped */
+	template <class T, std::endian E> static constexpr int big() noexcept {
+		return sizeof(T) == 1 ? NOM_BIG_ENDIAN : E == std::endian::big;
+	}
+
+	/* window is nom_buffer_window for a single element, which only has work to do on a stream and is kept out of line so the *next functions inline to a compare when there isn't one */
+	[[gnu::noinline]] int64_t window(int64_t size) noexcept {
+		return nom_buffer_window(&b, 1, size);
+	}
+
+	/* cow gives the buffer its own copy of storage it shares before a write, throwing std::bad_alloc if that fails */
+	void cow() {
+		if (b.shared != nullptr && nom_buffer_unshare(&b) != 0) {
+			throw std::bad_alloc();
+		}
+	}
+
+public:
+	/* creates a buffer of size bytes whose storage comes from a, or from malloc if a is null, throwing std::bad_alloc if that fails */
+	explicit buffer(int64_t size = 0, const NomAllocator *a = nullptr) {
+		nom_buffer_newwith(&b, size, a);
+		if (b.buf == nullptr && size > 0) {
+			throw std::bad_alloc();
+		}
+	}
+
+	/* takes ownership of a buffer made by the c functions, which must not be destroyed or released by anything else */
+	explicit buffer(const NomBuffer &from) noexcept : b(from) {}
+
+	buffer(buffer &&other) noexcept : b(other.b) { other.empty(); }
+
+	buffer &operator=(buffer &&other) noexcept {
+		if (this != &other) {
+			nom_buffer_release(&b);
+			b = other.b;
+			other.empty();
+		}
+		return *this;
+	}
+
+	buffer(const buffer &) = delete;
+	buffer &operator=(const buffer &) = delete;
+
+	~buffer() { nom_buffer_release(&b); }
+
+#ifdef NOM_POSIX
+	/* map creates a buffer backed by a mapping of the file fd refers to, see nom_buffer_mapfd, throwing std::system_error if that fails */
+	static buffer map(int fd, int flags = 0) {
+		NomBuffer m;
+
+		if (nom_buffer_mapfd(&m, fd, flags) != 0) {
+			throw std::system_error(errno, std::generic_category(),
+						"nom_buffer_mapfd");
+		}
+		return buffer(m);
+	}
+#endif
+
+	/* get returns the underlying buffer, for the c functions that have no counterpart here */
+	NomBuffer *get() noexcept { return &b; }
+	const NomBuffer *get() const noexcept { return &b; }
+
+	uint8_t *data() noexcept { return b.buf; }
+	const uint8_t *data() const noexcept { return b.buf; }
+	int64_t size() const noexcept { return b.cap; }
+	int64_t offset() const noexcept { return b.off; }
+
+	/* seek moves the offset to off */
+	void seek(int64_t off) noexcept { b.off = off; }
+
+	/* bytes returns the buffer's contents, which stay valid until it is written to through a shared slice, resized or refilled */
+	std::span<uint8_t> bytes() noexcept {
+		return {b.buf, static_cast<std::size_t>(b.cap)};
+	}
+	std::span<const uint8_t> bytes() const noexcept {
+		return {b.buf, static_cast<std::size_t>(b.cap)};
+	}
+
+	/* ensure makes the buffer at least n bytes long, throwing std::bad_alloc if that fails */
+	void ensure(int64_t n) {
+		if (nom_buffer_ensure(&b, n) != 0) {
+			throw std::bad_alloc();
+		}
+	}
+
+	/* slice returns a buffer over the n bytes at off that shares their storage until either side is written to, see nom_buffer_slice */
+	buffer slice(int64_t off, int64_t n) {
+		NomSlice s;
+
+		if (off < 0 || n < 0 || off > b.cap - n) {
+			throw std::out_of_range("nom::buffer::slice");
+		}
+		if (nom_buffer_slice(&s, &b, off, n) != 0) {
+			throw std::bad_alloc();
+		}
+		return buffer(s);
+	}
+
+	/* read returns the T stored in byte order E at off */
+	template <element T, std::endian E> T read(int64_t off) noexcept {
+		NOM_STAT_ACCESS(NOM_TRACE_READ, &b, off, sizeof(T), sizeof(T));
+		return load<T, E>(b.buf + off);
+	}
+
+	/* read fills out with the Ts stored in byte order E at off */
+	template <element T, std::endian E>
+	void read(int64_t off, std::span<T> out) noexcept {
+		int64_t n = static_cast<int64_t>(out.size());
+
+		NOM_STAT_ACCESS(NOM_TRACE_READ, &b, off, n * sizeof(T),
+				sizeof(T));
+		nom_byteorder(out.data(), b.buf + off, n, sizeof(T),
+			      big<T, E>());
+	}
+
+	/* write stores v at off in byte order E, throwing std::bad_alloc if the buffer shares storage that can't be copied */
+	template <element T, std::endian E> void write(int64_t off, T v) {
+		cow();
+		NOM_STAT_ACCESS(NOM_TRACE_WRITE, &b, off, sizeof(T), sizeof(T));
+		store<T, E>(b.buf + off, v);
+	}
+
+	/* write stores data at off in byte order E, throwing std::bad_alloc if the buffer shares storage that can't be copied */
+	template <element T, std::endian E>
+	void write(int64_t off, std::span<const T> data) {
+		int64_t n = static_cast<int64_t>(data.size());
+
+		cow();
+		NOM_STAT_ACCESS(NOM_TRACE_WRITE, &b, off, n * sizeof(T),
+				sizeof(T));
+		nom_byteorder(b.buf + off, data.data(), n, sizeof(T),
+			      big<T, E>());
+	}
+
+	/* read_next reads a T at the current offset and moves the offset past it, throwing std::out_of_range at the end of a stream */
+	template <element T, std::endian E> T read_next() {
+		T v;
+
+		if (b.stream != nullptr && window(sizeof(T)) < 1) {
+			throw std::out_of_range("nom::buffer::read_next");
+		}
+		v = read<T, E>(b.off);
+		nom_buffer_advance(&b, sizeof(T));
+		return v;
+	}
+
+	/* read_next fills out at the current offset and moves the offset past what was read, returning how many elements that was, which is fewer than asked for only at the end of a stream */
+	template <element T, std::endian E>
+	std::size_t read_next(std::span<T> out) noexcept {
+		std::size_t done = 0;
+		int64_t k;
+
+		while ((k = nom_buffer_window(
+				&b, static_cast<int64_t>(out.size() - done),
+				sizeof(T))) > 0) {
+			read<T, E>(b.off, out.subspan(done, k));
+			nom_buffer_advance(&b, k * sizeof(T));
+			done += k;
+		}
+		return done;
+	}
+
+	/* write_next writes v at the current offset and moves the offset past it, throwing std::out_of_range if a stream can't take it or std::bad_alloc if shared storage can't be copied */
+	template <element T, std::endian E> void write_next(T v) {
+		if (b.stream != nullptr && window(sizeof(T)) < 1) {
+			throw std::out_of_range("nom::buffer::write_next");
+		}
+		write<T, E>(b.off, v);
+		nom_buffer_advance(&b, sizeof(T));
+	}
+
+	/* write_next writes data at the current offset and moves the offset past what was written, returning how many elements that was, and throws std::bad_alloc if shared storage can't be copied */
+	template <element T, std::endian E>
+	std::size_t write_next(std::span<const T> data) {
+		std::size_t done = 0;
+		int64_t k;
+
+		while ((k = nom_buffer_window(
+				&b, static_cast<int64_t>(data.size() - done),
+				sizeof(T))) > 0) {
+			write<T, E>(b.off, data.subspan(done, k));
+			nom_buffer_advance(&b, k * sizeof(T));
+			done += k;
+		}
+		return done;
+	}
+};
+
+} // namespace nom
+
+#endif
@@ -0,0 +1,566 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+#ifndef NOM_NOM_AIO_H
+#define NOM_NOM_AIO_H
+
+/* glibc leaves syscall, pread, pwrite and ftruncate undeclared in strict c modes, and O_DIRECT undefined in every mode, unless _GNU_SOURCE is defined before the first system header */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE 1
+#endif
+
+#include <stdint.h>
+#include <string.h>
+
+#include "nom.h"
+
+#ifdef NOM_POSIX
+#include <sys/uio.h>
+
+#if defined(__GLIBC__) && !defined(__USE_GNU)
+#error "nom_aio.h needs _GNU_SOURCE defined before any system header"
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#ifdef __NR_io_uring_setup
+#define NOM_URING 1
+#endif
+#endif
+#endif
+
+/* flags for nom_aio_new */
+#define NOM_AIO_WRITE 0x01 /* the application fills the buffers and they are written to the file, instead of being read from it */
+#define NOM_AIO_DIRECT 0x02 /* bypass the page cache with O_DIRECT, which the buffers and transfers are aligned for */
+#define NOM_AIO_BLOCKING 0x04 /* transfer synchronously even where io_uring is available */
+
+/* what O_DIRECT buffers, offsets and lengths are aligned to, which covers the logical block size of any device */
+#define NOM_AIO_ALIGN 4096
+
+/* a completion callback, called on the thread that finds a transfer done with its buffer, the file offset it started at and the amount of bytes moved or -1 if it failed */
+typedef void (*NomAioFn)(void *ctx, struct NomBuffer *b, int64_t pos,
+			 int64_t result);
+
+/* one of the two buffers of a NomAio and the transfer it is part of */
+typedef struct NomAioSlot {
+	struct NomBuffer b;
+	struct iovec iov; /* what is left of the transfer, which io_uring reads once it is submitted */
+	int64_t pos; /* the file offset the transfer starts at */
+	int64_t len;
+	int64_t done; /* how much of it has been moved */
+	int64_t result; /* the amount of bytes moved once it is done, or -1 if it failed */
+	int busy; /* the transfer was started and isn't done */
+} NomAioSlot;
+
+/* moves a file through two buffers in turns, so the application works on one while the other is in flight */
+typedef struct NomAio {
+	int fd;
+	int flags;
+	int cur; /* the slot whose buffer the application has */
+	int eof; /* a read came up short */
+	int err; /* the errno of the first transfer that failed, or 0 */
+	int64_t block; /* the size of each buffer */
+	int64_t align; /* what transfers are aligned to, 1 unless O_DIRECT is used */
+	int64_t pos; /* the file offset the next transfer starts at */
+	int64_t end; /* where the file ended, once a read came up short */
+	NomAioFn done;
+	void *ctx;
+	struct NomAioSlot slots[2];
+	int ring; /* the io_uring's file descriptor, or -1 for the blocking fallback */
+#ifdef NOM_URING
+	uint8_t *sq; /* the submission queue ring, and the completion queue ring too where the kernel maps them together */
+	uint8_t *cq;
+	struct io_uring_sqe *sqes;
+	size_t sqsize;
+	size_t cqsize;
+	size_t sqessize;
+	unsigned *sqtail;
+	unsigned *sqmask;
+	unsigned *sqarray;
+	unsigned *cqhead;
+	unsigned *cqtail;
+	unsigned *cqmask;
+	struct io_uring_cqe *cqes;
+#endif
+} NomAio;
+
+/* nom_aio_allocate allocates n bytes aligned for O_DIRECT */
+NOM_API void *nom_aio_allocate(void *ctx, size_t n) {
+	void *p;
+
+	(void)ctx;
+	return posix_memalign(&p, NOM_AIO_ALIGN, n) == 0 ? p : NULL;
+}
+
+/* nom_aio_reallocate moves a block allocated by nom_aio_allocate into a bigger one, since realloc doesn't keep the alignment */
+NOM_API void *nom_aio_reallocate(void *ctx, void *p, size_t old_size,
+				 size_t n) {
+	void *q = nom_aio_allocate(ctx, n);
+
+	if (q != NULL) {
+		memcpy(q, p, old_size < n ? old_size : n);
+		free(p);
+	}
+	return q;
+}
+
+/* nom_aio_deallocate releases a block allocated by nom_aio_allocate */
+NOM_API void nom_aio_deallocate(void *ctx, void *p, size_t n) {
+	(void)ctx;
+	(void)n;
+	free(p);
+}
+
+/* where the buffers of a NomAio using O_DIRECT come from */
+NOM_DATA const struct NomAllocator nom_aio_allocator NOM_INIT(
+	{nom_aio_allocate, nom_aio_reallocate, nom_aio_deallocate, NULL});
+
+#ifdef NOM_URING
+/* nom_aio_ringclose tears down an io_uring set up by nom_aio_ringsetup, or whatever part of it was */
+NOM_API void nom_aio_ringclose(struct NomAio *a) {
+	if (a->sqes != NULL && a->sqes != MAP_FAILED) {
+		munmap(a->sqes, a->sqessize);
+	}
+	if (a->cq != NULL && a->cq != MAP_FAILED && a->cq != a->sq) {
+		munmap(a->cq, a->cqsize);
+	}
+	if (a->sq != NULL && a->sq != MAP_FAILED) {
+		munmap(a->sq, a->sqsize);
+	}
+	close(a->ring);
+	a->ring = -1;
+}
+
+/* nom_aio_ringsetup creates an io_uring with room for both slots' transfers, returning -1 if the kernel doesn't have io_uring or won't allow it */
+NOM_API int nom_aio_ringsetup(struct NomAio *a) {
+	struct io_uring_params p;
+
+	memset(&p, 0x00, sizeof(p));
+	a->sq = NULL;
+	a->cq = NULL;
+	a->sqes = NULL;
+	a->ring = (int)(syscall(__NR_io_uring_setup, 4, &p));
+	if (a->ring < 0) {
+		a->ring = -1;
+		return -1;
+	}
+	a->sqsize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	a->cqsize =
+		p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	a->sqessize = p.sq_entries * sizeof(struct io_uring_sqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		a->sqsize = a->cqsize =
+			a->sqsize > a->cqsize ? a->sqsize : a->cqsize;
+	}
+	a->sq = (uint8_t *)(mmap(NULL, a->sqsize, PROT_READ | PROT_WRITE,
+				 MAP_SHARED, a->ring, IORING_OFF_SQ_RING));
+	a->cq = (p.features & IORING_FEAT_SINGLE_MMAP)
+			? a->sq
+			: (uint8_t *)(mmap(NULL, a->cqsize,
+					   PROT_READ | PROT_WRITE, MAP_SHARED,
+					   a->ring, IORING_OFF_CQ_RING));
+	a->sqes = (struct io_uring_sqe *)(mmap(NULL, a->sqessize,
+					       PROT_READ | PROT_WRITE,
+					       MAP_SHARED, a->ring,
+					       IORING_OFF_SQES));
+	if (a->sq == MAP_FAILED || a->cq == MAP_FAILED ||
+	    a->sqes == MAP_FAILED) {
+		nom_aio_ringclose(a);
+		return -1;
+	}
+	a->sqtail = (unsigned *)(a->sq + p.sq_off.tail);
+	a->sqmask = (unsigned *)(a->sq + p.sq_off.ring_mask);
+	a->sqarray = (unsigned *)(a->sq + p.sq_off.array);
+	a->cqhead = (unsigned *)(a->cq + p.cq_off.head);
+	a->cqtail = (unsigned *)(a->cq + p.cq_off.tail);
+	a->cqmask = (unsigned *)(a->cq + p.cq_off.ring_mask);
+	a->cqes = (struct io_uring_cqe *)(a->cq + p.cq_off.cqes);
+	return 0;
+}
+#endif
+
+/* nom_aio_complete accounts for a slot's transfer having moved res bytes or failed with the errno -res, returning 1 if the rest of it still has to be moved, and calling the callback once it is done */
+NOM_API int nom_aio_complete(struct NomAio *a, int i, int64_t res) {
+	struct NomAioSlot *s = &a->slots[i];
+	int writing = a->flags & NOM_AIO_WRITE;
+
+	if (res == -EINTR || res == -EAGAIN) {
+		return 1;
+	}
+	if (res > 0) {
+		s->done += res;
+
+		/* short writes are continued, but a short read is the end of the file */
+		if (writing && s->done < s->len) {
+			return 1;
+		}
+	}
+	s->busy = 0;
+	s->result = s->done;
+	if (res < 0 || (res == 0 && writing)) {
+		s->result = -1;
+		if (a->err == 0) {
+			a->err = res < 0 ? (int)(-res) : EIO;
+		}
+
+	} else if (s->done < s->len) {
+		if (!a->eof || s->pos + s->done < a->end) {
+			a->end = s->pos + s->done;
+		}
+		a->eof = 1;
+	}
+	if (a->done != NULL) {
+		a->done(a->ctx, &s->b, s->pos, s->result);
+	}
+	return 0;
+}
+
+/* nom_aio_submit queues what is left of a slot's transfer on the io_uring */
+NOM_API void nom_aio_submit(struct NomAio *a, int i) {
+#ifdef NOM_URING
+	struct NomAioSlot *s = &a->slots[i];
+	struct io_uring_sqe *e;
+	unsigned tail = *a->sqtail, idx = tail & *a->sqmask;
+	long r;
+
+	s->iov.iov_base = s->b.buf + s->done;
+	s->iov.iov_len = (size_t)(s->len - s->done);
+	e = &a->sqes[idx];
+	memset(e, 0x00, sizeof(*e));
+	e->opcode = (a->flags & NOM_AIO_WRITE) ? IORING_OP_WRITEV
+					       : IORING_OP_READV;
+	e->fd = a->fd;
+	e->off = (uint64_t)(s->pos + s->done);
+	e->addr = (uint64_t)(uintptr_t)(&s->iov);
+	e->len = 1;
+	e->user_data = (uint64_t)(i);
+	a->sqarray[idx] = idx;
+	__atomic_store_n(a->sqtail, tail + 1, __ATOMIC_RELEASE);
+	do {
+		r = syscall(__NR_io_uring_enter, a->ring, 1, 0, 0, NULL, 0);
+	} while (r < 0 && (errno == EINTR || errno == EAGAIN));
+
+	/* an entry the kernel didn't take is taken back out of the ring, since the next io_uring_enter would otherwise submit it after the slot was given up on, and nom_aio_reap would wait for a transfer that was never started */
+	if (r != 1) {
+		__atomic_store_n(a->sqtail, tail, __ATOMIC_RELEASE);
+		nom_aio_complete(a, i, r < 0 ? -errno : -EIO);
+	}
+#else
+	(void)a;
+	(void)i;
+#endif
+}
+
+/* nom_aio_sync moves what is left of a slot's transfer with a blocking call, returning the amount of bytes moved or the negated errno */
+NOM_API int64_t nom_aio_sync(struct NomAio *a, int i) {
+	struct NomAioSlot *s = &a->slots[i];
+	ssize_t r;
+
+	if (a->flags & NOM_AIO_WRITE) {
+		r = pwrite(a->fd, s->b.buf + s->done,
+			   (size_t)(s->len - s->done),
+			   (off_t)(s->pos + s->done));
+
+	} else {
+		r = pread(a->fd, s->b.buf + s->done,
+			  (size_t)(s->len - s->done),
+			  (off_t)(s->pos + s->done));
+	}
+	return r < 0 ? -(int64_t)(errno) : (int64_t)(r);
+}
+
+/* nom_aio_start starts a slot's transfer of len bytes at pos, which without io_uring is done before it returns */
+NOM_API void nom_aio_start(struct NomAio *a, int i, int64_t pos, int64_t len) {
+	struct NomAioSlot *s = &a->slots[i];
+
+	s->pos = pos;
+	s->len = len;
+	s->done = 0;
+	s->result = 0;
+	s->busy = 1;
+	if (a->ring >= 0) {
+		nom_aio_submit(a, i);
+		return;
+	}
+	while (nom_aio_complete(a, i, nom_aio_sync(a, i))) {
+	}
+}
+
+/* nom_aio_reap handles the transfers that are done, waiting for at least one if wait is set */
+NOM_API void nom_aio_reap(struct NomAio *a, int wait) {
+#ifdef NOM_URING
+	struct io_uring_cqe *e;
+	unsigned head, tail;
+	int64_t res;
+	int i;
+
+	if (a->ring < 0) {
+		return;
+	}
+	if (wait &&
+	    syscall(__NR_io_uring_enter, a->ring, 0, 1, IORING_ENTER_GETEVENTS,
+		    NULL, 0) < 0 &&
+	    errno != EINTR && errno != EAGAIN) {
+		/* the transfers can't be waited for anymore, so they are given up on */
+		for (i = 0; i < 2; i++) {
+			if (a->slots[i].busy) {
+				nom_aio_complete(a, i, -errno);
+			}
+		}
+		return;
+	}
+	head = *a->cqhead;
+	tail = __atomic_load_n(a->cqtail, __ATOMIC_ACQUIRE);
+	for (; head != tail; head++) {
+		e = &a->cqes[head & *a->cqmask];
+		i = (int)(e->user_data);
+		res = e->res;
+		__atomic_store_n(a->cqhead, head + 1, __ATOMIC_RELEASE);
+		if (nom_aio_complete(a, i, res)) {
+			nom_aio_submit(a, i);
+		}
+	}
+#else
+	(void)a;
+	(void)wait;
+#endif
+}
+
+/* nom_aio_wait waits for a slot's transfer to be done, returning -1 if it failed */
+NOM_API int nom_aio_wait(struct NomAio *a, int i) {
+	while (a->slots[i].busy) {
+		nom_aio_reap(a, 1);
+	}
+	return a->slots[i].result < 0 ? -1 : 0;
+}
+
+/* nom_aio_fill starts reading the next block of the file into a slot, or leaves it empty past the end of the file */
+NOM_API void nom_aio_fill(struct NomAio *a, int i) {
+	if (a->eof) {
+		a->slots[i].pos = a->pos;
+		a->slots[i].done = 0;
+		return;
+	}
+
+	/* slices the application still holds of the buffer keep what it read last time */
+	if (NOM_COW(&a->slots[i].b) != 0) {
+		a->slots[i].pos = a->pos;
+		a->slots[i].done = 0;
+		nom_aio_complete(a, i, -ENOMEM);
+		return;
+	}
+	nom_aio_start(a, i, a->pos, a->block);
+	a->pos += a->block;
+}
+
+/* nom_aio_reset points a slot's buffer at its first size bytes */
+NOM_API void nom_aio_reset(struct NomAioSlot *s, int64_t size) {
+	s->b.off = 0x00;
+	s->b.cap = size;
+	s->b.boff = 0x00;
+	s->b.bcap = size * 8;
+}
+
+/* nom_aio_new starts moving the file fd refers to, from its current offset on, through two buffers of block_size bytes, reading the first block right away unless flags has NOM_AIO_WRITE, and returns -1 if that fails, or if the read does before it returns (which a blocking read always has), with errno in out->err */
+NOM_API int nom_aio_new(struct NomAio *out, int fd, int flags,
+			int64_t block_size) {
+	const struct NomAllocator *alloc = NULL;
+	int i;
+
+	out->fd = fd;
+	out->flags = flags;
+	out->eof = 0;
+	out->err = 0;
+	out->align = 1;
+	out->done = NULL;
+	out->ctx = NULL;
+	out->ring = -1;
+	out->pos = (int64_t)(lseek(fd, 0, SEEK_CUR));
+	if (out->pos < 0) {
+		return -1;
+	}
+	if (flags & NOM_AIO_DIRECT) {
+		out->align = NOM_AIO_ALIGN;
+		alloc = &nom_aio_allocator;
+		if (out->pos % NOM_AIO_ALIGN != 0) {
+			return -1;
+		}
+
+		/* without O_DIRECT the transfers are only aligned */
+#ifdef O_DIRECT
+		i = fcntl(fd, F_GETFL);
+		if (i < 0 || fcntl(fd, F_SETFL, i | O_DIRECT) != 0) {
+			return -1;
+		}
+#endif
+	}
+	out->block = (block_size + out->align - 1) / out->align * out->align;
+	for (i = 0; i < 2; i++) {
+		nom_buffer_newwith(&out->slots[i].b, out->block, alloc);
+		if (out->slots[i].b.buf == NULL) {
+			if (i == 1) {
+				nom_free(alloc, out->slots[0].b.buf,
+					 out->block);
+			}
+			return -1;
+		}
+		out->slots[i].pos = out->pos;
+		out->slots[i].len = 0;
+		out->slots[i].done = 0;
+		out->slots[i].result = 0;
+		out->slots[i].busy = 0;
+	}
+#ifdef NOM_URING
+	if (!(flags & NOM_AIO_BLOCKING)) {
+		nom_aio_ringsetup(out);
+	}
+#endif
+
+	/* a reader starts out with an empty buffer and the first block on its way into the other */
+	if (flags & NOM_AIO_WRITE) {
+		out->cur = 0;
+
+	} else {
+		out->cur = 1;
+		nom_aio_reset(&out->slots[1], 0);
+		nom_aio_fill(out, 0);
+		if (!out->slots[0].busy && out->slots[0].result < 0) {
+#ifdef NOM_URING
+			if (out->ring >= 0) {
+				nom_aio_ringclose(out);
+			}
+#endif
+			for (i = 0; i < 2; i++) {
+				nom_buffer_release(&out->slots[i].b);
+			}
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/* nom_aio_openfile opens the file at path for nom_aio_new, truncating or creating it when writing, returning -1 if that fails */
+NOM_API int nom_aio_openfile(struct NomAio *out, const char *path, int flags,
+			     int64_t block_size) {
+	int fd;
+
+	fd = open(path,
+		  (flags & NOM_AIO_WRITE) ? O_WRONLY | O_CREAT | O_TRUNC
+					  : O_RDONLY,
+		  0666);
+	if (fd < 0) {
+		return -1;
+	}
+	if (nom_aio_new(out, fd, flags, block_size) != 0) {
+		close(fd);
+		return -1;
+	}
+	return 0;
+}
+
+/* nom_aio_setcallback sets the callback called as each transfer is done, or removes it if fn is NULL */
+NOM_API void nom_aio_setcallback(struct NomAio *a, NomAioFn fn, void *ctx) {
+	a->done = fn;
+	a->ctx = ctx;
+}
+
+/* nom_aio_buffer returns the buffer the application has, which is empty for a reader until the first nom_aio_swap */
+NOM_API struct NomBuffer *nom_aio_buffer(struct NomAio *a) {
+	return &a->slots[a->cur].b;
+}
+
+/* nom_aio_poll handles the transfers that are done without waiting, returning 1 if nom_aio_swap won't have to wait */
+NOM_API int nom_aio_poll(struct NomAio *a) {
+	nom_aio_reap(a, 0);
+	return !a->slots[a->cur ^ 1].busy;
+}
+
+/* nom_aio_swap starts writing out everything before the offset of the application's buffer, or reading the next block into it, and returns the other buffer once its own transfer is done, empty or holding the block read into it, or NULL if a transfer failed */
+NOM_API struct NomBuffer *nom_aio_swap(struct NomAio *a) {
+	struct NomAioSlot *s = &a->slots[a->cur], *o = &a->slots[a->cur ^ 1];
+	int64_t n = s->b.off, k = n - n % a->align;
+
+	if (a->flags & NOM_AIO_WRITE) {
+		if (k > 0) {
+			nom_aio_start(a, a->cur, a->pos, k);
+			a->pos += k;
+		}
+		if (nom_aio_wait(a, a->cur ^ 1) != 0) {
+			return NULL;
+		}
+
+		/* O_DIRECT can only write whole blocks, so the rest goes to the front of the next buffer */
+		nom_aio_reset(o, a->block);
+		if (NOM_COW(&o->b) != 0) {
+			a->err = a->err != 0 ? a->err : ENOMEM;
+			return NULL;
+		}
+		memcpy(o->b.buf, s->b.buf + k, n - k);
+		o->b.off = n - k;
+
+	} else {
+		nom_aio_fill(a, a->cur);
+		if (nom_aio_wait(a, a->cur ^ 1) != 0) {
+			return NULL;
+		}
+		nom_aio_reset(o, o->done);
+	}
+	a->cur ^= 1;
+	return &o->b;
+}
+
+/* nom_aio_finish writes out everything before the offset of the application's buffer when writing, waits for every transfer, leaves the descriptor's offset where the application got to and releases the buffers, returning -1 if a transfer failed */
+NOM_API int nom_aio_finish(struct NomAio *a) {
+	struct NomAioSlot *s = &a->slots[a->cur];
+	int64_t n = s->b.off, k = (n + a->align - 1) / a->align * a->align;
+	int64_t end = s->pos + s->b.off;
+	int r = 0, i;
+
+	if (nom_aio_wait(a, 0) != 0 || nom_aio_wait(a, 1) != 0) {
+		r = -1;
+	}
+	if ((a->flags & NOM_AIO_WRITE) && r == 0 && n > 0) {
+		/* O_DIRECT can only write whole blocks, so the last one is padded and the file cut back afterwards */
+		if (nom_buffer_reserve(&s->b, k) != 0) {
+			r = -1;
+
+		} else {
+			memset(s->b.buf + n, 0x00, k - n);
+			nom_aio_start(a, a->cur, a->pos, k);
+			r = nom_aio_wait(a, a->cur);
+			if (r == 0 && k != n &&
+			    ftruncate(a->fd, (off_t)(a->pos + n)) != 0) {
+				r = -1;
+			}
+		}
+	}
+	if (a->flags & NOM_AIO_WRITE) {
+		end = a->pos + n;
+
+	} else if (a->eof && end > a->end) {
+		end = a->end;
+	}
+	lseek(a->fd, (off_t)(end), SEEK_SET);
+#ifdef NOM_URING
+	if (a->ring >= 0) {
+		nom_aio_ringclose(a);
+	}
+#endif
+	for (i = 0; i < 2; i++) {
+		nom_buffer_release(&a->slots[i].b);
+	}
+	return r != 0 || a->err != 0 ? -1 : 0;
+}
+#endif
+
+#endif
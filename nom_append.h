@@ -0,0 +1,188 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+#ifndef NOM_NOM_APPEND_H
+#define NOM_NOM_APPEND_H
+
+#include <stdint.h>
+
+#include "nom.h"
+
+#ifdef __cplusplus
+#include <atomic>
+#define NOM_ATOMIC(type) std::atomic<type>
+using std::atomic_compare_exchange_weak_explicit;
+using std::atomic_fetch_add_explicit;
+using std::atomic_load_explicit;
+using std::atomic_store_explicit;
+using std::memory_order_acquire;
+using std::memory_order_relaxed;
+using std::memory_order_seq_cst;
+#else
+#include <stdatomic.h>
+#define NOM_ATOMIC(type) _Atomic type
+#endif
+
+#ifdef NOM_POSIX
+#include <sched.h>
+#define NOM_YIELD() sched_yield()
+#else
+#define NOM_YIELD()
+#endif
+
+/* the amount of low bits of the reservation counter that hold the offset, which limits appenders to 256 tib */
+#define NOM_APPEND_OFFSET_BITS 48
+#define NOM_APPEND_OFFSET_MASK ((UINT64_C(1) << NOM_APPEND_OFFSET_BITS) - 1)
+
+/* the sequence numbers sharing the reservation counter with the offset, which wrap around */
+#define NOM_APPEND_SEQ_MASK ((UINT64_C(1) << (64 - NOM_APPEND_OFFSET_BITS)) - 1)
+
+/* how many regions can be reserved but not yet published at once, a power of two well below 1 << 16 */
+#define NOM_APPEND_SLOTS 256
+
+/* the size of a cache line, which the hot fields of an appender are spread apart by */
+#define NOM_CACHE_LINE 64
+
+/* where a committed region ends, tagged with its sequence number */
+typedef struct NomAppendSlot {
+	NOM_ATOMIC(uint64_t) tag; /* the sequence number of the region plus one, once it is committed */
+	NOM_ATOMIC(int64_t) end; /* the offset the region ends at, or -1 if it didn't fit */
+	char pad[NOM_CACHE_LINE - 16];
+} NomAppendSlot;
+
+/* lets many threads write into one buffer without a lock, publishing regions in the order they were reserved */
+typedef struct NomAppender {
+	struct NomBuffer *b;
+	char pad0[NOM_CACHE_LINE];
+	NOM_ATOMIC(uint64_t) reserved; /* the next region's sequence number and offset */
+	char pad1[NOM_CACHE_LINE];
+	NOM_ATOMIC(uint64_t) published; /* the first unpublished region's sequence number and offset */
+	char pad2[NOM_CACHE_LINE];
+	int64_t consumed; /* how far the reader got, only touched by it */
+	struct NomAppendSlot slots[NOM_APPEND_SLOTS];
+} NomAppender;
+
+/* a region of the buffer reserved by one writer */
+typedef struct NomRegion {
+	int64_t off; /* where the region starts in the buffer */
+	int64_t n;
+	uint64_t seq;
+} NomRegion;
+
+/* nom_appender_new starts concurrent appending to a buffer at its current offset, returning -1 if the buffer shares storage that can't be copied */
+NOM_API int nom_appender_new(struct NomAppender *out, struct NomBuffer *b) {
+	int i;
+
+	/* the storage can't be copied while threads are writing to it, so it is unshared up front */
+	if (NOM_COW(b) != 0) {
+		return -1;
+	}
+	out->b = b;
+	atomic_store_explicit(&out->reserved, (uint64_t)(b->off),
+			      memory_order_relaxed);
+	atomic_store_explicit(&out->published, (uint64_t)(b->off),
+			      memory_order_relaxed);
+	out->consumed = b->off;
+	for (i = 0; i < NOM_APPEND_SLOTS; i++) {
+		atomic_store_explicit(&out->slots[i].tag, (uint64_t)(0),
+				      memory_order_relaxed);
+		atomic_store_explicit(&out->slots[i].end, (int64_t)(0),
+				      memory_order_relaxed);
+	}
+	return 0;
+}
+
+/* nom_appender_reserve claims the next n bytes of the buffer for the calling thread, returning -1 if they don't fit, in which case the region still has to be committed */
+NOM_API int nom_appender_reserve(struct NomAppender *a, int64_t n,
+				 struct NomRegion *out) {
+	uint64_t v = atomic_fetch_add_explicit(
+		&a->reserved,
+		(UINT64_C(1) << NOM_APPEND_OFFSET_BITS) + (uint64_t)(n),
+		memory_order_relaxed);
+
+	out->off = (int64_t)(v & NOM_APPEND_OFFSET_MASK);
+	out->n = n;
+	out->seq = v >> NOM_APPEND_OFFSET_BITS;
+	return out->off + n > a->b->cap ? -1 : 0;
+}
+
+/* nom_appender_advance publishes every committed region directly after the published ones */
+NOM_API void nom_appender_advance(struct NomAppender *a) {
+	uint64_t p, seq, next;
+	struct NomAppendSlot *s;
+	int64_t end;
+
+	/* a committer stores its tag and then loads published, while the one publishing the region before it stores published and then loads that tag. unless all four are seq_cst each can miss the other's store, and the region is left committed but never published */
+	p = atomic_load_explicit(&a->published, memory_order_seq_cst);
+	for (;;) {
+		seq = p >> NOM_APPEND_OFFSET_BITS;
+		s = &a->slots[seq % NOM_APPEND_SLOTS];
+		if (atomic_load_explicit(&s->tag, memory_order_seq_cst) !=
+		    seq + 1) {
+			return;
+		}
+
+		/* a region that didn't fit moves the sequence on but not the offset, and so does every one after it */
+		end = atomic_load_explicit(&s->end, memory_order_relaxed);
+		next = ((seq + 1) << NOM_APPEND_OFFSET_BITS) |
+		       (end < 0 ? p & NOM_APPEND_OFFSET_MASK : (uint64_t)(end));
+		if (atomic_compare_exchange_weak_explicit(
+			    &a->published, &p, next, memory_order_seq_cst,
+			    memory_order_seq_cst)) {
+			p = next;
+		}
+	}
+}
+
+/* nom_appender_commit marks a reserved region as written, publishing it once every region reserved before it is committed too */
+NOM_API void nom_appender_commit(struct NomAppender *a,
+				 const struct NomRegion *r) {
+	struct NomAppendSlot *s = &a->slots[r->seq % NOM_APPEND_SLOTS];
+	uint64_t seq = r->seq;
+
+	/* the slot is free once the region that used it a lap ago is published, which only waits on a writer that stalled with a full ring of regions behind it */
+	while (((seq - (atomic_load_explicit(&a->published,
+					     memory_order_acquire) >>
+			NOM_APPEND_OFFSET_BITS)) &
+		NOM_APPEND_SEQ_MASK) >= NOM_APPEND_SLOTS) {
+		NOM_YIELD();
+	}
+	atomic_store_explicit(&s->end,
+			      r->off + r->n > a->b->cap ? -1 : r->off + r->n,
+			      memory_order_relaxed);
+	atomic_store_explicit(&s->tag, seq + 1, memory_order_seq_cst);
+	nom_appender_advance(a);
+}
+
+/* nom_appender_poll publishes any committed regions that are left over and hands the single reader the bytes published since its last poll as [*start, *end), returning 0 if there are none */
+NOM_API int nom_appender_poll(struct NomAppender *a, int64_t *start,
+			      int64_t *end) {
+	int64_t p;
+
+	nom_appender_advance(a);
+	p = (int64_t)(atomic_load_explicit(&a->published,
+					   memory_order_acquire) &
+		      NOM_APPEND_OFFSET_MASK);
+	*start = a->consumed;
+	*end = p;
+	a->consumed = p;
+	return p > *start;
+}
+
+/* nom_appender_finish publishes any committed regions that are left over and moves the buffer's offset past everything published, once all of the writers are done */
+NOM_API void nom_appender_finish(struct NomAppender *a) {
+	nom_appender_advance(a);
+	a->b->off = (int64_t)(atomic_load_explicit(&a->published,
+						   memory_order_acquire) &
+			      NOM_APPEND_OFFSET_MASK);
+}
+
+#endif
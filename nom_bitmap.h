@@ -0,0 +1,407 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+#ifndef NOM_NOM_BITMAP_H
+#define NOM_NOM_BITMAP_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "nom.h"
+
+/* bitmaps use the same bit order as the rest of nom, where bit off is the (off % 8)th most significant bit of byte off / 8, so loading a word in big endian puts its bits in order from the top */
+
+/* nom_popcount64_swar counts the set bits in v without a popcount instruction */
+NOM_API NOM_ALWAYS_INLINE int64_t nom_popcount64_swar(uint64_t v) {
+	v = v - ((v >> 1) & UINT64_C(0x5555555555555555));
+	v = (v & UINT64_C(0x3333333333333333)) +
+	    ((v >> 2) & UINT64_C(0x3333333333333333));
+	v = (v + (v >> 4)) & UINT64_C(0x0f0f0f0f0f0f0f0f);
+	return (int64_t)((v * UINT64_C(0x0101010101010101)) >> 56);
+}
+
+/* defines a kernel that counts the set bits in n bytes at p, 32 bytes at a time with independent sums so the counts overlap */
+#define NOM_POPCOUNT_KERNEL(name, count, attributes)                           \
+	attributes NOM_API int64_t name(const uint8_t *p, int64_t n) {         \
+		uint64_t w0, w1, w2, w3;                                       \
+		int64_t i = 0, c0 = 0, c1 = 0, c2 = 0, c3 = 0;                 \
+		for (; i + 32 <= n; i += 32) {                                 \
+			memcpy(&w0, p + i, 8);                                 \
+			memcpy(&w1, p + i + 8, 8);                             \
+			memcpy(&w2, p + i + 16, 8);                            \
+			memcpy(&w3, p + i + 24, 8);                            \
+			c0 += count(w0);                                       \
+			c1 += count(w1);                                       \
+			c2 += count(w2);                                       \
+			c3 += count(w3);                                       \
+		}                                                              \
+		for (; i + 8 <= n; i += 8) {                                   \
+			memcpy(&w0, p + i, 8);                                 \
+			c0 += count(w0);                                       \
+		}                                                              \
+		for (; i < n; i++) {                                           \
+			c0 += count((uint64_t)(p[i]));                         \
+		}                                                              \
+		return c0 + c1 + c2 + c3;                                      \
+	}
+
+NOM_POPCOUNT_KERNEL(nom_popcount_swar, nom_popcount64_swar, )
+
+#ifdef NOM_X86
+NOM_POPCOUNT_KERNEL(nom_popcount_hw, __builtin_popcountll,
+		    __attribute__((target("popcnt"))))
+#endif
+
+typedef int64_t (*NomPopcountKernel)(const uint8_t *p, int64_t n);
+
+/* nom_popcount_kernel returns the fastest popcount kernel nom is allowed to use */
+NOM_API NomPopcountKernel nom_popcount_kernel(void) {
+#ifdef NOM_X86
+	if (nom_cpu_features() & NOM_CPU_POPCNT) {
+		return nom_popcount_hw;
+	}
+#endif
+	return nom_popcount_swar;
+}
+
+/* nom_popcount counts the set bits in n bytes at p */
+NOM_API int64_t nom_popcount(const uint8_t *p, int64_t n) {
+	return nom_popcount_kernel()(p, n);
+}
+
+/* what nom_bitmap_range does to a range of bits */
+#define NOM_BITMAP_CLEAR 0
+#define NOM_BITMAP_SET 1
+#define NOM_BITMAP_FLIP 2
+
+/* nom_bitmap_apply does op to the bits of a byte selected by mask */
+NOM_API NOM_ALWAYS_INLINE void nom_bitmap_apply(uint8_t *p, uint8_t mask,
+						int op) {
+	if (op == NOM_BITMAP_CLEAR) {
+		*p &= (uint8_t)(~mask);
+
+	} else if (op == NOM_BITMAP_SET) {
+		*p |= mask;
+
+	} else {
+		*p ^= mask;
+	}
+}
+
+/* nom_bitmap_range does op to the n bits starting at bit offset off, touching the partial bytes at the ends one at a time and the whole ones in between in bulk */
+NOM_API void nom_bitmap_range(struct NomBuffer *b, int64_t off, int64_t n,
+			      int op) {
+	int64_t first = off / 8, last = (off + n - 1) / 8;
+	uint8_t head, tail;
+
+	if (n <= 0) {
+		return;
+	}
+	if (NOM_COW(b) != 0) {
+		return;
+	}
+	head = (uint8_t)(0xff >> (off % 8));
+	tail = (uint8_t)(0xff << (7 - (off + n - 1) % 8));
+	if (first == last) {
+		nom_bitmap_apply(b->buf + first, head & tail, op);
+		return;
+	}
+	nom_bitmap_apply(b->buf + first, head, op);
+	nom_bitmap_apply(b->buf + last, tail, op);
+	if (op == NOM_BITMAP_FLIP) {
+		nom_flipbytes(b->buf + first + 1, last - first - 1);
+
+	} else {
+		memset(b->buf + first + 1, op == NOM_BITMAP_SET ? 0xff : 0x00,
+		       last - first - 1);
+	}
+}
+
+/* nom_buffer_setbitrange sets the n bits starting at the specified bit offset */
+NOM_API void nom_buffer_setbitrange(struct NomBuffer *b, int64_t off,
+				    int64_t n) {
+	nom_bitmap_range(b, off, n, NOM_BITMAP_SET);
+}
+
+/* nom_buffer_clearbitrange clears the n bits starting at the specified bit offset */
+NOM_API void nom_buffer_clearbitrange(struct NomBuffer *b, int64_t off,
+				      int64_t n) {
+	nom_bitmap_range(b, off, n, NOM_BITMAP_CLEAR);
+}
+
+/* nom_buffer_flipbitrange flips the n bits starting at the specified bit offset */
+NOM_API void nom_buffer_flipbitrange(struct NomBuffer *b, int64_t off,
+				     int64_t n) {
+	nom_bitmap_range(b, off, n, NOM_BITMAP_FLIP);
+}
+
+/* nom_buffer_popcount returns how many of the n bits starting at the specified bit offset are set */
+NOM_API int64_t nom_buffer_popcount(struct NomBuffer *b, int64_t off,
+				    int64_t n) {
+	int64_t first = off / 8, last = (off + n - 1) / 8;
+	uint8_t head, tail;
+
+	if (n <= 0) {
+		return 0;
+	}
+	head = (uint8_t)(0xff >> (off % 8));
+	tail = (uint8_t)(0xff << (7 - (off + n - 1) % 8));
+	if (first == last) {
+		return nom_popcount64_swar(b->buf[first] & head & tail);
+	}
+	return nom_popcount64_swar(b->buf[first] & head) +
+	       nom_popcount(b->buf + first + 1, last - first - 1) +
+	       nom_popcount64_swar(b->buf[last] & tail);
+}
+
+/* nom_bitmap_find returns the offset of the first bit at or after off that is set, or clear if invert is all ones, or -1 if there isn't one before the end of the buffer */
+NOM_API int64_t nom_bitmap_find(struct NomBuffer *b, int64_t off,
+				uint64_t invert) {
+	uint64_t w0, w1, w2, w3;
+	int64_t i = off / 8;
+	uint8_t v;
+
+	if (off < 0 || i >= b->cap) {
+		return -1;
+	}
+	v = (uint8_t)((b->buf[i] ^ invert) & (0xff >> (off % 8)));
+	if (v != 0) {
+		return i * 8 + nom_clz64(v) - 56;
+	}
+
+	/* skip over 32 bytes without a match at a time, which keeps up with memory */
+	for (i++; i + 32 <= b->cap; i += 32) {
+		memcpy(&w0, b->buf + i, 8);
+		memcpy(&w1, b->buf + i + 8, 8);
+		memcpy(&w2, b->buf + i + 16, 8);
+		memcpy(&w3, b->buf + i + 24, 8);
+		if (((w0 ^ invert) | (w1 ^ invert) | (w2 ^ invert) |
+		     (w3 ^ invert)) != 0) {
+			break;
+		}
+	}
+	for (; i + 8 <= b->cap; i += 8) {
+		w0 = nom_load64be(b->buf + i) ^ invert;
+		if (w0 != 0) {
+			return i * 8 + nom_clz64(w0);
+		}
+	}
+	for (; i < b->cap; i++) {
+		v = (uint8_t)(b->buf[i] ^ invert);
+		if (v != 0) {
+			return i * 8 + nom_clz64(v) - 56;
+		}
+	}
+	return -1;
+}
+
+/* nom_buffer_findset returns the offset of the first set bit at or after the specified bit offset, or -1 if there isn't one */
+NOM_API int64_t nom_buffer_findset(struct NomBuffer *b, int64_t off) {
+	return nom_bitmap_find(b, off, 0);
+}
+
+/* nom_buffer_findclear returns the offset of the first clear bit at or after the specified bit offset, or -1 if there isn't one */
+NOM_API int64_t nom_buffer_findclear(struct NomBuffer *b, int64_t off) {
+	return nom_bitmap_find(b, off, ~UINT64_C(0));
+}
+
+/* what nom_bitmap_combine merges two bitmaps with */
+#define NOM_BITMAP_AND 0
+#define NOM_BITMAP_OR 1
+#define NOM_BITMAP_XOR 2
+#define NOM_BITMAP_ANDNOT 3
+
+/* nom_bitmap_merge applies op to a pair of words */
+NOM_API NOM_ALWAYS_INLINE uint64_t nom_bitmap_merge(uint64_t a, uint64_t b,
+						    int op) {
+	switch (op) {
+	case NOM_BITMAP_AND:
+		return a & b;
+	case NOM_BITMAP_OR:
+		return a | b;
+	case NOM_BITMAP_XOR:
+		return a ^ b;
+	default:
+		return a & ~b;
+	}
+}
+
+#if defined(NOM_X86) && defined(__SSE2__)
+/* nom_bitmap_merge128 is nom_bitmap_merge for 16 bytes */
+NOM_API NOM_ALWAYS_INLINE __m128i nom_bitmap_merge128(__m128i a, __m128i b,
+						      int op) {
+	switch (op) {
+	case NOM_BITMAP_AND:
+		return _mm_and_si128(a, b);
+	case NOM_BITMAP_OR:
+		return _mm_or_si128(a, b);
+	case NOM_BITMAP_XOR:
+		return _mm_xor_si128(a, b);
+	default:
+		return _mm_andnot_si128(b, a);
+	}
+}
+#endif
+
+/* nom_bitmap_combine sets each byte of b to op applied to it and the same byte of src, over the bytes both buffers have, and is inlined with a constant op so each loop is a straight run of word operations */
+NOM_API NOM_ALWAYS_INLINE void nom_bitmap_combine(struct NomBuffer *b,
+						  struct NomBuffer *src,
+						  int op) {
+	int64_t n = b->cap < src->cap ? b->cap : src->cap, i = 0;
+	uint64_t x, y;
+
+	if (NOM_COW(b) != 0) {
+		return;
+	}
+#if defined(NOM_X86) && defined(__SSE2__)
+	for (; i + 16 <= n; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(b->buf + i));
+		__m128i w = _mm_loadu_si128((const __m128i *)(src->buf + i));
+		_mm_storeu_si128((__m128i *)(b->buf + i),
+				 nom_bitmap_merge128(v, w, op));
+	}
+#endif
+	for (; i + 8 <= n; i += 8) {
+		memcpy(&x, b->buf + i, 8);
+		memcpy(&y, src->buf + i, 8);
+		x = nom_bitmap_merge(x, y, op);
+		memcpy(b->buf + i, &x, 8);
+	}
+	for (; i < n; i++) {
+		b->buf[i] = (uint8_t)(nom_bitmap_merge(b->buf[i], src->buf[i],
+						       op));
+	}
+}
+
+/* nom_buffer_andbits clears each bit of the buffer that isn't set in src */
+NOM_API void nom_buffer_andbits(struct NomBuffer *b, struct NomBuffer *src) {
+	nom_bitmap_combine(b, src, NOM_BITMAP_AND);
+}
+
+/* nom_buffer_orbits sets each bit of the buffer that is set in src */
+NOM_API void nom_buffer_orbits(struct NomBuffer *b, struct NomBuffer *src) {
+	nom_bitmap_combine(b, src, NOM_BITMAP_OR);
+}
+
+/* nom_buffer_xorbits flips each bit of the buffer that is set in src */
+NOM_API void nom_buffer_xorbits(struct NomBuffer *b, struct NomBuffer *src) {
+	nom_bitmap_combine(b, src, NOM_BITMAP_XOR);
+}
+
+/* nom_buffer_andnotbits clears each bit of the buffer that is set in src */
+NOM_API void nom_buffer_andnotbits(struct NomBuffer *b, struct NomBuffer *src) {
+	nom_bitmap_combine(b, src, NOM_BITMAP_ANDNOT);
+}
+
+/* the amount of bytes a rank index keeps one count for */
+#define NOM_RANK_BLOCK 64
+
+/* a count of the set bits before every block of a bitmap, which answers rank and select queries without scanning from the start and has to be rebuilt after the bitmap changes */
+typedef struct NomRankIndex {
+	struct NomBuffer *b;
+	int64_t *counts; /* the set bits before each block, followed by the total */
+	int64_t blocks;
+} NomRankIndex;
+
+/* nom_rankindex_new builds a rank index over the whole of a buffer, returning -1 if it can't be allocated */
+NOM_API int nom_rankindex_new(struct NomRankIndex *out, struct NomBuffer *b) {
+	NomPopcountKernel count = nom_popcount_kernel();
+	int64_t i, n;
+
+	out->b = b;
+	out->blocks = (b->cap + NOM_RANK_BLOCK - 1) / NOM_RANK_BLOCK;
+	out->counts = (int64_t *)(nom_alloc(
+		b->allocator, (out->blocks + 1) * sizeof(int64_t)));
+	if (out->counts == NULL) {
+		return -1;
+	}
+	out->counts[0] = 0;
+	for (i = 0; i < out->blocks; i++) {
+		n = b->cap - i * NOM_RANK_BLOCK;
+		out->counts[i + 1] =
+			out->counts[i] +
+			count(b->buf + i * NOM_RANK_BLOCK,
+			      n < NOM_RANK_BLOCK ? n : NOM_RANK_BLOCK);
+	}
+	return 0;
+}
+
+/* nom_rankindex_destroy releases a rank index */
+NOM_API void nom_rankindex_destroy(struct NomRankIndex *r) {
+	nom_free(r->b->allocator, r->counts, (r->blocks + 1) * sizeof(int64_t));
+	r->counts = NULL;
+	r->blocks = 0;
+}
+
+/* nom_rankindex_rank returns how many bits before the specified bit offset are set */
+NOM_API int64_t nom_rankindex_rank(struct NomRankIndex *r, int64_t off) {
+	int64_t block;
+
+	if (off <= 0) {
+		return 0;
+	}
+	if (off >= r->b->cap * 8) {
+		return r->counts[r->blocks];
+	}
+	block = off / (NOM_RANK_BLOCK * 8);
+	return r->counts[block] +
+	       nom_buffer_popcount(r->b, block * NOM_RANK_BLOCK * 8,
+				   off - block * NOM_RANK_BLOCK * 8);
+}
+
+/* nom_rankindex_select returns the offset of the set bit with k set bits before it, or -1 if there are fewer than k + 1 */
+NOM_API int64_t nom_rankindex_select(struct NomRankIndex *r, int64_t k) {
+	int64_t lo = 0, hi = r->blocks, mid, i, c;
+	uint64_t w;
+	uint8_t v;
+
+	if (k < 0 || k >= r->counts[r->blocks]) {
+		return -1;
+	}
+
+	/* find the last block with at most k set bits before it */
+	while (hi - lo > 1) {
+		mid = lo + (hi - lo) / 2;
+		if (r->counts[mid] <= k) {
+			lo = mid;
+
+		} else {
+			hi = mid;
+		}
+	}
+	k -= r->counts[lo];
+
+	/* then narrow it down a word, a byte and a bit at a time */
+	i = lo * NOM_RANK_BLOCK;
+	for (; i + 8 <= r->b->cap; i += 8) {
+		memcpy(&w, r->b->buf + i, 8);
+		c = nom_popcount64_swar(w);
+		if (k < c) {
+			break;
+		}
+		k -= c;
+	}
+	for (;; i++) {
+		c = nom_popcount64_swar(r->b->buf[i]);
+		if (k < c) {
+			break;
+		}
+		k -= c;
+	}
+	for (v = r->b->buf[i];; k--) {
+		if (k == 0) {
+			return i * 8 + nom_clz64(v) - 56;
+		}
+		v &= (uint8_t)(~(0x80 >> (nom_clz64(v) - 56)));
+	}
+}
+
+#endif
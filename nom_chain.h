@@ -0,0 +1,408 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+#ifndef NOM_NOM_CHAIN_H
+#define NOM_NOM_CHAIN_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "nom.h"
+
+#ifdef NOM_POSIX
+#include <limits.h>
+#include <sys/uio.h>
+#endif
+
+/* references shorter than this are copied into the chain, as a segment costs more than copying them */
+#define NOM_CHAIN_MINREF 64
+
+/* a contiguous piece of a chain, which either points into one of the chain's blocks or at memory the caller owns */
+typedef struct NomSegment {
+	uint8_t *base;
+	int64_t len;
+	int inline_data; /* base points into one of the chain's blocks */
+} NomSegment;
+
+/* a sequence of segments that is serialized without copying referenced memory */
+typedef struct NomChain {
+	struct NomSegment *segs;
+	int64_t nsegs;
+	int64_t segcap;
+	struct NomBuffer **blocks; /* where inline writes go, each written up to its offset and never moved */
+	int64_t nblocks;
+	int64_t blockcap;
+	int64_t block_size;
+	int64_t len; /* the total amount of bytes in the chain */
+	int64_t seg; /* the segment the read cursor is in */
+	int64_t segoff; /* the read cursor's offset into that segment */
+	int64_t off; /* the read cursor's offset into the chain */
+	const struct NomAllocator *allocator;
+} NomChain;
+
+/* nom_chain_newwith creates an empty chain whose inline writes go to blocks of block_size bytes allocated with a */
+NOM_API void nom_chain_newwith(struct NomChain *out, int64_t block_size,
+			       const struct NomAllocator *a) {
+	out->segs = NULL;
+	out->nsegs = 0;
+	out->segcap = 0;
+	out->blocks = NULL;
+	out->nblocks = 0;
+	out->blockcap = 0;
+	out->block_size = block_size;
+	out->len = 0;
+	out->seg = 0;
+	out->segoff = 0;
+	out->off = 0;
+	out->allocator = a;
+}
+
+/* nom_chain_new creates an empty chain whose inline writes go to blocks of block_size bytes */
+NOM_API void nom_chain_new(struct NomChain *out, int64_t block_size) {
+	nom_chain_newwith(out, block_size, NULL);
+}
+
+/* nom_chain_destroy releases a chain's blocks and segment list, leaving referenced memory alone */
+NOM_API void nom_chain_destroy(struct NomChain *c) {
+	int64_t i;
+
+	for (i = 0; i < c->nblocks; i++) {
+		nom_buffer_destroy(c->blocks[i]);
+	}
+	nom_free(c->allocator, c->blocks,
+		 c->blockcap * sizeof(struct NomBuffer *));
+	nom_free(c->allocator, c->segs, c->segcap * sizeof(struct NomSegment));
+	nom_chain_newwith(c, c->block_size, c->allocator);
+}
+
+/* nom_chain_pushsegment adds a segment to the end of the chain, merging it into the last one when they are contiguous, and returns -1 if that fails */
+NOM_API int nom_chain_pushsegment(struct NomChain *c, uint8_t *base,
+				  int64_t len, int inline_data) {
+	struct NomSegment *segs, *last;
+	int64_t cap;
+
+	if (len <= 0) {
+		return 0;
+	}
+	last = c->nsegs > 0 ? &c->segs[c->nsegs - 1] : NULL;
+	if (last != NULL && last->inline_data == inline_data &&
+	    last->base + last->len == base) {
+		last->len += len;
+		c->len += len;
+		return 0;
+	}
+	if (c->nsegs == c->segcap) {
+		cap = c->segcap < 8 ? 8 : c->segcap * 2;
+		segs = (struct NomSegment *)(nom_realloc(
+			c->allocator, c->segs,
+			c->segcap * sizeof(struct NomSegment),
+			cap * sizeof(struct NomSegment)));
+		if (segs == NULL) {
+			return -1;
+		}
+		c->segs = segs;
+		c->segcap = cap;
+	}
+	c->segs[c->nsegs].base = base;
+	c->segs[c->nsegs].len = len;
+	c->segs[c->nsegs].inline_data = inline_data;
+	c->nsegs++;
+	c->len += len;
+	return 0;
+}
+
+/* nom_chain_reserve returns n bytes of contiguous inline space at the end of the chain, which the caller has to fill in, or NULL if that fails */
+NOM_API uint8_t *nom_chain_reserve(struct NomChain *c, int64_t n) {
+	struct NomBuffer *block, **blocks;
+	uint8_t *p;
+	int64_t cap;
+
+	block = c->nblocks > 0 ? c->blocks[c->nblocks - 1] : NULL;
+	if (block == NULL || block->cap - block->off < n) {
+		if (c->nblocks == c->blockcap) {
+			cap = c->blockcap < 4 ? 4 : c->blockcap * 2;
+			blocks = (struct NomBuffer **)(nom_realloc(
+				c->allocator, c->blocks,
+				c->blockcap * sizeof(struct NomBuffer *),
+				cap * sizeof(struct NomBuffer *)));
+			if (blocks == NULL) {
+				return NULL;
+			}
+			c->blocks = blocks;
+			c->blockcap = cap;
+		}
+		block = nom_buffer_create(
+			c->allocator, n > c->block_size ? n : c->block_size);
+		if (block == NULL) {
+			return NULL;
+		}
+		c->blocks[c->nblocks++] = block;
+	}
+	p = block->buf + block->off;
+	if (nom_chain_pushsegment(c, p, n, 1) != 0) {
+		return NULL;
+	}
+	nom_buffer_seekbyte(block, n, 1);
+	return p;
+}
+
+/* nom_chain_appendbytes copies a byte array to the end of the chain, returning -1 if that fails */
+NOM_API int nom_chain_appendbytes(struct NomChain *c, int64_t data_length,
+				  uint8_t *data) {
+	uint8_t *p;
+
+	if (data_length <= 0) {
+		return 0;
+	}
+	p = nom_chain_reserve(c, data_length);
+	if (p == NULL) {
+		return -1;
+	}
+	memcpy(p, data, data_length);
+	return 0;
+}
+
+/* nom_chain_appendref adds a reference to a byte array the caller keeps alive and unchanged until the chain is destroyed, returning -1 if that fails */
+NOM_API int nom_chain_appendref(struct NomChain *c, int64_t data_length,
+				uint8_t *data) {
+	if (data_length < NOM_CHAIN_MINREF) {
+		return nom_chain_appendbytes(c, data_length, data);
+	}
+	return nom_chain_pushsegment(c, data, data_length, 0);
+}
+
+/* nom_chain_appendarray copies n elements of size bytes to the end of the chain in big (1) or little (0) endian, returning -1 if that fails */
+NOM_API int nom_chain_appendarray(struct NomChain *c, const void *data,
+				  int64_t n, int size, int big) {
+	uint8_t *p;
+
+	if (n <= 0) {
+		return 0;
+	}
+	p = nom_chain_reserve(c, n * size);
+	if (p == NULL) {
+		return -1;
+	}
+	nom_byteorder(p, data, n, size, big);
+	return 0;
+}
+
+/* nom_chain_appendu16le copies an array of u16s to the end of the chain in little endian, returning -1 if that fails */
+NOM_API int nom_chain_appendu16le(struct NomChain *c, int64_t data_length,
+				  uint16_t *data) {
+	return nom_chain_appendarray(c, data, data_length, 2, 0);
+}
+
+/* nom_chain_appendu16be copies an array of u16s to the end of the chain in big endian, returning -1 if that fails */
+NOM_API int nom_chain_appendu16be(struct NomChain *c, int64_t data_length,
+				  uint16_t *data) {
+	return nom_chain_appendarray(c, data, data_length, 2, 1);
+}
+
+/* nom_chain_appendu32le copies an array of u32s to the end of the chain in little endian, returning -1 if that fails */
+NOM_API int nom_chain_appendu32le(struct NomChain *c, int64_t data_length,
+				  uint32_t *data) {
+	return nom_chain_appendarray(c, data, data_length, 4, 0);
+}
+
+/* nom_chain_appendu32be copies an array of u32s to the end of the chain in big endian, returning -1 if that fails */
+NOM_API int nom_chain_appendu32be(struct NomChain *c, int64_t data_length,
+				  uint32_t *data) {
+	return nom_chain_appendarray(c, data, data_length, 4, 1);
+}
+
+/* nom_chain_appendu64le copies an array of u64s to the end of the chain in little endian, returning -1 if that fails */
+NOM_API int nom_chain_appendu64le(struct NomChain *c, int64_t data_length,
+				  uint64_t *data) {
+	return nom_chain_appendarray(c, data, data_length, 8, 0);
+}
+
+/* nom_chain_appendu64be copies an array of u64s to the end of the chain in big endian, returning -1 if that fails */
+NOM_API int nom_chain_appendu64be(struct NomChain *c, int64_t data_length,
+				  uint64_t *data) {
+	return nom_chain_appendarray(c, data, data_length, 8, 1);
+}
+
+/* nom_chain_seek moves the read cursor to the specified offset into the chain, returning -1 if it is out of range */
+NOM_API int nom_chain_seek(struct NomChain *c, int64_t off) {
+	if (off < 0 || off > c->len) {
+		return -1;
+	}
+	c->off = off;
+	c->seg = 0;
+	while (c->seg < c->nsegs && off >= c->segs[c->seg].len) {
+		off -= c->segs[c->seg].len;
+		c->seg++;
+	}
+	c->segoff = off;
+	return 0;
+}
+
+/* nom_chain_readbytesnext reads n bytes at the read cursor, across segment boundaries, and moves the cursor forward the amount of bytes read, returning -1 if the chain is too short */
+NOM_API int nom_chain_readbytesnext(struct NomChain *c, uint8_t *out,
+				    int64_t n) {
+	int64_t k;
+
+	if (n > c->len - c->off) {
+		return -1;
+	}
+	while (n > 0) {
+		k = c->segs[c->seg].len - c->segoff;
+		k = k < n ? k : n;
+		memcpy(out, c->segs[c->seg].base + c->segoff, k);
+		out += k;
+		n -= k;
+		c->off += k;
+		c->segoff += k;
+		if (c->segoff == c->segs[c->seg].len) {
+			c->seg++;
+			c->segoff = 0;
+		}
+	}
+	return 0;
+}
+
+/* nom_chain_readarraynext reads n elements of size bytes in big (1) or little (0) endian at the read cursor and moves the cursor forward the amount of bytes read, returning -1 if the chain is too short */
+NOM_API int nom_chain_readarraynext(struct NomChain *c, void *out, int64_t n,
+				    int size, int big) {
+	uint8_t *dst = (uint8_t *)(out);
+	uint8_t tmp[8];
+	int64_t k;
+
+	if (n * size > c->len - c->off) {
+		return -1;
+	}
+	while (n > 0) {
+		/* whole elements inside the current segment are converted in place, one that straddles a boundary goes through tmp */
+		k = (c->segs[c->seg].len - c->segoff) / size;
+		k = k < n ? k : n;
+		if (k == 0) {
+			nom_chain_readbytesnext(c, tmp, size);
+			nom_byteorder(dst, tmp, 1, size, big);
+			k = 1;
+
+		} else {
+			nom_byteorder(dst, c->segs[c->seg].base + c->segoff, k,
+				      size, big);
+			c->off += k * size;
+			c->segoff += k * size;
+			if (c->segoff == c->segs[c->seg].len) {
+				c->seg++;
+				c->segoff = 0;
+			}
+		}
+		dst += k * size;
+		n -= k;
+	}
+	return 0;
+}
+
+/* nom_chain_readu16lenext reads n u16s in little endian at the read cursor and moves the cursor forward the amount of bytes read, returning -1 if the chain is too short */
+NOM_API int nom_chain_readu16lenext(struct NomChain *c, uint16_t *out,
+				    int64_t n) {
+	return nom_chain_readarraynext(c, out, n, 2, 0);
+}
+
+/* nom_chain_readu16benext reads n u16s in big endian at the read cursor and moves the cursor forward the amount of bytes read, returning -1 if the chain is too short */
+NOM_API int nom_chain_readu16benext(struct NomChain *c, uint16_t *out,
+				    int64_t n) {
+	return nom_chain_readarraynext(c, out, n, 2, 1);
+}
+
+/* nom_chain_readu32lenext reads n u32s in little endian at the read cursor and moves the cursor forward the amount of bytes read, returning -1 if the chain is too short */
+NOM_API int nom_chain_readu32lenext(struct NomChain *c, uint32_t *out,
+				    int64_t n) {
+	return nom_chain_readarraynext(c, out, n, 4, 0);
+}
+
+/* nom_chain_readu32benext reads n u32s in big endian at the read cursor and moves the cursor forward the amount of bytes read, returning -1 if the chain is too short */
+NOM_API int nom_chain_readu32benext(struct NomChain *c, uint32_t *out,
+				    int64_t n) {
+	return nom_chain_readarraynext(c, out, n, 4, 1);
+}
+
+/* nom_chain_readu64lenext reads n u64s in little endian at the read cursor and moves the cursor forward the amount of bytes read, returning -1 if the chain is too short */
+NOM_API int nom_chain_readu64lenext(struct NomChain *c, uint64_t *out,
+				    int64_t n) {
+	return nom_chain_readarraynext(c, out, n, 8, 0);
+}
+
+/* nom_chain_readu64benext reads n u64s in big endian at the read cursor and moves the cursor forward the amount of bytes read, returning -1 if the chain is too short */
+NOM_API int nom_chain_readu64benext(struct NomChain *c, uint64_t *out,
+				    int64_t n) {
+	return nom_chain_readarraynext(c, out, n, 8, 1);
+}
+
+#ifdef NOM_POSIX
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+/* the most segments nom_chain_writev hands to one writev, which is as many as the kernel takes up to a batch that still fits on the stack */
+#if IOV_MAX < 1024
+#define NOM_CHAIN_IOV IOV_MAX
+#else
+#define NOM_CHAIN_IOV 1024
+#endif
+
+/* nom_chain_iovec describes up to max segments starting at segment first as iovecs, returning how many it filled in */
+NOM_API int64_t nom_chain_iovec(struct NomChain *c, struct iovec *out,
+				int64_t first, int64_t max) {
+	int64_t i;
+
+	for (i = 0; i < max && first + i < c->nsegs; i++) {
+		out[i].iov_base = c->segs[first + i].base;
+		out[i].iov_len = (size_t)(c->segs[first + i].len);
+	}
+	return i;
+}
+
+/* nom_chain_writev writes the whole chain to fd with as few writev calls as possible, returning -1 if that fails */
+NOM_API int nom_chain_writev(struct NomChain *c, int fd) {
+	struct iovec iov[NOM_CHAIN_IOV];
+	int64_t seg = 0, skip = 0, n, i;
+	size_t len;
+	ssize_t r;
+
+	while (seg < c->nsegs) {
+		n = nom_chain_iovec(c, iov, seg, NOM_CHAIN_IOV);
+
+		/* the first segment may have been written partially last time around */
+		iov[0].iov_base = (uint8_t *)(iov[0].iov_base) + skip;
+		iov[0].iov_len -= (size_t)(skip);
+		for (i = 0, len = 0; i < n; i++) {
+			len += iov[i].iov_len;
+		}
+		do {
+			r = writev(fd, iov, (int)(n));
+		} while (r < 0 && errno == EINTR);
+		if (r < 0) {
+			return -1;
+		}
+
+		/* a writev that took nothing would be retried forever */
+		if (r == 0 && len > 0) {
+			errno = EIO;
+			return -1;
+		}
+		r += skip;
+		skip = 0;
+		while (seg < c->nsegs && r >= c->segs[seg].len) {
+			r -= c->segs[seg].len;
+			seg++;
+		}
+		skip = r;
+	}
+	return 0;
+}
+#endif
+
+#endif
@@ -16,68 +16,174 @@ file, You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "nom.h"
 
-/* nom_buffer_writecomplexle writes an array of integers to the buffer in little endian at the specified offset */
+/* nom_buffer_writecomplexle writes an array of numbers to the buffer in little endian at the specified offset */
 #define nom_buffer_writecomplexle(b, o, n, d)                                  \
 	_Generic((d), uint8_t *                                                \
 		 : nom_buffer_writebytes, uint16_t *                           \
 		 : nom_buffer_writeu16le, uint32_t *                           \
 		 : nom_buffer_writeu32le, uint64_t *                           \
-		 : nom_buffer_writeu64le)((b), (o), (n), (d))
+		 : nom_buffer_writeu64le, int16_t *                            \
+		 : nom_buffer_writei16le, int32_t *                            \
+		 : nom_buffer_writei32le, int64_t *                            \
+		 : nom_buffer_writei64le, float *                              \
+		 : nom_buffer_writef32le, double *                             \
+		 : nom_buffer_writef64le)((b), (o), (n), (d))
 
-/* nom_buffer_writecomplexlenext writes an array of integers to the buffer in little endian at the current offset and moves the offset forward the amount of bytes written */
+/* nom_buffer_writecomplexlenext writes an array of numbers to the buffer in little endian at the current offset and moves the offset forward the amount of bytes written */
 #define nom_buffer_writecomplexlenext(b, n, d)                                 \
 	_Generic((d), uint8_t *                                                \
 		 : nom_buffer_writebytesnext, uint16_t *                       \
 		 : nom_buffer_writeu16lenext, uint32_t *                       \
 		 : nom_buffer_writeu32lenext, uint64_t *                       \
-		 : nom_buffer_writeu64lenext)((b), (n), (d))
+		 : nom_buffer_writeu64lenext, int16_t *                        \
+		 : nom_buffer_writei16lenext, int32_t *                        \
+		 : nom_buffer_writei32lenext, int64_t *                        \
+		 : nom_buffer_writei64lenext, float *                          \
+		 : nom_buffer_writef32lenext, double *                         \
+		 : nom_buffer_writef64lenext)((b), (n), (d))
 
-/* nom_buffer_writecomplexbe writes an array of integers to the buffer in big endian at the specified offset */
+/* nom_buffer_writecomplexbe writes an array of numbers to the buffer in big endian at the specified offset */
 #define nom_buffer_writecomplexbe(b, o, n, d)                                  \
 	_Generic((d), uint8_t *                                                \
 		 : nom_buffer_writebytes, uint16_t *                           \
 		 : nom_buffer_writeu16be, uint32_t *                           \
 		 : nom_buffer_writeu32be, uint64_t *                           \
-		 : nom_buffer_writeu64be)((b), (o), (n), (d))
+		 : nom_buffer_writeu64be, int16_t *                            \
+		 : nom_buffer_writei16be, int32_t *                            \
+		 : nom_buffer_writei32be, int64_t *                            \
+		 : nom_buffer_writei64be, float *                              \
+		 : nom_buffer_writef32be, double *                             \
+		 : nom_buffer_writef64be)((b), (o), (n), (d))
 
-/* nom_buffer_writecomplexbenext writes an array of integers to the buffer in big endian at the current offset and moves the offset forward the amount of bytes written */
+/* nom_buffer_writecomplexbenext writes an array of numbers to the buffer in big endian at the current offset and moves the offset forward the amount of bytes written */
 #define nom_buffer_writecomplexbenext(b, n, d)                                 \
 	_Generic((d), uint8_t *                                                \
 		 : nom_buffer_writebytesnext, uint16_t *                       \
 		 : nom_buffer_writeu16benext, uint32_t *                       \
 		 : nom_buffer_writeu32benext, uint64_t *                       \
-		 : nom_buffer_writeu64benext)((b), (n), (d))
+		 : nom_buffer_writeu64benext, int16_t *                        \
+		 : nom_buffer_writei16benext, int32_t *                        \
+		 : nom_buffer_writei32benext, int64_t *                        \
+		 : nom_buffer_writei64benext, float *                          \
+		 : nom_buffer_writef32benext, double *                         \
+		 : nom_buffer_writef64benext)((b), (n), (d))
 
-/* nom_buffer_readcomplexle reads n integers from the buffer in little endian at the specified offset */
+/* nom_buffer_appendcomplexle writes an array of numbers to the buffer in little endian at the current offset, growing the buffer if it doesn't fit, and moves the offset forward the amount of bytes written */
+#define nom_buffer_appendcomplexle(b, n, d)                                    \
+	_Generic((d), uint8_t *                                                \
+		 : nom_buffer_appendbytes, uint16_t *                          \
+		 : nom_buffer_appendu16le, uint32_t *                          \
+		 : nom_buffer_appendu32le, uint64_t *                          \
+		 : nom_buffer_appendu64le, int16_t *                           \
+		 : nom_buffer_appendi16le, int32_t *                           \
+		 : nom_buffer_appendi32le, int64_t *                           \
+		 : nom_buffer_appendi64le, float *                             \
+		 : nom_buffer_appendf32le, double *                            \
+		 : nom_buffer_appendf64le)((b), (n), (d))
+
+/* nom_buffer_appendcomplexbe writes an array of numbers to the buffer in big endian at the current offset, growing the buffer if it doesn't fit, and moves the offset forward the amount of bytes written */
+#define nom_buffer_appendcomplexbe(b, n, d)                                    \
+	_Generic((d), uint8_t *                                                \
+		 : nom_buffer_appendbytes, uint16_t *                          \
+		 : nom_buffer_appendu16be, uint32_t *                          \
+		 : nom_buffer_appendu32be, uint64_t *                          \
+		 : nom_buffer_appendu64be, int16_t *                           \
+		 : nom_buffer_appendi16be, int32_t *                           \
+		 : nom_buffer_appendi32be, int64_t *                           \
+		 : nom_buffer_appendi64be, float *                             \
+		 : nom_buffer_appendf32be, double *                            \
+		 : nom_buffer_appendf64be)((b), (n), (d))
+
+/* nom_buffer_readcomplexle reads n numbers from the buffer in little endian at the specified offset */
 #define nom_buffer_readcomplexle(b, d, o, n)                                   \
 	_Generic((d), uint8_t *                                                \
 		 : nom_buffer_readbytes, uint16_t *                            \
 		 : nom_buffer_readu16le, uint32_t *                            \
 		 : nom_buffer_readu32le, uint64_t *                            \
-		 : nom_buffer_readu64le)((b), (d), (o), (n))
+		 : nom_buffer_readu64le, int16_t *                             \
+		 : nom_buffer_readi16le, int32_t *                             \
+		 : nom_buffer_readi32le, int64_t *                             \
+		 : nom_buffer_readi64le, float *                               \
+		 : nom_buffer_readf32le, double *                              \
+		 : nom_buffer_readf64le)((b), (d), (o), (n))
 
-/* nom_buffer_readcomplexlenext reads n integers from the buffer in little endian at the current offset and moves the offset forward the amount of bytes read */
+/* nom_buffer_readcomplexlenext reads n numbers from the buffer in little endian at the current offset and moves the offset forward the amount of bytes read */
 #define nom_buffer_readcomplexlenext(b, d, n)                                  \
 	_Generic((d), uint8_t *                                                \
 		 : nom_buffer_readbytesnext, uint16_t *                        \
 		 : nom_buffer_readu16lenext, uint32_t *                        \
 		 : nom_buffer_readu32lenext, uint64_t *                        \
-		 : nom_buffer_readu64lenext)((b), (d), (n))
+		 : nom_buffer_readu64lenext, int16_t *                         \
+		 : nom_buffer_readi16lenext, int32_t *                         \
+		 : nom_buffer_readi32lenext, int64_t *                         \
+		 : nom_buffer_readi64lenext, float *                           \
+		 : nom_buffer_readf32lenext, double *                          \
+		 : nom_buffer_readf64lenext)((b), (d), (n))
 
-/* nom_buffer_readcomplexbe reads n integers from the buffer in big endian at the specified offset */
+/* nom_buffer_readcomplexbe reads n numbers from the buffer in big endian at the specified offset */
 #define nom_buffer_readcomplexbe(b, d, o, n)                                   \
 	_Generic((d), uint8_t *                                                \
 		 : nom_buffer_readbytes, uint16_t *                            \
 		 : nom_buffer_readu16be, uint32_t *                            \
 		 : nom_buffer_readu32be, uint64_t *                            \
-		 : nom_buffer_readu64be)((b), (d), (o), (n))
+		 : nom_buffer_readu64be, int16_t *                             \
+		 : nom_buffer_readi16be, int32_t *                             \
+		 : nom_buffer_readi32be, int64_t *                             \
+		 : nom_buffer_readi64be, float *                               \
+		 : nom_buffer_readf32be, double *                              \
+		 : nom_buffer_readf64be)((b), (d), (o), (n))
 
-/* nom_buffer_readcomplexbenext reads n integers from the buffer in big endian at the current offset and moves the offset forward the amount of bytes read */
+/* nom_buffer_readcomplexbenext reads n numbers from the buffer in big endian at the current offset and moves the offset forward the amount of bytes read */
 #define nom_buffer_readcomplexbenext(b, d, n)                                  \
 	_Generic((d), uint8_t *                                                \
 		 : nom_buffer_readbytesnext, uint16_t *                        \
 		 : nom_buffer_readu16benext, uint32_t *                        \
 		 : nom_buffer_readu32benext, uint64_t *                        \
-		 : nom_buffer_readu64benext)((b), (d), (n))
+		 : nom_buffer_readu64benext, int16_t *                         \
+		 : nom_buffer_readi16benext, int32_t *                         \
+		 : nom_buffer_readi32benext, int64_t *                         \
+		 : nom_buffer_readi64benext, float *                           \
+		 : nom_buffer_readf32benext, double *                          \
+		 : nom_buffer_readf64benext)((b), (d), (n))
+
+/* nom_buffer_writevar writes an array of numbers to the buffer as varints at the specified offset, zigzag encoding signed ones */
+#define nom_buffer_writevar(b, o, n, d)                                        \
+	_Generic((d), uint32_t *                                               \
+		 : nom_buffer_writevaru32, uint64_t *                          \
+		 : nom_buffer_writevaru64, int32_t *                           \
+		 : nom_buffer_writevari32, int64_t *                           \
+		 : nom_buffer_writevari64)((b), (o), (n), (d))
+
+/* nom_buffer_writevarnext writes an array of numbers to the buffer as varints at the current offset and moves the offset forward the amount of bytes written */
+#define nom_buffer_writevarnext(b, n, d)                                       \
+	_Generic((d), uint32_t *                                               \
+		 : nom_buffer_writevaru32next, uint64_t *                      \
+		 : nom_buffer_writevaru64next, int32_t *                       \
+		 : nom_buffer_writevari32next, int64_t *                       \
+		 : nom_buffer_writevari64next)((b), (n), (d))
+
+/* nom_buffer_appendvar writes an array of numbers to the buffer as varints at the current offset, growing the buffer if they don't fit, and moves the offset forward the amount of bytes written */
+#define nom_buffer_appendvar(b, n, d)                                          \
+	_Generic((d), uint32_t *                                               \
+		 : nom_buffer_appendvaru32, uint64_t *                         \
+		 : nom_buffer_appendvaru64, int32_t *                          \
+		 : nom_buffer_appendvari32, int64_t *                          \
+		 : nom_buffer_appendvari64)((b), (n), (d))
+
+/* nom_buffer_readvar reads n varints from the buffer at the specified offset, zigzag decoding signed ones */
+#define nom_buffer_readvar(b, d, o, n)                                         \
+	_Generic((d), uint32_t *                                               \
+		 : nom_buffer_readvaru32, uint64_t *                           \
+		 : nom_buffer_readvaru64, int32_t *                            \
+		 : nom_buffer_readvari32, int64_t *                            \
+		 : nom_buffer_readvari64)((b), (d), (o), (n))
+
+/* nom_buffer_readvarnext reads n varints from the buffer at the current offset and moves the offset forward the amount of bytes read */
+#define nom_buffer_readvarnext(b, d, n)                                        \
+	_Generic((d), uint32_t *                                               \
+		 : nom_buffer_readvaru32next, uint64_t *                       \
+		 : nom_buffer_readvaru64next, int32_t *                        \
+		 : nom_buffer_readvari32next, int64_t *                        \
+		 : nom_buffer_readvari64next)((b), (d), (n))
 
 #endif
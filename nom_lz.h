@@ -0,0 +1,497 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+#ifndef NOM_NOM_LZ_H
+#define NOM_NOM_LZ_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "nom.h"
+
+/* blocks use lz4's block format, where each sequence is a token holding the literal length in its high nibble and the match length minus 4 in its low one, either continuing in bytes that are added on while they are 255 when the nibble is 15, followed by the literals and the match's distance back as a little endian u16 */
+
+/* the shortest match a sequence can have */
+#define NOM_LZ_MINMATCH 4
+
+/* the last 5 bytes of a block are always literals, and the last match starts at least 12 bytes before its end */
+#define NOM_LZ_LASTLITERALS 5
+#define NOM_LZ_MFLIMIT 12
+
+/* the farthest back a match can be */
+#define NOM_LZ_MAXOFFSET 65535
+
+/* the biggest input that can be compressed into one block */
+#define NOM_LZ_MAXINPUT 0x7e000000
+
+/* log2 of the amount of entries in the compressor's hash table, which lives on the stack */
+#define NOM_LZ_HASHLOG 12
+
+/* a frame is the decompressed size and the size of the block after it, as little endian u32s, followed by the block */
+#define NOM_LZ_HEADER 8
+
+/* set in a frame's block size when the block is the data as is, because it didn't compress */
+#define NOM_LZ_STORED UINT32_C(0x80000000)
+
+/* nom_lz_load32 loads a u32 in host order from p, which doesn't have to be aligned */
+NOM_API NOM_ALWAYS_INLINE uint32_t nom_lz_load32(const uint8_t *p) {
+	uint32_t v;
+
+	memcpy(&v, p, 4);
+	return v;
+}
+
+/* nom_lz_load32le loads a little endian u32 from p */
+NOM_API NOM_ALWAYS_INLINE uint32_t nom_lz_load32le(const uint8_t *p) {
+	return (uint32_t)(p[0]) | (uint32_t)(p[1]) << 8 |
+	       (uint32_t)(p[2]) << 16 | (uint32_t)(p[3]) << 24;
+}
+
+/* nom_lz_store32le stores v to p in little endian */
+NOM_API NOM_ALWAYS_INLINE void nom_lz_store32le(uint8_t *p, uint32_t v) {
+	p[0] = (uint8_t)(v);
+	p[1] = (uint8_t)(v >> 8);
+	p[2] = (uint8_t)(v >> 16);
+	p[3] = (uint8_t)(v >> 24);
+}
+
+/* nom_lz_hash hashes the 5 bytes at p into bits bits, which finds more matches than hashing the 4 a match needs since fewer of them collide */
+NOM_API NOM_ALWAYS_INLINE uint32_t nom_lz_hash(const uint8_t *p, int bits) {
+	return (uint32_t)(((nom_load64le(p) << 24) * UINT64_C(889523592379)) >>
+			  (64 - bits));
+}
+
+/* nom_lz_count returns how many of the bytes from p up to end are the same as the ones from ref on */
+NOM_API NOM_ALWAYS_INLINE int64_t nom_lz_count(const uint8_t *p,
+					       const uint8_t *ref,
+					       const uint8_t *end) {
+	const uint8_t *start = p;
+	uint64_t x;
+
+	while (p + 8 <= end) {
+		x = nom_load64le(p) ^ nom_load64le(ref);
+		if (x != 0) {
+			return p - start + nom_ctz64(x) / 8;
+		}
+		p += 8;
+		ref += 8;
+	}
+	while (p < end && *p == *ref) {
+		p++;
+		ref++;
+	}
+	return p - start;
+}
+
+/* nom_lz_writelength writes the bytes a length continues in after its nibble, returning where they end */
+NOM_API NOM_ALWAYS_INLINE uint8_t *nom_lz_writelength(uint8_t *op, int64_t n) {
+	memset(op, 255, n / 255);
+	op += n / 255;
+	*op++ = (uint8_t)(n % 255);
+	return op;
+}
+
+/* nom_lz_readlength adds the bytes a length continues in after its nibble onto n, returning -1 if the block ends first */
+NOM_API NOM_ALWAYS_INLINE int nom_lz_readlength(const uint8_t **ip,
+						const uint8_t *end,
+						int64_t *n) {
+	uint8_t s;
+
+	do {
+		if (*ip >= end) {
+			return -1;
+		}
+		s = *(*ip)++;
+		*n += s;
+	} while (s == 255);
+	return 0;
+}
+
+/* nom_lz_copy copies n bytes from src to dst in 16 byte pieces, writing up to 15 bytes past the end of dst */
+NOM_API NOM_ALWAYS_INLINE void nom_lz_copy(uint8_t *dst, const uint8_t *src,
+					   int64_t n) {
+	uint8_t *end = dst + n;
+
+	do {
+		memcpy(dst, src, 16);
+		dst += 16;
+		src += 16;
+	} while (dst < end);
+}
+
+/* the smallest multiple of each distance below 8 that is at least 8 */
+NOM_DATA const int64_t nom_lz_repeat[8] NOM_INIT({0, 8, 8, 9, 8, 10, 12, 14});
+
+/* nom_lz_bound returns the most a block of n bytes can compress to, which is a little more than n when it doesn't compress at all */
+NOM_API int64_t nom_lz_bound(int64_t n) { return n + n / 255 + 16; }
+
+/* nom_lz_compress compresses n bytes from src into a block at dst, which has room for cap bytes, returning the size of the block or -1 if it doesn't fit */
+NOM_API int64_t nom_lz_compress(uint8_t *dst, int64_t cap, const uint8_t *src,
+				int64_t n) {
+	uint32_t table[1 << NOM_LZ_HASHLOG];
+	const uint8_t *ip = src, *anchor = src, *ref, *limit, *matchlimit;
+	uint8_t *op = dst, *token;
+	int64_t lit, len, step, off;
+	int bits = NOM_LZ_HASHLOG;
+	uint32_t v, h;
+
+	if (n < 0 || n > NOM_LZ_MAXINPUT) {
+		return -1;
+	}
+	if (n <= NOM_LZ_MFLIMIT) {
+		goto last;
+	}
+	limit = src + n - NOM_LZ_MFLIMIT;
+	matchlimit = src + n - NOM_LZ_LASTLITERALS;
+
+	/* small inputs only fill a small table, so they don't pay for clearing a big one */
+	while (bits > 8 && (INT64_C(1) << (bits + 2)) > n) {
+		bits--;
+	}
+	memset(table, 0x00, sizeof(uint32_t) << bits);
+	ip++;
+	for (;;) {
+		/* the search skips ahead faster the longer it goes without finding a match, so incompressible data gets through quickly */
+		step = 1 << 6;
+		for (;;) {
+			if (ip > limit) {
+				goto last;
+			}
+			v = nom_lz_load32(ip);
+			h = nom_lz_hash(ip, bits);
+			ref = src + table[h];
+			table[h] = (uint32_t)(ip - src);
+			if (ip - ref <= NOM_LZ_MAXOFFSET &&
+			    nom_lz_load32(ref) == v) {
+				break;
+			}
+			ip += step++ >> 6;
+		}
+		while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+			ip--;
+			ref--;
+		}
+		len = nom_lz_count(ip + NOM_LZ_MINMATCH, ref + NOM_LZ_MINMATCH,
+				   matchlimit);
+		lit = ip - anchor;
+		off = ip - ref;
+
+		/* the token, both lengths' continuation bytes, the literals and the offset */
+		if ((op - dst) + lit + lit / 255 + len / 255 + 5 > cap) {
+			return -1;
+		}
+		token = op++;
+		if (lit >= 15) {
+			*token = 15 << 4;
+			op = nom_lz_writelength(op, lit - 15);
+
+		} else {
+			*token = (uint8_t)(lit << 4);
+		}
+		memcpy(op, anchor, lit);
+		op += lit;
+		op[0] = (uint8_t)(off);
+		op[1] = (uint8_t)(off >> 8);
+		op += 2;
+		if (len >= 15) {
+			*token |= 15;
+			op = nom_lz_writelength(op, len - 15);
+
+		} else {
+			*token |= (uint8_t)(len);
+		}
+		ip += len + NOM_LZ_MINMATCH;
+		anchor = ip;
+		if (ip > limit) {
+			break;
+		}
+
+		/* the bytes just before where a match ends often start the next one */
+		table[nom_lz_hash(ip - 2, bits)] = (uint32_t)(ip - 2 - src);
+	}
+
+last:
+	lit = src + n - anchor;
+	if ((op - dst) + lit + lit / 255 + 2 > cap) {
+		return -1;
+	}
+	token = op++;
+	if (lit >= 15) {
+		*token = 15 << 4;
+		op = nom_lz_writelength(op, lit - 15);
+
+	} else {
+		*token = (uint8_t)(lit << 4);
+	}
+	memcpy(op, anchor, lit);
+	op += lit;
+	return op - dst;
+}
+
+/* nom_lz_decompress decompresses the n byte block at src into dst, which has room for cap bytes, returning the decompressed size or -1 if the block is corrupt or doesn't fit */
+NOM_API int64_t nom_lz_decompress(uint8_t *dst, int64_t cap, const uint8_t *src,
+				  int64_t n) {
+	const uint8_t *ip = src, *iend = src + n, *match;
+	uint8_t *op = dst, *oend = dst + cap, *end;
+	int64_t lit, len, off, d;
+	unsigned token;
+
+	for (;;) {
+		if (ip >= iend) {
+			return -1;
+		}
+		token = *ip++;
+		lit = token >> 4;
+
+		/* most sequences have a few literals and aren't near the end of either side, so the literals are copied as one piece without any checks, and a match has to follow them */
+		if (lit < 15 && iend - ip >= 32 && oend - op >= 32) {
+			memcpy(op, ip, 16);
+			op += lit;
+			ip += lit;
+
+		} else {
+			if (lit == 15 &&
+			    nom_lz_readlength(&ip, iend, &lit) != 0) {
+				return -1;
+			}
+			if (lit > iend - ip || lit > oend - op) {
+				return -1;
+			}
+
+			/* copying in whole pieces is only safe with room to spare on both sides, which everything but the end of a block has */
+			if (iend - ip >= lit + 16 && oend - op >= lit + 16) {
+				nom_lz_copy(op, ip, lit);
+
+			} else {
+				memcpy(op, ip, lit);
+			}
+			op += lit;
+			ip += lit;
+			if (ip == iend) {
+				return op - dst;
+			}
+			if (iend - ip < 2) {
+				return -1;
+			}
+		}
+
+		off = (int64_t)(ip[0]) | (int64_t)(ip[1]) << 8;
+		ip += 2;
+		if ((uint64_t)(off - 1) >= (uint64_t)(op - dst)) {
+			return -1;
+		}
+		len = token & 15;
+
+		/* and most matches are short and far enough back to be copied in 8 byte pieces that don't overlap */
+		if (len < 15 && off >= 8 && oend - op >= 32) {
+			memcpy(op, op - off, 8);
+			memcpy(op + 8, op - off + 8, 8);
+			memcpy(op + 16, op - off + 16, 2);
+			op += len + NOM_LZ_MINMATCH;
+			continue;
+		}
+		if (len == 15 && nom_lz_readlength(&ip, iend, &len) != 0) {
+			return -1;
+		}
+		len += NOM_LZ_MINMATCH;
+		if (len > oend - op) {
+			return -1;
+		}
+		match = op - off;
+		end = op + len;
+		if (oend - op < len + 16) {
+			while (op < end) {
+				*op++ = *match++;
+			}
+			continue;
+		}
+
+		/* a match closer than a piece overlaps what it writes, so it is copied from a whole number of its repeats back instead, once there are that many */
+		if (off >= 16) {
+			nom_lz_copy(op, match, len);
+
+		} else if (off >= 8) {
+			do {
+				memcpy(op, match, 8);
+				op += 8;
+				match += 8;
+			} while (op < end);
+
+		} else {
+			d = nom_lz_repeat[off];
+			for (len = d - off; len > 0 && op < end; len--) {
+				*op++ = *match++;
+			}
+			while (op < end) {
+				memcpy(op, op - d, 8);
+				op += 8;
+			}
+		}
+		op = end;
+	}
+}
+
+/* nom_lz_frame writes a frame of n bytes from data to p, which has room for cap bytes, storing the data as is if it doesn't compress, and returns the size of the frame or -1 if it doesn't fit */
+NOM_API int64_t nom_lz_frame(uint8_t *p, int64_t cap, const uint8_t *data,
+			     int64_t n) {
+	int64_t k, room = cap - NOM_LZ_HEADER;
+
+	if (n > NOM_LZ_MAXINPUT || room < 0) {
+		return -1;
+	}
+
+	/* a block that isn't smaller than the data is given up on as soon as it can't be */
+	k = nom_lz_compress(p + NOM_LZ_HEADER, room < n ? room : n - 1, data,
+			    n);
+	if (k >= 0) {
+		nom_lz_store32le(p + 4, (uint32_t)(k));
+
+	} else if (n <= room) {
+		memcpy(p + NOM_LZ_HEADER, data, n);
+		nom_lz_store32le(p + 4, (uint32_t)(n) | NOM_LZ_STORED);
+		k = n;
+
+	} else {
+		return -1;
+	}
+	nom_lz_store32le(p, (uint32_t)(n));
+	return NOM_LZ_HEADER + k;
+}
+
+/* nom_lz_reserve makes room for n bytes at the current offset without changing the capacity, growing the allocation with the buffer's growth policy, unsharing it or flushing a stream's window, and returns how much room there is */
+NOM_API int64_t nom_lz_reserve(struct NomBuffer *b, int64_t n) {
+	NomGrowthPolicy growth =
+		b->growth == NULL ? nom_growth_geometric : b->growth;
+
+	if (NOM_COW(b) != 0) {
+		return 0;
+	}
+	if (b->stream != NULL) {
+		nom_buffer_window(b, 1, n);
+		return b->cap - b->off;
+	}
+	if (b->off + n > b->alloc) {
+		nom_buffer_reserve(b, growth(b->alloc, b->off + n));
+	}
+	return b->alloc - b->off;
+}
+
+/* nom_buffer_compress compresses n bytes at off into a block at the current offset of out, growing out if it doesn't fit, and moves out's offset forward the size of the block, returning it or -1 if growing fails */
+NOM_API int64_t nom_buffer_compress(struct NomBuffer *b, int64_t off, int64_t n,
+				    struct NomBuffer *out) {
+	int64_t k, room;
+
+	NOM_STAT_ACCESS(NOM_TRACE_READ, b, off, n, 1);
+
+	/* reserving can move out's storage, so it has to happen before out->buf is read */
+	room = nom_lz_reserve(out, nom_lz_bound(n));
+	k = nom_lz_compress(out->buf + out->off, room, b->buf + off, n);
+	if (k < 0 || nom_buffer_ensure(out, out->off + k) != 0) {
+		return -1;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, out, out->off, k, 1);
+	nom_buffer_advance(out, k);
+	return k;
+}
+
+/* nom_buffer_decompress decompresses the n byte block at off into out at its current offset without growing it, and moves out's offset forward the decompressed size, returning it or -1 if the block is corrupt or doesn't fit */
+NOM_API int64_t nom_buffer_decompress(struct NomBuffer *b, int64_t off,
+				      int64_t n, struct NomBuffer *out) {
+	int64_t k;
+
+	NOM_STAT_ACCESS(NOM_TRACE_READ, b, off, n, 1);
+	if (NOM_COW(out) != 0) {
+		return -1;
+	}
+	k = nom_lz_decompress(out->buf + out->off, out->cap - out->off,
+			      b->buf + off, n);
+	if (k < 0) {
+		return -1;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, out, out->off, k, 1);
+	nom_buffer_advance(out, k);
+	return k;
+}
+
+/* nom_buffer_writelznext compresses a byte array into a frame at the current offset and moves the offset forward the size of the frame, returning -1 if it doesn't fit */
+NOM_API int nom_buffer_writelznext(struct NomBuffer *b, int64_t data_length,
+				   uint8_t *data) {
+	int64_t k;
+
+	if (NOM_COW(b) != 0) {
+		return -1;
+	}
+	nom_buffer_window(b, 1, NOM_LZ_HEADER + nom_lz_bound(data_length));
+	k = nom_lz_frame(b->buf + b->off, b->cap - b->off, data, data_length);
+	if (k < 0) {
+		return -1;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, b, b->off, k, 1);
+	nom_buffer_advance(b, k);
+	return 0;
+}
+
+/* nom_buffer_appendlz compresses a byte array into a frame at the current offset, growing the buffer if it doesn't fit, and moves the offset forward the size of the frame */
+NOM_API int nom_buffer_appendlz(struct NomBuffer *b, int64_t data_length,
+				uint8_t *data) {
+	int64_t k, room;
+
+	room = nom_lz_reserve(b, NOM_LZ_HEADER + nom_lz_bound(data_length));
+	k = nom_lz_frame(b->buf + b->off, room, data, data_length);
+	if (k < 0 || nom_buffer_ensure(b, b->off + k) != 0) {
+		return -1;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, b, b->off, k, 1);
+	nom_buffer_advance(b, k);
+	return 0;
+}
+
+/* nom_buffer_peeklz returns the decompressed size of the frame at the current offset without moving it, or -1 if there isn't a frame header there */
+NOM_API int64_t nom_buffer_peeklz(struct NomBuffer *b) {
+	nom_buffer_window(b, 1, NOM_LZ_HEADER);
+	if (b->cap - b->off < NOM_LZ_HEADER) {
+		return -1;
+	}
+	return nom_lz_load32le(b->buf + b->off);
+}
+
+/* nom_buffer_readlznext decompresses the frame at the current offset into out, which has room for n bytes, and moves the offset past the frame, returning the decompressed size or -1 if the frame is truncated, corrupt or doesn't fit */
+NOM_API int64_t nom_buffer_readlznext(struct NomBuffer *b, uint8_t *out,
+				      int64_t n) {
+	int64_t size = nom_buffer_peeklz(b), k;
+	uint32_t block;
+
+	if (size < 0 || size > n) {
+		return -1;
+	}
+	block = nom_lz_load32le(b->buf + b->off + 4);
+	k = block & ~NOM_LZ_STORED;
+	nom_buffer_window(b, 1, NOM_LZ_HEADER + k);
+	if (b->cap - b->off < NOM_LZ_HEADER + k) {
+		return -1;
+	}
+	if (block & NOM_LZ_STORED) {
+		if (k != size) {
+			return -1;
+		}
+		memcpy(out, b->buf + b->off + NOM_LZ_HEADER, k);
+
+	} else if (nom_lz_decompress(out, size,
+				     b->buf + b->off + NOM_LZ_HEADER,
+				     k) != size) {
+		return -1;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_READ, b, b->off, NOM_LZ_HEADER + k, 1);
+	nom_buffer_advance(b, NOM_LZ_HEADER + k);
+	return size;
+}
+
+#endif
@@ -0,0 +1,306 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+#ifndef NOM_NOM_POOL_H
+#define NOM_NOM_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nom.h"
+
+#ifdef NOM_POSIX
+#include <pthread.h>
+#endif
+
+/* blocks handed out by arenas and pools are aligned to this many bytes */
+#define NOM_ALIGNMENT 16
+
+/* nom_align rounds n up to a multiple of NOM_ALIGNMENT */
+NOM_API size_t nom_align(size_t n) {
+	return (n + (NOM_ALIGNMENT - 1)) & ~(size_t)(NOM_ALIGNMENT - 1);
+}
+
+/* a chunk of memory an arena hands out blocks from, followed by its data */
+typedef struct NomArenaChunk {
+	struct NomArenaChunk *next;
+	size_t size; /* the amount of bytes of data */
+	size_t used;
+} NomArenaChunk;
+
+/* a bump allocator that releases every block it handed out at once */
+typedef struct NomArena {
+	struct NomAllocator allocator; /* hooks that allocate from this arena */
+	struct NomArenaChunk *first;
+	struct NomArenaChunk *cur; /* the chunk blocks are being handed out from */
+	uint8_t *last; /* the most recent block, which can be resized or released in place */
+	size_t chunk_size;
+} NomArena;
+
+/* nom_arena_data returns the start of a chunk's data */
+NOM_API uint8_t *nom_arena_data(struct NomArenaChunk *c) {
+	return (uint8_t *)(c) + nom_align(sizeof(struct NomArenaChunk));
+}
+
+/* nom_arena_allocate is the allocate hook of an arena */
+NOM_API void *nom_arena_allocate(void *ctx, size_t n) {
+	struct NomArena *a = (struct NomArena *)(ctx);
+	struct NomArenaChunk *c;
+	size_t size;
+
+	n = nom_align(n == 0 ? 1 : n);
+	if (a->cur == NULL || a->cur->used + n > a->cur->size) {
+		/* chunks kept by nom_arena_reset are reused before new ones are made */
+		if (a->cur != NULL && a->cur->next != NULL &&
+		    a->cur->next->size >= n) {
+			c = a->cur->next;
+
+		} else {
+			size = n > a->chunk_size ? n : a->chunk_size;
+			c = (struct NomArenaChunk *)(malloc(
+				nom_align(sizeof(struct NomArenaChunk)) +
+				size));
+			if (c == NULL) {
+				return NULL;
+			}
+			c->size = size;
+			if (a->cur == NULL) {
+				c->next = a->first;
+				a->first = c;
+
+			} else {
+				c->next = a->cur->next;
+				a->cur->next = c;
+			}
+		}
+		c->used = 0;
+		a->cur = c;
+	}
+	a->last = nom_arena_data(a->cur) + a->cur->used;
+	a->cur->used += n;
+	return a->last;
+}
+
+/* nom_arena_reallocate is the reallocate hook of an arena, which resizes the most recent block in place */
+NOM_API void *nom_arena_reallocate(void *ctx, void *p, size_t old_size,
+				   size_t n) {
+	struct NomArena *a = (struct NomArena *)(ctx);
+	size_t start, m = nom_align(n == 0 ? 1 : n);
+	void *q;
+
+	if (p != NULL && p == a->last) {
+		start = (size_t)(a->last - nom_arena_data(a->cur));
+		if (start + m <= a->cur->size) {
+			a->cur->used = start + m;
+			return p;
+		}
+	}
+	q = nom_arena_allocate(ctx, n);
+	if (q != NULL && p != NULL) {
+		memcpy(q, p, old_size < n ? old_size : n);
+	}
+	return q;
+}
+
+/* nom_arena_deallocate is the deallocate hook of an arena, which only gives back the most recent block */
+NOM_API void nom_arena_deallocate(void *ctx, void *p, size_t n) {
+	struct NomArena *a = (struct NomArena *)(ctx);
+
+	(void)n;
+	if (p != NULL && p == a->last) {
+		a->cur->used = (size_t)(a->last - nom_arena_data(a->cur));
+		a->last = NULL;
+	}
+}
+
+/* nom_arena_new creates an arena that gets memory from malloc chunk_size bytes at a time */
+NOM_API void nom_arena_new(struct NomArena *out, size_t chunk_size) {
+	out->allocator.allocate = nom_arena_allocate;
+	out->allocator.reallocate = nom_arena_reallocate;
+	out->allocator.deallocate = nom_arena_deallocate;
+	out->allocator.ctx = out;
+	out->first = NULL;
+	out->cur = NULL;
+	out->last = NULL;
+	out->chunk_size = chunk_size;
+}
+
+/* nom_arena_reset releases every block the arena handed out in O(1), keeping its chunks around for reuse */
+NOM_API void nom_arena_reset(struct NomArena *a) {
+	a->cur = a->first;
+	a->last = NULL;
+	if (a->cur != NULL) {
+		a->cur->used = 0;
+	}
+}
+
+/* nom_arena_destroy gives all of an arena's chunks back to malloc */
+NOM_API void nom_arena_destroy(struct NomArena *a) {
+	struct NomArenaChunk *c = a->first, *next;
+
+	while (c != NULL) {
+		next = c->next;
+		free(c);
+		c = next;
+	}
+	a->first = NULL;
+	a->cur = NULL;
+	a->last = NULL;
+}
+
+/* a pool's size classes are powers of two from 1 << NOM_POOL_MINSHIFT up, anything bigger goes straight to malloc */
+#define NOM_POOL_MINSHIFT 6
+#define NOM_POOL_CLASSES 16
+
+/* a cache of freed blocks sorted into size classes, which isn't thread-safe by itself */
+typedef struct NomPool {
+	struct NomAllocator allocator; /* hooks that allocate from this pool */
+	void *blocks[NOM_POOL_CLASSES]; /* cached blocks, linked through their first word */
+	int64_t cached[NOM_POOL_CLASSES];
+	int64_t limit; /* the most blocks cached per class */
+} NomPool;
+
+/* nom_pool_class returns the size class of an n byte block, or -1 if it is too big for one */
+NOM_API int nom_pool_class(size_t n) {
+	int c = 0;
+
+	while (((size_t)(1) << (c + NOM_POOL_MINSHIFT)) < n) {
+		if (++c == NOM_POOL_CLASSES) {
+			return -1;
+		}
+	}
+	return c;
+}
+
+/* nom_pool_allocate is the allocate hook of a pool */
+NOM_API void *nom_pool_allocate(void *ctx, size_t n) {
+	struct NomPool *p = (struct NomPool *)(ctx);
+	int c = nom_pool_class(n);
+	void *block;
+
+	if (c < 0) {
+		return malloc(n);
+	}
+	block = p->blocks[c];
+	if (block == NULL) {
+		return malloc((size_t)(1) << (c + NOM_POOL_MINSHIFT));
+	}
+	memcpy(&p->blocks[c], block, sizeof(void *));
+	p->cached[c]--;
+	return block;
+}
+
+/* nom_pool_deallocate is the deallocate hook of a pool */
+NOM_API void nom_pool_deallocate(void *ctx, void *block, size_t n) {
+	struct NomPool *p = (struct NomPool *)(ctx);
+	int c = nom_pool_class(n);
+
+	if (block == NULL) {
+		return;
+	}
+	if (c < 0 || p->cached[c] >= p->limit) {
+		free(block);
+		return;
+	}
+	memcpy(block, &p->blocks[c], sizeof(void *));
+	p->blocks[c] = block;
+	p->cached[c]++;
+}
+
+/* nom_pool_reallocate is the reallocate hook of a pool, which keeps blocks that stay in the same size class */
+NOM_API void *nom_pool_reallocate(void *ctx, void *block, size_t old_size,
+				  size_t n) {
+	int c = nom_pool_class(n);
+	void *q;
+
+	if (block == NULL) {
+		return nom_pool_allocate(ctx, n);
+	}
+	if (c >= 0 && c == nom_pool_class(old_size)) {
+		return block;
+	}
+	if (c < 0 && nom_pool_class(old_size) < 0) {
+		return realloc(block, n);
+	}
+	q = nom_pool_allocate(ctx, n);
+	if (q != NULL) {
+		memcpy(q, block, old_size < n ? old_size : n);
+		nom_pool_deallocate(ctx, block, old_size);
+	}
+	return q;
+}
+
+/* nom_pool_new creates a pool that caches up to limit freed blocks of each size class */
+NOM_API void nom_pool_new(struct NomPool *out, int64_t limit) {
+	int c;
+
+	out->allocator.allocate = nom_pool_allocate;
+	out->allocator.reallocate = nom_pool_reallocate;
+	out->allocator.deallocate = nom_pool_deallocate;
+	out->allocator.ctx = out;
+	for (c = 0; c < NOM_POOL_CLASSES; c++) {
+		out->blocks[c] = NULL;
+		out->cached[c] = 0;
+	}
+	out->limit = limit;
+}
+
+/* nom_pool_trim gives every block a pool has cached back to malloc */
+NOM_API void nom_pool_trim(struct NomPool *p) {
+	void *block;
+	int c;
+
+	for (c = 0; c < NOM_POOL_CLASSES; c++) {
+		while ((block = p->blocks[c]) != NULL) {
+			memcpy(&p->blocks[c], block, sizeof(void *));
+			free(block);
+		}
+		p->cached[c] = 0;
+	}
+}
+
+NOM_DATA NOM_THREAD_LOCAL struct NomPool nom_pool_thread;
+NOM_DATA NOM_THREAD_LOCAL int nom_pool_thread_ready NOM_INIT(0);
+
+#ifdef NOM_POSIX
+/* a key whose destructor trims each thread's pool as the thread exits */
+NOM_DATA pthread_key_t nom_pool_key NOM_INIT({0});
+NOM_DATA pthread_once_t nom_pool_key_once NOM_INIT(PTHREAD_ONCE_INIT);
+NOM_DATA int nom_pool_key_ready NOM_INIT(0);
+
+/* nom_pool_exit is the destructor of nom_pool_key */
+NOM_API void nom_pool_exit(void *p) { nom_pool_trim((struct NomPool *)(p)); }
+
+/* nom_pool_key_new creates nom_pool_key, once per process */
+NOM_API void nom_pool_key_new(void) {
+	nom_pool_key_ready =
+		pthread_key_create(&nom_pool_key, nom_pool_exit) == 0;
+}
+#endif
+
+/* nom_pool_local returns the calling thread's pool, whose cached blocks are given back when the thread exits where there are pthreads, and should be trimmed by hand before then elsewhere */
+NOM_API struct NomPool *nom_pool_local(void) {
+	if (!nom_pool_thread_ready) {
+		nom_pool_new(&nom_pool_thread, 256);
+		nom_pool_thread_ready = 1;
+#ifdef NOM_POSIX
+		pthread_once(&nom_pool_key_once, nom_pool_key_new);
+		if (nom_pool_key_ready) {
+			pthread_setspecific(nom_pool_key, &nom_pool_thread);
+		}
+#endif
+	}
+	return &nom_pool_thread;
+}
+
+#endif
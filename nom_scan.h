@@ -0,0 +1,566 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+#ifndef NOM_NOM_SCAN_H
+#define NOM_NOM_SCAN_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "nom.h"
+
+/* scans compare a vector of bytes against what they look for at a time and turn the result into a bit per byte with movemask, so a whole vector without a match costs a compare and a branch */
+
+/* wide registers cost about 200ns to get going on some cpus, so scans look through this many bytes 16 at a time before switching to 32, and matches close to the start never touch them */
+#define NOM_SCAN_WIDE 16384
+
+/* a set of bytes, as two tables indexed by the low nibble of a byte whose bits say which of the high nibbles 0-7 (low) or 8-15 (high) are in the set */
+typedef struct NomScanSet {
+	uint8_t low[16];
+	uint8_t high[16];
+} NomScanSet;
+
+/* what a scan looks for */
+typedef struct NomScanKey {
+	uint8_t c; /* the byte, for byte scans */
+	struct NomScanSet set; /* the bytes, for set scans */
+	const uint8_t *pattern; /* the bytes in order, for pattern scans */
+	int64_t length; /* the length of pattern, at least 2 */
+} NomScanKey;
+
+/* a scan kernel returns the index of the first match in n bytes at p, or -1 if there isn't one */
+typedef int64_t (*NomScanKernel)(const uint8_t *p, int64_t n,
+				 const struct NomScanKey *k);
+
+/* nom_scan_set builds the set of the n bytes at set */
+NOM_API void nom_scan_set(struct NomScanSet *out, const uint8_t *set,
+			  int64_t n) {
+	int64_t i;
+
+	memset(out, 0x00, sizeof(struct NomScanSet));
+	for (i = 0; i < n; i++) {
+		if (set[i] & 0x80) {
+			out->high[set[i] & 0x0f] |=
+				(uint8_t)(1 << ((set[i] >> 4) & 7));
+
+		} else {
+			out->low[set[i] & 0x0f] |=
+				(uint8_t)(1 << (set[i] >> 4));
+		}
+	}
+}
+
+/* nom_scan_member returns whether c is in s */
+NOM_API NOM_ALWAYS_INLINE int nom_scan_member(const struct NomScanSet *s,
+					      uint8_t c) {
+	return ((c & 0x80 ? s->high : s->low)[c & 0x0f] >> ((c >> 4) & 7)) & 1;
+}
+
+/* nom_scan_byte_scalar is the byte kernel for machines without simd, which memchr is usually vectorized for anyway */
+NOM_API int64_t nom_scan_byte_scalar(const uint8_t *p, int64_t n,
+				     const struct NomScanKey *k) {
+	const uint8_t *q;
+
+	if (n <= 0) {
+		return -1;
+	}
+	q = (const uint8_t *)(memchr(p, k->c, (size_t)(n)));
+	return q == NULL ? -1 : q - p;
+}
+
+/* nom_scan_set_scalar is the set kernel one byte at a time */
+NOM_API int64_t nom_scan_set_scalar(const uint8_t *p, int64_t n,
+				    const struct NomScanKey *k) {
+	int64_t i;
+
+	for (i = 0; i < n; i++) {
+		if (nom_scan_member(&k->set, p[i])) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+/* nom_scan_pattern_scalar is the pattern kernel, finding the first byte of the pattern with memchr and comparing the rest */
+NOM_API int64_t nom_scan_pattern_scalar(const uint8_t *p, int64_t n,
+					const struct NomScanKey *k) {
+	const uint8_t *q = p, *end;
+
+	if (n < k->length) {
+		return -1;
+	}
+	end = p + n - k->length + 1;
+	while (q < end) {
+		q = (const uint8_t *)(memchr(q, k->pattern[0], end - q));
+		if (q == NULL) {
+			return -1;
+		}
+		if (memcmp(q + 1, k->pattern + 1, k->length - 1) == 0) {
+			return q - p;
+		}
+		q++;
+	}
+	return -1;
+}
+
+/* nom_scan_all_scalar stores base plus the index of each c in n bytes at p to out until max are stored, returning how many were */
+NOM_API int64_t nom_scan_all_scalar(const uint8_t *p, int64_t n, uint8_t c,
+				    int64_t *out, int64_t base, int64_t max) {
+	int64_t i, k = 0;
+
+	for (i = 0; i < n && k < max; i++) {
+		if (p[i] == c) {
+			out[k++] = base + i;
+		}
+	}
+	return k;
+}
+
+/* nom_scan_store stores base plus the index of each set bit of m to out, stopping once k reaches max, and returns the new k */
+NOM_API NOM_ALWAYS_INLINE int64_t nom_scan_store(uint64_t m, int64_t *out,
+						 int64_t k, int64_t base,
+						 int64_t max) {
+	while (m != 0 && k < max) {
+		out[k++] = base + nom_ctz64(m);
+		m &= m - 1;
+	}
+	return k;
+}
+
+#if defined(NOM_X86) && defined(__SSE2__)
+/* nom_scan_eq16 returns a bit per byte of the 16 bytes at p that equals the bytes of v */
+NOM_API NOM_ALWAYS_INLINE uint32_t nom_scan_eq16(const uint8_t *p, __m128i v) {
+	return (uint32_t)(_mm_movemask_epi8(
+		_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p)), v)));
+}
+
+/* nom_scan_byte_sse2 is the byte kernel 64 bytes at a time, or'ing the compares together so there is one branch for all of them */
+NOM_API int64_t nom_scan_byte_sse2(const uint8_t *p, int64_t n,
+				   const struct NomScanKey *k) {
+	__m128i v = _mm_set1_epi8((char)(k->c));
+	int64_t i = 0, r;
+	uint64_t m;
+
+	for (; i + 64 <= n; i += 64) {
+		__m128i e0 = _mm_cmpeq_epi8(
+			_mm_loadu_si128((const __m128i *)(p + i)), v);
+		__m128i e1 = _mm_cmpeq_epi8(
+			_mm_loadu_si128((const __m128i *)(p + i + 16)), v);
+		__m128i e2 = _mm_cmpeq_epi8(
+			_mm_loadu_si128((const __m128i *)(p + i + 32)), v);
+		__m128i e3 = _mm_cmpeq_epi8(
+			_mm_loadu_si128((const __m128i *)(p + i + 48)), v);
+		__m128i any = _mm_or_si128(_mm_or_si128(e0, e1),
+					   _mm_or_si128(e2, e3));
+
+		if (_mm_movemask_epi8(any) != 0) {
+			m = (uint64_t)(_mm_movemask_epi8(e0)) |
+			    (uint64_t)(_mm_movemask_epi8(e1)) << 16 |
+			    (uint64_t)(_mm_movemask_epi8(e2)) << 32 |
+			    (uint64_t)(_mm_movemask_epi8(e3)) << 48;
+			return i + nom_ctz64(m);
+		}
+	}
+	for (; i + 16 <= n; i += 16) {
+		m = nom_scan_eq16(p + i, v);
+		if (m != 0) {
+			return i + nom_ctz64(m);
+		}
+	}
+
+	/* the last few bytes are looked at by going back to the last whole vector, skipping the bytes it has in common with the one before */
+	if (i < n && n >= 16) {
+		m = nom_scan_eq16(p + n - 16, v) >> (16 - (n - i));
+		return m != 0 ? i + nom_ctz64(m) : -1;
+	}
+	r = nom_scan_byte_scalar(p + i, n - i, k);
+	return r < 0 ? -1 : i + r;
+}
+
+/* nom_scan_pattern_sse2 is the pattern kernel 16 starting positions at a time, comparing the rest of the pattern only where both its first and its last byte match */
+NOM_API int64_t nom_scan_pattern_sse2(const uint8_t *p, int64_t n,
+				      const struct NomScanKey *k) {
+	__m128i first = _mm_set1_epi8((char)(k->pattern[0]));
+	__m128i last = _mm_set1_epi8((char)(k->pattern[k->length - 1]));
+	int64_t i = 0, r;
+	uint32_t m;
+
+	for (; i + k->length - 1 + 16 <= n; i += 16) {
+		m = nom_scan_eq16(p + i, first) &
+		    nom_scan_eq16(p + i + k->length - 1, last);
+		while (m != 0) {
+			r = nom_ctz64(m);
+			if (memcmp(p + i + r + 1, k->pattern + 1,
+				   k->length - 2) == 0) {
+				return i + r;
+			}
+			m &= m - 1;
+		}
+	}
+	r = nom_scan_pattern_scalar(p + i, n - i, k);
+	return r < 0 ? -1 : i + r;
+}
+
+/* nom_scan_all_sse2 is nom_scan_all_scalar 64 bytes at a time */
+NOM_API int64_t nom_scan_all_sse2(const uint8_t *p, int64_t n, uint8_t c,
+				  int64_t *out, int64_t base, int64_t max) {
+	__m128i v = _mm_set1_epi8((char)(c));
+	int64_t i = 0, k = 0;
+	uint64_t m;
+
+	for (; i + 64 <= n && k < max; i += 64) {
+		m = (uint64_t)(nom_scan_eq16(p + i, v)) |
+		    (uint64_t)(nom_scan_eq16(p + i + 16, v)) << 16 |
+		    (uint64_t)(nom_scan_eq16(p + i + 32, v)) << 32 |
+		    (uint64_t)(nom_scan_eq16(p + i + 48, v)) << 48;
+		k = nom_scan_store(m, out, k, base + i, max);
+	}
+	return k + nom_scan_all_scalar(p + i, n - i, c, out + k, base + i,
+				       max - k);
+}
+
+/* nom_scan_class16 returns v with the bytes that aren't in the set whose tables are low and high zeroed, bits holding 1 << i in lanes i and i + 8 */
+__attribute__((target("ssse3"))) NOM_API __m128i
+nom_scan_class16(__m128i v, __m128i low, __m128i high, __m128i bits) {
+	/* pshufb gives 0 for lanes whose index has the top bit set, so each table only answers for its half of the bytes */
+	__m128i t = _mm_or_si128(
+		_mm_shuffle_epi8(low, v),
+		_mm_shuffle_epi8(high, _mm_xor_si128(v, _mm_set1_epi8(-128))));
+	__m128i h = _mm_shuffle_epi8(
+		bits, _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(7)));
+
+	return _mm_and_si128(t, h);
+}
+
+/* nom_scan_nonzero16 returns a bit per byte of v that isn't 0 */
+NOM_API NOM_ALWAYS_INLINE uint64_t nom_scan_nonzero16(__m128i v) {
+	return (uint64_t)(_mm_movemask_epi8(
+		       _mm_cmpeq_epi8(v, _mm_setzero_si128()))) ^
+	       0xffff;
+}
+
+/* nom_scan_set_ssse3 is the set kernel 64 bytes at a time, looking every byte up in the set's tables with pshufb */
+__attribute__((target("ssse3"))) NOM_API int64_t
+nom_scan_set_ssse3(const uint8_t *p, int64_t n, const struct NomScanKey *k) {
+	__m128i low = _mm_loadu_si128((const __m128i *)(k->set.low));
+	__m128i high = _mm_loadu_si128((const __m128i *)(k->set.high));
+	__m128i bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8,
+				     16, 32, 64, -128);
+	int64_t i = 0, r;
+	uint64_t m;
+
+	for (; i + 64 <= n; i += 64) {
+		__m128i x0 = nom_scan_class16(
+			_mm_loadu_si128((const __m128i *)(p + i)), low, high,
+			bits);
+		__m128i x1 = nom_scan_class16(
+			_mm_loadu_si128((const __m128i *)(p + i + 16)), low,
+			high, bits);
+		__m128i x2 = nom_scan_class16(
+			_mm_loadu_si128((const __m128i *)(p + i + 32)), low,
+			high, bits);
+		__m128i x3 = nom_scan_class16(
+			_mm_loadu_si128((const __m128i *)(p + i + 48)), low,
+			high, bits);
+		__m128i any = _mm_or_si128(_mm_or_si128(x0, x1),
+					   _mm_or_si128(x2, x3));
+
+		if (nom_scan_nonzero16(any) != 0) {
+			m = nom_scan_nonzero16(x0) |
+			    nom_scan_nonzero16(x1) << 16 |
+			    nom_scan_nonzero16(x2) << 32 |
+			    nom_scan_nonzero16(x3) << 48;
+			return i + nom_ctz64(m);
+		}
+	}
+	for (; i + 16 <= n; i += 16) {
+		m = nom_scan_nonzero16(nom_scan_class16(
+			_mm_loadu_si128((const __m128i *)(p + i)), low, high,
+			bits));
+		if (m != 0) {
+			return i + nom_ctz64(m);
+		}
+	}
+	r = nom_scan_set_scalar(p + i, n - i, k);
+	return r < 0 ? -1 : i + r;
+}
+
+/* nom_scan_eq32 is nom_scan_eq16 for 32 bytes */
+__attribute__((target("avx2"))) NOM_API uint32_t
+nom_scan_eq32(const uint8_t *p, __m256i v) {
+	return (uint32_t)(_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+		_mm256_loadu_si256((const __m256i *)(p)), v)));
+}
+
+/* nom_scan_byte_avx2 is nom_scan_byte_sse2 with 32 byte vectors */
+__attribute__((target("avx2"))) NOM_API int64_t
+nom_scan_byte_avx2(const uint8_t *p, int64_t n, const struct NomScanKey *k) {
+	__m256i v = _mm256_set1_epi8((char)(k->c));
+	int64_t i = 0, r;
+	uint64_t m;
+
+	for (; i + 64 <= n; i += 64) {
+		__m256i e0 = _mm256_cmpeq_epi8(
+			_mm256_loadu_si256((const __m256i *)(p + i)), v);
+		__m256i e1 = _mm256_cmpeq_epi8(
+			_mm256_loadu_si256((const __m256i *)(p + i + 32)), v);
+		__m256i any = _mm256_or_si256(e0, e1);
+
+		if (!_mm256_testz_si256(any, any)) {
+			m = (uint64_t)((uint32_t)(_mm256_movemask_epi8(e0))) |
+			    (uint64_t)((uint32_t)(_mm256_movemask_epi8(e1)))
+				    << 32;
+			return i + nom_ctz64(m);
+		}
+	}
+	r = nom_scan_byte_sse2(p + i, n - i, k);
+	return r < 0 ? -1 : i + r;
+}
+
+/* nom_scan_pattern_avx2 is nom_scan_pattern_sse2 with 32 byte vectors */
+__attribute__((target("avx2"))) NOM_API int64_t
+nom_scan_pattern_avx2(const uint8_t *p, int64_t n,
+		      const struct NomScanKey *k) {
+	__m256i first = _mm256_set1_epi8((char)(k->pattern[0]));
+	__m256i last = _mm256_set1_epi8((char)(k->pattern[k->length - 1]));
+	int64_t i = 0, r;
+	uint32_t m;
+
+	for (; i + k->length - 1 + 32 <= n; i += 32) {
+		m = nom_scan_eq32(p + i, first) &
+		    nom_scan_eq32(p + i + k->length - 1, last);
+		while (m != 0) {
+			r = nom_ctz64(m);
+			if (memcmp(p + i + r + 1, k->pattern + 1,
+				   k->length - 2) == 0) {
+				return i + r;
+			}
+			m &= m - 1;
+		}
+	}
+	r = nom_scan_pattern_sse2(p + i, n - i, k);
+	return r < 0 ? -1 : i + r;
+}
+
+/* nom_scan_class32 is nom_scan_class16 for 32 bytes, whose pshufb looks up each 16 byte half in its own copy of the tables */
+__attribute__((target("avx2"))) NOM_API __m256i
+nom_scan_class32(__m256i v, __m256i low, __m256i high, __m256i bits) {
+	__m256i t = _mm256_or_si256(
+		_mm256_shuffle_epi8(low, v),
+		_mm256_shuffle_epi8(
+			high, _mm256_xor_si256(v, _mm256_set1_epi8(-128))));
+	__m256i h = _mm256_shuffle_epi8(
+		bits,
+		_mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(7)));
+
+	return _mm256_and_si256(t, h);
+}
+
+/* nom_scan_nonzero32 is nom_scan_nonzero16 for 32 bytes */
+__attribute__((target("avx2"))) NOM_API uint64_t
+nom_scan_nonzero32(__m256i v) {
+	return (uint64_t)(~(uint32_t)(_mm256_movemask_epi8(
+		_mm256_cmpeq_epi8(v, _mm256_setzero_si256()))));
+}
+
+/* nom_scan_set_avx2 is nom_scan_set_ssse3 with 32 byte vectors */
+__attribute__((target("avx2"))) NOM_API int64_t
+nom_scan_set_avx2(const uint8_t *p, int64_t n, const struct NomScanKey *k) {
+	__m256i low = _mm256_broadcastsi128_si256(
+		_mm_loadu_si128((const __m128i *)(k->set.low)));
+	__m256i high = _mm256_broadcastsi128_si256(
+		_mm_loadu_si128((const __m128i *)(k->set.high)));
+	__m256i bits = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+		1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128));
+	int64_t i = 0, r;
+	uint64_t m;
+
+	for (; i + 64 <= n; i += 64) {
+		__m256i x0 = nom_scan_class32(
+			_mm256_loadu_si256((const __m256i *)(p + i)), low,
+			high, bits);
+		__m256i x1 = nom_scan_class32(
+			_mm256_loadu_si256((const __m256i *)(p + i + 32)), low,
+			high, bits);
+		__m256i any = _mm256_or_si256(x0, x1);
+
+		if (!_mm256_testz_si256(any, any)) {
+			m = nom_scan_nonzero32(x0) |
+			    nom_scan_nonzero32(x1) << 32;
+			return i + nom_ctz64(m);
+		}
+	}
+	r = nom_scan_set_ssse3(p + i, n - i, k);
+	return r < 0 ? -1 : i + r;
+}
+
+/* nom_scan_all_avx2 is nom_scan_all_sse2 with 32 byte vectors */
+__attribute__((target("avx2"))) NOM_API int64_t
+nom_scan_all_avx2(const uint8_t *p, int64_t n, uint8_t c, int64_t *out,
+		  int64_t base, int64_t max) {
+	__m256i v = _mm256_set1_epi8((char)(c));
+	int64_t i = 0, k = 0;
+	uint64_t m;
+
+	for (; i + 64 <= n && k < max; i += 64) {
+		m = (uint64_t)(nom_scan_eq32(p + i, v)) |
+		    (uint64_t)(nom_scan_eq32(p + i + 32, v)) << 32;
+		k = nom_scan_store(m, out, k, base + i, max);
+	}
+	return k + nom_scan_all_sse2(p + i, n - i, c, out + k, base + i,
+				     max - k);
+}
+#endif
+
+/* the kinds of scan, which index the kernel tables */
+#define NOM_SCAN_BYTE 0
+#define NOM_SCAN_SET 1
+#define NOM_SCAN_PATTERN 2
+
+/* nom_scan_kernels picks the kernels nom is allowed to use for a kind of scan, narrow for the first NOM_SCAN_WIDE bytes and wide for the rest */
+NOM_API void nom_scan_kernels(int kind, NomScanKernel *narrow,
+			      NomScanKernel *wide) {
+	static const NomScanKernel scalar[3] = {nom_scan_byte_scalar,
+						nom_scan_set_scalar,
+						nom_scan_pattern_scalar};
+#if defined(NOM_X86) && defined(__SSE2__)
+	static const NomScanKernel sse[3] = {
+		nom_scan_byte_sse2, nom_scan_set_ssse3, nom_scan_pattern_sse2};
+	static const NomScanKernel avx2[3] = {
+		nom_scan_byte_avx2, nom_scan_set_avx2, nom_scan_pattern_avx2};
+	int f = nom_cpu_features();
+
+	/* the set kernels are the only ones that need more than sse2 */
+	*narrow = kind != NOM_SCAN_SET || (f & NOM_CPU_SSSE3) ? sse[kind]
+							      : scalar[kind];
+	*wide = (f & NOM_CPU_AVX2) ? avx2[kind] : *narrow;
+#else
+	*narrow = scalar[kind];
+	*wide = scalar[kind];
+#endif
+}
+
+/* nom_scan looks for k in the bytes of the buffer from off to its capacity, returning the offset of the first match or -1 */
+NOM_API int64_t nom_scan(struct NomBuffer *b, int64_t off, int kind,
+			 const struct NomScanKey *k) {
+	NomScanKernel narrow, wide;
+	int64_t n = b->cap - off, w, r;
+
+	/* a pattern can start in the last length - 1 bytes of the narrow part, so the wide part starts that much earlier, though never before off */
+	int64_t overlap = kind == NOM_SCAN_PATTERN ? k->length - 1 : 0;
+
+	if (off < 0 || n <= 0) {
+		return -1;
+	}
+	nom_scan_kernels(kind, &narrow, &wide);
+	w = n < NOM_SCAN_WIDE ? n : NOM_SCAN_WIDE;
+	r = narrow(b->buf + off, w, k);
+	if (r >= 0 || w == n) {
+		NOM_STAT_ACCESS(NOM_TRACE_READ, b, off, r < 0 ? n : r + 1, 1);
+		return r < 0 ? -1 : off + r;
+	}
+	w = w > overlap ? w - overlap : 0;
+	r = wide(b->buf + off + w, n - w, k);
+	NOM_STAT_ACCESS(NOM_TRACE_READ, b, off, r < 0 ? n : w + r + 1, 1);
+	return r < 0 ? -1 : off + w + r;
+}
+
+/* nom_scan_next moves the buffer's offset to the match at r if there is one, and returns r */
+NOM_API int64_t nom_scan_next(struct NomBuffer *b, int64_t r) {
+	if (r >= 0) {
+		nom_buffer_advance(b, r - b->off);
+	}
+	return r;
+}
+
+/* nom_buffer_findbyte returns the offset of the first c at or after the specified offset, or -1 if there isn't one before the buffer's capacity (a stream's window isn't refilled) */
+NOM_API int64_t nom_buffer_findbyte(struct NomBuffer *b, int64_t off,
+				    uint8_t c) {
+	struct NomScanKey k;
+
+	k.c = c;
+	return nom_scan(b, off, NOM_SCAN_BYTE, &k);
+}
+
+/* nom_buffer_findbytenext returns the offset of the first c at or after the current offset and moves the offset to it, or returns -1 and leaves the offset alone if there isn't one */
+NOM_API int64_t nom_buffer_findbytenext(struct NomBuffer *b, uint8_t c) {
+	return nom_scan_next(b, nom_buffer_findbyte(b, b->off, c));
+}
+
+/* nom_buffer_findany returns the offset of the first byte at or after the specified offset that is one of the set_length bytes at set, or -1 if there isn't one */
+NOM_API int64_t nom_buffer_findany(struct NomBuffer *b, int64_t off,
+				   int64_t set_length, const uint8_t *set) {
+	struct NomScanKey k;
+
+	nom_scan_set(&k.set, set, set_length);
+	return nom_scan(b, off, NOM_SCAN_SET, &k);
+}
+
+/* nom_buffer_findanynext returns the offset of the first byte at or after the current offset that is one of the set_length bytes at set and moves the offset to it, or returns -1 and leaves the offset alone if there isn't one */
+NOM_API int64_t nom_buffer_findanynext(struct NomBuffer *b, int64_t set_length,
+				       const uint8_t *set) {
+	return nom_scan_next(b, nom_buffer_findany(b, b->off, set_length, set));
+}
+
+/* nom_buffer_findpattern returns the offset of the first occurrence of the pattern_length bytes at pattern that starts at or after the specified offset, or -1 if there isn't one */
+NOM_API int64_t nom_buffer_findpattern(struct NomBuffer *b, int64_t off,
+				       int64_t pattern_length,
+				       const uint8_t *pattern) {
+	struct NomScanKey k;
+
+	if (pattern_length <= 1) {
+		if (pattern_length <= 0) {
+			return off >= 0 && off <= b->cap ? off : -1;
+		}
+		return nom_buffer_findbyte(b, off, pattern[0]);
+	}
+	k.pattern = pattern;
+	k.length = pattern_length;
+	return nom_scan(b, off, NOM_SCAN_PATTERN, &k);
+}
+
+/* nom_buffer_findpatternnext returns the offset of the first occurrence of the pattern_length bytes at pattern that starts at or after the current offset and moves the offset to it, or returns -1 and leaves the offset alone if there isn't one */
+NOM_API int64_t nom_buffer_findpatternnext(struct NomBuffer *b,
+					   int64_t pattern_length,
+					   const uint8_t *pattern) {
+	return nom_scan_next(
+		b, nom_buffer_findpattern(b, b->off, pattern_length, pattern));
+}
+
+/* nom_buffer_findall stores the offset of every c in the n bytes at off to out, in order, stopping once max are stored, and returns how many were */
+NOM_API int64_t nom_buffer_findall(struct NomBuffer *b, int64_t *out,
+				   int64_t off, int64_t n, uint8_t c,
+				   int64_t max) {
+#if defined(NOM_X86) && defined(__SSE2__)
+	int64_t w = n < NOM_SCAN_WIDE ? n : NOM_SCAN_WIDE, k;
+#endif
+
+	if (n <= 0 || max <= 0) {
+		return 0;
+	}
+	NOM_STAT_ACCESS(NOM_TRACE_READ, b, off, n, 1);
+#if defined(NOM_X86) && defined(__SSE2__)
+	k = nom_scan_all_sse2(b->buf + off, w, c, out, off, max);
+	if (k == max || w == n) {
+		return k;
+	}
+	if (nom_cpu_features() & NOM_CPU_AVX2) {
+		return k + nom_scan_all_avx2(b->buf + off + w, n - w, c,
+					     out + k, off + w, max - k);
+	}
+	return k + nom_scan_all_sse2(b->buf + off + w, n - w, c, out + k,
+				     off + w, max - k);
+#else
+	return nom_scan_all_scalar(b->buf + off, n, c, out, off, max);
+#endif
+}
+
+#endif
@@ -0,0 +1,345 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+#ifndef NOM_NOM_SCHEMA_H
+#define NOM_NOM_SCHEMA_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "nom.h"
+
+/*
+
+a schema is a list of fields, given as a macro that applies its argument to each (kind, name) pair:
+
+	#define POINT_FIELDS(F) F(u32le, x) F(u16be, y) F(varu64, id) F(bytes, label)
+
+	NOM_SCHEMA_STRUCT(Point, POINT_FIELDS)
+	NOM_SCHEMA(Point, POINT_FIELDS)
+
+which declares struct Point and defines nom_encode_Point, nom_decode_Point and nom_size_Point. the fixed kinds are
+u8, u16le, u16be, u32le, u32be, u64le and u64be. the variable kinds are varu32, varu64, vari32 and vari64, which are
+leb128 and zigzag varints, and bytes, which is a varint length followed by that many bytes and is stored as name_length
+and name. fixed fields are stored straight to the buffer with a single capacity check for each run of them, while
+variable fields go through the regular buffer functions. name points into the buffer rather than at a copy, so a schema
+with bytes fields can't be decoded from a stream, whose window the fields after it could refill
+
+*/
+
+#if NOM_BIG_ENDIAN
+#define NOM_SCHEMA_LE(bits, v) nom_bswap##bits(v)
+#define NOM_SCHEMA_BE(bits, v) (v)
+#else
+#define NOM_SCHEMA_LE(bits, v) (v)
+#define NOM_SCHEMA_BE(bits, v) nom_bswap##bits(v)
+#endif
+
+/* defines unaligned loads and stores of a fixed kind, which are what encoders and decoders use for fixed fields */
+#define NOM_SCHEMA_ACCESSORS(kind, type, bits, order)                          \
+	NOM_API NOM_ALWAYS_INLINE void nom_schema_store_##kind(uint8_t *p,     \
+							       type v) {       \
+		v = order(bits, v);                                            \
+		memcpy(p, &v, sizeof(type));                                   \
+	}                                                                      \
+	NOM_API NOM_ALWAYS_INLINE type nom_schema_load_##kind(                 \
+		const uint8_t *p) {                                            \
+		type v;                                                        \
+		memcpy(&v, p, sizeof(type));                                   \
+		return order(bits, v);                                         \
+	}
+
+#define NOM_SCHEMA_SAME(bits, v) (v)
+
+NOM_SCHEMA_ACCESSORS(u8, uint8_t, 8, NOM_SCHEMA_SAME)
+NOM_SCHEMA_ACCESSORS(u16le, uint16_t, 16, NOM_SCHEMA_LE)
+NOM_SCHEMA_ACCESSORS(u16be, uint16_t, 16, NOM_SCHEMA_BE)
+NOM_SCHEMA_ACCESSORS(u32le, uint32_t, 32, NOM_SCHEMA_LE)
+NOM_SCHEMA_ACCESSORS(u32be, uint32_t, 32, NOM_SCHEMA_BE)
+NOM_SCHEMA_ACCESSORS(u64le, uint64_t, 64, NOM_SCHEMA_LE)
+NOM_SCHEMA_ACCESSORS(u64be, uint64_t, 64, NOM_SCHEMA_BE)
+
+/* nom_schema_room makes sure n bytes can be written (writing = 1) or read (writing = 0) at the current offset, growing or unsharing the buffer or flushing or refilling a stream's window, and returns -1 if they can't */
+NOM_API int nom_schema_room(struct NomBuffer *b, int64_t n, int writing) {
+	if (writing && NOM_COW(b) != 0) {
+		return -1;
+	}
+	if (b->cap - b->off >= n) {
+		return 0;
+	}
+	if (b->stream == NULL) {
+		return writing ? nom_buffer_ensure(b, b->off + n) : -1;
+	}
+	if (writing) {
+		if (nom_buffer_flush(b) != 0) {
+			return -1;
+		}
+		return b->cap - b->off >= n ? 0 : -1;
+	}
+	return nom_buffer_refill(b, n);
+}
+
+/* nom_schema_putvar writes one integer of the given type as a varint at the current offset, making room for it and the rest bytes of fixed fields after it, and returns -1 if that fails */
+NOM_API int nom_schema_putvar(struct NomBuffer *b, const void *v, int type,
+			      int64_t rest) {
+	uint64_t u;
+	int64_t used;
+
+	if (b->stream != NULL) {
+		if (nom_schema_room(b, 10, 1) != 0) {
+			return -1;
+		}
+		nom_varint_writenext(b, v, 1, type);
+		return nom_schema_room(b, rest, 1);
+	}
+
+	/* a buffer is only grown by the bytes the varint takes up, since growing it by the 10 a varint can take would leave unwritten bytes at its end */
+	nom_varint_widen(&u, v, 1, type);
+	used = nom_varint_size(u);
+	if (nom_schema_room(b, used + rest, 1) != 0) {
+		return -1;
+	}
+	nom_varint_encode(b->buf + b->off, &u, 1);
+	NOM_STAT_ACCESS(NOM_TRACE_WRITE, b, b->off, used, 1);
+	nom_buffer_advance(b, used);
+	return 0;
+}
+
+/* nom_schema_getvar reads one varint of the given type at the current offset, making sure the rest bytes of fixed fields after it are there, and returns -1 if that fails */
+NOM_API int nom_schema_getvar(struct NomBuffer *b, void *out, int type,
+			      int64_t rest) {
+	if (nom_varint_readnext(b, out, 1, type) != 0) {
+		return -1;
+	}
+	return nom_schema_room(b, rest, 0);
+}
+
+/* nom_schema_putbytes writes a varint length followed by a byte array at the current offset, making room for it and the rest bytes of fixed fields after it, and returns -1 if that fails */
+NOM_API int nom_schema_putbytes(struct NomBuffer *b, int64_t data_length,
+				const uint8_t *data, int64_t rest) {
+	uint64_t n = (uint64_t)(data_length);
+
+	if (b->stream == NULL &&
+	    nom_buffer_ensure(b, b->off + nom_varint_size(n) + data_length +
+					 rest) != 0) {
+		return -1;
+	}
+	if (nom_schema_putvar(b, &n, NOM_VARINT_U64, 0) != 0) {
+		return -1;
+	}
+	nom_buffer_writebytesnext(b, data_length, (uint8_t *)(data));
+	if (b->stream != NULL && b->stream->err) {
+		return -1;
+	}
+	return nom_schema_room(b, rest, 1);
+}
+
+/* nom_schema_getbytes reads a varint length at the current offset and points out at that many bytes after it, which stay valid until the buffer is written to or resized, and returns -1 if they or the rest bytes of fixed fields after them aren't there or the buffer is a stream */
+NOM_API int nom_schema_getbytes(struct NomBuffer *b, int64_t *out_length,
+				uint8_t **out, int64_t rest) {
+	uint64_t n;
+
+	/* the bytes would be in the stream's window, which reading the fields after them can refill */
+	if (b->stream != NULL ||
+	    nom_varint_readnext(b, &n, 1, NOM_VARINT_U64) != 0 ||
+	    n > (uint64_t)(INT64_MAX - rest) ||
+	    nom_schema_room(b, (int64_t)(n) + rest, 0) != 0) {
+		return -1;
+	}
+	*out_length = (int64_t)(n);
+	*out = b->buf + b->off;
+	nom_buffer_advance(b, (int64_t)(n));
+	return 0;
+}
+
+/* the type, fixed size and varint type of each kind of field */
+#define NOM_SCHEMA_TYPE_u8 uint8_t
+#define NOM_SCHEMA_TYPE_u16le uint16_t
+#define NOM_SCHEMA_TYPE_u16be uint16_t
+#define NOM_SCHEMA_TYPE_u32le uint32_t
+#define NOM_SCHEMA_TYPE_u32be uint32_t
+#define NOM_SCHEMA_TYPE_u64le uint64_t
+#define NOM_SCHEMA_TYPE_u64be uint64_t
+#define NOM_SCHEMA_TYPE_varu32 uint32_t
+#define NOM_SCHEMA_TYPE_varu64 uint64_t
+#define NOM_SCHEMA_TYPE_vari32 int32_t
+#define NOM_SCHEMA_TYPE_vari64 int64_t
+
+#define NOM_SCHEMA_SIZE_u8 1
+#define NOM_SCHEMA_SIZE_u16le 2
+#define NOM_SCHEMA_SIZE_u16be 2
+#define NOM_SCHEMA_SIZE_u32le 4
+#define NOM_SCHEMA_SIZE_u32be 4
+#define NOM_SCHEMA_SIZE_u64le 8
+#define NOM_SCHEMA_SIZE_u64be 8
+#define NOM_SCHEMA_SIZE_varu32 0
+#define NOM_SCHEMA_SIZE_varu64 0
+#define NOM_SCHEMA_SIZE_vari32 0
+#define NOM_SCHEMA_SIZE_vari64 0
+#define NOM_SCHEMA_SIZE_bytes 0
+
+#define NOM_SCHEMA_VARINT_varu32 NOM_VARINT_U32
+#define NOM_SCHEMA_VARINT_varu64 NOM_VARINT_U64
+#define NOM_SCHEMA_VARINT_vari32 NOM_VARINT_I32
+#define NOM_SCHEMA_VARINT_vari64 NOM_VARINT_I64
+
+/* struct members */
+#define NOM_SCHEMA_MEMBER(kind, name) NOM_SCHEMA_MEMBER_##kind(kind, name)
+#define NOM_SCHEMA_MEMBER_SCALAR(kind, name) NOM_SCHEMA_TYPE_##kind name;
+#define NOM_SCHEMA_MEMBER_u8 NOM_SCHEMA_MEMBER_SCALAR
+#define NOM_SCHEMA_MEMBER_u16le NOM_SCHEMA_MEMBER_SCALAR
+#define NOM_SCHEMA_MEMBER_u16be NOM_SCHEMA_MEMBER_SCALAR
+#define NOM_SCHEMA_MEMBER_u32le NOM_SCHEMA_MEMBER_SCALAR
+#define NOM_SCHEMA_MEMBER_u32be NOM_SCHEMA_MEMBER_SCALAR
+#define NOM_SCHEMA_MEMBER_u64le NOM_SCHEMA_MEMBER_SCALAR
+#define NOM_SCHEMA_MEMBER_u64be NOM_SCHEMA_MEMBER_SCALAR
+#define NOM_SCHEMA_MEMBER_varu32 NOM_SCHEMA_MEMBER_SCALAR
+#define NOM_SCHEMA_MEMBER_varu64 NOM_SCHEMA_MEMBER_SCALAR
+#define NOM_SCHEMA_MEMBER_vari32 NOM_SCHEMA_MEMBER_SCALAR
+#define NOM_SCHEMA_MEMBER_vari64 NOM_SCHEMA_MEMBER_SCALAR
+#define NOM_SCHEMA_MEMBER_bytes(kind, name)                                    \
+	int64_t name##_length;                                                 \
+	uint8_t *name;
+
+/* the sum of the fixed fields' sizes */
+#define NOM_SCHEMA_FIXED(kind, name) +NOM_SCHEMA_SIZE_##kind
+
+/* encoding steps, where p is where the next fixed field goes and rest is how many bytes of fixed fields are left */
+#define NOM_SCHEMA_ENCODE(kind, name) NOM_SCHEMA_ENCODE_##kind(kind, name)
+#define NOM_SCHEMA_ENCODE_FIXED(kind, name)                                    \
+	nom_schema_store_##kind(p, s->name);                                   \
+	p += NOM_SCHEMA_SIZE_##kind;                                           \
+	rest -= NOM_SCHEMA_SIZE_##kind;
+#define NOM_SCHEMA_ENCODE_VARINT(kind, name)                                   \
+	nom_buffer_advance(b, p - (b->buf + b->off));                          \
+	if (nom_schema_putvar(b, &s->name, NOM_SCHEMA_VARINT_##kind, rest) !=  \
+	    0) {                                                               \
+		return -1;                                                     \
+	}                                                                      \
+	p = b->buf + b->off;
+#define NOM_SCHEMA_ENCODE_bytes(kind, name)                                    \
+	nom_buffer_advance(b, p - (b->buf + b->off));                          \
+	if (nom_schema_putbytes(b, s->name##_length, s->name, rest) != 0) {    \
+		return -1;                                                     \
+	}                                                                      \
+	p = b->buf + b->off;
+#define NOM_SCHEMA_ENCODE_u8 NOM_SCHEMA_ENCODE_FIXED
+#define NOM_SCHEMA_ENCODE_u16le NOM_SCHEMA_ENCODE_FIXED
+#define NOM_SCHEMA_ENCODE_u16be NOM_SCHEMA_ENCODE_FIXED
+#define NOM_SCHEMA_ENCODE_u32le NOM_SCHEMA_ENCODE_FIXED
+#define NOM_SCHEMA_ENCODE_u32be NOM_SCHEMA_ENCODE_FIXED
+#define NOM_SCHEMA_ENCODE_u64le NOM_SCHEMA_ENCODE_FIXED
+#define NOM_SCHEMA_ENCODE_u64be NOM_SCHEMA_ENCODE_FIXED
+#define NOM_SCHEMA_ENCODE_varu32 NOM_SCHEMA_ENCODE_VARINT
+#define NOM_SCHEMA_ENCODE_varu64 NOM_SCHEMA_ENCODE_VARINT
+#define NOM_SCHEMA_ENCODE_vari32 NOM_SCHEMA_ENCODE_VARINT
+#define NOM_SCHEMA_ENCODE_vari64 NOM_SCHEMA_ENCODE_VARINT
+
+/* decoding steps, mirroring the encoding ones */
+#define NOM_SCHEMA_DECODE(kind, name) NOM_SCHEMA_DECODE_##kind(kind, name)
+#define NOM_SCHEMA_DECODE_FIXED(kind, name)                                    \
+	s->name = nom_schema_load_##kind(p);                                   \
+	p += NOM_SCHEMA_SIZE_##kind;                                           \
+	rest -= NOM_SCHEMA_SIZE_##kind;
+#define NOM_SCHEMA_DECODE_VARINT(kind, name)                                   \
+	nom_buffer_advance(b, p - (b->buf + b->off));                          \
+	if (nom_schema_getvar(b, &s->name, NOM_SCHEMA_VARINT_##kind, rest) !=  \
+	    0) {                                                               \
+		return -1;                                                     \
+	}                                                                      \
+	p = b->buf + b->off;
+#define NOM_SCHEMA_DECODE_bytes(kind, name)                                    \
+	nom_buffer_advance(b, p - (b->buf + b->off));                          \
+	if (nom_schema_getbytes(b, &s->name##_length, &s->name, rest) != 0) {  \
+		return -1;                                                     \
+	}                                                                      \
+	p = b->buf + b->off;
+#define NOM_SCHEMA_DECODE_u8 NOM_SCHEMA_DECODE_FIXED
+#define NOM_SCHEMA_DECODE_u16le NOM_SCHEMA_DECODE_FIXED
+#define NOM_SCHEMA_DECODE_u16be NOM_SCHEMA_DECODE_FIXED
+#define NOM_SCHEMA_DECODE_u32le NOM_SCHEMA_DECODE_FIXED
+#define NOM_SCHEMA_DECODE_u32be NOM_SCHEMA_DECODE_FIXED
+#define NOM_SCHEMA_DECODE_u64le NOM_SCHEMA_DECODE_FIXED
+#define NOM_SCHEMA_DECODE_u64be NOM_SCHEMA_DECODE_FIXED
+#define NOM_SCHEMA_DECODE_varu32 NOM_SCHEMA_DECODE_VARINT
+#define NOM_SCHEMA_DECODE_varu64 NOM_SCHEMA_DECODE_VARINT
+#define NOM_SCHEMA_DECODE_vari32 NOM_SCHEMA_DECODE_VARINT
+#define NOM_SCHEMA_DECODE_vari64 NOM_SCHEMA_DECODE_VARINT
+
+/* the encoded size of variable fields */
+#define NOM_SCHEMA_VARSIZE(kind, name) NOM_SCHEMA_VARSIZE_##kind(kind, name)
+#define NOM_SCHEMA_VARSIZE_NONE(kind, name)
+#define NOM_SCHEMA_VARSIZE_UNSIGNED(kind, name)                                \
+	size += nom_varint_size(s->name);
+#define NOM_SCHEMA_VARSIZE_SIGNED(kind, name)                                  \
+	size += nom_varint_size(((uint64_t)(s->name) << 1) ^                   \
+				(uint64_t)((int64_t)(s->name) >> 63));
+#define NOM_SCHEMA_VARSIZE_bytes(kind, name)                                   \
+	size += nom_varint_size((uint64_t)(s->name##_length)) +                \
+		s->name##_length;
+#define NOM_SCHEMA_VARSIZE_u8 NOM_SCHEMA_VARSIZE_NONE
+#define NOM_SCHEMA_VARSIZE_u16le NOM_SCHEMA_VARSIZE_NONE
+#define NOM_SCHEMA_VARSIZE_u16be NOM_SCHEMA_VARSIZE_NONE
+#define NOM_SCHEMA_VARSIZE_u32le NOM_SCHEMA_VARSIZE_NONE
+#define NOM_SCHEMA_VARSIZE_u32be NOM_SCHEMA_VARSIZE_NONE
+#define NOM_SCHEMA_VARSIZE_u64le NOM_SCHEMA_VARSIZE_NONE
+#define NOM_SCHEMA_VARSIZE_u64be NOM_SCHEMA_VARSIZE_NONE
+#define NOM_SCHEMA_VARSIZE_varu32 NOM_SCHEMA_VARSIZE_UNSIGNED
+#define NOM_SCHEMA_VARSIZE_varu64 NOM_SCHEMA_VARSIZE_UNSIGNED
+#define NOM_SCHEMA_VARSIZE_vari32 NOM_SCHEMA_VARSIZE_SIGNED
+#define NOM_SCHEMA_VARSIZE_vari64 NOM_SCHEMA_VARSIZE_SIGNED
+
+/* NOM_SCHEMA_STRUCT declares a struct with a member for each field of a schema */
+#define NOM_SCHEMA_STRUCT(name, fields)                                        \
+	typedef struct name {                                                  \
+		fields(NOM_SCHEMA_MEMBER)                                      \
+	} name;
+
+/* NOM_SCHEMA defines nom_encode_<name>, which writes a struct at the current offset, growing the buffer if needed, and nom_decode_<name>, which reads one, both moving the offset past it and returning -1 on failure, and nom_size_<name>, which returns a struct's encoded size, linked like the rest of nom's functions so a schema can be defined in a header */
+#define NOM_SCHEMA(name, fields)                                               \
+	NOM_API int nom_encode_##name(struct NomBuffer *b,                     \
+				      const struct name *s) {                  \
+		int64_t rest = 0 fields(NOM_SCHEMA_FIXED);                     \
+		uint8_t *p;                                                    \
+                                                                               \
+		if (nom_schema_room(b, rest, 1) != 0) {                        \
+			return -1;                                             \
+		}                                                              \
+		p = b->buf + b->off;                                           \
+		fields(NOM_SCHEMA_ENCODE)                                      \
+		nom_buffer_advance(b, p - (b->buf + b->off));                  \
+		(void)(rest);                                                  \
+		return 0;                                                      \
+	}                                                                      \
+                                                                               \
+	NOM_API int nom_decode_##name(struct NomBuffer *b, struct name *s) {   \
+		int64_t rest = 0 fields(NOM_SCHEMA_FIXED);                     \
+		const uint8_t *p;                                              \
+                                                                               \
+		if (nom_schema_room(b, rest, 0) != 0) {                        \
+			return -1;                                             \
+		}                                                              \
+		p = b->buf + b->off;                                           \
+		fields(NOM_SCHEMA_DECODE)                                      \
+		nom_buffer_advance(b, p - (b->buf + b->off));                  \
+		(void)(rest);                                                  \
+		return 0;                                                      \
+	}                                                                      \
+                                                                               \
+	NOM_API int64_t nom_size_##name(const struct name *s) {                \
+		int64_t size = 0 fields(NOM_SCHEMA_FIXED);                     \
+                                                                               \
+		(void)(s);                                                     \
+		fields(NOM_SCHEMA_VARSIZE)                                     \
+		return size;                                                   \
+	}
+
+#endif
@@ -0,0 +1,160 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+#define _GNU_SOURCE
+#include "test.h"
+
+#include "../nom_aio.h"
+
+static char path[32];
+static int64_t callbacks;
+
+static void count(void *ctx, struct NomBuffer *b, int64_t pos, int64_t res) {
+	(void)(ctx);
+	(void)(b);
+	(void)(pos);
+	(void)(res);
+	callbacks++;
+}
+
+/* check_roundtrip writes total u32s counting up from 0 through a NomAio in pieces of varying size and reads them back, returning -1 if the file can't be opened with flags */
+static int check_roundtrip(int flags, int64_t total, int64_t block) {
+	struct NomAio a;
+	struct NomBuffer *b;
+	struct stat st;
+	int64_t i = 0, n, k;
+	uint32_t v[37], x = 0;
+	int fd;
+
+	if (nom_aio_openfile(&a, path, flags | NOM_AIO_WRITE, block) != 0) {
+		return -1;
+	}
+	callbacks = 0;
+	nom_aio_setcallback(&a, count, NULL);
+	b = nom_aio_buffer(&a);
+	while (i < total) {
+		n = 1 + i % 37 < total - i ? 1 + i % 37 : total - i;
+		for (k = 0; k < n; k++) {
+			v[k] = (uint32_t)(i + k);
+		}
+		if (b->cap - b->off < n * 4) {
+			b = nom_aio_swap(&a);
+			CHECK(b != NULL && b->cap - b->off >= n * 4);
+			if (b == NULL) {
+				break;
+			}
+		}
+		nom_buffer_writeu32lenext(b, n, v);
+		i += n;
+	}
+	fd = a.fd;
+	CHECK(nom_aio_finish(&a) == 0);
+	CHECK(lseek(fd, 0, SEEK_CUR) == total * 4);
+	CHECK(fstat(fd, &st) == 0 && st.st_size == total * 4);
+	CHECK(total == 0 || callbacks > 0);
+	close(fd);
+
+	CHECK(nom_aio_openfile(&a, path, flags, block) == 0);
+	b = nom_aio_buffer(&a);
+	CHECK(b->cap == 0);
+	for (i = 0;; i++) {
+		if (b->off == b->cap) {
+			b = nom_aio_swap(&a);
+			CHECK(b != NULL);
+			if (b == NULL || b->cap == 0) {
+				break;
+			}
+		}
+		nom_buffer_readu32lenext(b, &x, 1);
+		if (x != (uint32_t)(i)) {
+			CHECK(x == (uint32_t)(i));
+			break;
+		}
+	}
+	CHECK(i == total);
+	fd = a.fd;
+	CHECK(nom_aio_finish(&a) == 0);
+	CHECK(lseek(fd, 0, SEEK_CUR) == total * 4);
+	close(fd);
+	return 0;
+}
+
+int main(void) {
+	static const int64_t totals[][2] = {
+		{0, 4096},	{1, 4096},	   {1000, 4096},
+		{1024, 4096},	{100003, 8192},	   {1 << 20, 1 << 16},
+		{3 << 20, 100000}};
+	struct NomAio a;
+	unsigned tail;
+	int f, i, fd, ring;
+
+	fd = nom_test_tmpfile(path);
+	CHECK(fd >= 0);
+	close(fd);
+
+	/* io_uring and the blocking fallback, with and without O_DIRECT, which not every filesystem has */
+	for (f = 0; f < 8; f += 2) {
+		for (i = 0; i < 7; i++) {
+			if (check_roundtrip(f, totals[i][0], totals[i][1]) !=
+			    0) {
+				CHECK(f & NOM_AIO_DIRECT);
+				break;
+			}
+		}
+	}
+
+	/* a first read that fails, like one of a directory, fails nom_aio_new */
+	fd = open("/tmp", O_RDONLY);
+	CHECK(fd >= 0);
+	CHECK(nom_aio_new(&a, fd, NOM_AIO_BLOCKING, 4096) == -1 &&
+	      a.err == EISDIR);
+	close(fd);
+
+	/* polling until the first block is in */
+	CHECK(nom_aio_openfile(&a, path, 0, 1 << 16) == 0);
+	while (!nom_aio_poll(&a)) {
+	}
+	CHECK(nom_aio_swap(&a)->cap == 1 << 16);
+	fd = a.fd;
+	CHECK(nom_aio_finish(&a) == 0);
+	close(fd);
+
+#ifdef NOM_URING
+	/* a transfer the kernel won't take is taken back out of the ring and fails, instead of being waited for */
+	CHECK(nom_aio_openfile(&a, path, 0, 4096) == 0);
+	ring = a.ring;
+	if (ring >= 0) {
+		CHECK(nom_aio_wait(&a, 0) == 0);
+		tail = *a.sqtail;
+		a.ring = open("/dev/null", O_RDONLY);
+		CHECK(nom_aio_swap(&a) != NULL);
+		CHECK(*a.sqtail == tail && a.err != 0);
+		CHECK(nom_aio_swap(&a) == NULL);
+		close(a.ring);
+		a.ring = ring;
+	}
+	fd = a.fd;
+	CHECK(nom_aio_finish(&a) == (ring >= 0 ? -1 : 0));
+	close(fd);
+#endif
+
+	/* writes to a descriptor that isn't open for writing fail */
+	fd = open(path, O_RDONLY);
+	CHECK(nom_aio_new(&a, fd, NOM_AIO_WRITE, 4096) == 0);
+	nom_aio_buffer(&a)->off = 4096;
+	nom_aio_swap(&a);
+	nom_aio_swap(&a);
+	CHECK(nom_aio_finish(&a) == -1 && a.err == EBADF);
+	close(fd);
+
+	unlink(path);
+	return nom_test_done("aio");
+}
@@ -0,0 +1,113 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+#include "test.h"
+
+#include <pthread.h>
+
+#include "../nom_append.h"
+
+#define THREADS 4
+#define PER_THREAD 20000
+
+static struct NomAppender appender;
+
+/* writer appends regions of 8 to 24 bytes holding its id and the region's length */
+static void *writer(void *arg) {
+	uint32_t id = (uint32_t)((uintptr_t)(arg)), i, w[6];
+	struct NomRegion r;
+	int64_t n;
+
+	for (i = 0; i < PER_THREAD; i++) {
+		n = 8 + (i % 5) * 4;
+		if (nom_appender_reserve(&appender, n, &r) == 0) {
+			w[0] = id;
+			w[1] = (uint32_t)(n);
+			w[2] = w[3] = w[4] = w[5] = i;
+			nom_buffer_writeu32le(appender.b, r.off, n / 4, w);
+		}
+		nom_appender_commit(&appender, &r);
+	}
+	return NULL;
+}
+
+int main(void) {
+	struct NomBuffer b, c;
+	struct NomRegion r1, r2, r3;
+	pthread_t t[THREADS];
+	int64_t s, e, pos = 3, regions = 0;
+	uint32_t n;
+	int i;
+
+	/* every region shows up to the reader exactly once and in one piece */
+	nom_buffer_new(&b, THREADS * PER_THREAD * 24 + 100);
+	b.off = 3;
+	CHECK(nom_appender_new(&appender, &b) == 0);
+	for (i = 0; i < THREADS; i++) {
+		pthread_create(&t[i], NULL, writer, (void *)((uintptr_t)(i)));
+	}
+	while (regions < (int64_t)(THREADS) * PER_THREAD) {
+		if (!nom_appender_poll(&appender, &s, &e)) {
+			continue;
+		}
+		CHECK(s == pos);
+		while (pos < e) {
+			nom_buffer_readu32le(&b, &n, pos + 4, 1);
+			if (n < 8 || n > 24) {
+				CHECK(n >= 8 && n <= 24);
+				pos = e;
+				regions = (int64_t)(THREADS) * PER_THREAD;
+				break;
+			}
+			pos += n;
+			regions++;
+		}
+		CHECK(pos == e);
+	}
+	for (i = 0; i < THREADS; i++) {
+		pthread_join(t[i], NULL);
+	}
+	nom_appender_finish(&appender);
+	CHECK(b.off == pos);
+	nom_buffer_release(&b);
+
+	/* regions that don't fit are committed without being published, and don't hold up the sequence */
+	nom_buffer_new(&c, 20);
+	CHECK(nom_appender_new(&appender, &c) == 0);
+	CHECK(nom_appender_reserve(&appender, 8, &r1) == 0);
+	CHECK(nom_appender_reserve(&appender, 16, &r2) == -1);
+	CHECK(nom_appender_reserve(&appender, 1, &r3) == -1);
+	nom_appender_commit(&appender, &r3);
+	nom_appender_commit(&appender, &r2);
+	CHECK(!nom_appender_poll(&appender, &s, &e));
+	nom_appender_commit(&appender, &r1);
+	CHECK(nom_appender_poll(&appender, &s, &e) && s == 0 && e == 8);
+
+	/* the slot ring wraps */
+	for (i = 0; i < 70000; i++) {
+		nom_appender_reserve(&appender, 0, &r1);
+		nom_appender_commit(&appender, &r1);
+	}
+	nom_appender_finish(&appender);
+	CHECK(c.off == 8);
+
+	/* a region committed without being published, as when its committer and the one before it miss each other's stores, is published by the next poll */
+	CHECK(nom_appender_new(&appender, &c) == 0);
+	CHECK(nom_appender_reserve(&appender, 4, &r1) == 0);
+	atomic_store_explicit(&appender.slots[r1.seq % NOM_APPEND_SLOTS].end,
+			      (int64_t)(12), memory_order_relaxed);
+	atomic_store_explicit(&appender.slots[r1.seq % NOM_APPEND_SLOTS].tag,
+			      r1.seq + 1, memory_order_seq_cst);
+	CHECK(nom_appender_poll(&appender, &s, &e) && s == 8 && e == 12);
+	nom_buffer_release(&c);
+
+	return nom_test_done("append");
+}
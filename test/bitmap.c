@@ -0,0 +1,151 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+#include "test.h"
+
+#include "../nom_bitmap.h"
+
+static int bit(struct NomBuffer *b, int64_t i) {
+	uint8_t o;
+
+	nom_buffer_readbit(b, &o, i);
+	return o;
+}
+
+/* check_trial runs every bitmap operation over random bits and compares it to doing the same a bit at a time */
+static void check_trial(int trial) {
+	int64_t cap = 1 + (int64_t)(nom_test_rand() % 300), off, n, i, m;
+	int64_t pc = 0, fs = -1, fc = -1, rk = 0;
+	struct NomBuffer b, r, s;
+	struct NomRankIndex ri;
+	uint8_t x, y;
+	int op;
+
+	nom_buffer_new(&b, cap);
+	nom_buffer_new(&r, cap);
+	nom_buffer_new(&s, 1 + (int64_t)(nom_test_rand() % 300));
+	nom_test_fill(b.buf, cap);
+	if (trial % 3 == 0) {
+		memset(b.buf, trial % 2 ? 0xff : 0, cap);
+	}
+	memcpy(r.buf, b.buf, cap);
+	for (i = 0; i < s.cap; i++) {
+		s.buf[i] = (uint8_t)(nom_test_rand());
+		if (nom_test_rand() % 4 == 0) {
+			s.buf[i] = 0;
+		}
+	}
+
+	off = (int64_t)(nom_test_rand() % (cap * 8));
+	n = (int64_t)(nom_test_rand() % (cap * 8 - off + 1));
+	op = (int)(nom_test_rand() % 3);
+	if (op == 0) {
+		nom_buffer_setbitrange(&b, off, n);
+
+	} else if (op == 1) {
+		nom_buffer_clearbitrange(&b, off, n);
+
+	} else {
+		nom_buffer_flipbitrange(&b, off, n);
+	}
+	for (i = off; i < off + n; i++) {
+		if (op == 0) {
+			nom_buffer_setbit(&r, i);
+
+		} else if (op == 1) {
+			nom_buffer_clearbit(&r, i);
+
+		} else {
+			nom_buffer_flipbit(&r, i);
+		}
+	}
+	CHECK(memcmp(b.buf, r.buf, cap) == 0);
+
+	off = (int64_t)(nom_test_rand() % (cap * 8));
+	n = (int64_t)(nom_test_rand() % (cap * 8 - off + 1));
+	for (i = off; i < off + n; i++) {
+		pc += bit(&b, i);
+	}
+	CHECK(nom_buffer_popcount(&b, off, n) == pc);
+	for (i = off; i < cap * 8; i++) {
+		if (fs < 0 && bit(&b, i)) {
+			fs = i;
+		}
+		if (fc < 0 && !bit(&b, i)) {
+			fc = i;
+		}
+	}
+	CHECK(nom_buffer_findset(&b, off) == fs);
+	CHECK(nom_buffer_findclear(&b, off) == fc);
+
+	CHECK(nom_rankindex_new(&ri, &b) == 0);
+	for (i = 0; i <= cap * 8; i++) {
+		CHECK(nom_rankindex_rank(&ri, i) == rk);
+		if (i < cap * 8 && bit(&b, i)) {
+			CHECK(nom_rankindex_select(&ri, rk) == i);
+			rk++;
+		}
+	}
+	CHECK(nom_rankindex_select(&ri, rk) == -1);
+	nom_rankindex_destroy(&ri);
+
+	op = (int)(nom_test_rand() % 4);
+	m = cap < s.cap ? cap : s.cap;
+	for (i = 0; i < m; i++) {
+		x = r.buf[i];
+		y = s.buf[i];
+		r.buf[i] = op == 0   ? x & y
+			   : op == 1 ? x | y
+			   : op == 2 ? x ^ y
+				     : x & (uint8_t)(~y);
+	}
+	if (op == 0) {
+		nom_buffer_andbits(&b, &s);
+
+	} else if (op == 1) {
+		nom_buffer_orbits(&b, &s);
+
+	} else if (op == 2) {
+		nom_buffer_xorbits(&b, &s);
+
+	} else {
+		nom_buffer_andnotbits(&b, &s);
+	}
+	CHECK(memcmp(b.buf, r.buf, cap) == 0);
+
+	nom_buffer_release(&b);
+	nom_buffer_release(&r);
+	nom_buffer_release(&s);
+}
+
+int main(void) {
+	struct NomBuffer big;
+	int m, trial;
+
+	for (m = 0; m < NOM_TEST_MASKS; m++) {
+		nom_cpu_restrict(nom_test_masks[m]);
+		for (trial = 0; trial < 300; trial++) {
+			check_trial(trial);
+		}
+
+		/* long runs go through the wide kernels */
+		nom_buffer_new(&big, 1 << 16);
+		memset(big.buf, 0x5a, big.cap);
+		CHECK(nom_buffer_popcount(&big, 3, big.cap * 8 - 10) ==
+		      big.cap * 4 - 5);
+		memset(big.buf, 0, big.cap);
+		big.buf[big.cap - 1] = 1;
+		CHECK(nom_buffer_findset(&big, 0) == big.cap * 8 - 1);
+		nom_buffer_release(&big);
+	}
+
+	return nom_test_done("bitmap");
+}
@@ -0,0 +1,173 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+#include "test.h"
+
+/* ref_bit returns bit i of p, counting from the most significant bit of the first byte */
+static int ref_bit(const uint8_t *p, int64_t i) {
+	return (p[i / 8] >> (7 - i % 8)) & 1;
+}
+
+static void ref_setbit(uint8_t *p, int64_t i, int v) {
+	if (v) {
+		p[i / 8] |= (uint8_t)(1 << (7 - i % 8));
+
+	} else {
+		p[i / 8] &= (uint8_t)(~(1 << (7 - i % 8)));
+	}
+}
+
+/* check_bits reads and sets random bit fields against ref_bit */
+static void check_bits(struct NomBuffer *b) {
+	uint8_t ref[64];
+	uint64_t out, e, data;
+	int64_t n, off, i;
+	int it;
+
+	for (it = 0; it < 50000; it++) {
+		nom_test_fill(ref, 64);
+		memcpy(b->buf, ref, 64);
+		n = (int64_t)(nom_test_rand() % 65);
+		off = (int64_t)(nom_test_rand() % (512 - n + 1));
+		out = e = nom_test_rand();
+		data = nom_test_rand();
+
+		nom_buffer_readbits(b, &out, off, n);
+		for (i = 0; i < n; i++) {
+			e = (e << 1) | (uint64_t)(ref_bit(ref, off + i));
+		}
+		CHECK(out == e);
+
+		nom_buffer_setbits(b, off, data, n);
+		for (i = 0; i < n; i++) {
+			ref_setbit(ref, off + i,
+				   (int)((data >> (n - 1 - i)) & 1));
+		}
+		CHECK(memcmp(ref, b->buf, 64) == 0);
+	}
+}
+
+/* check_cursors writes a run of random width fields with a NomBitWriter and reads them back with a NomBitReader */
+static void check_cursors(struct NomBuffer *b) {
+	uint8_t ref[64];
+	int64_t widths[64], start, total, i;
+	uint64_t vals[64], mask;
+	struct NomBitWriter w;
+	struct NomBitReader r;
+	int it, cnt;
+
+	for (it = 0; it < 5000; it++) {
+		start = (int64_t)(nom_test_rand() % 40);
+		total = start;
+		for (cnt = 0; cnt < 64; cnt++) {
+			widths[cnt] = (int64_t)(nom_test_rand() % 65);
+			if (total + widths[cnt] > 512) {
+				break;
+			}
+			vals[cnt] = nom_test_rand();
+			total += widths[cnt];
+		}
+		nom_test_fill(ref, 64);
+		memcpy(b->buf, ref, 64);
+
+		if (nom_bitwriter_new(&w, b, start) != 0) {
+			CHECK(!"nom_bitwriter_new on an unshared buffer");
+			return;
+		}
+		for (i = 0; i < cnt; i++) {
+			nom_bitwriter_write(&w, vals[i], widths[i]);
+		}
+		nom_bitwriter_sync(&w);
+		CHECK(b->boff == total);
+
+		/* bits outside the written run are untouched */
+		for (i = 0; i < start; i++) {
+			CHECK(ref_bit(b->buf, i) == ref_bit(ref, i));
+		}
+		for (i = total; i < 512; i++) {
+			CHECK(ref_bit(b->buf, i) == ref_bit(ref, i));
+		}
+
+		nom_bitreader_new(&r, b, start);
+		for (i = 0; i < cnt; i++) {
+			mask = widths[i] == 64 ? ~UINT64_C(0)
+					       : (UINT64_C(1) << widths[i]) - 1;
+			if (i & 1) {
+				CHECK(nom_bitreader_peek(&r, widths[i]) ==
+				      (vals[i] & mask));
+			}
+			CHECK(nom_bitreader_read(&r, widths[i]) ==
+			      (vals[i] & mask));
+		}
+		CHECK(nom_bitreader_tell(&r) == total);
+		nom_bitreader_align(&r);
+		CHECK(nom_bitreader_tell(&r) % 8 == 0 &&
+		      nom_bitreader_tell(&r) - total < 8);
+	}
+}
+
+/* check_packing packs and unpacks fixed width values against setbits */
+static void check_packing(struct NomBuffer *b, struct NomBuffer *c) {
+	uint32_t v[200], o[200];
+	int64_t cnt, off, i;
+	int it, w;
+
+	for (it = 0; it < 20000; it++) {
+		w = (int)(nom_test_rand() % 32) + 1;
+		cnt = (int64_t)(nom_test_rand() % 120);
+		off = (int64_t)(nom_test_rand() % (600 * 8 - w * cnt + 1));
+		nom_test_fill(b->buf, 600);
+		memcpy(c->buf, b->buf, 600);
+		for (i = 0; i < cnt; i++) {
+			v[i] = (uint32_t)(nom_test_rand());
+		}
+
+		nom_buffer_packbits(b, off, w, cnt, v);
+		for (i = 0; i < cnt; i++) {
+			nom_buffer_setbits(c, off + i * w, v[i], w);
+		}
+		CHECK(memcmp(b->buf, c->buf, 600) == 0);
+
+		nom_buffer_unpackbits(b, o, off, w, cnt);
+		for (i = 0; i < cnt; i++) {
+			CHECK(o[i] ==
+			      (w == 32 ? v[i] : v[i] & ((1u << w) - 1)));
+		}
+	}
+
+	b->boff = 3;
+	nom_buffer_packbitsnext(b, 5, 10, v);
+	CHECK(b->boff == 53);
+}
+
+int main(void) {
+	struct NomBuffer b, c;
+	uint8_t bit;
+
+	nom_buffer_new(&b, 600);
+	nom_buffer_new(&c, 600);
+
+	check_bits(&b);
+	check_cursors(&b);
+	check_packing(&b, &c);
+
+	/* known answers */
+	memset(b.buf, 0, 2);
+	nom_buffer_setbit(&b, 0);
+	nom_buffer_setbit(&b, 15);
+	CHECK(b.buf[0] == 0x80 && b.buf[1] == 0x01);
+	nom_buffer_readbit(&b, &bit, 15);
+	CHECK(bit == 1);
+
+	free(b.buf);
+	free(c.buf);
+	return nom_test_done("bits");
+}
@@ -0,0 +1,137 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+#include "test.h"
+
+#include <pthread.h>
+
+#include "../nom_extras.h"
+
+/* ref_load reads a size byte integer at p the slow way */
+static uint64_t ref_load(const uint8_t *p, int size, int big) {
+	uint64_t v = 0;
+	int k;
+
+	for (k = 0; k < size; k++) {
+		v |= (uint64_t)(p[big ? size - 1 - k : k]) << (8 * k);
+	}
+	return v;
+}
+
+/* check_arrays reads n elements of every width at off in both orders, compares them against ref_load and writes them back */
+static void check_arrays(struct NomBuffer *b, struct NomBuffer *c, int64_t off,
+			 int64_t n) {
+	static uint16_t a16[300];
+	static uint32_t a32[300];
+	static uint64_t a64[300];
+	int64_t i;
+	int big;
+
+	for (big = 0; big < 2; big++) {
+		if (big) {
+			nom_buffer_readu16be(b, a16, off, n);
+			nom_buffer_readu32be(b, a32, off, n);
+			nom_buffer_readu64be(b, a64, off, n);
+
+		} else {
+			nom_buffer_readu16le(b, a16, off, n);
+			nom_buffer_readu32le(b, a32, off, n);
+			nom_buffer_readu64le(b, a64, off, n);
+		}
+		for (i = 0; i < n; i++) {
+			CHECK(a16[i] == ref_load(b->buf + off + i * 2, 2, big));
+			CHECK(a32[i] == ref_load(b->buf + off + i * 4, 4, big));
+			CHECK(a64[i] == ref_load(b->buf + off + i * 8, 8, big));
+		}
+
+		memset(c->buf, 0, c->cap);
+		if (big) {
+			nom_buffer_writeu64be(c, off, n, a64);
+
+		} else {
+			nom_buffer_writeu64le(c, off, n, a64);
+		}
+		CHECK(memcmp(c->buf + off, b->buf + off, n * 8) == 0);
+		if (big) {
+			nom_buffer_writeu32be(c, off, n, a32);
+
+		} else {
+			nom_buffer_writeu32le(c, off, n, a32);
+		}
+		CHECK(memcmp(c->buf + off, b->buf + off, n * 4) == 0);
+		if (big) {
+			nom_buffer_writeu16be(c, off, n, a16);
+
+		} else {
+			nom_buffer_writeu16le(c, off, n, a16);
+		}
+		CHECK(memcmp(c->buf + off, b->buf + off, n * 2) == 0);
+	}
+}
+
+/* first_swap swaps an array, which in a fresh process detects the cpu and picks a kernel */
+static void *first_swap(void *arg) {
+	uint32_t v[64], o[64];
+	int i;
+
+	for (i = 0; i < 64; i++) {
+		v[i] = (uint32_t)(i);
+	}
+	nom_byteorder(o, v, 64, 4, !NOM_BIG_ENDIAN);
+	*(int *)(arg) = o[63] == nom_bswap32(63);
+	return NULL;
+}
+
+int main(void) {
+	struct NomBuffer b, c;
+	uint32_t x[2] = {1, 2};
+	int64_t off, n;
+	int m, ok[2];
+	pthread_t t;
+
+	/* threads can race to be the first to swap, which the thread sanitizer checks */
+	pthread_create(&t, NULL, first_swap, &ok[0]);
+	first_swap(&ok[1]);
+	pthread_join(t, NULL);
+	CHECK(ok[0] && ok[1]);
+
+	nom_buffer_new(&b, 4096);
+	nom_buffer_new(&c, 4096);
+	nom_test_fill(b.buf, b.cap);
+
+	/* every kernel has to give the bytes the scalar loop does, at every length around the vector widths and every alignment */
+	for (m = 0; m < NOM_TEST_MASKS; m++) {
+		nom_cpu_restrict(nom_test_masks[m]);
+		for (off = 0; off < 9; off++) {
+			for (n = 0; n < 300; n += n < 70 ? 1 : 23) {
+				check_arrays(&b, &c, off, n);
+			}
+		}
+	}
+
+	/* known answers */
+	nom_buffer_writeu32be(&c, 0, 2, x);
+	CHECK(memcmp(c.buf, "\0\0\0\1\0\0\0\2", 8) == 0);
+	nom_buffer_writeu32le(&c, 0, 2, x);
+	CHECK(memcmp(c.buf, "\1\0\0\0\2\0\0\0", 8) == 0);
+
+	/* the generic macros pick the same functions */
+	c.off = 0;
+	nom_buffer_writecomplexlenext(&c, 2, x);
+	CHECK(c.off == 8);
+	c.off = 0;
+	nom_buffer_readu32benext(&c, x, 2);
+	CHECK(x[0] == 0x01000000 && x[1] == 0x02000000);
+
+	free(b.buf);
+	free(c.buf);
+	return nom_test_done("byteorder");
+}
@@ -0,0 +1,101 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+#include "test.h"
+
+#include "../nom_chain.h"
+
+int main(void) {
+	struct NomChain c;
+	uint8_t big[1000], bb[1000], s[3], all[2000],
+		seq[1500 * (NOM_CHAIN_MINREF + 1)];
+	uint32_t v[50], o[50];
+	uint16_t h[700];
+	int64_t got = 0;
+	int i;
+
+	for (i = 0; i < 1000; i++) {
+		big[i] = (uint8_t)(i);
+	}
+	for (i = 0; i < 50; i++) {
+		v[i] = 0x01020304u * i;
+	}
+
+	/* copied and referenced segments read back in order */
+	nom_chain_new(&c, 100);
+	CHECK(nom_chain_appendbytes(&c, 3, (uint8_t *)("abc")) == 0);
+	CHECK(nom_chain_appendu32be(&c, 50, v) == 0);
+	CHECK(nom_chain_appendref(&c, 1000, big) == 0);
+	CHECK(nom_chain_appendu32le(&c, 50, v) == 0);
+	CHECK(nom_chain_appendref(&c, 10, big) == 0);
+	CHECK(c.len == 3 + 200 + 1000 + 200 + 10);
+
+	CHECK(nom_chain_readbytesnext(&c, s, 3) == 0 &&
+	      memcmp(s, "abc", 3) == 0);
+	CHECK(nom_chain_readu32benext(&c, o, 50) == 0 &&
+	      memcmp(o, v, 200) == 0);
+	CHECK(nom_chain_readbytesnext(&c, bb, 1000) == 0 &&
+	      memcmp(bb, big, 1000) == 0);
+
+	/* integers straddling segments */
+	CHECK(nom_chain_seek(&c, 1) == 0);
+	CHECK(nom_chain_readu16lenext(&c, h, 700) == 0);
+	CHECK(h[0] == ('b' | 'c' << 8));
+	CHECK(nom_chain_seek(&c, 3 + 200 + 1000) == 0);
+	CHECK(nom_chain_readu32lenext(&c, o, 50) == 0 &&
+	      memcmp(o, v, 200) == 0);
+	CHECK(nom_chain_readbytesnext(&c, s, 3) == 0 && s[2] == 2);
+	CHECK(nom_chain_readbytesnext(&c, bb, 7) == 0 && bb[6] == 9);
+	CHECK(nom_chain_readbytesnext(&c, s, 1) == -1);
+
+#ifdef NOM_POSIX
+	{
+		char path[32];
+		int p[2];
+		ssize_t r;
+
+		CHECK(pipe(p) == 0);
+		CHECK(nom_chain_writev(&c, p[1]) == 0);
+		close(p[1]);
+		while ((r = read(p[0], all + got, 2000 - got)) > 0) {
+			got += r;
+		}
+		close(p[0]);
+		CHECK(got == c.len);
+		CHECK(memcmp(all, "abc", 3) == 0);
+		CHECK(memcmp(all + 203, big, 1000) == 0);
+		CHECK(nom_chain_writev(&c, p[0]) == -1);
+
+		/* chains of more segments than a writev takes go out in batches */
+		nom_chain_destroy(&c);
+		nom_chain_new(&c, 100);
+		for (i = 0; i < 1500; i++) {
+			s[0] = (uint8_t)(i);
+			nom_chain_appendref(&c, NOM_CHAIN_MINREF, big);
+			nom_chain_appendbytes(&c, 1, s);
+		}
+		CHECK(c.nsegs == 3000 && c.nsegs > 2 * NOM_CHAIN_IOV);
+		p[0] = nom_test_tmpfile(path);
+		CHECK(nom_chain_writev(&c, p[0]) == 0);
+		got = pread(p[0], seq, sizeof(seq), 0);
+		close(p[0]);
+		unlink(path);
+		CHECK(got == 1500 * (NOM_CHAIN_MINREF + 1));
+		for (i = 0; i < 1500; i++) {
+			got = (int64_t)(i) * (NOM_CHAIN_MINREF + 1);
+			CHECK(seq[got + NOM_CHAIN_MINREF] == (uint8_t)(i));
+		}
+	}
+#endif
+
+	nom_chain_destroy(&c);
+	return nom_test_done("chain");
+}
@@ -0,0 +1,153 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+#include "test.h"
+
+#include "../nom_schema.h"
+
+#define MSG(F) F(u32le, a) F(varu64, b) F(bytes, c) F(u16be, d)
+NOM_SCHEMA_STRUCT(msg, MSG)
+NOM_SCHEMA(msg, MSG)
+
+/* ref_crc32c is crc32c a bit at a time */
+static uint32_t ref_crc32c(uint32_t crc, const uint8_t *p, int64_t n) {
+	int k;
+
+	crc = ~crc;
+	while (n-- > 0) {
+		crc ^= *p++;
+		for (k = 0; k < 8; k++) {
+			crc = crc & 1 ? (crc >> 1) ^ NOM_CRC32C_POLY : crc >> 1;
+		}
+	}
+	return ~crc;
+}
+
+/* check_fused writes and reads back a mix of types with a checksum attached, which has to match one over the bytes afterwards */
+static void check_fused(struct NomBuffer *b, const uint8_t *data, int kind) {
+	static uint8_t back[1000];
+	uint32_t v[3] = {1, 2, 3}, v2[3];
+	uint64_t vv[2] = {300, 1}, vv2[2];
+	struct msg m = {7, 99999, 3, (uint8_t *)("xyz"), 5}, m2;
+	struct NomChecksum w, r;
+	float f = 1.5f, h;
+	int64_t end;
+
+	b->off = 0;
+	nom_checksum_new(&w, kind, 0);
+	nom_buffer_setchecksum(b, &w);
+	nom_buffer_appendu32be(b, 3, v);
+	nom_buffer_appendvaru64(b, 2, vv);
+	nom_buffer_appendbytes(b, 1000, (uint8_t *)(data));
+	nom_encode_msg(b, &m);
+	nom_buffer_appendf16le(b, 1, &f);
+	end = b->off;
+	CHECK(nom_checksum_digest(&w) == nom_buffer_checksum(b, kind, 0, end));
+	CHECK(nom_buffer_verify(b, kind, 0, end, nom_checksum_digest(&w)) ==
+	      0);
+	CHECK(nom_buffer_verify(b, kind, 1, end - 1, nom_checksum_digest(&w)) ==
+	      -1);
+
+	b->off = 0;
+	nom_checksum_new(&r, kind, 0);
+	nom_buffer_setchecksum(b, &r);
+	nom_buffer_readu32benext(b, v2, 3);
+	CHECK(nom_buffer_readvaru64next(b, vv2, 2) == 0);
+	nom_buffer_readbytesnext(b, back, 1000);
+	CHECK(nom_decode_msg(b, &m2) == 0);
+	nom_buffer_readf16lenext(b, &h, 1);
+	CHECK(b->off == end && m2.b == 99999 && h == 1.5f);
+	CHECK(nom_checksum_digest(&r) == nom_checksum_digest(&w));
+	nom_buffer_setchecksum(b, NULL);
+}
+
+int main(void) {
+	static uint8_t big[100003];
+	const uint8_t *s = (const uint8_t *)("123456789");
+	struct NomChecksum c;
+	struct NomBuffer b;
+	int64_t o, k, step, n;
+	uint64_t one;
+	uint8_t byte;
+	int m, kind;
+
+	nom_test_fill(big, sizeof(big));
+
+	/* known answers */
+	CHECK(nom_crc32c(0, s, 9) == UINT32_C(0xe3069283));
+	CHECK(nom_crc32c(0, s, 0) == 0);
+	CHECK(nom_xxh64(s, 0, 0) == UINT64_C(0xef46db3751d8e999));
+	CHECK(nom_xxh64((const uint8_t *)("abc"), 3, 0) ==
+	      UINT64_C(0x44bc2cf5ad770999));
+	CHECK(nom_xxh64(s, 9, 0) == UINT64_C(0x8cb841db40e6ae83));
+
+	/* the constant tables hold what they would be computed as */
+	for (k = 0; k < 256; k++) {
+		byte = (uint8_t)(k);
+		one = ~ref_crc32c(~UINT32_C(0), &byte, 1);
+		CHECK(nom_crc32c_table[0][k] == one);
+		for (m = 1; m < 8; m++) {
+			one = (one >> 8) ^ nom_crc32c_table[0][one & 0xff];
+			CHECK(nom_crc32c_table[m][k] == one);
+		}
+	}
+#if defined(NOM_X86) && defined(__x86_64__)
+	CHECK(nom_crc32c_shifts[0] ==
+	      nom_crc32c_xpow(8 * NOM_CRC32C_LONG - 33));
+	CHECK(nom_crc32c_shifts[1] ==
+	      nom_crc32c_xpow(16 * NOM_CRC32C_LONG - 33));
+	CHECK(nom_crc32c_shifts[2] ==
+	      nom_crc32c_xpow(8 * NOM_CRC32C_SHORT - 33));
+	CHECK(nom_crc32c_shifts[3] ==
+	      nom_crc32c_xpow(16 * NOM_CRC32C_SHORT - 33));
+#endif
+
+	/* the folding kernel and slice-by-8 give the bitwise crc at every length and alignment, and crcs continue across calls */
+	for (m = 0; m < NOM_TEST_MASKS; m++) {
+		nom_cpu_restrict(nom_test_masks[m]);
+		for (n = 0; n < 2000; n += n < 300 ? 1 : 97) {
+			for (o = 0; o < 8; o++) {
+				CHECK(nom_crc32c(0, big + o, n) ==
+				      ref_crc32c(0, big + o, n));
+			}
+		}
+		CHECK(nom_crc32c(0, big, sizeof(big)) ==
+		      ref_crc32c(0, big, sizeof(big)));
+		CHECK(nom_crc32c(nom_crc32c(0, big, 777), big + 777,
+				 sizeof(big) - 777) ==
+		      ref_crc32c(0, big, sizeof(big)));
+	}
+	nom_cpu_restrict(-1);
+
+	/* feeding a checksum in uneven pieces gives what one call does */
+	for (kind = 0; kind < 2; kind++) {
+		nom_checksum_new(&c, kind, 0);
+		for (o = 0, step = 1; o < (int64_t)(sizeof(big)); o += k) {
+			k = step < (int64_t)(sizeof(big)) - o
+				    ? step
+				    : (int64_t)(sizeof(big)) - o;
+			nom_checksum_update(&c, big + o, k);
+			step = step * 3 % 97 + 1;
+		}
+		one = kind ? nom_xxh64(big, sizeof(big), 0)
+			   : nom_crc32c(0, big, sizeof(big));
+		CHECK(nom_checksum_digest(&c) == one);
+	}
+
+	/* the *next functions feed what they move to the attached checksum */
+	nom_buffer_new(&b, 16);
+	for (kind = 0; kind < 2; kind++) {
+		check_fused(&b, big, kind);
+	}
+	nom_buffer_release(&b);
+
+	return nom_test_done("checksum");
+}
@@ -0,0 +1,117 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+#include "test.h"
+
+/* same_float compares floats by their bits, so nans and signed zeros have to match too */
+static int same_float(float a, float b) { return memcmp(&a, &b, 4) == 0; }
+
+int main(void) {
+	static uint8_t halves[65536 * 2], out[65536 * 2];
+	static float f[65536], g[65536];
+	struct NomBuffer b;
+	uint16_t h, h2;
+	uint32_t x;
+	float s[3] = {1.0f, -2.5f, 65504.0f}, t[3];
+	int64_t i;
+	int m, big, bad;
+
+	/* known answers */
+	CHECK(nom_half_to_float(0x3c00) == 1.0f);
+	CHECK(nom_half_to_float(0xc000) == -2.0f);
+	CHECK(nom_half_to_float(0x7bff) == 65504.0f);
+	CHECK(nom_half_to_float(0x0001) == 1.0f / 16777216.0f);
+	CHECK(nom_float_to_half(1.0f) == 0x3c00);
+	CHECK(nom_float_to_half(65520.0f) == 0x7c00);
+	CHECK(nom_float_to_half(1.0f + 1.0f / 2048.0f) == 0x3c00);
+	CHECK(nom_float_to_half(1.0f + 3.0f / 2048.0f) == 0x3c02);
+	CHECK(nom_float_to_i16(2.5f) == 2 && nom_float_to_i16(3.5f) == 4);
+	CHECK(nom_float_to_i16(1e9f) == 32767 &&
+	      nom_float_to_i16(-1e9f) == -32768);
+
+	/* every half converts the way the scalar functions say, in both orders and at every simd level, and back again */
+	for (m = 0; m < NOM_TEST_MASKS; m++) {
+		nom_cpu_restrict(nom_test_masks[m]);
+		for (big = 0; big < 2; big++) {
+			for (i = 0; i < 65536; i++) {
+				nom_store16(halves + i * 2, (uint16_t)(i), big);
+			}
+			nom_half_decode(f, halves, 65536, big);
+			bad = 0;
+			for (i = 0; i < 65536; i++) {
+				h = (uint16_t)(i);
+				bad += !same_float(f[i], nom_half_to_float(h));
+			}
+			CHECK(bad == 0);
+
+			/* signalling nans come back quiet, and everything else comes back as it was */
+			nom_half_encode(out, f, 65536, big);
+			bad = 0;
+			for (i = 0; i < 65536; i++) {
+				h = nom_load16(out + i * 2, big);
+				h2 = (uint16_t)(i);
+				if ((h2 & 0x7c00) == 0x7c00 && (h2 & 0x3ff)) {
+					h2 |= 0x200;
+				}
+				bad += h != h2;
+			}
+			CHECK(bad == 0);
+
+			/* random floats round the same way as the scalar path, odd lengths included */
+			for (i = 0; i < 65536; i++) {
+				x = (uint32_t)(nom_test_rand());
+				memcpy(&g[i], &x, 4);
+			}
+			nom_half_encode(out, g, 65531, big);
+			bad = 0;
+			for (i = 0; i < 65531; i++) {
+				bad += nom_load16(out + i * 2, big) !=
+				       nom_float_to_half(g[i]);
+			}
+			CHECK(bad == 0);
+
+			/* scaled i16s */
+			for (i = 0; i < 65536; i++) {
+				x = (uint32_t)(nom_test_rand() % 80000);
+				g[i] = (float)((int32_t)(x)-40000) + 0.5f;
+			}
+			nom_scaled_encode(out, g, 65533, big, 0.5f);
+			bad = 0;
+			for (i = 0; i < 65533; i++) {
+				h = (uint16_t)(nom_float_to_i16(g[i] * 2.0f));
+				bad += nom_load16(out + i * 2, big) != h;
+			}
+			CHECK(bad == 0);
+			nom_scaled_decode(f, out, 65533, big, 0.5f);
+			bad = 0;
+			for (i = 0; i < 65533; i++) {
+				bad += f[i] !=
+				       (float)((int16_t)(nom_load16(out + i * 2,
+								    big))) *
+					       0.5f;
+			}
+			CHECK(bad == 0);
+		}
+	}
+
+	/* the buffer functions */
+	nom_buffer_new(&b, 0);
+	CHECK(nom_buffer_appendf16be(&b, 3, s) == 0);
+	CHECK(b.off == 6 && memcmp(b.buf, "\x3c\x00\xc1\x00\x7b\xff", 6) == 0);
+	nom_buffer_readf16be(&b, t, 0, 3);
+	CHECK(t[0] == s[0] && t[1] == s[1] && t[2] == s[2]);
+	b.off = 0;
+	CHECK(nom_buffer_appendscaledi16le(&b, 3, s, 0.5f) == 0);
+	CHECK(memcmp(b.buf, "\x02\x00\xfb\xff\xff\x7f", 6) == 0);
+	nom_buffer_release(&b);
+
+	return nom_test_done("convert");
+}
@@ -0,0 +1,98 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+#include <vector>
+
+#include "test.h"
+
+#include "../nom.hpp"
+
+using std::endian;
+
+int main() {
+	nom::buffer b(64);
+	std::vector<uint32_t> v{1, 2, 3, 4}, w(4);
+	std::vector<uint8_t> by{9, 8}, bo(2);
+	nom::allocator_ref<std::allocator<char>> a;
+	nom::buffer c(16, a.get());
+
+	/* single elements pick their byte order at compile time */
+	b.write<uint32_t, endian::big>(0, 0x01020304);
+	CHECK(b.data()[0] == 1 && b.data()[3] == 4);
+	CHECK((b.read<uint32_t, endian::little>(0)) == 0x04030201);
+	b.write<double, endian::big>(8, 1.5);
+	CHECK((b.read<double, endian::big>(8)) == 1.5);
+	b.write<int16_t, endian::little>(16, -2);
+	CHECK((b.read<int16_t, endian::little>(16)) == -2);
+
+	/* spans go through nom_byteorder */
+	b.seek(20);
+	CHECK((b.write_next<uint32_t, endian::big>(
+		      std::span<const uint32_t>(v))) == 4);
+	CHECK(b.offset() == 36 && b.data()[23] == 1);
+	b.seek(20);
+	CHECK((b.read_next<uint32_t, endian::big>(std::span<uint32_t>(w))) ==
+	      4);
+	CHECK(w == v);
+	b.write<uint8_t, endian::big>(40, std::span<const uint8_t>(by));
+	b.read<uint8_t, endian::big>(40, std::span<uint8_t>(bo));
+	CHECK(bo == by);
+
+	/* slices share until written to, and buffers move */
+	{
+		nom::buffer s = b.slice(0, 4);
+		CHECK(s.size() == 4 && s.data() == b.data());
+		s.write<uint8_t, endian::little>(0, 7);
+		CHECK(b.data()[0] == 1 && s.data()[0] == 7);
+		nom::buffer m = std::move(b);
+		CHECK(b.data() == nullptr && m.size() == 64);
+		b = std::move(s);
+		CHECK(b.size() == 4);
+	}
+
+	/* storage from a standard allocator */
+	c.ensure(1000);
+	c.write_next<float, endian::big>(2.5f);
+	c.seek(0);
+	CHECK((c.read_next<float, endian::big>()) == 2.5f);
+	c.seek(0);
+	CHECK((c.read_next<uint16_t, endian::big>()) == 0x4020);
+
+	try {
+		b.slice(2, 10);
+		CHECK(!"slice out of range");
+
+	} catch (std::out_of_range &) {
+	}
+
+#ifdef NOM_POSIX
+	/* writes that can't copy shared storage throw instead of writing through it */
+	{
+		char path[32];
+		int fd = nom_test_tmpfile(path);
+
+		CHECK(fd >= 0 && write(fd, "abcd", 4) == 4);
+		nom::buffer m = nom::buffer::map(fd, NOM_MAP_WRITE);
+		nom::buffer s = m.slice(0, 4);
+		close(fd);
+		unlink(path);
+		try {
+			s.write<uint8_t, endian::little>(0, 7);
+			CHECK(!"write to a slice of a writable mapping");
+
+		} catch (std::bad_alloc &) {
+		}
+		CHECK(s.data()[0] == 'a');
+	}
+#endif
+
+	return nom_test_done("cpp");
+}
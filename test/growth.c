@@ -0,0 +1,59 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+#include "test.h"
+
+#include "../nom_extras.h"
+
+int main(void) {
+	struct NomBuffer b;
+	uint32_t v[3] = {1, 2, 3};
+	uint64_t q = 5;
+	uint8_t c;
+	int64_t last = -1;
+	int i, reallocs = 0;
+
+	/* appending a byte at a time grows geometrically instead of once per byte */
+	nom_buffer_new(&b, 0);
+	for (i = 0; i < 1000000; i++) {
+		c = (uint8_t)(i);
+		CHECK(nom_buffer_appendbytes(&b, 1, &c) == 0);
+		if (b.alloc != last) {
+			reallocs++;
+			last = b.alloc;
+		}
+	}
+	CHECK(b.cap == 1000000 && b.off == 1000000 && b.bcap == 8000000);
+	CHECK(reallocs < 64);
+	for (i = 0; i < 1000000; i++) {
+		if (b.buf[i] != (uint8_t)(i)) {
+			CHECK(b.buf[i] == (uint8_t)(i));
+			break;
+		}
+	}
+
+	nom_buffer_appendcomplexbe(&b, 3, v);
+	CHECK(b.buf[1000003] == 1 && b.cap == 1000012);
+
+	CHECK(nom_buffer_shrinktofit(&b) == 0 && b.alloc == b.cap);
+	CHECK(nom_buffer_reserve(&b, 2000000) == 0 && b.alloc == 2000000 &&
+	      b.cap == 1000012);
+	CHECK(nom_buffer_grow(&b, 10) == 0 && b.cap == 1000022 &&
+	      b.buf[1000003] == 1);
+
+	b.growth = nom_growth_exact;
+	b.off = b.cap;
+	CHECK(nom_buffer_appendu64le(&b, 1, &q) == 0);
+	CHECK(b.cap == 1000030 && b.buf[1000022] == 5);
+
+	nom_buffer_release(&b);
+	return nom_test_done("growth");
+}
@@ -0,0 +1,67 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+#define NOM_STATS
+#include "test.h"
+
+#include "../nom_pool.h"
+#include "linkage/point.h"
+
+/* defined in linkage/peer.cpp */
+int peer_features(void);
+void peer_write(struct NomBuffer *b);
+struct NomPool *peer_pool(void);
+int peer_encode(struct NomBuffer *b, const struct Point *p);
+
+static int traced = 0;
+
+static void hook(void *ctx, int event, const struct NomBuffer *b, int64_t off,
+		 int64_t n) {
+	(void)(ctx);
+	(void)(b);
+	(void)(off);
+	(void)(n);
+	traced += event == NOM_TRACE_WRITE;
+}
+
+int main(void) {
+	struct NomBuffer b;
+	struct NomStats s;
+	struct Point p = {1, 300}, q;
+
+	/* nom's state is process wide without NOM_EXTERN, so what one file sets is what the other sees */
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(_WIN32)
+	nom_cpu_restrict(NOM_CPU_SSSE3);
+	CHECK(peer_features() == (nom_cpu_features() & NOM_CPU_SSSE3));
+	nom_cpu_restrict(0);
+	CHECK(peer_features() == 0);
+
+	nom_buffer_new(&b, 16);
+	nom_stats_reset();
+	CHECK(nom_stats_settrace(hook, NULL) == 0);
+	peer_write(&b);
+	nom_stats_snapshot(&s);
+	CHECK(s.writes == 1 && s.write_bytes == 4 && traced == 1);
+	nom_stats_settrace(NULL, NULL);
+	free(b.buf);
+
+	CHECK(peer_pool() == nom_pool_local());
+#endif
+
+	/* and a schema defined in a header links into both */
+	nom_buffer_new(&b, 0);
+	CHECK(peer_encode(&b, &p) == 0 && b.off == nom_size_Point(&p));
+	b.off = 0;
+	CHECK(nom_decode_Point(&b, &q) == 0 && q.x == 1 && q.y == 300);
+	nom_buffer_release(&b);
+
+	return nom_test_done("linkage");
+}
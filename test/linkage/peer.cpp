@@ -0,0 +1,30 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+/* the other translation unit of the linkage test, in c++ so the c and c++ definitions of nom's state are checked to be the same object */
+
+#define NOM_STATS
+#include "../../nom_pool.h"
+#include "point.h"
+
+extern "C" int peer_features(void) { return nom_cpu_features(); }
+
+extern "C" void peer_write(struct NomBuffer *b) {
+	uint32_t x = 1;
+
+	nom_buffer_writeu32le(b, 0, 1, &x);
+}
+
+extern "C" struct NomPool *peer_pool(void) { return nom_pool_local(); }
+
+extern "C" int peer_encode(struct NomBuffer *b, const struct Point *p) {
+	return nom_encode_Point(b, p);
+}
@@ -0,0 +1,23 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+/* a schema defined in a header that both files of the linkage test include */
+
+#ifndef NOM_TEST_LINKAGE_POINT_H
+#define NOM_TEST_LINKAGE_POINT_H
+
+#include "../../nom_schema.h"
+
+#define POINT_FIELDS(F) F(u32le, x) F(varu64, y)
+NOM_SCHEMA_STRUCT(Point, POINT_FIELDS)
+NOM_SCHEMA(Point, POINT_FIELDS)
+
+#endif
@@ -0,0 +1,176 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+#include "test.h"
+
+#include "../nom_lz.h"
+
+static const char *words[] = {"alpha ", "beta ",   "gamma ", "delta ",
+			      "nom ",   "buffer ", "crunch ", "the ",
+			      "letter ", "c ",     "offset ", "\n"};
+
+/* gen fills n bytes at p with random bytes, a run, text or a short period, picked by kind */
+static void gen(uint8_t *p, int64_t n, int kind) {
+	const char *w;
+	int64_t i = 0;
+
+	if (kind == 0) {
+		nom_test_fill(p, n);
+
+	} else if (kind == 1) {
+		memset(p, 'a', n);
+
+	} else if (kind == 3) {
+		for (; i < n; i++) {
+			p[i] = (uint8_t)(i % 3 + (i % 7 == 0));
+		}
+
+	} else {
+		while (i < n) {
+			w = words[nom_test_rand() % 12];
+			if (nom_test_rand() % 8 == 0) {
+				p[i++] = (uint8_t)(nom_test_rand());
+				continue;
+			}
+			while (*w && i < n) {
+				p[i++] = (uint8_t)(*w++);
+			}
+		}
+	}
+}
+
+/* check_roundtrip compresses n bytes, decompresses them again and makes sure damaged blocks are turned away without reading or writing out of bounds */
+static void check_roundtrip(int64_t n, int kind) {
+	int64_t bound = nom_lz_bound(n), k, r;
+	uint8_t *src = malloc(n + 1), *c = malloc(bound), *d = malloc(n + 1),
+		*x;
+
+	gen(src, n, kind);
+	k = nom_lz_compress(c, bound, src, n);
+	CHECK(k >= 0 && k <= bound);
+	r = nom_lz_decompress(d, n, c, k);
+	CHECK(r == n && memcmp(src, d, n) == 0);
+	if (n > 0) {
+		CHECK(nom_lz_decompress(d, n - 1, c, k) == -1);
+	}
+	if (k > 1) {
+		CHECK(nom_lz_compress(c, k - 1, src, n) == -1);
+	}
+	for (r = 0; r < k && r < 64; r++) {
+		nom_lz_decompress(d, n, c, r);
+	}
+	x = malloc(k + 1);
+	for (r = 0; r < 50 && k > 0; r++) {
+		memcpy(x, c, k);
+		x[nom_test_rand() % k] ^= (uint8_t)(1 + nom_test_rand() % 255);
+		nom_lz_decompress(d, n, x, k);
+	}
+	free(x);
+	free(src);
+	free(c);
+	free(d);
+}
+
+int main(void) {
+	static const int64_t sizes[] = {0,    1,    5,     12,    13,    14,
+					15,   16,   17,    31,    64,    100,
+					255,  256,  270,   1000,  4096,  65535,
+					65536, 70000, 300000, 1 << 21};
+	static const uint8_t block[] = {0x44, 'a', 'b', 'c', 'd', 0x04, 0x00,
+					0x50, 'e', 'f', 'g', 'h', 'i'};
+	uint8_t tmp[5000], out[5000];
+	struct NomBuffer a, o, d, w;
+	struct NomChecksum cw, cr;
+	int64_t k, sz, total = 0, sum = 0;
+	int i, kind;
+
+	/* a block made by the reference lz4 */
+	CHECK(nom_lz_decompress(out, sizeof(out), block, sizeof(block)) == 17);
+	CHECK(memcmp(out, "abcdabcdabcdefghi", 17) == 0);
+
+	for (kind = 0; kind < 4; kind++) {
+		for (i = 0; i < (int)(sizeof(sizes) / sizeof(sizes[0])); i++) {
+			check_roundtrip(sizes[i], kind);
+		}
+	}
+	for (i = 0; i < 1000; i++) {
+		check_roundtrip((int64_t)(nom_test_rand() % 3000),
+				(int)(nom_test_rand() % 4));
+	}
+
+	/* blocks between buffers */
+	nom_buffer_new(&a, 10000);
+	gen(a.buf, 10000, 2);
+	nom_buffer_new(&o, 0);
+	k = nom_buffer_compress(&a, 100, 9000, &o);
+	CHECK(k > 0 && o.off == k && o.cap == k);
+	nom_buffer_new(&d, 9000);
+	CHECK(nom_buffer_decompress(&o, 0, k, &d) == 9000 && d.off == 9000);
+	CHECK(memcmp(d.buf, a.buf + 100, 9000) == 0);
+	d.off = 1;
+	CHECK(nom_buffer_decompress(&o, 0, k, &d) == -1);
+	nom_buffer_release(&d);
+
+	/* frames, with a checksum over them */
+	o.off = 0;
+	o.cap = 0;
+	nom_checksum_new(&cw, NOM_CHECKSUM_CRC32C, 0);
+	nom_buffer_setchecksum(&o, &cw);
+	for (i = 0; i < 50; i++) {
+		sz = (int64_t)(nom_test_rand() % 5000);
+		gen(tmp, sz, (int)(nom_test_rand() % 4));
+		CHECK(nom_buffer_appendlz(&o, sz, tmp) == 0);
+		sum += sz;
+	}
+	nom_buffer_setchecksum(&o, NULL);
+	o.off = 0;
+	nom_checksum_new(&cr, NOM_CHECKSUM_CRC32C, 0);
+	nom_buffer_setchecksum(&o, &cr);
+	while (o.off < o.cap) {
+		sz = nom_buffer_peeklz(&o);
+		CHECK(sz >= 0 && sz <= 5000);
+		k = nom_buffer_readlznext(&o, out, 5000);
+		CHECK(k == sz);
+		if (k < 0) {
+			break;
+		}
+		total += k;
+	}
+	CHECK(total == sum);
+	CHECK(nom_buffer_peeklz(&o) == -1);
+	CHECK(cr.crc == cw.crc);
+	nom_buffer_setchecksum(&o, NULL);
+	o.off = 0;
+	sz = nom_buffer_peeklz(&o);
+	if (sz > 0) {
+		CHECK(nom_buffer_readlznext(&o, out, sz - 1) == -1);
+	}
+
+	/* writelznext doesn't grow the buffer, and stores what doesn't compress */
+	nom_buffer_new(&w, 64);
+	memset(tmp, 'x', 1000);
+	CHECK(nom_buffer_writelznext(&w, 1000, tmp) == 0);
+	w.off = 0;
+	CHECK(nom_buffer_readlznext(&w, out, 1000) == 1000);
+	gen(tmp, 1000, 0);
+	CHECK(nom_buffer_writelznext(&w, 1000, tmp) == -1);
+	w.off = 0;
+	CHECK(nom_buffer_appendlz(&w, 1000, tmp) == 0);
+	CHECK(w.off == NOM_LZ_HEADER + 1000);
+	w.off = 0;
+	CHECK(nom_buffer_readlznext(&w, out, 1000) == 1000 &&
+	      memcmp(out, tmp, 1000) == 0);
+
+	nom_buffer_release(&w);
+	nom_buffer_release(&a);
+	nom_buffer_release(&o);
+	return nom_test_done("lz");
+}
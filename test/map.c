@@ -0,0 +1,64 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+#include "test.h"
+
+int main(void) {
+#ifdef NOM_POSIX
+	struct NomBuffer b;
+	char path[32], empty[32];
+	uint8_t data[100000];
+	uint16_t w = 0xbeef;
+	uint32_t v = 0;
+	int fd, i;
+
+	for (i = 0; i < 100000; i++) {
+		data[i] = (uint8_t)(i);
+	}
+	fd = nom_test_tmpfile(path);
+	CHECK(fd >= 0 && write(fd, data, sizeof(data)) == sizeof(data));
+	close(fd);
+
+	CHECK(nom_buffer_mapfile(&b, path,
+				 NOM_MAP_SEQUENTIAL | NOM_MAP_WILLNEED |
+					 NOM_MAP_HUGEPAGES) == 0);
+	CHECK(b.cap == 100000);
+	nom_buffer_readu32benext(&b, &v, 1);
+	CHECK(v == 0x00010203 && b.off == 4);
+	CHECK(nom_buffer_grow(&b, 10) == -1);
+	nom_buffer_release(&b);
+
+	/* writes to a shared mapping reach the file */
+	CHECK(nom_buffer_mapfile(&b, path, NOM_MAP_WRITE) == 0);
+	nom_buffer_writeu16be(&b, 0, 1, &w);
+	CHECK(nom_buffer_unmap(&b) == 0 && b.buf == NULL);
+
+	/* and to a private one don't */
+	CHECK(nom_buffer_mapfile(&b, path,
+				 NOM_MAP_PRIVATE | NOM_MAP_POPULATE) == 0);
+	CHECK(b.buf[0] == 0xbe && b.buf[1] == 0xef);
+	b.buf[0] = 0;
+	nom_buffer_release(&b);
+	CHECK(nom_buffer_mapfile(&b, path, 0) == 0);
+	CHECK(b.buf[0] == 0xbe);
+	nom_buffer_release(&b);
+
+	fd = nom_test_tmpfile(empty);
+	close(fd);
+	CHECK(nom_buffer_mapfile(&b, empty, 0) == 0 && b.cap == 0);
+	nom_buffer_release(&b);
+	CHECK(nom_buffer_mapfile(&b, "/nonexistent/nom", 0) == -1);
+
+	unlink(path);
+	unlink(empty);
+#endif
+	return nom_test_done("map");
+}
@@ -0,0 +1,107 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+#include "test.h"
+
+#include "../nom_pool.h"
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#include <pthread.h>
+
+/* cache_blocks leaves 100 blocks of 1 kib cached in the thread's pool and exits */
+static void *cache_blocks(void *arg) {
+	struct NomPool *p = nom_pool_local();
+	void *blocks[100];
+	int i;
+
+	(void)(arg);
+	for (i = 0; i < 100; i++) {
+		blocks[i] = nom_alloc(&p->allocator, 1000);
+	}
+	for (i = 0; i < 100; i++) {
+		nom_free(&p->allocator, blocks[i], 1000);
+	}
+	return NULL;
+}
+#endif
+
+int main(void) {
+	struct NomArena a;
+	struct NomBuffer *bs[100], *big, *h;
+	struct NomPool *p;
+	uint64_t v;
+	uint8_t c;
+	int round, i, j, r;
+
+	/* buffers made from an arena are aligned, keep their contents while growing and go away with a reset */
+	nom_arena_new(&a, 4096);
+	for (round = 0; round < 3; round++) {
+		for (i = 0; i < 100; i++) {
+			bs[i] = nom_buffer_create(&a.allocator, 32);
+			CHECK(bs[i] != NULL &&
+			      (uintptr_t)(bs[i]->buf) % 16 == 0);
+			for (j = 0; j < 100; j++) {
+				c = (uint8_t)(j);
+				nom_buffer_appendbytes(bs[i], 1, &c);
+			}
+		}
+		for (i = 0; i < 100; i++) {
+			for (j = 0; j < 100; j++) {
+				CHECK(bs[i]->buf[j] == j);
+			}
+		}
+		big = nom_buffer_create(&a.allocator, 100000);
+		CHECK(big != NULL);
+		memset(big->buf, 1, 100000);
+		nom_buffer_destroy(big);
+		nom_arena_reset(&a);
+	}
+	nom_arena_destroy(&a);
+
+	/* a thread's pool hands blocks back out of its size classes */
+	p = nom_pool_local();
+	for (r = 0; r < 1000; r++) {
+		struct NomBuffer *b = nom_buffer_create(&p->allocator, r % 300);
+
+		v = (uint64_t)(r);
+		for (i = 0; i < 50; i++) {
+			nom_buffer_appendu64be(b, 1, &v);
+		}
+		CHECK(b->cap == 400 && b->buf[399] == (uint8_t)(r));
+		nom_buffer_shrinktofit(b);
+		nom_buffer_destroy(b);
+	}
+	h = nom_buffer_create(&p->allocator, 1 << 22);
+	CHECK(nom_buffer_grow(h, 1 << 22) == 0);
+	nom_buffer_destroy(h);
+	nom_pool_trim(p);
+
+#ifdef __GLIBC__
+	/* threads give their cached blocks back as they exit. with a single malloc arena, mallinfo2 sees the blocks of every thread */
+	{
+		pthread_t t[4];
+		size_t before;
+
+		mallopt(M_ARENA_MAX, 1);
+		before = mallinfo2().uordblks;
+		for (i = 0; i < 4; i++) {
+			pthread_create(&t[i], NULL, cache_blocks, NULL);
+		}
+		for (i = 0; i < 4; i++) {
+			pthread_join(t[i], NULL);
+		}
+		CHECK(mallinfo2().uordblks < before + 100 * 1024);
+	}
+#endif
+
+	return nom_test_done("pool");
+}
@@ -0,0 +1,148 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+#include "test.h"
+
+#include "../nom_scan.h"
+
+static int64_t ref_byte(const uint8_t *p, int64_t cap, int64_t off, uint8_t c) {
+	for (; off < cap; off++) {
+		if (p[off] == c) {
+			return off;
+		}
+	}
+	return -1;
+}
+
+static int64_t ref_any(const uint8_t *p, int64_t cap, int64_t off,
+		       const uint8_t *set, int64_t n) {
+	int64_t j;
+
+	for (; off < cap; off++) {
+		for (j = 0; j < n; j++) {
+			if (p[off] == set[j]) {
+				return off;
+			}
+		}
+	}
+	return -1;
+}
+
+static int64_t ref_pattern(const uint8_t *p, int64_t cap, int64_t off,
+			   const uint8_t *pat, int64_t n) {
+	for (; off + n <= cap; off++) {
+		if (memcmp(p + off, pat, n) == 0) {
+			return off;
+		}
+	}
+	return -1;
+}
+
+/* check_trial runs every kind of scan over a random buffer, which is past NOM_SCAN_WIDE when wide is set, against the reference loops */
+static void check_trial(int wide) {
+	static int64_t out[60000];
+	int64_t cap = wide ? NOM_SCAN_WIDE + (int64_t)(nom_test_rand() % 40000)
+			   : (int64_t)(nom_test_rand() % 300);
+	struct NomBuffer *b = nom_buffer_create(NULL, cap);
+	int64_t alpha = 2 + (int64_t)(nom_test_rand() % 60), off, i, n, k, e,
+		max, r, pn, sn;
+	uint8_t set[8], pat[8], c;
+
+	for (i = 0; i < cap; i++) {
+		b->buf[i] = (uint8_t)(nom_test_rand() % alpha +
+				      (nom_test_rand() % 50 == 0 ? 128 : 0));
+	}
+	off = cap > 0 ? (int64_t)(nom_test_rand() % (cap + 1)) : 0;
+	c = (uint8_t)(nom_test_rand() % (alpha + 5));
+	CHECK(nom_buffer_findbyte(b, off, c) == ref_byte(b->buf, cap, off, c));
+
+	sn = (int64_t)(nom_test_rand() % 8);
+	for (i = 0; i < sn; i++) {
+		set[i] = (uint8_t)(nom_test_rand());
+		if (nom_test_rand() % 2) {
+			set[i] = (uint8_t)(set[i] % alpha);
+		}
+	}
+	CHECK(nom_buffer_findany(b, off, sn, set) ==
+	      ref_any(b->buf, cap, off, set, sn));
+
+	pn = 1 + (int64_t)(nom_test_rand() % 6);
+	if (cap > pn && nom_test_rand() % 2) {
+		memcpy(pat, b->buf + nom_test_rand() % (cap - pn), pn);
+
+	} else {
+		for (i = 0; i < pn; i++) {
+			pat[i] = (uint8_t)(nom_test_rand() % alpha);
+		}
+	}
+	CHECK(nom_buffer_findpattern(b, off, pn, pat) ==
+	      ref_pattern(b->buf, cap, off, pat, pn));
+
+	n = cap - off;
+	max = 1 + (int64_t)(nom_test_rand() % (n + 2));
+	k = nom_buffer_findall(b, out, off, n, c, max);
+	for (i = off, e = 0; i < cap && e < max; i++) {
+		if (b->buf[i] == c) {
+			CHECK(e < k && out[e] == i);
+			e++;
+		}
+	}
+	CHECK(e == k);
+
+	b->off = off;
+	r = nom_buffer_findbytenext(b, c);
+	CHECK(r == ref_byte(b->buf, cap, off, c) &&
+	      b->off == (r < 0 ? off : r));
+	nom_buffer_destroy(b);
+}
+
+/* check_long_pattern looks for a pattern longer than NOM_SCAN_WIDE, which appears both before off and after it */
+static void check_long_pattern(void) {
+	struct NomBuffer *b = nom_buffer_create(NULL, 60000);
+	static uint8_t pat[20000];
+
+	nom_test_fill(b->buf, 60000);
+	memcpy(pat, b->buf + 500, 20000);
+	memcpy(b->buf + 35000, pat, 20000);
+	CHECK(nom_buffer_findpattern(b, 1000, 20000, pat) == 35000);
+	CHECK(nom_buffer_findpattern(b, 500, 20000, pat) == 500);
+	CHECK(nom_buffer_findpattern(b, 35001, 20000, pat) == -1);
+	nom_buffer_destroy(b);
+}
+
+int main(void) {
+	struct NomBuffer *b = nom_buffer_create(NULL, 256);
+	uint8_t s[2];
+	int m, i, c;
+
+	for (i = 0; i < 256; i++) {
+		b->buf[i] = (uint8_t)(i);
+	}
+	for (m = 0; m < NOM_TEST_MASKS; m++) {
+		nom_cpu_restrict(nom_test_masks[m]);
+		for (i = 0; i < 2000; i++) {
+			check_trial(i % 40 == 0);
+		}
+		check_long_pattern();
+
+		/* every byte value in a set */
+		for (c = 0; c < 256; c++) {
+			s[0] = (uint8_t)(c);
+			s[1] = (uint8_t)((c * 7 + 3) & 255);
+			CHECK(nom_buffer_findany(b, 0, 2, s) ==
+			      (s[0] < s[1] ? s[0] : s[1]));
+			CHECK(nom_buffer_findbyte(b, 0, (uint8_t)(c)) == c);
+		}
+	}
+	nom_buffer_destroy(b);
+
+	return nom_test_done("scan");
+}
@@ -0,0 +1,131 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+#include "test.h"
+
+#include "../nom_schema.h"
+
+#define FIXED_FIELDS(F)                                                        \
+	F(u32le, id) F(u16be, kind) F(u8, flags) F(u64le, stamp) F(u32be, len) \
+		F(u16le, port)
+NOM_SCHEMA_STRUCT(Fixed, FIXED_FIELDS)
+NOM_SCHEMA(Fixed, FIXED_FIELDS)
+
+#define VAR_FIELDS(F)                                                          \
+	F(u32le, a) F(vari32, b) F(bytes, name) F(u64be, c) F(varu64, d)       \
+		F(u8, e)
+NOM_SCHEMA_STRUCT(Var, VAR_FIELDS)
+NOM_SCHEMA(Var, VAR_FIELDS)
+
+#define NUM_FIELDS(F) F(u32le, a) F(vari32, b) F(varu64, d) F(u8, e)
+NOM_SCHEMA_STRUCT(Num, NUM_FIELDS)
+NOM_SCHEMA(Num, NUM_FIELDS)
+
+/* a source that hands out at most 3 bytes at a time, so decoding a struct refills the window partway */
+struct Source {
+	const uint8_t *p;
+	int64_t n, pos;
+};
+
+static int64_t source_read(void *ctx, uint8_t *buf, int64_t n) {
+	struct Source *s = (struct Source *)(ctx);
+	int64_t k = s->n - s->pos;
+
+	if (k > n) {
+		k = n;
+	}
+	if (k > 3) {
+		k = 3;
+	}
+	memcpy(buf, s->p + s->pos, k);
+	s->pos += k;
+	return k;
+}
+
+int main(void) {
+	struct NomBuffer b;
+	struct Fixed f = {0x01020304, 0x0506, 7, 8, 9, 10}, g;
+	struct Var v = {7, -300, 5, (uint8_t *)("hello"),
+			UINT64_C(0x0102030405060708), UINT64_C(1) << 40, 9};
+	struct Var w;
+	struct Num x = {7, -300, UINT64_C(1) << 40, 9}, y;
+	struct Source src;
+	struct NomStream s;
+	struct NomBuffer r;
+	int64_t end;
+	int i;
+
+	/* fixed fields land where the field kinds say */
+	nom_buffer_new(&b, 0);
+	CHECK(nom_encode_Fixed(&b, &f) == 0);
+	CHECK(b.off == nom_size_Fixed(&f) && b.off == 21);
+	CHECK(memcmp(b.buf, "\x04\x03\x02\x01\x05\x06\x07", 7) == 0);
+	b.off = 0;
+	memset(&g, 0, sizeof(g));
+	CHECK(nom_decode_Fixed(&b, &g) == 0);
+	CHECK(g.id == f.id && g.kind == f.kind && g.flags == f.flags &&
+	      g.stamp == f.stamp && g.len == f.len && g.port == f.port);
+	nom_buffer_release(&b);
+
+	/* variable fields round trip */
+	nom_buffer_new(&b, 0);
+	for (i = 0; i < 1000; i++) {
+		CHECK(nom_encode_Var(&b, &v) == 0);
+	}
+	CHECK(b.off == 1000 * nom_size_Var(&v));
+
+	/* the buffer ends where the encoding does, with no unwritten bytes after the last varint */
+	CHECK(b.cap == b.off);
+	end = b.off;
+	b.off = 0;
+	for (i = 0; i < 1000; i++) {
+		CHECK(nom_decode_Var(&b, &w) == 0);
+		CHECK(w.a == 7 && w.b == -300 && w.name_length == 5 &&
+		      memcmp(w.name, "hello", 5) == 0 && w.c == v.c &&
+		      w.d == v.d && w.e == 9);
+	}
+	CHECK(b.off == end);
+	CHECK(nom_decode_Var(&b, &w) == -1);
+
+	/* truncated input fails */
+	b.cap = end - 3;
+	b.off = end - nom_size_Var(&v);
+	CHECK(nom_decode_Var(&b, &w) == -1);
+
+	/* bytes fields can't be decoded from a stream, since the window they point into is refilled for the fields after them */
+	src.p = b.buf;
+	src.n = end;
+	src.pos = 0;
+	nom_stream_new(&s, source_read, NULL, &src);
+	CHECK(nom_buffer_openstream(&r, &s, 16) == 0);
+	CHECK(nom_decode_Var(&r, &w) == -1);
+	nom_buffer_release(&r);
+	nom_buffer_release(&b);
+
+	/* the other kinds can */
+	nom_buffer_new(&b, 0);
+	for (i = 0; i < 1000; i++) {
+		CHECK(nom_encode_Num(&b, &x) == 0);
+	}
+	src.p = b.buf;
+	src.n = b.off;
+	src.pos = 0;
+	nom_stream_new(&s, source_read, NULL, &src);
+	CHECK(nom_buffer_openstream(&r, &s, 16) == 0);
+	for (i = 0; i < 1000; i++) {
+		CHECK(nom_decode_Num(&r, &y) == 0);
+		CHECK(y.a == 7 && y.b == -300 && y.d == x.d && y.e == 9);
+	}
+	CHECK(nom_decode_Num(&r, &y) == -1);
+	nom_buffer_release(&r);
+	nom_buffer_release(&b);
+	return nom_test_done("schema");
+}
@@ -0,0 +1,192 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+#include "test.h"
+
+#include "../nom_bitmap.h"
+#include "../nom_lz.h"
+#include "../nom_schema.h"
+
+#define MSG_FIELDS(F) F(u32le, a) F(u8, b)
+NOM_SCHEMA_STRUCT(Msg, MSG_FIELDS)
+NOM_SCHEMA(Msg, MSG_FIELDS)
+
+/* an allocator that fails once failing is set, for writes that can't copy shared storage */
+static int failing = 0;
+
+static void *failing_allocate(void *ctx, size_t n) {
+	(void)(ctx);
+	return failing ? NULL : malloc(n);
+}
+
+static void *failing_reallocate(void *ctx, void *p, size_t old_size,
+				size_t n) {
+	(void)(ctx);
+	(void)(old_size);
+	return failing ? NULL : realloc(p, n);
+}
+
+static void failing_deallocate(void *ctx, void *p, size_t n) {
+	(void)(ctx);
+	(void)(n);
+	free(p);
+}
+
+static const struct NomAllocator failing_allocator = {
+	failing_allocate, failing_reallocate, failing_deallocate, NULL};
+
+int main(void) {
+	struct NomBuffer *p = nom_buffer_create(NULL, 64), *q, m, f;
+	struct Msg msg = {7, 9}, o;
+	NomSlice s1, s2, s3, qs;
+	uint8_t v[8], d[256], x = 0xaa, b0, *old;
+	uint32_t u = 300;
+	char path[32];
+	int i, fd;
+
+	for (i = 0; i < 64; i++) {
+		p->buf[i] = (uint8_t)(i);
+	}
+
+	/* slices of slices see the parent's bytes */
+	CHECK(nom_buffer_slice(&s1, p, 8, 32) == 0);
+	CHECK(nom_buffer_slice(&s2, &s1, 4, 8) == 0);
+	CHECK(nom_buffer_slice(&s3, &s2, 7, 2) == -1);
+	CHECK(nom_buffer_slice(&s3, &s2, -1, 2) == -1);
+	CHECK(p->shared != NULL && nom_shared_refs(p->shared) == 3);
+	nom_buffer_readbytesnext(&s2, v, 8);
+	for (i = 0; i < 8; i++) {
+		CHECK(v[i] == 12 + i);
+	}
+
+	/* writing through either side copies first */
+	nom_buffer_writebytes(&s1, 0, 1, &x);
+	CHECK(s1.buf[0] == 0xaa && p->buf[8] == 8 && s2.buf[0] == 12);
+	CHECK(s1.shared == NULL && nom_shared_refs(p->shared) == 2);
+	nom_buffer_writebytes(p, 12, 1, &x);
+	CHECK(p->buf[12] == 0xaa && s2.buf[0] == 12 && p->shared == NULL);
+
+	/* the storage outlives the parent, and is written in place once only one buffer has it */
+	nom_buffer_destroy(p);
+	CHECK(s2.buf[7] == 19 && nom_shared_refs(s2.shared) == 1);
+	old = s2.buf;
+	nom_buffer_writebytes(&s2, 0, 1, &x);
+	CHECK(s2.buf == old && s2.buf[0] == 0xaa);
+	CHECK(nom_buffer_ensure(&s2, 100) == 0 && s2.shared == NULL &&
+	      s2.cap == 100 && s2.buf[7] == 19);
+	nom_buffer_release(&s2);
+	nom_buffer_release(&s1);
+
+	/* growing takes the storage back when no slice is left, and copies it otherwise */
+	p = nom_buffer_create(NULL, 16);
+	CHECK(nom_buffer_slice(&s1, p, 0, 16) == 0);
+	nom_buffer_release(&s1);
+	CHECK(nom_buffer_ensure(p, 1000) == 0 && p->shared == NULL);
+	CHECK(nom_buffer_slice(&s1, p, 0, 16) == 0);
+	for (i = 0; i < 16; i++) {
+		p->buf[i] = (uint8_t)(i);
+	}
+	CHECK(nom_buffer_ensure(p, 5000) == 0 && p->shared == NULL);
+	CHECK(nom_shared_refs(s1.shared) == 1 && s1.buf[15] == 15);
+	CHECK(nom_buffer_ensure(&s1, 5000) == 0 && s1.shared == NULL &&
+	      s1.alloc >= 5000);
+	nom_buffer_release(&s1);
+
+	/* the bit, bitmap, schema, varint and lz writers copy too */
+	CHECK(nom_buffer_slice(&s1, p, 0, 64) == 0);
+	nom_buffer_setbit(&s1, 3);
+	CHECK(s1.shared == NULL && !(p->buf[0] & 0x10));
+	nom_buffer_release(&s1);
+	CHECK(nom_buffer_slice(&s1, p, 0, 64) == 0);
+	nom_buffer_setbitrange(&s1, 0, 20);
+	CHECK(s1.shared == NULL && p->buf[1] == 1);
+	nom_buffer_release(&s1);
+	CHECK(nom_buffer_slice(&s1, p, 0, 64) == 0);
+	b0 = p->buf[0];
+	CHECK(nom_encode_Msg(&s1, &msg) == 0);
+	CHECK(p->buf[0] == b0 && s1.buf[0] == 7);
+	s1.off = 0;
+	CHECK(nom_decode_Msg(&s1, &o) == 0 && o.a == 7 && o.b == 9);
+	nom_buffer_release(&s1);
+	CHECK(nom_buffer_slice(&s1, p, 0, 64) == 0);
+	nom_buffer_writevaru32(&s1, 0, 1, &u);
+	CHECK(p->buf[0] == b0 && s1.buf[0] == 0xac);
+	nom_buffer_release(&s1);
+	CHECK(nom_buffer_slice(&s1, p, 0, 64) == 0);
+	memset(d, 0, sizeof(d));
+	d[0] = 1;
+	CHECK(nom_buffer_appendlz(&s1, 100, d) == 0 && p->buf[0] == b0);
+	s1.off = 0;
+	CHECK(nom_buffer_readlznext(&s1, d, 100) == 100 && d[0] == 1);
+	nom_buffer_release(&s1);
+
+	/* compressing into a shared buffer copies it */
+	q = nom_buffer_create(NULL, 4);
+	memset(d, 'a', 256);
+	nom_buffer_writebytes(p, 0, 256, d);
+	q->buf[0] = 0x55;
+	CHECK(nom_buffer_slice(&qs, q, 0, 4) == 0);
+	CHECK(nom_buffer_compress(p, 0, 256, q) > 0 && q->shared == NULL &&
+	      qs.buf[0] == 0x55);
+	nom_buffer_release(&qs);
+	nom_buffer_destroy(q);
+
+	/* a slice of a slice outlives both */
+	CHECK(nom_buffer_slice(&s1, p, 10, 20) == 0);
+	CHECK(nom_buffer_slice(&s2, &s1, 5, 5) == 0);
+	nom_buffer_destroy(p);
+	nom_buffer_release(&s1);
+	CHECK(nom_shared_refs(s2.shared) == 1 && s2.buf[0] == 'a');
+	nom_buffer_release(&s2);
+
+	/* and of a mapping, which stays mapped until the slice lets go */
+	fd = nom_test_tmpfile(path);
+	CHECK(fd >= 0 && write(fd, "hello world", 11) == 11);
+	close(fd);
+	CHECK(nom_buffer_mapfile(&m, path, 0) == 0);
+	CHECK(nom_buffer_slice(&s1, &m, 6, 5) == 0);
+	CHECK(nom_buffer_unmap(&m) == 0);
+	CHECK(memcmp(s1.buf, "world", 5) == 0);
+	nom_buffer_release(&s1);
+
+	/* a writable mapping can't be copied, since writes to the copy would miss the file, so while it is sliced writes to either side are dropped */
+	CHECK(nom_buffer_mapfile(&m, path, NOM_MAP_WRITE) == 0);
+	CHECK(nom_buffer_slice(&s1, &m, 6, 5) == 0);
+	nom_buffer_writebytes(&s1, 0, 1, &x);
+	nom_buffer_writebytes(&m, 0, 1, &x);
+	CHECK(nom_buffer_unshare(&s1) == -1 && nom_buffer_unshare(&m) == -1);
+	CHECK(m.buf[0] == 'h' && s1.buf[0] == 'w');
+	nom_buffer_release(&s1);
+	nom_buffer_writebytes(&m, 0, 1, &x);
+	CHECK(nom_buffer_unmap(&m) == 0);
+	fd = open(path, O_RDONLY);
+	CHECK(fd >= 0 && read(fd, v, 1) == 1 && v[0] == 0xaa);
+	close(fd);
+	unlink(path);
+
+	/* and writes that can't allocate a copy leave both sides as they were */
+	nom_buffer_newwith(&f, 8, &failing_allocator);
+	memset(f.buf, 1, 8);
+	CHECK(nom_buffer_slice(&s1, &f, 0, 8) == 0);
+	failing = 1;
+	nom_buffer_writebytes(&s1, 0, 1, &x);
+	nom_buffer_writeu32le(&f, 0, 1, &u);
+	CHECK(nom_buffer_writevaru32(&s1, 0, 1, &u) == -1);
+	CHECK(nom_buffer_appendvaru32(&f, 1, &u) == -1);
+	CHECK(f.buf[0] == 1 && s1.buf[0] == 1 && f.buf == s1.buf);
+	failing = 0;
+	nom_buffer_writebytes(&s1, 0, 1, &x);
+	CHECK(f.buf[0] == 1 && s1.buf[0] == 0xaa);
+	nom_buffer_release(&s1);
+	nom_buffer_release(&f);
+
+	return nom_test_done("slice");
+}
@@ -0,0 +1,119 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+#define NOM_STATS
+#include "test.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+static int events[4];
+
+/* the contexts the swapping hooks are installed with, each of which only ever sees its own */
+static int ctx_a, ctx_b, swapping = 1;
+
+static void hook(void *ctx, int ev, const struct NomBuffer *b, int64_t off,
+		 int64_t n) {
+	(void)(ctx);
+	(void)(b);
+	(void)(off);
+	(void)(n);
+	events[ev]++;
+}
+
+static void hook_a(void *ctx, int ev, const struct NomBuffer *b, int64_t off,
+		   int64_t n) {
+	(void)(ev);
+	(void)(b);
+	(void)(off);
+	(void)(n);
+	CHECK(ctx == &ctx_a);
+}
+
+static void hook_b(void *ctx, int ev, const struct NomBuffer *b, int64_t off,
+		   int64_t n) {
+	(void)(ev);
+	(void)(b);
+	(void)(off);
+	(void)(n);
+	CHECK(ctx == &ctx_b);
+}
+
+/* counter writes to a buffer of its own until the hooks stop being swapped */
+static void *counter(void *arg) {
+	struct NomBuffer b;
+	uint8_t x = 1;
+
+	(void)(arg);
+	nom_buffer_new(&b, 1);
+	while (__atomic_load_n(&swapping, __ATOMIC_RELAXED)) {
+		nom_buffer_writebytes(&b, 0, 1, &x);
+	}
+	nom_buffer_release(&b);
+	return NULL;
+}
+
+int main(void) {
+	struct NomBuffer b;
+	struct NomStats s;
+	uint32_t v[4] = {1, 2, 3, 4}, o[4];
+	uint64_t x = 0;
+	pthread_t t;
+	int i;
+
+	nom_stats_reset();
+	nom_stats_settrace(hook, NULL);
+	nom_buffer_new(&b, 24);
+	nom_buffer_writeu32le(&b, 1, 4, v);
+	nom_buffer_readu32le(&b, o, 1, 4);
+	nom_buffer_readbits(&b, &x, 3, 10);
+	for (i = 0; i < 100; i++) {
+		nom_buffer_appendbytes(&b, 7, (uint8_t *)("abcdefg"));
+	}
+	nom_buffer_writevaru32(&b, 0, 4, v);
+	nom_buffer_clearallbits(&b);
+	nom_stats_snapshot(&s);
+
+	CHECK(s.reads == 1 && s.read_bytes == 16);
+	CHECK(s.writes == 102 && s.write_bytes == 16 + 700 + 4);
+	CHECK(s.misaligned == 2);
+	CHECK(s.grows > 0 && s.peak_capacity >= 700);
+	CHECK(s.bit_ops == 2);
+	CHECK(events[NOM_TRACE_READ] == 1 && events[NOM_TRACE_WRITE] == 102 &&
+	      events[NOM_TRACE_BITS] == 2 && events[NOM_TRACE_GROW] == s.grows);
+
+	nom_stats_settrace(NULL, NULL);
+	nom_stats_reset();
+	nom_stats_snapshot(&s);
+	CHECK(s.reads == 0 && s.peak_capacity == 0);
+
+	nom_buffer_release(&b);
+
+	/* hooks can be swapped while another thread is counting events */
+	pthread_create(&t, NULL, counter, NULL);
+	for (i = 0; i < 2000; i++) {
+		CHECK(nom_stats_settrace(i % 2 ? hook_b : hook_a,
+					 i % 2 ? &ctx_b : &ctx_a) == 0);
+		sched_yield();
+	}
+	__atomic_store_n(&swapping, 0, __ATOMIC_RELAXED);
+	pthread_join(t, NULL);
+	nom_stats_settrace(NULL, NULL);
+
+	/* and only one hook is made for each of them, however often they are swapped in, until they are freed */
+	CHECK(nom_trace_hooks != NULL && nom_trace_hooks->next != NULL &&
+	      nom_trace_hooks->next->next != NULL &&
+	      nom_trace_hooks->next->next->next == NULL);
+	nom_stats_freetrace();
+	CHECK(nom_trace == NULL && nom_trace_hooks == NULL);
+
+	return nom_test_done("stats");
+}
@@ -0,0 +1,141 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+#include "test.h"
+
+/* a sink that takes a few bytes less than it is offered, so flushes have to loop */
+struct Sink {
+	uint8_t *p;
+	int64_t n;
+};
+
+static int64_t sink_write(void *ctx, uint8_t *buf, int64_t n) {
+	struct Sink *s = (struct Sink *)(ctx);
+	int64_t k = n > 5 ? n - 3 : n;
+
+	memcpy(s->p + s->n, buf, k);
+	s->n += k;
+	return k;
+}
+
+/* a source that hands out a few bytes less than it is asked for */
+struct Source {
+	const uint8_t *p;
+	int64_t n, pos;
+};
+
+static int64_t source_read(void *ctx, uint8_t *buf, int64_t n) {
+	struct Source *s = (struct Source *)(ctx);
+	int64_t k = s->n - s->pos;
+
+	if (k > n) {
+		k = n;
+	}
+	if (k > 7) {
+		k -= 3;
+	}
+	memcpy(buf, s->p + s->pos, k);
+	s->pos += k;
+	return k;
+}
+
+int main(void) {
+	int64_t n = 100000;
+	uint32_t *v = (uint32_t *)(malloc(n * 4)),
+		 *r = (uint32_t *)(malloc(n * 4));
+	uint64_t q = UINT64_C(0x1122334455667788), q2 = 0;
+	uint8_t hdr[3] = {9, 8, 7}, h[3];
+	struct Sink sink = {(uint8_t *)(malloc(n * 16)), 0};
+	struct Source src;
+	struct NomStream s;
+	struct NomBuffer b;
+	int64_t i;
+
+	for (i = 0; i < n; i++) {
+		v[i] = (uint32_t)(i * 2654435761u);
+	}
+
+	/* writes go out through the window in order */
+	nom_stream_new(&s, NULL, sink_write, &sink);
+	CHECK(nom_buffer_openstream(&b, &s, 1000) == 0);
+	nom_buffer_writebytesnext(&b, 3, hdr);
+	nom_buffer_writeu32benext(&b, n, v);
+	CHECK(nom_buffer_appendu64le(&b, 1, &q) == 0);
+	nom_buffer_release(&b);
+	CHECK(sink.n == 3 + n * 4 + 8);
+
+	/* and come back through a window of a different size */
+	src.p = sink.p;
+	src.n = sink.n;
+	src.pos = 0;
+	nom_stream_new(&s, source_read, NULL, &src);
+	CHECK(nom_buffer_openstream(&b, &s, 777) == 0);
+	nom_buffer_readbytesnext(&b, h, 3);
+	CHECK(memcmp(h, hdr, 3) == 0);
+	nom_buffer_readu32benext(&b, r, n);
+	CHECK(memcmp(r, v, n * 4) == 0);
+	nom_buffer_readu64lenext(&b, &q2, 1);
+	CHECK(q2 == q && !s.eof);
+	nom_buffer_readbytesnext(&b, h, 1);
+	CHECK(s.eof);
+	nom_buffer_release(&b);
+
+	/* windows smaller than an element grow to fit one instead of ending the stream */
+	sink.n = 0;
+	nom_stream_new(&s, NULL, sink_write, &sink);
+	nom_buffer_openstream(&b, &s, 3);
+	nom_buffer_writeu64lenext(&b, 1, &q);
+	nom_buffer_writeu64lenext(&b, 1, &q);
+	CHECK(nom_buffer_flush(&b) == 0 && sink.n == 16 && !s.err);
+	nom_buffer_release(&b);
+	src.p = sink.p;
+	src.n = 16;
+	src.pos = 0;
+	nom_stream_new(&s, source_read, NULL, &src);
+	nom_buffer_openstream(&b, &s, 3);
+	q2 = 0;
+	nom_buffer_readu64lenext(&b, &q2, 1);
+	CHECK(q2 == q && !s.eof);
+	q2 = 0;
+	nom_buffer_readu64lenext(&b, &q2, 1);
+	CHECK(q2 == q && !s.eof);
+	CHECK(nom_buffer_refill(&b, 1) == -1 && s.eof);
+	nom_buffer_release(&b);
+
+#ifdef NOM_POSIX
+	{
+		char path[32];
+		int fd = nom_test_tmpfile(path);
+
+		nom_stream_fd(&s, fd, 1);
+		nom_buffer_openstream(&b, &s, 4096);
+		nom_buffer_writeu32lenext(&b, n, v);
+		CHECK(nom_buffer_flush(&b) == 0 && s.pos == n * 4);
+		nom_buffer_release(&b);
+		close(fd);
+
+		fd = open(path, O_RDONLY);
+		nom_stream_fd(&s, fd, 0);
+		nom_buffer_openstream(&b, &s, 4096);
+		memset(r, 0, n * 4);
+		nom_buffer_readu32lenext(&b, r, n);
+		CHECK(memcmp(r, v, n * 4) == 0);
+		nom_buffer_release(&b);
+		close(fd);
+		unlink(path);
+	}
+#endif
+
+	free(v);
+	free(r);
+	free(sink.p);
+	return nom_test_done("stream");
+}
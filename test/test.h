@@ -0,0 +1,87 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+#ifndef NOM_TEST_TEST_H
+#define NOM_TEST_TEST_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../nom.h"
+
+/* the simd levels every kernel is checked at, from scalar only to whatever the cpu has */
+static const int nom_test_masks[] = {0, NOM_CPU_SSSE3,
+				     NOM_CPU_SSSE3 | NOM_CPU_POPCNT |
+					     NOM_CPU_SSE42 | NOM_CPU_PCLMUL,
+				     NOM_CPU_SSSE3 | NOM_CPU_AVX2 |
+					     NOM_CPU_POPCNT | NOM_CPU_F16C,
+				     -1};
+#define NOM_TEST_MASKS (int)(sizeof(nom_test_masks) / sizeof(int))
+
+/* how many checks failed, of which only the first few are printed */
+static int nom_test_failures = 0;
+
+/* CHECK reports cond on stderr when it doesn't hold and carries on */
+#define CHECK(cond)                                                            \
+	do {                                                                   \
+		if (!(cond)) {                                                 \
+			nom_test_fail(__FILE__, __LINE__, #cond);              \
+		}                                                              \
+	} while (0)
+
+static inline void nom_test_fail(const char *file, int line, const char *cond) {
+	if (nom_test_failures++ < 20) {
+		fprintf(stderr, "%s:%d: check failed: %s (cpu mask %d)\n", file,
+			line, cond, nom_cpu_features());
+	}
+}
+
+/* nom_test_done prints the outcome of a test and returns its exit status */
+static inline int nom_test_done(const char *name) {
+	nom_cpu_restrict(-1);
+	if (nom_test_failures > 0) {
+		printf("%s: %d checks failed\n", name, nom_test_failures);
+		return 1;
+	}
+	printf("%s: ok\n", name);
+	return 0;
+}
+
+/* a xorshift generator, so every run sees the same data */
+static uint64_t nom_test_state = UINT64_C(88172645463325252);
+
+static inline uint64_t nom_test_rand(void) {
+	nom_test_state ^= nom_test_state << 13;
+	nom_test_state ^= nom_test_state >> 7;
+	nom_test_state ^= nom_test_state << 17;
+	return nom_test_state;
+}
+
+/* nom_test_fill fills n bytes at p with random data */
+static inline void nom_test_fill(uint8_t *p, int64_t n) {
+	int64_t i;
+
+	for (i = 0; i < n; i++) {
+		p[i] = (uint8_t)(nom_test_rand());
+	}
+}
+
+#ifdef NOM_POSIX
+/* nom_test_tmpfile creates an empty temporary file, writing its path to path, and returns a descriptor for it or -1 */
+static inline int nom_test_tmpfile(char path[32]) {
+	strcpy(path, "/tmp/nom_test_XXXXXX");
+	return mkstemp(path);
+}
+#endif
+
+#endif
@@ -0,0 +1,157 @@
+/*
+
+nom - crunch but the letter c
+Copyright (c) 2019 superwhiskers <whiskerdev@protonmail.com>
+
+This Source Code Form is subject to the terms of the Mozilla Public
+License, v. 2.0. If a copy of the MPL was not distributed with this
+file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+*/
+
+#include "test.h"
+
+#include "../nom_extras.h"
+
+/* ref_encode writes v as a leb128 varint the slow way */
+static int ref_encode(uint8_t *p, uint64_t v) {
+	int n = 0;
+
+	do {
+		p[n] = (uint8_t)(v & 0x7f);
+		v >>= 7;
+		if (v != 0) {
+			p[n] |= 0x80;
+		}
+		n++;
+	} while (v != 0);
+	return n;
+}
+
+/* a source that hands out about half of what it is asked for */
+struct Source {
+	const uint8_t *p;
+	int64_t n, pos;
+};
+
+static int64_t source_read(void *ctx, uint8_t *buf, int64_t n) {
+	struct Source *s = (struct Source *)(ctx);
+	int64_t k = s->n - s->pos;
+
+	if (k > n) {
+		k = n;
+	}
+	if (k > 3) {
+		k = k / 2 + 1;
+	}
+	memcpy(buf, s->p + s->pos, k);
+	s->pos += k;
+	return k;
+}
+
+int main(void) {
+	int64_t n = 200000, rl = 0, size = 0, i;
+	uint64_t *v = (uint64_t *)(malloc(n * 8)),
+		 *r = (uint64_t *)(malloc(n * 8));
+	uint8_t *ref = (uint8_t *)(malloc(n * 10)), bad[16];
+	uint8_t max[10] = {0xff, 0xff, 0xff, 0xff, 0xff,
+			   0xff, 0xff, 0xff, 0xff, 0x01};
+	int64_t si[6] = {0, -1, 1, INT64_MIN, INT64_MAX, -64}, so[6];
+	int32_t s3[5] = {0, -1, 1, INT32_MIN, INT32_MAX}, s3o[5];
+	uint32_t u3[3] = {0, 300, UINT32_MAX}, u3o[3];
+	struct NomBuffer b, sb;
+	struct NomStream s;
+	struct Source src;
+	int bits;
+
+	for (i = 0; i < n; i++) {
+		bits = (int)(nom_test_rand() % 65);
+		v[i] = nom_test_rand();
+		if (bits < 64) {
+			v[i] &= (UINT64_C(1) << bits) - 1;
+		}
+		if (i % 3 == 0) {
+			v[i] &= 0x7f;
+		}
+		rl += ref_encode(ref + rl, v[i]);
+		size += nom_varint_size(v[i]);
+	}
+	CHECK(size == rl);
+
+	/* encodes byte for byte like the reference and decodes back */
+	nom_buffer_new(&b, 0);
+	CHECK(nom_buffer_appendvar(&b, n, v) == 0);
+	CHECK(b.off == rl && memcmp(b.buf, ref, rl) == 0);
+	CHECK(nom_buffer_readvaru64(&b, r, 0, n) == rl);
+	CHECK(memcmp(r, v, n * 8) == 0);
+	b.off = 0;
+	memset(r, 0, n * 8);
+	CHECK(nom_buffer_readvarnext(&b, r, n) == 0 && b.off == rl);
+	CHECK(memcmp(r, v, n * 8) == 0);
+	CHECK(nom_buffer_readvaru64(&b, r, 0, n + 1) == -1);
+
+	/* known answers, including zigzag */
+	b.off = 0;
+	nom_buffer_appendvar(&b, 6, si);
+	nom_buffer_appendvar(&b, 5, s3);
+	nom_buffer_appendvar(&b, 3, u3);
+	CHECK(b.buf[0] == 0 && b.buf[1] == 1 && b.buf[2] == 2);
+	CHECK(memcmp(b.buf + 37, "\x00\xac\x02\xff\xff\xff\xff\x0f", 8) == 0);
+	b.off = 0;
+	nom_buffer_readvarnext(&b, so, 6);
+	nom_buffer_readvarnext(&b, s3o, 5);
+	nom_buffer_readvarnext(&b, u3o, 3);
+	CHECK(memcmp(so, si, sizeof(si)) == 0);
+	CHECK(memcmp(s3o, s3, sizeof(s3)) == 0);
+	CHECK(memcmp(u3o, u3, sizeof(u3)) == 0);
+
+	/* overlong and overflowing varints are rejected without moving */
+	memset(bad, 0x80, 16);
+	b.off = 0;
+	nom_buffer_writebytes(&b, 0, 16, bad);
+	CHECK(nom_buffer_readvaru64next(&b, r, 1) == -1 && b.off == 0);
+	nom_buffer_writebytes(&b, 0, 10, max);
+	CHECK(nom_buffer_readvaru64(&b, r, 0, 1) == 10 && r[0] == UINT64_MAX);
+	max[9] = 2;
+	nom_buffer_writebytes(&b, 0, 10, max);
+	CHECK(nom_buffer_readvaru64(&b, r, 0, 1) == -1);
+
+	/* and so are values too big for a 32 bit type, after the ones before them are read */
+	{
+		uint64_t w[3] = {5, UINT64_C(1) << 32, 7};
+		uint32_t u[3] = {0, 0, 0};
+		int32_t i32[2];
+
+		b.off = 0;
+		nom_buffer_writevaru64next(&b, 3, w);
+		CHECK(nom_buffer_readvaru32(&b, u, 0, 3) == -1);
+		CHECK(nom_buffer_readvari32(&b, i32, 0, 2) == -1);
+		b.off = 0;
+		CHECK(nom_buffer_readvaru32next(&b, u, 3) == -1);
+		CHECK(b.off == 1 && u[0] == 5);
+		w[1] = UINT32_MAX;
+		b.off = 0;
+		nom_buffer_writevaru64next(&b, 3, w);
+		b.off = 0;
+		CHECK(nom_buffer_readvaru32next(&b, u, 3) == 0);
+		CHECK(u[1] == UINT32_MAX && u[2] == 7);
+	}
+
+	/* decoding across window refills */
+	src.p = ref;
+	src.n = rl;
+	src.pos = 0;
+	nom_stream_new(&s, source_read, NULL, &src);
+	nom_buffer_openstream(&sb, &s, 64);
+	memset(r, 0, n * 8);
+	CHECK(nom_buffer_readvaru64next(&sb, r, n) == 0);
+	CHECK(memcmp(r, v, n * 8) == 0);
+	CHECK(nom_buffer_readvaru64next(&sb, r, 1) == -1);
+	nom_buffer_release(&sb);
+
+	nom_buffer_release(&b);
+	free(v);
+	free(r);
+	free(ref);
+	return nom_test_done("varint");
+}